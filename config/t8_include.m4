@@ -62,4 +62,11 @@ dnl This macro prints messages at the end of the configure run.
 dnl
 AC_DEFUN([T8_FINAL_MESSAGES],
 [
+if test "x$enable_pthread" != xyes ; then
+AC_MSG_NOTICE([- $1 -------------------------------------------------
+The default element schemes allocate elements from one memory pool per
+thread only if libsc is configured with --enable-pthread.  Otherwise
+t8_element_new and t8_element_destroy must not be called concurrently.
+])
+fi
 ])
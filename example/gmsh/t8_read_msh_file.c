@@ -74,10 +74,12 @@ t8_read_msh_partition (t8_cmesh_t cmesh, const char *prefix)
  *  dim         The dimension of the mesh to be read from the files.
  *  master      If do_partition is true a valid MPI rank that will read the
  *              file alone. The other processes will not hold any trees then.
+ *  distributed If true, all processes read a part of the file and the
+ *              cmesh is partitioned uniformly. master is ignored then.
  */
 static t8_cmesh_t
 t8_read_msh_file_build_cmesh (const char *prefix, int do_partition, int dim,
-                              int master)
+                              int master, int distributed)
 {
   t8_cmesh_t          cmesh;
   int                 partitioned_read;
@@ -85,6 +87,11 @@ t8_read_msh_file_build_cmesh (const char *prefix, int do_partition, int dim,
   /* If the master argument is positive, then we read the cmesh
    * only on the master rank and is directly partitioned. */
   partitioned_read = master >= 0;
+  if (distributed) {
+    /* All processes read and the cmesh is partitioned */
+    partitioned_read = 1;
+    master = -1;
+  }
   cmesh =
     t8_cmesh_from_msh_file ((char *) prefix, partitioned_read,
                             sc_MPI_COMM_WORLD, dim, master);
@@ -108,6 +115,7 @@ int
 main (int argc, char *argv[])
 {
   int                 mpiret, parsed, partition, dim, master, mpisize;
+  int                 distributed;
   sc_options_t       *opt;
   const char         *prefix;
   char                usage[BUFSIZ];
@@ -144,6 +152,9 @@ main (int argc, char *argv[])
   sc_options_add_int (opt, 'm', "master", &master, -1, "If specified, the "
                       "mesh is partitioned and all elements reside on process with "
                       "rank master.");
+  sc_options_add_bool (opt, 'D', "distributed", &distributed, 0, "If true "
+                       "all processes read a part of the file and the mesh "
+                       "is partitioned uniformly.");
   parsed =
     sc_options_parse (t8_get_package_id (), SC_LP_ERROR, opt, argc, argv);
   if (parsed < 0 || strcmp (prefix, "") == 0 || 0 > dim || dim > 3
@@ -152,7 +163,8 @@ main (int argc, char *argv[])
     return 1;
   }
   else {
-    cmesh = t8_read_msh_file_build_cmesh (prefix, partition, dim, master);
+    cmesh = t8_read_msh_file_build_cmesh (prefix, partition, dim, master,
+                                          distributed);
     t8_cmesh_destroy (&cmesh);
     sc_options_print_summary (t8_get_package_id (), SC_LP_PRODUCTION, opt);
   }
@@ -0,0 +1,194 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element types in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this example we measure the runtime of the computation of linear ids
+ * of triangles and tetrahedra and of the construction of triangles and
+ * tetrahedra from linear ids.
+ * We compare the implementations t8_dtri/dtet_linear_id and
+ * t8_dtri/dtet_init_linear_id with the level by level reference
+ * implementations. Whether the fast implementations use the BMI2
+ * instructions depends on the compiler flags (for example -mbmi2).
+ */
+
+#include <sc_options.h>
+#include <t8.h>
+#include <t8_default/t8_dtri_bits.h>
+#include <t8_default/t8_dtet_bits.h>
+#include <t8_default/t8_dtri_connectivity.h>
+#include <t8_default/t8_dtet_connectivity.h>
+
+/* A linear congruential generator for pseudo random linear ids */
+static              t8_linearidx_t
+t8_time_linear_id_next (t8_linearidx_t * state)
+{
+  *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return *state;
+}
+
+static void
+t8_time_linear_id_tri (int level, size_t num_ids)
+{
+  t8_dtri_t          *tris;
+  t8_linearidx_t      state = 1, checksum[2] = { 0, 0 };
+  const t8_linearidx_t mask = ((t8_linearidx_t) 1 << (T8_DTRI_DIM * level))
+    - 1;
+  size_t              i;
+  double              time[4];
+
+  tris = T8_ALLOC (t8_dtri_t, num_ids);
+  time[0] = -sc_MPI_Wtime ();
+  state = 1;
+  for (i = 0; i < num_ids; i++) {
+    t8_dtri_init_linear_id_reference (tris + i,
+                                      t8_time_linear_id_next (&state) & mask,
+                                      level);
+  }
+  time[0] += sc_MPI_Wtime ();
+  time[1] = -sc_MPI_Wtime ();
+  state = 1;
+  for (i = 0; i < num_ids; i++) {
+    t8_dtri_init_linear_id (tris + i, t8_time_linear_id_next (&state) & mask,
+                            level);
+  }
+  time[1] += sc_MPI_Wtime ();
+  time[2] = -sc_MPI_Wtime ();
+  for (i = 0; i < num_ids; i++) {
+    checksum[0] += t8_dtri_linear_id_reference (tris + i, level);
+  }
+  time[2] += sc_MPI_Wtime ();
+  time[3] = -sc_MPI_Wtime ();
+  for (i = 0; i < num_ids; i++) {
+    checksum[1] += t8_dtri_linear_id (tris + i, level);
+  }
+  time[3] += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (checksum[0] == checksum[1], "Linear ids do not match");
+
+  t8_global_productionf ("Triangles level %i, %zd ids\n", level, num_ids);
+  t8_global_productionf ("  init_linear_id reference: %.3e s\n", time[0]);
+  t8_global_productionf ("  init_linear_id:           %.3e s\n", time[1]);
+  t8_global_productionf ("  linear_id reference:      %.3e s\n", time[2]);
+  t8_global_productionf ("  linear_id:                %.3e s\n", time[3]);
+  T8_FREE (tris);
+}
+
+static void
+t8_time_linear_id_tet (int level, size_t num_ids)
+{
+  t8_dtet_t          *tets;
+  t8_linearidx_t      state = 1, checksum[2] = { 0, 0 };
+  const t8_linearidx_t mask = ((t8_linearidx_t) 1 << (T8_DTET_DIM * level))
+    - 1;
+  size_t              i;
+  double              time[4];
+
+  tets = T8_ALLOC (t8_dtet_t, num_ids);
+  time[0] = -sc_MPI_Wtime ();
+  state = 1;
+  for (i = 0; i < num_ids; i++) {
+    t8_dtet_init_linear_id_reference (tets + i,
+                                      t8_time_linear_id_next (&state) & mask,
+                                      level);
+  }
+  time[0] += sc_MPI_Wtime ();
+  time[1] = -sc_MPI_Wtime ();
+  state = 1;
+  for (i = 0; i < num_ids; i++) {
+    t8_dtet_init_linear_id (tets + i, t8_time_linear_id_next (&state) & mask,
+                            level);
+  }
+  time[1] += sc_MPI_Wtime ();
+  time[2] = -sc_MPI_Wtime ();
+  for (i = 0; i < num_ids; i++) {
+    checksum[0] += t8_dtet_linear_id_reference (tets + i, level);
+  }
+  time[2] += sc_MPI_Wtime ();
+  time[3] = -sc_MPI_Wtime ();
+  for (i = 0; i < num_ids; i++) {
+    checksum[1] += t8_dtet_linear_id (tets + i, level);
+  }
+  time[3] += sc_MPI_Wtime ();
+  SC_CHECK_ABORT (checksum[0] == checksum[1], "Linear ids do not match");
+
+  t8_global_productionf ("Tetrahedra level %i, %zd ids\n", level, num_ids);
+  t8_global_productionf ("  init_linear_id reference: %.3e s\n", time[0]);
+  t8_global_productionf ("  init_linear_id:           %.3e s\n", time[1]);
+  t8_global_productionf ("  linear_id reference:      %.3e s\n", time[2]);
+  t8_global_productionf ("  linear_id:                %.3e s\n", time[3]);
+  T8_FREE (tets);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int                 mpiret;
+  int                 first_argc;
+  int                 level, num_ids;
+  int                 help = 0;
+  sc_options_t       *opt;
+
+  /* Initialize MPI, sc, p4est and t8code */
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  sc_init (sc_MPI_COMM_WORLD, 1, 1, NULL, SC_LP_ESSENTIAL);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  /* Setup for command line options */
+  opt = sc_options_new (argv[0]);
+
+  sc_options_add_int (opt, 'l', "level", &level, 15,
+                      "The refinement level of the elements.");
+  sc_options_add_int (opt, 'n', "num-ids", &num_ids, 1000000,
+                      "The number of linear ids to compute.");
+  sc_options_add_switch (opt, 'h', "help", &help,
+                         "Display a short help message.");
+
+  /* parse command line options */
+  first_argc = sc_options_parse (t8_get_package_id (), SC_LP_DEFAULT,
+                                 opt, argc, argv);
+  /* check for wrong usage of arguments */
+  if (first_argc < 0 || first_argc != argc || level < 0
+      || level > T8_DTET_MAXLEVEL || num_ids <= 0) {
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+    return 1;
+  }
+  if (help) {
+    /* Display help message */
+    sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
+  }
+  else {
+#ifdef __BMI2__
+    t8_global_productionf ("Using BMI2 instructions\n");
+#else
+    t8_global_productionf ("Using the portable implementation\n");
+#endif
+    t8_time_linear_id_tri (level, num_ids);
+    t8_time_linear_id_tet (level, num_ids);
+  }
+  sc_options_destroy (opt);
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+  return 0;
+}
@@ -82,13 +82,119 @@ t8_basic_adapt_refine_tet (t8_forest_t forest, t8_forest_t forest_from,
 
 }
 
+/* The element kernels that are timed by t8_time_element_kernels */
+enum
+{
+  T8_TIME_KERNEL_LINEAR_ID,
+  T8_TIME_KERNEL_SUCCESSOR,
+  T8_TIME_KERNEL_CHILDREN,
+  T8_TIME_KERNEL_PARENT,
+  T8_TIME_KERNEL_NUM
+};
+
+/* Time the low level element functions of the scheme on all local
+ * elements of a committed forest. Each kernel is called repeat times
+ * per element. */
+static void
+t8_time_element_kernels (t8_forest_t forest, int repeat,
+                         sc_statinfo_t * stats)
+{
+  t8_locidx_t         itree, ielem, num_elems;
+  t8_eclass_t         tree_class;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *elem, *succ, *children[T8_DPRISM_CHILDREN];
+  t8_linearidx_t      id_sum = 0;
+  sc_flopinfo_t       fi, snapshot;
+  double              times[T8_TIME_KERNEL_NUM] = { 0 };
+  int                 irepeat, ichild, level, num_children;
+
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree_class = t8_forest_get_tree_class (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest, tree_class);
+    num_elems = t8_forest_get_tree_num_elements (forest, itree);
+    if (num_elems == 0) {
+      continue;
+    }
+    elem = t8_forest_get_element_in_tree (forest, itree, 0);
+    num_children = ts->t8_element_num_children (elem);
+    T8_ASSERT (num_children <= T8_DPRISM_CHILDREN);
+    ts->t8_element_new (1, &succ);
+    ts->t8_element_new (num_children, children);
+
+    /* The linear id of each element at its own and the maximum level */
+    sc_flops_start (&fi);
+    sc_flops_snap (&fi, &snapshot);
+    for (irepeat = 0; irepeat < repeat; irepeat++) {
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+        level = ts->t8_element_level (elem);
+        id_sum += ts->t8_element_get_linear_id (elem, level);
+        id_sum +=
+          ts->t8_element_get_linear_id (elem, ts->t8_element_maxlevel ());
+      }
+    }
+    sc_flops_shot (&fi, &snapshot);
+    times[T8_TIME_KERNEL_LINEAR_ID] += snapshot.iwtime;
+
+    /* The successor of each element, except the last one. Since the forest
+     * is uniform, all other elements have a successor. */
+    sc_flops_snap (&fi, &snapshot);
+    for (irepeat = 0; irepeat < repeat; irepeat++) {
+      for (ielem = 0; ielem + 1 < num_elems; ielem++) {
+        elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+        level = ts->t8_element_level (elem);
+        ts->t8_element_successor (elem, succ, level);
+      }
+    }
+    sc_flops_shot (&fi, &snapshot);
+    times[T8_TIME_KERNEL_SUCCESSOR] += snapshot.iwtime;
+
+    /* All children of each element */
+    sc_flops_snap (&fi, &snapshot);
+    for (irepeat = 0; irepeat < repeat; irepeat++) {
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        elem = t8_forest_get_element_in_tree (forest, itree, ielem);
+        ts->t8_element_children (elem, num_children, children);
+      }
+    }
+    sc_flops_shot (&fi, &snapshot);
+    times[T8_TIME_KERNEL_CHILDREN] += snapshot.iwtime;
+
+    /* The parents of the children of the last element */
+    sc_flops_snap (&fi, &snapshot);
+    for (irepeat = 0; irepeat < repeat; irepeat++) {
+      for (ielem = 0; ielem < num_elems; ielem++) {
+        ichild = ielem % num_children;
+        ts->t8_element_parent (children[ichild], succ);
+      }
+    }
+    sc_flops_shot (&fi, &snapshot);
+    times[T8_TIME_KERNEL_PARENT] += snapshot.iwtime;
+
+    ts->t8_element_destroy (1, &succ);
+    ts->t8_element_destroy (num_children, children);
+  }
+  /* Print the checksum such that the compiler cannot drop the loops */
+  t8_debugf ("Linear id checksum %llu\n", (unsigned long long) id_sum);
+  sc_stats_set1 (&stats[T8_TIME_KERNEL_LINEAR_ID],
+                 times[T8_TIME_KERNEL_LINEAR_ID], "Linear id");
+  sc_stats_set1 (&stats[T8_TIME_KERNEL_SUCCESSOR],
+                 times[T8_TIME_KERNEL_SUCCESSOR], "Successor");
+  sc_stats_set1 (&stats[T8_TIME_KERNEL_CHILDREN],
+                 times[T8_TIME_KERNEL_CHILDREN], "Children");
+  sc_stats_set1 (&stats[T8_TIME_KERNEL_PARENT],
+                 times[T8_TIME_KERNEL_PARENT], "Parent");
+}
+
 static void
 t8_time_refine (int start_level, int end_level, int create_forest, int cube,
-                int adapt, int do_balance, t8_eclass_t eclass)
+                int adapt, int do_balance, int kernel_repeat,
+                t8_eclass_t eclass)
 {
   t8_forest_t         forest, forest_adapt, forest_partition;
   sc_flopinfo_t       fi, snapshot;
-  sc_statinfo_t       stats[1];
+  sc_statinfo_t       stats[1 + T8_TIME_KERNEL_NUM];
+  int                 num_stats = 1;
   char                vtuname[BUFSIZ];
 
   T8_ASSERT (eclass == T8_ECLASS_PRISM || eclass == T8_ECLASS_TET);
@@ -112,6 +218,11 @@ t8_time_refine (int start_level, int end_level, int create_forest, int cube,
   t8_forest_commit (forest);
   sc_flops_shot (&fi, &snapshot);
   sc_stats_set1 (&stats[0], snapshot.iwtime, "New");
+  if (kernel_repeat > 0) {
+    /* Time the element functions on the uniform forest */
+    t8_time_element_kernels (forest, kernel_repeat, stats + 1);
+    num_stats += T8_TIME_KERNEL_NUM;
+  }
   if (cube == 1) {
     snprintf (vtuname, BUFSIZ, "forest_hypercube_%s",
               t8_eclass_to_string[eclass]);
@@ -155,8 +266,9 @@ t8_time_refine (int start_level, int end_level, int create_forest, int cube,
     t8_forest_print_profile (forest);
     t8_forest_unref (&forest);
   }
-  sc_stats_compute (sc_MPI_COMM_WORLD, 1, stats);
-  sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS, 1, stats, 1, 1);
+  sc_stats_compute (sc_MPI_COMM_WORLD, num_stats, stats);
+  sc_stats_print (t8_get_package_id (), SC_LP_STATISTICS, num_stats, stats,
+                  1, 1);
 }
 
 int
@@ -168,7 +280,7 @@ main (int argc, char **argv)
   char                help[BUFSIZ];
   int                 create_forest;
   int                 start_level = 0, end_level = 1, cube = 0, adapt =
-    0, do_balance = 0, eclass_int;
+    0, do_balance = 0, eclass_int, kernel_repeat;
   int                 parsed, helpme;
 
   /* brief help message */
@@ -204,6 +316,10 @@ main (int argc, char **argv)
                          "Establish a 2:1 balance in the forest.");
   sc_options_add_int (opt, 'c', "cube", &cube, 0,
                       "cube = 1 -> use the hypercube mesh and visual output.");
+  sc_options_add_int (opt, 'k', "kernels", &kernel_repeat, 0,
+                      "If > 0, time the element functions (linear id, "
+                      "successor, children, parent) on the initial forest "
+                      "with this many repetitions.");
   sc_options_add_int (opt, 'e', "elements", &eclass_int, 6,
                       "This option specifies"
                       " the type of elements to use.\n"
@@ -226,10 +342,10 @@ main (int argc, char **argv)
     sc_options_print_usage (t8_get_package_id (), SC_LP_ERROR, opt, NULL);
   }
   else if (parsed >= 0 && 0 <= start_level && start_level <= end_level
-           && (eclass_int == 5 || eclass_int == 6)) {
+           && (eclass_int == 5 || eclass_int == 6) && kernel_repeat >= 0) {
     create_forest = 1;
-    t8_time_refine (start_level, end_level, create_forest, cube, adapt, do_balance,
-                    (t8_eclass_t) eclass_int);
+    t8_time_refine (start_level, end_level, create_forest, cube, adapt,
+                    do_balance, kernel_repeat, (t8_eclass_t) eclass_int);
   }
   else {
     /* wrong usage */
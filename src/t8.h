@@ -112,6 +112,7 @@ typedef enum
   T8_MPI_PARTITION_FOREST,  /**< Used for forest partitioning */
   T8_MPI_GHOST_FOREST,  /**< Used for for ghost layer creation */
   T8_MPI_GHOST_EXC_FOREST,  /**< Used for ghost data exchange */
+  T8_MPI_VTK_AGGREGATE,  /**< Used for aggregated vtk output */
   T8_MPI_TAG_LAST
 }
 t8_MPI_tag_t;
@@ -0,0 +1,270 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+/** \file t8_cmesh_face_match.c
+ *
+ * A radix sort based matching of tree faces by their vertex indices.
+ */
+
+#include "t8_cmesh_face_match.h"
+
+/* The number of bits that a radix sort pass sorts by */
+#define T8_FACE_MATCH_RADIX_BITS 8
+#define T8_FACE_MATCH_RADIX (1 << T8_FACE_MATCH_RADIX_BITS)
+
+static int
+t8_cmesh_face_long_compare (const void *a, const void *b)
+{
+  long                la = *(const long *) a;
+  long                lb = *(const long *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+void
+t8_cmesh_face_keys_add_tree (sc_array_t * faces, t8_gloidx_t gtree_id,
+                             t8_eclass_t eclass, const long *vertices)
+{
+  t8_cmesh_face_key_t *face;
+  t8_eclass_t         face_class;
+  int                 iface, iv, num_face_vertices;
+
+  T8_ASSERT (faces != NULL);
+  T8_ASSERT (faces->elem_size == sizeof (t8_cmesh_face_key_t));
+  for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+    face = (t8_cmesh_face_key_t *) sc_array_push (faces);
+    face_class = (t8_eclass_t) t8_eclass_face_types[eclass][iface];
+    num_face_vertices = t8_eclass_num_vertices[face_class];
+    for (iv = 0; iv < 4; iv++) {
+      if (iv < num_face_vertices) {
+        face->vertices[iv] =
+          vertices[t8_face_vertex_to_tree_vertex[eclass][iface][iv]];
+        T8_ASSERT (face->vertices[iv] >= 0);
+      }
+      else {
+        face->vertices[iv] = -1;
+      }
+      face->key[iv] = face->vertices[iv];
+    }
+    qsort (face->key, num_face_vertices, sizeof (long),
+           t8_cmesh_face_long_compare);
+    face->gtree_id = gtree_id;
+    face->face_number = iface;
+    face->eclass = eclass;
+  }
+}
+
+/* The digit of a face key that a radix sort pass sorts by.
+ * The padding -1 is mapped to 0 and all vertex indices are shifted by one. */
+static inline unsigned
+t8_cmesh_face_key_digit (const t8_cmesh_face_key_t * face, int field,
+                         int digit)
+{
+  unsigned long       value = (unsigned long) (face->key[field] + 1);
+
+  return (value >> (T8_FACE_MATCH_RADIX_BITS * digit))
+    & (T8_FACE_MATCH_RADIX - 1);
+}
+
+void
+t8_cmesh_face_keys_sort (sc_array_t * faces)
+{
+  t8_cmesh_face_key_t *face, *source, *dest, *swap, *buffer;
+  unsigned long       max_value = 0;
+  size_t              iz, sum, count, num_faces = faces->elem_count;
+  size_t             *counts, *offsets;
+  int                 num_fields = 0, num_digits = 0;
+  int                 ipass, num_passes, field, digit, iv;
+
+  T8_ASSERT (faces->elem_size == sizeof (t8_cmesh_face_key_t));
+  if (num_faces <= 1) {
+    return;
+  }
+  /* Compute the number of used entries of a key and the largest index */
+  for (iz = 0; iz < num_faces; iz++) {
+    face = (t8_cmesh_face_key_t *) sc_array_index (faces, iz);
+    for (iv = 0; iv < 4 && face->key[iv] >= 0; iv++) {
+      max_value = SC_MAX (max_value, (unsigned long) face->key[iv] + 1);
+    }
+    num_fields = SC_MAX (num_fields, iv);
+  }
+  for (; max_value > 0; max_value >>= T8_FACE_MATCH_RADIX_BITS) {
+    num_digits++;
+  }
+  num_passes = num_fields * num_digits;
+  if (num_passes == 0) {
+    return;
+  }
+
+  /* Count the digits of all passes in one sweep over the faces.
+   * The least significant digit of the last key entry is sorted first. */
+  counts = T8_ALLOC_ZERO (size_t, num_passes * T8_FACE_MATCH_RADIX);
+  for (iz = 0; iz < num_faces; iz++) {
+    face = (t8_cmesh_face_key_t *) sc_array_index (faces, iz);
+    for (ipass = 0; ipass < num_passes; ipass++) {
+      field = num_fields - 1 - ipass / num_digits;
+      digit = ipass % num_digits;
+      counts[ipass * T8_FACE_MATCH_RADIX
+             + t8_cmesh_face_key_digit (face, field, digit)]++;
+    }
+  }
+
+  /* Each pass is a stable counting sort from source to dest */
+  buffer = T8_ALLOC (t8_cmesh_face_key_t, num_faces);
+  source = (t8_cmesh_face_key_t *) faces->array;
+  dest = buffer;
+  for (ipass = 0; ipass < num_passes; ipass++) {
+    field = num_fields - 1 - ipass / num_digits;
+    digit = ipass % num_digits;
+    offsets = counts + ipass * T8_FACE_MATCH_RADIX;
+    if (offsets[t8_cmesh_face_key_digit (source, field, digit)]
+        == num_faces) {
+      /* All faces have the same digit, this pass does not change the order */
+      continue;
+    }
+    for (iz = 0, sum = 0; iz < T8_FACE_MATCH_RADIX; iz++) {
+      count = offsets[iz];
+      offsets[iz] = sum;
+      sum += count;
+    }
+    for (iz = 0; iz < num_faces; iz++) {
+      dest[offsets[t8_cmesh_face_key_digit (source + iz, field, digit)]++] =
+        source[iz];
+    }
+    swap = source;
+    source = dest;
+    dest = swap;
+  }
+  if (source == buffer) {
+    memcpy (faces->array, buffer, num_faces * sizeof (t8_cmesh_face_key_t));
+  }
+  T8_FREE (buffer);
+  T8_FREE (counts);
+}
+
+/* Given two matching faces, compute the orientation of the face
+ * connection.  It is the position of the first vertex of the smaller
+ * face in the bigger face.  The smaller face is the one of the smaller
+ * tree class, or of the smaller tree id if both classes are equal,
+ * or the smaller face number if both trees are equal. */
+static int
+t8_cmesh_face_orientation (const t8_cmesh_face_key_t * face_a,
+                           const t8_cmesh_face_key_t * face_b)
+{
+  const t8_cmesh_face_key_t *smaller_face, *bigger_face;
+  t8_eclass_t         bigger_class;
+  int                 compare, iv;
+
+  compare = t8_eclass_compare ((t8_eclass_t) face_a->eclass,
+                               (t8_eclass_t) face_b->eclass);
+  if (compare == 0) {
+    compare = face_a->gtree_id != face_b->gtree_id ?
+      (face_a->gtree_id < face_b->gtree_id ? -1 : 1)
+      : face_a->face_number - face_b->face_number;
+  }
+  if (compare > 0) {
+    smaller_face = face_b;
+    bigger_face = face_a;
+  }
+  else {
+    smaller_face = face_a;
+    bigger_face = face_b;
+  }
+  bigger_class = (t8_eclass_t)
+    t8_eclass_face_types[bigger_face->eclass][bigger_face->face_number];
+  /* Find which vertex of the bigger face is the first vertex
+   * of the smaller face */
+  for (iv = 0; iv < t8_eclass_num_vertices[bigger_class]; iv++) {
+    if (bigger_face->vertices[iv] == smaller_face->vertices[0]) {
+      return iv;
+    }
+  }
+  SC_ABORT_NOT_REACHED ();
+  return -1;
+}
+
+void
+t8_cmesh_face_keys_match (sc_array_t * faces, sc_array_t * joins,
+                          int boundary)
+{
+  t8_cmesh_face_key_t *face, *neighbor;
+  t8_cmesh_face_join_t *join;
+  size_t              iz;
+
+  T8_ASSERT (faces->elem_size == sizeof (t8_cmesh_face_key_t));
+  T8_ASSERT (joins->elem_size == sizeof (t8_cmesh_face_join_t));
+  for (iz = 0; iz < faces->elem_count; iz++) {
+    face = (t8_cmesh_face_key_t *) sc_array_index (faces, iz);
+    neighbor = NULL;
+    if (iz + 1 < faces->elem_count) {
+      neighbor = (t8_cmesh_face_key_t *) sc_array_index (faces, iz + 1);
+      if (memcmp (face->key, neighbor->key, sizeof (face->key))) {
+        neighbor = NULL;
+      }
+    }
+    if (neighbor == NULL && !boundary) {
+      /* face is a domain boundary */
+      continue;
+    }
+    join = (t8_cmesh_face_join_t *) sc_array_push (joins);
+    join->gtree_id = face->gtree_id;
+    join->face_number = face->face_number;
+    join->eclass = face->eclass;
+    if (neighbor == NULL) {
+      /* A domain boundary is a connection of the face to itself */
+      join->neighbor = face->gtree_id;
+      join->neighbor_face = face->face_number;
+      join->neighbor_eclass = face->eclass;
+      join->orientation = 0;
+      continue;
+    }
+    join->neighbor = neighbor->gtree_id;
+    join->neighbor_face = neighbor->face_number;
+    join->neighbor_eclass = neighbor->eclass;
+    join->orientation = t8_cmesh_face_orientation (face, neighbor);
+    /* Skip the neighbor */
+    iz++;
+  }
+}
+
+void
+t8_cmesh_face_match (t8_cmesh_t cmesh, sc_array_t * faces, int boundary)
+{
+  sc_array_t          joins;
+  t8_cmesh_face_join_t *join;
+  size_t              iz;
+
+  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
+  t8_debugf ("Matching %lu tree faces\n", (unsigned long) faces->elem_count);
+  t8_cmesh_face_keys_sort (faces);
+  sc_array_init (&joins, sizeof (t8_cmesh_face_join_t));
+  t8_cmesh_face_keys_match (faces, &joins, boundary);
+  for (iz = 0; iz < joins.elem_count; iz++) {
+    join = (t8_cmesh_face_join_t *) sc_array_index (&joins, iz);
+    t8_cmesh_set_join (cmesh, join->gtree_id, join->neighbor,
+                       join->face_number, join->neighbor_face,
+                       join->orientation);
+  }
+  sc_array_reset (&joins);
+  t8_debugf ("Done matching tree faces.\n");
+}
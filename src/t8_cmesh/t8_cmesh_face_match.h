@@ -0,0 +1,111 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+/** \file t8_cmesh_face_match.h
+ *
+ * Find the face connections of a coarse mesh from the vertex indices of
+ * its trees.  This is used by the mesh file readers.
+ * Each face of a tree is stored as a key that consists of the sorted
+ * indices of its vertices.  After sorting all keys with a radix sort,
+ * the two faces of a face connection are adjacent in the array.
+ */
+
+#ifndef T8_CMESH_FACE_MATCH_H
+#define T8_CMESH_FACE_MATCH_H
+
+#include <t8.h>
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+
+/** The face of a tree, identified by the indices of its vertices. */
+typedef struct
+{
+  long                key[4];   /**< The sorted vertex indices, padded with -1 */
+  long                vertices[4];      /**< The vertex indices in face order */
+  t8_gloidx_t         gtree_id; /**< The global id of the tree */
+  int8_t              face_number;      /**< The face number in the tree */
+  int8_t              eclass;   /**< The eclass of the tree */
+} t8_cmesh_face_key_t;
+
+/** A face connection between two trees. */
+typedef struct
+{
+  t8_gloidx_t         gtree_id; /**< The first tree of the connection */
+  t8_gloidx_t         neighbor; /**< The tree across the face */
+  int8_t              face_number;      /**< The face of \a gtree_id */
+  int8_t              neighbor_face;    /**< The face of \a neighbor */
+  int8_t              orientation;      /**< The orientation of the connection */
+  int8_t              eclass;   /**< The eclass of \a gtree_id */
+  int8_t              neighbor_eclass;  /**< The eclass of \a neighbor */
+} t8_cmesh_face_join_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Add the keys of all faces of a tree to an array.
+ * \param [in,out] faces    An array of \ref t8_cmesh_face_key_t.
+ *                          One entry per face of the tree is appended.
+ * \param [in]     gtree_id The global id of the tree.
+ * \param [in]     eclass   The eclass of the tree.
+ * \param [in]     vertices The nonnegative indices of the tree's
+ *                          vertices in t8code order.
+ */
+void                t8_cmesh_face_keys_add_tree (sc_array_t * faces,
+                                                 t8_gloidx_t gtree_id,
+                                                 t8_eclass_t eclass,
+                                                 const long *vertices);
+
+/** Sort an array of face keys, such that equal faces are adjacent.
+ * The sort is a stable radix sort over the vertex indices, thus faces
+ * with equal keys keep their relative order.
+ * \param [in,out] faces    An array of \ref t8_cmesh_face_key_t.
+ */
+void                t8_cmesh_face_keys_sort (sc_array_t * faces);
+
+/** Match the faces of a sorted array of face keys.
+ * Each pair of adjacent faces with equal keys is a face connection.
+ * \param [in]     faces    A sorted array of \ref t8_cmesh_face_key_t.
+ * \param [in,out] joins    An array of \ref t8_cmesh_face_join_t.
+ *                          One entry per face connection is appended.
+ *                          Its first tree is the one that comes first
+ *                          in \a faces.
+ * \param [in]     boundary If true, a face without a neighbor is appended
+ *                          as a connection of the face to itself.
+ */
+void                t8_cmesh_face_keys_match (sc_array_t * faces,
+                                              sc_array_t * joins,
+                                              int boundary);
+
+/** Sort and match an array of face keys and set the face connections
+ * in a cmesh.
+ * \param [in,out] cmesh    An initialized but not committed cmesh.
+ * \param [in,out] faces    An array of \ref t8_cmesh_face_key_t.
+ *                          It is sorted on output.
+ * \param [in]     boundary If true, faces without a neighbor are
+ *                          connected to themselves.
+ */
+void                t8_cmesh_face_match (t8_cmesh_t cmesh,
+                                         sc_array_t * faces, int boundary);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_CMESH_FACE_MATCH_H */
@@ -0,0 +1,53 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+/** \file t8_cmesh_msh_file.h
+ *
+ * Internal functions of the .msh file reader that are exposed for testing.
+ */
+
+#ifndef T8_CMESH_MSH_FILE_H
+#define T8_CMESH_MSH_FILE_H
+
+#include <t8.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Parse a decimal floating point number as it is stored in a .msh file.
+ * Leading blanks are skipped, but not newlines.  The result and the end
+ * of the number are those of strtod.
+ * \param [in,out] pos    On input the position to start parsing.
+ *                        On successful output the position behind the
+ *                        number.
+ * \param [in]     end    The end of the input, which need not be
+ *                        nul-terminated.
+ * \param [out]    value  The parsed number.
+ * \return  True if a number was parsed, false if there is no number.
+ */
+int                 t8_cmesh_msh_file_parse_double (const char **pos,
+                                                    const char *end,
+                                                    double *value);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_CMESH_MSH_FILE_H */
@@ -25,6 +25,14 @@
 #include <t8_cmesh_vtk.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_stash.h"
+#include "t8_cmesh_face_match.h"
+#include "t8_cmesh_msh_file.h"
+#if defined T8_HAVE_MMAP && defined T8_HAVE_SYS_MMAN_H
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 /* The supported number of gmesh tree classes.
  * Currently, we only support first order trees.
@@ -80,38 +88,382 @@ const int           t8_vertex_to_msh_vertex_num[T8_ECLASS_COUNT][8]
  *       maybe also only trees and ghosts to classes.
  *       Specifying all face-connections makes commit algorithm slow! */
 
-/* TODO: eventually compute neighbours only from .node and .ele files, since
- *       creating .neigh files with tetgen/triangle is not common and even seems
- *       to not work sometimes */
+/* A .msh file whose content is held in memory.
+ * If possible, the file is mapped into memory, such that only the parts
+ * that are actually parsed are read from disk. */
+typedef struct
+{
+  const char         *data;     /* The content of the file */
+  size_t              size;     /* The size of the file in bytes */
+  int                 mapped;   /* True if data is memory mapped */
+  int                 version;  /* The major version of the format, 2 or 4 */
+  int                 binary;   /* True if the sections are stored binary */
+  int                 data_size;        /* The size of a size_t in a binary file */
+} t8_msh_file_t;
 
-/* Read a the next line from a file stream that does not start with '#' or
- * contains only whitespaces (tabs etc.)
- *
- * \param [in,out] line     An allocated string to store the line.
- * \param [in,out] n        The number of allocated bytes.
- *                          If more bytes are needed line is reallocated and
- *                          the new number of bytes is stored in n.
- * \param [in]     fp       The file stream to read from.
- * \return                  The number of read arguments of the last line read.
- *                          negative on failure */
+/* Open a .msh file and read its content into memory.
+ * If mmap is available, the file is mapped and the parser only reads the
+ * pages that it touches.  Otherwise the whole file is read.  In the
+ * distributed reader, each process then holds the whole file while it
+ * parses its part.  The parser addresses the file by absolute offsets
+ * and the version 4 sections are only found by walking all block headers,
+ * so reading only a part of the file is not supported.
+ * Returns 0 on success and -1 on failure. */
 static int
-t8_cmesh_msh_read_next_line (char **line, size_t * n, FILE * fp)
+t8_msh_file_open (const char *filename, t8_msh_file_t * file)
 {
-  int                 retval;
+  FILE               *fp;
+  char               *data;
+  long                size;
 
-  do {
-    /* read first non-comment line from file */
-    /* TODO: getline depends on IEEE Std 1003.1-2008 (``POSIX.1'')
-     *       p4est therefore has its own getline function in p4est_connectivity.h. */
-    retval = getline (line, n, fp);
-    if (retval < 0) {
-      return retval;
+  memset (file, 0, sizeof (*file));
+#if defined T8_HAVE_MMAP && defined T8_HAVE_SYS_MMAN_H
+  {
+    struct stat         filestat;
+    void               *mapped;
+    int                 fd;
+
+    fd = open (filename, O_RDONLY);
+    if (fd < 0) {
+      return -1;
+    }
+    if (fstat (fd, &filestat) == 0 && filestat.st_size > 0) {
+      mapped = mmap (NULL, filestat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        file->data = (const char *) mapped;
+        file->size = filestat.st_size;
+        file->mapped = 1;
+      }
+    }
+    close (fd);
+    if (file->mapped) {
+      return 0;
+    }
+  }
+#endif
+  /* Read the whole file into a buffer */
+  fp = fopen (filename, "rb");
+  if (fp == NULL) {
+    return -1;
+  }
+  if (fseek (fp, 0, SEEK_END) || (size = ftell (fp)) < 0
+      || fseek (fp, 0, SEEK_SET)) {
+    fclose (fp);
+    return -1;
+  }
+  data = T8_ALLOC (char, size + 1);
+  if (fread (data, 1, size, fp) != (size_t) size) {
+    T8_FREE (data);
+    fclose (fp);
+    return -1;
+  }
+  fclose (fp);
+  file->data = data;
+  file->size = size;
+  return 0;
+}
+
+/* Release the memory of an opened .msh file */
+static void
+t8_msh_file_close (t8_msh_file_t * file)
+{
+#if defined T8_HAVE_MMAP && defined T8_HAVE_SYS_MMAN_H
+  if (file->mapped) {
+    munmap ((void *) file->data, file->size);
+    file->data = NULL;
+    return;
+  }
+#endif
+  T8_FREE ((char *) file->data);
+  file->data = NULL;
+}
+
+/* Skip spaces and tabs, but not newlines */
+static inline const char *
+t8_msh_file_skip_blanks (const char *pos, const char *end)
+{
+  while (pos < end && (*pos == ' ' || *pos == '\t' || *pos == '\r'
+                       || *pos == '\v')) {
+    pos++;
+  }
+  return pos;
+}
+
+/* Return true if c is whitespace, including newlines */
+static inline int
+t8_msh_file_is_space (char c)
+{
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v';
+}
+
+/* Skip all whitespace including newlines */
+static inline const char *
+t8_msh_file_skip_space (const char *pos, const char *end)
+{
+  while (pos < end && t8_msh_file_is_space (*pos)) {
+    pos++;
+  }
+  return pos;
+}
+
+/* Return true if only blanks follow pos on its line */
+static inline int
+t8_msh_file_end_of_line (const char *pos, const char *end)
+{
+  pos = t8_msh_file_skip_blanks (pos, end);
+  return pos == end || *pos == '\n';
+}
+
+/* Parse an integer starting at *pos, leading blanks are skipped.
+ * On success, *pos is set behind the number and true is returned.
+ * Returns false if there is no integer on the current line. */
+static inline int
+t8_msh_file_parse_long (const char **pos, const char *end, long *value)
+{
+  const char         *p = t8_msh_file_skip_blanks (*pos, end);
+  const char         *digits;
+  unsigned long       result = 0;
+  int                 negative = 0;
+
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  for (digits = p; p < end && (unsigned) (*p - '0') < 10; p++) {
+    result = 10 * result + (*p - '0');
+  }
+  if (p == digits) {
+    return 0;
+  }
+  *value = negative ? -(long) result : (long) result;
+  *pos = p;
+  return 1;
+}
+
+/* The powers of ten that are exactly representable as double */
+static const double t8_msh_file_pow10[23] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Parse a floating point number starting at *pos, leading blanks are
+ * skipped.  If the decimal mantissa has at most 53 bits and the exponent
+ * is small, the result is computed with one correctly rounded operation.
+ * Otherwise we fall back to strtod.  Thus the result and the end of the
+ * number are those of strtod for all decimal numbers.  Hexadecimal
+ * numbers, infinity and NaN are not supported.
+ * On success, *pos is set behind the number and true is returned.
+ * Returns false if there is no number on the current line. */
+static inline int
+t8_msh_file_parse_double (const char **pos, const char *end, double *value)
+{
+  const char         *p = t8_msh_file_skip_blanks (*pos, end);
+  const char         *start = p, *exp_pos, *exp_digits;
+  uint64_t            mantissa = 0;
+  long                exponent = 0, exp_value;
+  int                 num_digits = 0, truncated = 0;
+  int                 negative = 0, has_digits = 0, exp_negative;
+  double              result;
+
+  if (p < end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    p++;
+  }
+  for (; p < end && (unsigned) (*p - '0') < 10; p++) {
+    has_digits = 1;
+    if (num_digits < 19) {
+      mantissa = 10 * mantissa + (*p - '0');
+      num_digits += mantissa > 0;
+    }
+    else {
+      /* Ignore the digit, but keep its magnitude */
+      truncated = 1;
+      exponent++;
+    }
+  }
+  if (p < end && *p == '.') {
+    for (p++; p < end && (unsigned) (*p - '0') < 10; p++) {
+      has_digits = 1;
+      if (num_digits < 19) {
+        mantissa = 10 * mantissa + (*p - '0');
+        num_digits += mantissa > 0;
+        exponent--;
+      }
+      else {
+        truncated = 1;
+      }
+    }
+  }
+  if (!has_digits) {
+    return 0;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    /* As for strtod, the number ends before the 'e' if no digits follow */
+    exp_pos = p + 1;
+    exp_negative = 0;
+    exp_value = 0;
+    if (exp_pos < end && (*exp_pos == '-' || *exp_pos == '+')) {
+      exp_negative = *exp_pos == '-';
+      exp_pos++;
+    }
+    for (exp_digits = exp_pos;
+         exp_pos < end && (unsigned) (*exp_pos - '0') < 10; exp_pos++) {
+      /* Saturate, such that huge exponents cannot overflow */
+      if (exp_value < 100000) {
+        exp_value = 10 * exp_value + (*exp_pos - '0');
+      }
+    }
+    if (exp_pos > exp_digits) {
+      exponent += exp_negative ? -exp_value : exp_value;
+      p = exp_pos;
+    }
+  }
+  if (!truncated && mantissa <= ((uint64_t) 1 << 53)
+      && -22 <= exponent && exponent <= 22) {
+    /* Both the mantissa and the power of ten are exact doubles */
+    result = (double) mantissa;
+    result = exponent < 0 ? result / t8_msh_file_pow10[-exponent]
+      : result * t8_msh_file_pow10[exponent];
+    *value = negative ? -result : result;
+  }
+  else {
+    char                buffer[64], *number;
+
+    /* strtod needs a nul-terminated string */
+    number = p - start < 64 ? buffer : T8_ALLOC (char, p - start + 1);
+    memcpy (number, start, p - start);
+    number[p - start] = '\0';
+    *value = strtod (number, NULL);
+    if (number != buffer) {
+      T8_FREE (number);
+    }
+  }
+  *pos = p;
+  return 1;
+}
+
+int
+t8_cmesh_msh_file_parse_double (const char **pos, const char *end,
+                                double *value)
+{
+  return t8_msh_file_parse_double (pos, end, value);
+}
+
+/* Return the next line in [*pos, end) that does not start with '#' and
+ * does not consist of whitespace only, and set *pos to the beginning
+ * of the following line.  The line is not terminated; it ends at the
+ * next newline or at end.  Returns NULL if there is no such line. */
+static const char  *
+t8_cmesh_msh_read_next_line (const char **pos, const char *end)
+{
+  const char         *line, *next;
+
+  while (*pos < end) {
+    line = *pos;
+    next = (const char *) memchr (line, '\n', end - line);
+    *pos = next == NULL ? end : next + 1;
+    if (*line != '#' && !t8_msh_file_end_of_line (line, end)) {
+      return line;
+    }
+  }
+  return NULL;
+}
+
+/* Return true if the line at pos is the section marker name. */
+static int
+t8_msh_file_is_marker (const char *pos, const char *end, const char *name)
+{
+  size_t              len = strlen (name);
+
+  return (size_t) (end - pos) >= len && !strncmp (pos, name, len)
+    && t8_msh_file_end_of_line (pos + len, end);
+}
+
+/* Find the first line in the file at or after pos that is the section
+ * marker name, for example "$Nodes".  Returns the beginning of the line
+ * after the marker, or NULL if the marker does not exist.
+ * The search also works for binary sections, since we only look for
+ * '$' characters at the beginning of a line. */
+static const char  *
+t8_msh_file_find_section (const t8_msh_file_t * file, const char *pos,
+                          const char *name)
+{
+  const char         *end = file->data + file->size;
+  const char         *next;
+
+  for (; pos != NULL && pos < end;
+       pos = (const char *) memchr (pos + 1, '$', end - pos - 1)) {
+    if (*pos == '$' && (pos == file->data || pos[-1] == '\n')
+        && t8_msh_file_is_marker (pos, end, name)) {
+      next = (const char *) memchr (pos, '\n', end - pos);
+      return next == NULL ? end : next + 1;
+    }
+  }
+  return NULL;
+}
+
+/* Read the $MeshFormat section of a file and set the version, binary and
+ * data_size entries.  Files without this section are treated as version 2.
+ * Returns 0 on success and -1 if the format is not supported. */
+static int
+t8_msh_file_read_format (t8_msh_file_t * file)
+{
+  const char         *end = file->data + file->size;
+  const char         *pos = file->data, *line;
+  double              version;
+  long                file_type, data_size;
+  int                 one;
+
+  file->version = 2;
+  file->binary = 0;
+  file->data_size = sizeof (long);
+  line = t8_cmesh_msh_read_next_line (&pos, end);
+  if (line == NULL || !t8_msh_file_is_marker (line, end, "$MeshFormat")) {
+    return 0;
+  }
+  line = t8_cmesh_msh_read_next_line (&pos, end);
+  if (line == NULL || !t8_msh_file_parse_double (&line, end, &version)
+      || !t8_msh_file_parse_long (&line, end, &file_type)
+      || !t8_msh_file_parse_long (&line, end, &data_size)) {
+    t8_global_errorf ("Could not read the format of the .msh file\n");
+    return -1;
+  }
+  file->version = (int) version;
+  file->binary = file_type != 0;
+  file->data_size = data_size;
+  if (file->version == 4 && version < 4.1) {
+    t8_global_errorf ("Version %g of the .msh format is not supported,"
+                      " use version 2 or 4.1\n", version);
+    return -1;
+  }
+  if (file->version != 2 && file->version != 4) {
+    t8_global_errorf ("Version %g of the .msh format is not supported\n",
+                      version);
+    return -1;
+  }
+  if (file->binary) {
+    if (file->version != 4) {
+      t8_global_errorf ("Binary .msh files are only supported in"
+                        " version 4.1\n");
+      return -1;
+    }
+    if (data_size != 4 && data_size != 8) {
+      t8_global_errorf ("Unsupported data size %li in .msh file\n",
+                        data_size);
+      return -1;
+    }
+    /* The integer 1 is written in binary to detect the byte order */
+    if ((size_t) (end - pos) < sizeof (int)) {
+      return -1;
+    }
+    memcpy (&one, pos, sizeof (int));
+    if (one != 1) {
+      t8_global_errorf ("The byte order of the binary .msh file is not"
+                        " supported\n");
+      return -1;
     }
   }
-  /* check if line is a comment (trailing '#') or consists solely of
-   * blank spaces/tabs */
-  while (*line[0] == '#' || strspn (*line, " \t\r\v\n") == strlen (*line));
-  return retval;
+  return 0;
 }
 
 /* The nodes are stored in the .msh file in the format
@@ -124,577 +476,1166 @@ t8_cmesh_msh_read_next_line (char **line, size_t * n, FILE * fp)
  * $EndNodes
  *
  * The node indices do not need to be in consecutive order.
- * We thus use a hash table to read all node indices and coordinates.
- * The hash value is the node index modulo the number of nodes.
+ * We thus store all nodes in an array sorted by their indices and look
+ * them up by binary search.
  */
 typedef struct
 {
-  t8_locidx_t         index;
+  long                index;
   double              coordinates[3];
 } t8_msh_file_node_t;
 
-/* Return the hash value of a node.
- * \param [in]  node    The node whose hash value should be computed.
- * \param [in]  num_nodes A pointer to a locidx_t storing the total number of nodes.
- * \return              The hash value for a node. This is its index modulo the number of nodes.
- */
-static unsigned
-t8_msh_file_node_hash (const void *node, const void *num_nodes)
-{
-  t8_msh_file_node_t *Node;
-  t8_locidx_t         Num_nodes;
-
-  T8_ASSERT (node != NULL);
-  T8_ASSERT (num_nodes != NULL);
-  /* The data parameter stores the total number of nodes */
-  Num_nodes = *(t8_locidx_t *) num_nodes;
-  /* The node parameter stores a node structure */
-  Node = (t8_msh_file_node_t *) node;
-  /* The hash value of the node is its index modulo the number of nodes */
-  return Node->index % Num_nodes;
-}
-
-/* Returns true if two given nodes are the same.
- * False otherwise.
- * Two nodes are considered equal if their indices are the same.
- * u_data is not needed.
- */
+/* A tree as it is read from the file. The distributed reader also sends
+ * it to its owner process. */
+typedef struct
+{
+  t8_gloidx_t         gtree_id; /* The global id of the tree */
+  int                 eclass;   /* The eclass of the tree */
+  long                nodes[8]; /* The node indices in .msh order */
+} t8_msh_file_dtree_t;
+
 static int
-t8_msh_file_node_compare (const void *node_a, const void *node_b,
-                          const void *u_data)
+t8_msh_file_node_index_compare (const void *a, const void *b)
+{
+  long                index_a = ((const t8_msh_file_node_t *) a)->index;
+  long                index_b = ((const t8_msh_file_node_t *) b)->index;
+
+  return index_a < index_b ? -1 : index_a > index_b;
+}
+
+/* The sections of a version 2 .msh file that we read.
+ * Each entry is the byte offset of the line that starts the section. */
+enum
 {
-  t8_msh_file_node_t *Node_a, *Node_b;
+  T8_MSH_FILE_NODES,
+  T8_MSH_FILE_END_NODES,
+  T8_MSH_FILE_ELEMENTS,
+  T8_MSH_FILE_END_ELEMENTS,
+  T8_MSH_FILE_NUM_MARKERS
+};
+
+static const char  *t8_msh_file_markers[T8_MSH_FILE_NUM_MARKERS] = {
+  "$Nodes", "$EndNodes", "$Elements", "$EndElements"
+};
 
-  Node_a = (t8_msh_file_node_t *) node_a;
-  Node_b = (t8_msh_file_node_t *) node_b;
+/* Return the first line that starts in [start, end) of the file.
+ * A line starts at offset 0 or after a newline. */
+static const char  *
+t8_msh_file_first_line (const t8_msh_file_t * file, size_t start,
+                        size_t end)
+{
+  const char         *line;
 
-  return Node_a->index == Node_b->index;
+  if (start == 0 || file->data[start - 1] == '\n') {
+    return file->data + start;
+  }
+  line = (const char *) memchr (file->data + start, '\n', end - start);
+  return line == NULL ? file->data + end : line + 1;
 }
 
-/* Read an open .msh file and parse the nodes into a hash table.
- */
-static sc_hash_t   *
-t8_msh_file_read_nodes (FILE * fp, t8_locidx_t * num_nodes,
-                        sc_mempool_t ** node_mempool)
-{
-  t8_msh_file_node_t *Node;
-  sc_hash_t          *node_table = NULL;
-  t8_locidx_t         ln, last_index;
-  char               *line = (char *) malloc (1024);
-  char                first_word[2048] = "\0";
-  size_t              linen = 1024;
-  int                 retval;
-  long                index, lnum_nodes;
-
-  T8_ASSERT (fp != NULL);
-  /* Go to the beginning of the file */
-  fseek (fp, 0, SEEK_SET);
-  /* Search for the line beginning with "$Nodes" */
-  while (!feof (fp) && strcmp (first_word, "$Nodes")) {
-    (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-    /* Get the first word of this line */
-    retval = sscanf (line, "%2048s", first_word);
-
-    /* Checking for read/write error */
-    if (retval != 1) {
-      t8_global_errorf ("Premature end of line while reading num nodes.\n");
-      t8_debugf ("The line is %s", line);
-      goto die_node;
-    }
-  }
-
-  /* Read the line containing the number of nodes */
-  (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-  /* Read the number of nodes in a long int before converting it
-   * to t8_locidx_t. */
-  retval = sscanf (line, "%li", &lnum_nodes);
-  /* Checking for read/write error */
-  if (retval != 1) {
-    t8_global_errorf ("Premature end of line while reading num nodes.\n");
-    t8_debugf ("The line is %s", line);
-    goto die_node;
-  }
-  *num_nodes = lnum_nodes;
-  /* Check for type conversion error. */
-  T8_ASSERT (*num_nodes == lnum_nodes);
-
-  /* Create the mempool for the nodes */
-  *node_mempool = sc_mempool_new (sizeof (t8_msh_file_node_t));
-  /* Create the hash table */
-  node_table = sc_hash_new (t8_msh_file_node_hash, t8_msh_file_node_compare,
-                            num_nodes, NULL);
-
-  /* read each node and add it to the hash table */
-  last_index = 0;
-  for (ln = 0; ln < *num_nodes; ln++) {
-    /* Read the next line. Its format should be %i %f %f %f
-     * The node index followed by its coordinates. */
-    retval = t8_cmesh_msh_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
-      t8_global_errorf ("Error reading node file\n");
-      goto die_node;
-    }
-    /* Allocate a new node */
-    Node = (t8_msh_file_node_t *) sc_mempool_alloc (*node_mempool);
-    /* Fill the node with the entries in the file */
-    retval = sscanf (line, "%li %lf %lf %lf", &index,
-                     &Node->coordinates[0], &Node->coordinates[1],
-                     &Node->coordinates[2]);
-    if (retval != 4) {
-      t8_global_errorf ("Error reading node file after node %li\n",
-                        (long) last_index);
-      goto die_node;
-    }
-    Node->index = index;
-    /* Check for type conversion error */
-    T8_ASSERT (Node->index == index);
-    /* Insert the node in the hash table */
-    retval = sc_hash_insert_unique (node_table, Node, NULL);
-    /* If retval is zero then the node was already in the hash table.
-     * This case should not occur. */
-    T8_ASSERT (retval);
-    last_index = Node->index;
-  }
-
-  free (line);
-  t8_debugf ("Successfully read all Nodes.\n");
-  return node_table;
-  /* If everything went well, the function ends here. */
-
-  /* This code is execute when a read/write error occurs */
-die_node:
-  /* If we allocated the hash table, destroy it */
-  if (node_table != NULL) {
-    sc_hash_destroy (node_table);
-    sc_mempool_destroy (*node_mempool);
-    node_mempool = NULL;
-  }
-  /* Free memory */
-  free (line);
-  /* Return NULL as error code */
-  return NULL;
+/* Find the section markers in the lines that start in [start, end).
+ * Markers that are not found are set to LONG_MAX. */
+static void
+t8_msh_file_find_markers (const t8_msh_file_t * file, size_t start,
+                          size_t end, long *markers)
+{
+  const char         *pos, *file_end = file->data + file->size;
+  int                 imarker;
+
+  for (imarker = 0; imarker < T8_MSH_FILE_NUM_MARKERS; imarker++) {
+    markers[imarker] = LONG_MAX;
+  }
+  pos = t8_msh_file_first_line (file, start, end);
+  for (; pos != NULL && pos < file->data + end;
+       pos = (const char *) memchr (pos, '\n', file_end - pos),
+       pos = pos == NULL ? NULL : pos + 1) {
+    if (*pos != '$') {
+      continue;
+    }
+    for (imarker = 0; imarker < T8_MSH_FILE_NUM_MARKERS; imarker++) {
+      if (markers[imarker] == LONG_MAX
+          && t8_msh_file_is_marker (pos, file_end,
+                                    t8_msh_file_markers[imarker])) {
+        markers[imarker] = pos - file->data;
+      }
+    }
+  }
 }
 
-/* fp should be set after the Nodes section, right before the tree section.
- * If vertex_indices is not NULL, it is allocated and will store
- * for each tree the indices of its vertices.
- * They are stored as arrays of long ints. */
-int
-t8_cmesh_msh_file_read_eles (t8_cmesh_t cmesh, FILE * fp,
-                             sc_hash_t * vertices,
-                             sc_array_t ** vertex_indices, int dim)
-{
-  char               *line = (char *) malloc (1024), *line_modify;
-  char                first_word[2048] = "\0";
-  size_t              linen = 1024;
-  t8_locidx_t         num_trees, tree_loop;
-  t8_gloidx_t         tree_count;
+/* Parse a line of the $Nodes section of a version 2 file.
+ * Returns 1 if a node was parsed, 0 if the line is the number of nodes
+ * and -1 on failure. */
+static int
+t8_msh_file2_parse_node (const char *line, const char *end,
+                         t8_msh_file_node_t * node)
+{
+  int                 i;
+
+  if (!t8_msh_file_parse_long (&line, end, &node->index)) {
+    return -1;
+  }
+  for (i = 0; i < 3; i++) {
+    if (!t8_msh_file_parse_double (&line, end, &node->coordinates[i])) {
+      /* A single number is the number of nodes */
+      return i == 0 && t8_msh_file_end_of_line (line, end) ? 0 : -1;
+    }
+  }
+  return 1;
+}
+
+/* Parse a line of the $Elements section of a version 2 file.
+ * The line looks like
+ * tree_number tree_type Number_tags tag_1 ... tag_n Node_1 ... Node_m
+ * Returns 1 if a tree of dimension dim was parsed, 0 if the line is the
+ * number of elements or an element of another dimension,
+ * and -1 on failure. */
+static int
+t8_msh_file2_parse_element (const char *line, const char *end, int dim,
+                            t8_msh_file_dtree_t * tree)
+{
+  long                values[3], tag;
   t8_eclass_t         eclass;
-  t8_msh_file_node_t  Node, **found_node;
-  long                lnum_trees;
-  int                 retval, i;
-  int                 ele_type, num_tags;
-  int                 num_nodes, t8_vertex_num;
-  long                node_indices[8], *stored_indices;
-  double              tree_vertices[24];
+  int                 i;
 
-  T8_ASSERT (fp != NULL);
-  /* Search for the line beginning with "$Elements" */
-  while (!feof (fp) && strcmp (first_word, "$Elements")) {
-    (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-    /* Get the first word of this line */
-    retval = sscanf (line, "%2048s", first_word);
-
-    /* Checking for read/write error */
-    if (retval != 1) {
-      t8_global_errorf ("Premature end of line while reading num trees.\n");
-      t8_debugf ("The line is %s", line);
-      goto die_ele;
-    }
-  }
-
-  /* Read the line containing the number of trees */
-  (void) t8_cmesh_msh_read_next_line (&line, &linen, fp);
-  /* Since t8_locidx_t could be int32 or int64, we first read the
-   * number of trees in a long int and store it as t8_locidx_t later. */
-  retval = sscanf (line, "%li", &lnum_trees);
-  /* Checking for read/write error */
-  if (retval != 1) {
-    t8_global_errorf ("Premature end of line while reading num trees.\n");
-    t8_debugf ("The line is %s", line);
-    goto die_ele;
-  }
-  num_trees = lnum_trees;
-  /* Check for type conversion error */
-  T8_ASSERT (num_trees == lnum_trees);
-
-  if (vertex_indices != NULL) {
-    /* We store a list of the vertex indices for each element */
-    *vertex_indices = sc_array_new (sizeof (long *));
-  }
-  tree_count = 0;               /* The index of the next tree to insert */
-  for (tree_loop = 0; tree_loop < num_trees; tree_loop++) {
-    /* Read the next line containing tree information */
-    retval = t8_cmesh_msh_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
-      t8_global_errorf ("Premature end of line while reading trees.\n");
-      goto die_ele;
-    }
-    /* The line describing the tree looks like
-     * tree_number tree_type Number_tags tag_1 ... tag_n Node_1 ... Node_m
-     *
-     * We ignore the tree number, read the type and the number of (integer) tags.
-     * We also ignore the tags and after we know the type, we read the
-     * nodes.
-     */
-    sscanf (line, "%*i %i %i", &ele_type, &num_tags);
-    /* Check if the tree type is supported */
-    if (ele_type > T8_NUM_GMSH_ELEM_CLASSES || ele_type < 0
-        || t8_msh_tree_type_to_eclass[ele_type] == T8_ECLASS_COUNT) {
-      t8_global_errorf ("tree type %i is not supported by t8code.\n",
-                        ele_type);
-      goto die_ele;
-    }
-    /* Continue if tree type is supported */
-    eclass = t8_msh_tree_type_to_eclass[ele_type];
-    T8_ASSERT (eclass != T8_ECLASS_COUNT);
-    /* Check if the tree is of the correct dimension */
-    if (t8_eclass_to_dimension[eclass] == dim) {
-      /* The tree is of the correct dimension,
-       * add it to the cmesh and read its nodes */
-      t8_cmesh_set_tree_class (cmesh, tree_count, eclass);
-      line_modify = line;
-      /* Since the tags are stored before the node indices, we need to
-       * skip them first. But since the number of them is unknown and the
-       * lenght (in characters) of them, we have to skip one by one. */
-      for (i = 0; i < 3 + num_tags; i++) {
-        T8_ASSERT (strcmp (line_modify, "\0"));
-        /* move line_modify to the next word in the line */
-        (void) strsep (&line_modify, " ");
-      }
-      /* At this point line_modify contains only the node indices. */
-      num_nodes = t8_eclass_num_vertices[eclass];
-      for (i = 0; i < num_nodes; i++) {
-        T8_ASSERT (strcmp (line_modify, "\0"));
-        retval = sscanf (line_modify, "%li", node_indices + i);
-        if (retval != 1) {
-          t8_global_errorf ("Premature end of line while reading tree.\n");
-          t8_debugf ("The line is %s", line);
-          goto die_ele;
-        }
-        /* move line_modify to the next word in the line */
-        (void) strsep (&line_modify, " ");
-      }
-      /* Now the nodes are read and we get their coordinates from
-       * the stored nodes */
-      for (i = 0; i < num_nodes; i++) {
-        Node.index = node_indices[i];
-        sc_hash_lookup (vertices, (void *) &Node, (void ***) &found_node);
-        /* Add node coordinates to the tree vertices */
-        t8_vertex_num = t8_msh_tree_vertex_to_t8_vertex_num[eclass][i];
-        tree_vertices[3 * t8_vertex_num] = (*found_node)->coordinates[0];
-        tree_vertices[3 * t8_vertex_num + 1] = (*found_node)->coordinates[1];
-        tree_vertices[3 * t8_vertex_num + 2] = (*found_node)->coordinates[2];
-      }
-      if (t8_cmesh_tree_vertices_negative_volume (eclass, tree_vertices,
-                                                  num_nodes)) {
-        /* The volume described is negative. We need to switch two
-         * vertices. */
-        double              temp;
-        T8_ASSERT (t8_eclass_to_dimension[eclass] == 3);
-        t8_debugf ("Correcting negative volume of tree %li\n", tree_count);
-        /* We switch vertex 0 and vertex 1 */
-        for (i = 0; i < 3; i++) {
-          temp = tree_vertices[i];
-          tree_vertices[i] = tree_vertices[3 + i];
-          tree_vertices[3 + i] = temp;
-        }
-        T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
-                   (eclass, tree_vertices, num_nodes));
+  for (i = 0; i < 3; i++) {
+    if (!t8_msh_file_parse_long (&line, end, &values[i])) {
+      /* A single number is the number of elements */
+      return i == 1 && t8_msh_file_end_of_line (line, end) ? 0 : -1;
+    }
+  }
+  /* values[1] is the element type and values[2] the number of tags */
+  if (values[1] > T8_NUM_GMSH_ELEM_CLASSES || values[1] < 0
+      || t8_msh_tree_type_to_eclass[values[1]] == T8_ECLASS_COUNT) {
+    t8_global_errorf ("tree type %li is not supported by t8code.\n",
+                      values[1]);
+    return -1;
+  }
+  eclass = t8_msh_tree_type_to_eclass[values[1]];
+  if (t8_eclass_to_dimension[eclass] != dim) {
+    return 0;
+  }
+  /* Skip the tags */
+  for (i = 0; i < values[2]; i++) {
+    if (!t8_msh_file_parse_long (&line, end, &tag)) {
+      return -1;
+    }
+  }
+  tree->eclass = eclass;
+  for (i = 0; i < t8_eclass_num_vertices[eclass]; i++) {
+    if (!t8_msh_file_parse_long (&line, end, &tree->nodes[i])) {
+      return -1;
+    }
+  }
+  return 1;
+}
+
+/* Parse the nodes and the trees of dimension dim of a version 2 file
+ * whose lines start in [start, end) of the file, given the offsets of
+ * the section markers.
+ * Returns true on success and false otherwise. */
+static int
+t8_msh_file2_parse_range (const t8_msh_file_t * file, int dim,
+                          size_t start, size_t end, const long *markers,
+                          sc_array_t * nodes, sc_array_t * trees)
+{
+  const char         *file_end = file->data + file->size;
+  const char         *pos, *line;
+  long                line_offset;
+  int                 retval;
+
+  T8_ASSERT (file->version == 2 && !file->binary);
+  pos = t8_msh_file_first_line (file, start, end);
+  while ((line = t8_cmesh_msh_read_next_line (&pos, file_end)) != NULL
+         && (line_offset = line - file->data) < (long) end) {
+    retval = 0;
+    if (markers[T8_MSH_FILE_NODES] < line_offset
+        && line_offset < markers[T8_MSH_FILE_END_NODES]) {
+      retval = t8_msh_file2_parse_node (line, file_end, (t8_msh_file_node_t *)
+                                        sc_array_push (nodes));
+      if (retval != 1) {
+        sc_array_pop (nodes);
       }
-      /* Set the vertices of this tree */
-      t8_cmesh_set_tree_vertices (cmesh, tree_count, t8_get_package_id (),
-                                  0, tree_vertices, num_nodes);
-      /* If wished, we store the vertex indices of that tree. */
-      if (vertex_indices != NULL) {
-        /* Allocate memory for the inices */
-        stored_indices = T8_ALLOC (long, t8_eclass_num_vertices[eclass]);
-        for (i = 0; i < t8_eclass_num_vertices[eclass]; i++) {
-          /* Get the i-th node index in t8code order and store it. */
-          stored_indices[i] =
-            node_indices[t8_vertex_to_msh_vertex_num[eclass][i]];
-        }
-        /* Set the index array as a new entry in the array */
-        *(long **) sc_array_push (*vertex_indices) = stored_indices;
+    }
+    else if (markers[T8_MSH_FILE_ELEMENTS] < line_offset
+             && line_offset < markers[T8_MSH_FILE_END_ELEMENTS]) {
+      retval = t8_msh_file2_parse_element (line, file_end, dim,
+                                           (t8_msh_file_dtree_t *)
+                                           sc_array_push (trees));
+      if (retval != 1) {
+        sc_array_pop (trees);
       }
-      /* advance the tree counter */
-      tree_count++;
+    }
+    if (retval < 0) {
+      t8_global_errorf ("Error reading .msh file at offset %li\n",
+                        line_offset);
+      return 0;
     }
   }
-  free (line);
-  return 0;
-die_ele:
-  /* Error handling */
-  free (line);
-  t8_cmesh_destroy (&cmesh);
-  return -1;
+  return 1;
 }
 
-/* This struct stores all information associated to a tree's face.
- * We need it to find neighbor trees.
- */
-typedef struct
+/* Read an unsigned integer of a version 4 file. In binary files it is a
+ * size_t of data_size bytes. Returns true on success. */
+static inline int
+t8_msh_file4_read_size (const t8_msh_file_t * file, const char **pos,
+                        long *value)
+{
+  const char         *end = file->data + file->size;
+
+  if (file->binary) {
+    if (end - *pos < file->data_size) {
+      return 0;
+    }
+    if (file->data_size == 8) {
+      uint64_t            value64;
+      memcpy (&value64, *pos, 8);
+      *value = (long) value64;
+    }
+    else {
+      uint32_t            value32;
+      memcpy (&value32, *pos, 4);
+      *value = (long) value32;
+    }
+    *pos += file->data_size;
+    return 1;
+  }
+  *pos = t8_msh_file_skip_space (*pos, end);
+  return t8_msh_file_parse_long (pos, end, value);
+}
+
+/* Read an int of a version 4 file. Returns true on success. */
+static inline int
+t8_msh_file4_read_int (const t8_msh_file_t * file, const char **pos,
+                       long *value)
+{
+  const char         *end = file->data + file->size;
+  int                 value32;
+
+  if (file->binary) {
+    if ((size_t) (end - *pos) < sizeof (int)) {
+      return 0;
+    }
+    memcpy (&value32, *pos, sizeof (int));
+    *value = value32;
+    *pos += sizeof (int);
+    return 1;
+  }
+  *pos = t8_msh_file_skip_space (*pos, end);
+  return t8_msh_file_parse_long (pos, end, value);
+}
+
+/* Read a double of a version 4 file. Returns true on success. */
+static inline int
+t8_msh_file4_read_double (const t8_msh_file_t * file, const char **pos,
+                          double *value)
+{
+  const char         *end = file->data + file->size;
+
+  if (file->binary) {
+    if ((size_t) (end - *pos) < sizeof (double)) {
+      return 0;
+    }
+    memcpy (value, *pos, sizeof (double));
+    *pos += sizeof (double);
+    return 1;
+  }
+  *pos = t8_msh_file_skip_space (*pos, end);
+  return t8_msh_file_parse_double (pos, end, value);
+}
+
+/* Skip count entries of a version 4 file. In binary files each entry has
+ * entry_size bytes, in ascii files the entries are separated by
+ * whitespace. Returns true on success. */
+static int
+t8_msh_file4_skip (const t8_msh_file_t * file, const char **pos,
+                   long count, size_t entry_size)
 {
-  t8_locidx_t         ltree_id; /* The local id of the tree this face belongs to */
-  int8_t              face_number;      /* The number of that face whitin the tree */
-  int                 num_vertices;     /* The number of vertices of this face. */
-  long               *vertices; /* The indices of these vertices. */
-} t8_msh_file_face_t;
+  const char         *end = file->data + file->size;
+  const char         *p = *pos;
+  long                ientry;
 
-/* Hash a face. The hash value is the sum of its vertex indices */
-static unsigned
-t8_msh_file_face_hash (const void *face, const void *data)
+  if (file->binary) {
+    if ((size_t) (end - p) < count * entry_size) {
+      return 0;
+    }
+    *pos = p + count * entry_size;
+    return 1;
+  }
+  for (ientry = 0; ientry < count; ientry++) {
+    p = t8_msh_file_skip_space (p, end);
+    if (p == end) {
+      return 0;
+    }
+    while (p < end && !t8_msh_file_is_space (*p)) {
+      p++;
+    }
+  }
+  *pos = p;
+  return 1;
+}
+
+/* Parse the nodes of a version 4.1 file. The nodes are split into
+ * num_parts parts of equal size in the order of the file and only the
+ * nodes of part number part are parsed.
+ * The section is stored as
+ *
+ * $Nodes
+ * numEntityBlocks numNodes minNodeTag maxNodeTag
+ * entityDim entityTag parametric numNodesInBlock   // for each block
+ * nodeTag                                          // numNodesInBlock times
+ * x y z (u v w)                                    // numNodesInBlock times
+ * $EndNodes
+ *
+ * Returns true on success and false otherwise. */
+static int
+t8_msh_file4_parse_nodes (const t8_msh_file_t * file, int part,
+                          int num_parts, sc_array_t * nodes)
 {
-  t8_msh_file_face_t *Face;
-  int                 iv;
-  long                sum = 0;
+  const char         *pos, *tags;
+  long                header[4], block[4], num_coords;
+  long                first, last, position, ibl, in, offset;
+  t8_msh_file_node_t *node;
+  int                 i;
+  size_t              first_new;
 
-  Face = (t8_msh_file_face_t *) face;
-  for (iv = 0; iv < Face->num_vertices; iv++) {
-    sum += Face->vertices[iv];
+  pos = t8_msh_file_find_section (file, file->data, "$Nodes");
+  if (pos == NULL) {
+    t8_global_errorf ("Could not find the nodes in the .msh file\n");
+    return 0;
+  }
+  for (i = 0; i < 4; i++) {
+    if (!t8_msh_file4_read_size (file, &pos, &header[i])) {
+      return 0;
+    }
   }
-  T8_ASSERT (sum >= 0);
-  return (unsigned) sum;
+  /* The positions of the nodes that we parse */
+  first = (long) (((long double) part * header[1]) / num_parts);
+  last = (long) (((long double) (part + 1) * header[1]) / num_parts);
+  for (ibl = 0, position = 0; ibl < header[0] && position < last; ibl++) {
+    for (i = 0; i < 3; i++) {
+      if (!t8_msh_file4_read_int (file, &pos, &block[i])) {
+        return 0;
+      }
+    }
+    if (!t8_msh_file4_read_size (file, &pos, &block[3])) {
+      return 0;
+    }
+    /* Parametric nodes store entityDim additional coordinates */
+    num_coords = 3 + (block[2] ? block[0] : 0);
+    /* The range of this block that we parse */
+    offset = SC_MAX (first - position, 0);
+    in = SC_MIN (last - position, block[3]);
+    if (offset >= in) {
+      /* Skip this block */
+      if (!t8_msh_file4_skip (file, &pos, block[3], file->data_size)
+          || !t8_msh_file4_skip (file, &pos, block[3] * num_coords,
+                                 sizeof (double))) {
+        return 0;
+      }
+      position += block[3];
+      continue;
+    }
+    /* Read the tags */
+    tags = pos;
+    if (!t8_msh_file4_skip (file, &tags, offset, file->data_size)) {
+      return 0;
+    }
+    first_new = nodes->elem_count;
+    for (i = offset; i < in; i++) {
+      node = (t8_msh_file_node_t *) sc_array_push (nodes);
+      if (!t8_msh_file4_read_size (file, &tags, &node->index)) {
+        return 0;
+      }
+    }
+    /* Read the coordinates */
+    pos = tags;
+    if (!t8_msh_file4_skip (file, &pos, block[3] - in, file->data_size)
+        || !t8_msh_file4_skip (file, &pos, offset * num_coords,
+                               sizeof (double))) {
+      return 0;
+    }
+    for (i = offset; i < in; i++) {
+      node = (t8_msh_file_node_t *)
+        sc_array_index (nodes, first_new + i - offset);
+      if (!t8_msh_file4_read_double (file, &pos, &node->coordinates[0])
+          || !t8_msh_file4_read_double (file, &pos, &node->coordinates[1])
+          || !t8_msh_file4_read_double (file, &pos, &node->coordinates[2])
+          || !t8_msh_file4_skip (file, &pos, num_coords - 3,
+                                 sizeof (double))) {
+        return 0;
+      }
+    }
+    if (!t8_msh_file4_skip (file, &pos, (block[3] - in) * num_coords,
+                            sizeof (double))) {
+      return 0;
+    }
+    position += block[3];
+  }
+  return 1;
 }
 
-/* Two face are considered equal if they have the same vertices up
- * to renumeration. */
+/* Parse the elements of a version 4.1 file. The elements are split into
+ * num_parts parts of equal size in the order of the file and only the
+ * trees of dimension dim in part number part are parsed.
+ * The section is stored as
+ *
+ * $Elements
+ * numEntityBlocks numElements minElementTag maxElementTag
+ * entityDim entityTag elementType numElementsInBlock   // for each block
+ * elementTag nodeTag ... nodeTag                       // numElementsInBlock times
+ * $EndElements
+ *
+ * Returns true on success and false otherwise. */
 static int
-t8_msh_file_face_equal (const void *facea, const void *faceb,
-                        const void *data)
-{
-  int                 iv, jv, ret;
-  long                vertex;
-  t8_msh_file_face_t *Face_a, *Face_b;
-
-  Face_a = (t8_msh_file_face_t *) facea;
-  Face_b = (t8_msh_file_face_t *) faceb;
-  /* If both have different number of vertices they can't be equal */
-  ret = Face_a->num_vertices == Face_b->num_vertices;
-  if (!ret) {
+t8_msh_file4_parse_elements (const t8_msh_file_t * file, int dim, int part,
+                             int num_parts, sc_array_t * trees)
+{
+  const char         *pos;
+  long                header[4], block[4], tag;
+  long                first, last, position, ibl, in, offset;
+  t8_msh_file_dtree_t *tree;
+  t8_eclass_t         eclass;
+  int                 i, j, num_nodes;
+
+  pos = t8_msh_file_find_section (file, file->data, "$Elements");
+  if (pos == NULL) {
+    t8_global_errorf ("Could not find the elements in the .msh file\n");
     return 0;
   }
-  /* Check for each vertex of Face_a whether it is a vertex
-   * of Face_b */
-  for (iv = 0; iv < Face_a->num_vertices; iv++) {
-    vertex = Face_a->vertices[iv];
-    ret = 0;
-    for (jv = 0; jv < Face_b->num_vertices; jv++) {
-      ret |= vertex == Face_b->vertices[jv];
+  for (i = 0; i < 4; i++) {
+    if (!t8_msh_file4_read_size (file, &pos, &header[i])) {
+      return 0;
     }
-    /* if vertex was a vertex of Face_b then ret is true here */
-    if (!ret) {
+  }
+  /* The positions of the elements that we parse */
+  first = (long) (((long double) part * header[1]) / num_parts);
+  last = (long) (((long double) (part + 1) * header[1]) / num_parts);
+  for (ibl = 0, position = 0; ibl < header[0] && position < last; ibl++) {
+    for (i = 0; i < 3; i++) {
+      if (!t8_msh_file4_read_int (file, &pos, &block[i])) {
+        return 0;
+      }
+    }
+    if (!t8_msh_file4_read_size (file, &pos, &block[3])) {
+      return 0;
+    }
+    /* block[2] is the element type */
+    if (block[2] > T8_NUM_GMSH_ELEM_CLASSES || block[2] < 0
+        || t8_msh_tree_type_to_eclass[block[2]] == T8_ECLASS_COUNT) {
+      t8_global_errorf ("tree type %li is not supported by t8code.\n",
+                        block[2]);
       return 0;
     }
+    eclass = t8_msh_tree_type_to_eclass[block[2]];
+    num_nodes = t8_eclass_num_vertices[eclass];
+    offset = SC_MAX (first - position, 0);
+    in = SC_MIN (last - position, block[3]);
+    if (offset >= in || t8_eclass_to_dimension[eclass] != dim) {
+      /* Skip this block */
+      if (!t8_msh_file4_skip (file, &pos, block[3] * (1 + num_nodes),
+                              file->data_size)) {
+        return 0;
+      }
+      position += block[3];
+      continue;
+    }
+    if (!t8_msh_file4_skip (file, &pos, offset * (1 + num_nodes),
+                            file->data_size)) {
+      return 0;
+    }
+    for (i = offset; i < in; i++) {
+      tree = (t8_msh_file_dtree_t *) sc_array_push (trees);
+      tree->eclass = eclass;
+      if (!t8_msh_file4_read_size (file, &pos, &tag)) {
+        return 0;
+      }
+      for (j = 0; j < num_nodes; j++) {
+        if (!t8_msh_file4_read_size (file, &pos, &tree->nodes[j])) {
+          return 0;
+        }
+      }
+    }
+    if (!t8_msh_file4_skip (file, &pos, (block[3] - in) * (1 + num_nodes),
+                            file->data_size)) {
+      return 0;
+    }
+    position += block[3];
   }
   return 1;
 }
 
-/* We use this function in a loop over all elements
- * in the hash table, to free the memory of the vertices array */
+/* Compute the vertex coordinates of a tree in t8code order from the nodes,
+ * which are sorted by index. If t8_nodes is not NULL, the node indices in
+ * t8code order are stored in it.
+ * Returns true on success and false if a node does not exist. */
 static int
-t8_msh_file_face_free (void **face, const void *data)
+t8_msh_file_tree_vertices (const t8_msh_file_dtree_t * tree,
+                           sc_array_t * nodes, double *tree_vertices,
+                           long *t8_nodes)
 {
-  t8_msh_file_face_t *Face;
+  t8_eclass_t         eclass = (t8_eclass_t) tree->eclass;
+  t8_msh_file_node_t  lookup, *node;
+  ssize_t             position;
+  double              temp;
+  long                node_index;
+  int                 i, t8_vertex_num;
+  const int           num_nodes = t8_eclass_num_vertices[eclass];
 
-  Face = *(t8_msh_file_face_t **) face;
-  T8_FREE (Face->vertices);
+  for (i = 0; i < num_nodes; i++) {
+    lookup.index = tree->nodes[i];
+    position = sc_array_bsearch (nodes, &lookup,
+                                 t8_msh_file_node_index_compare);
+    if (position < 0) {
+      t8_global_errorf ("Node %li does not exist\n", tree->nodes[i]);
+      return 0;
+    }
+    node = (t8_msh_file_node_t *) sc_array_index (nodes, position);
+    /* Add node coordinates to the tree vertices */
+    t8_vertex_num = t8_msh_tree_vertex_to_t8_vertex_num[eclass][i];
+    tree_vertices[3 * t8_vertex_num] = node->coordinates[0];
+    tree_vertices[3 * t8_vertex_num + 1] = node->coordinates[1];
+    tree_vertices[3 * t8_vertex_num + 2] = node->coordinates[2];
+    if (t8_nodes != NULL) {
+      /* Get the i-th node index in t8code order */
+      t8_nodes[i] = tree->nodes[t8_vertex_to_msh_vertex_num[eclass][i]];
+    }
+  }
+  if (t8_cmesh_tree_vertices_negative_volume (eclass, tree_vertices,
+                                              num_nodes)) {
+    /* The volume described is negative. We need to switch two
+     * vertices. */
+    T8_ASSERT (t8_eclass_to_dimension[eclass] == 3);
+    t8_debugf ("Correcting negative volume of tree %li\n",
+               (long) tree->gtree_id);
+    /* We switch vertex 0 and vertex 1 */
+    for (i = 0; i < 3; i++) {
+      temp = tree_vertices[i];
+      tree_vertices[i] = tree_vertices[3 + i];
+      tree_vertices[3 + i] = temp;
+    }
+    T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
+               (eclass, tree_vertices, num_nodes));
+    if (t8_nodes != NULL) {
+      /* The node indices have to match the vertices */
+      node_index = t8_nodes[0];
+      t8_nodes[0] = t8_nodes[1];
+      t8_nodes[1] = node_index;
+    }
+  }
   return 1;
 }
 
-/* Given a face and a cmesh set the face as a domain boundary.
- * We use this function in a loop over all hashed faces.
- */
+/* Read the nodes and all trees of dimension dim from an opened file,
+ * add the trees to the cmesh and their faces to the array faces of
+ * t8_cmesh_face_key_t.
+ * Returns 0 on success and -1 on failure. */
 static int
-t8_msh_file_face_set_boundary (void **face, const void *data)
+t8_cmesh_msh_file_read (t8_cmesh_t cmesh, const t8_msh_file_t * file,
+                        sc_array_t * faces, int dim)
+{
+  sc_array_t         *nodes, *trees;
+  t8_msh_file_dtree_t *tree;
+  long                markers[T8_MSH_FILE_NUM_MARKERS];
+  double              tree_vertices[24];
+  long                t8_nodes[8];
+  size_t              iz;
+  int                 success;
+
+  nodes = sc_array_new (sizeof (t8_msh_file_node_t));
+  trees = sc_array_new (sizeof (t8_msh_file_dtree_t));
+  if (file->version == 2) {
+    t8_msh_file_find_markers (file, 0, file->size, markers);
+    success = markers[T8_MSH_FILE_END_NODES] != LONG_MAX
+      && markers[T8_MSH_FILE_END_ELEMENTS] != LONG_MAX;
+    if (!success) {
+      t8_global_errorf ("Could not find the nodes and elements in the"
+                        " .msh file\n");
+    }
+    success = success && t8_msh_file2_parse_range (file, dim, 0, file->size,
+                                                   markers, nodes, trees);
+  }
+  else {
+    success = t8_msh_file4_parse_nodes (file, 0, 1, nodes)
+      && t8_msh_file4_parse_elements (file, dim, 0, 1, trees);
+  }
+  t8_debugf ("Read %lu nodes and %lu trees.\n",
+             (unsigned long) nodes->elem_count,
+             (unsigned long) trees->elem_count);
+  sc_array_sort (nodes, t8_msh_file_node_index_compare);
+
+  for (iz = 0; success && iz < trees->elem_count; iz++) {
+    tree = (t8_msh_file_dtree_t *) sc_array_index (trees, iz);
+    tree->gtree_id = iz;
+    success = t8_msh_file_tree_vertices (tree, nodes, tree_vertices,
+                                         t8_nodes);
+    if (success) {
+      t8_cmesh_set_tree_class (cmesh, tree->gtree_id,
+                               (t8_eclass_t) tree->eclass);
+      t8_cmesh_set_tree_vertices (cmesh, tree->gtree_id,
+                                  t8_get_package_id (), 0, tree_vertices,
+                                  t8_eclass_num_vertices[tree->eclass]);
+      t8_cmesh_face_keys_add_tree (faces, tree->gtree_id,
+                                   (t8_eclass_t) tree->eclass, t8_nodes);
+    }
+  }
+  sc_array_destroy (nodes);
+  sc_array_destroy (trees);
+  return success ? 0 : -1;
+}
+
+/* The distributed reader.
+ * Each process reads a byte range of the .msh file and parses the nodes
+ * and the elements whose lines start in this range.  All further steps
+ * are rendezvous algorithms: Data about a node or a face is sent to the
+ * process that is responsible for a range of node indices, is sorted
+ * there and sent back.  No process ever holds the whole mesh. */
+
+/* A request for the coordinates of a node */
+typedef struct
+{
+  long                index;    /* The index of the node */
+  int                 rank;     /* The process that asks for it */
+} t8_msh_file_request_t;
+
+/* A tree that is a ghost of this process */
+typedef struct
 {
-  t8_msh_file_face_t *Face;
-  t8_cmesh_t          cmesh;
   t8_gloidx_t         gtree_id;
+  int                 eclass;
+} t8_msh_file_dghost_t;
 
-  cmesh = (t8_cmesh_t) data;
-  Face = *(t8_msh_file_face_t **) face;
+static int
+t8_msh_file_long_compare (const void *a, const void *b)
+{
+  long                la = *(const long *) a;
+  long                lb = *(const long *) b;
 
-  /* Get the global tree id */
-  gtree_id = Face->ltree_id;
-  /* Set the Face as a domain boundary */
-  t8_cmesh_set_join (cmesh, gtree_id, gtree_id, Face->face_number,
-                     Face->face_number, 0);
-  return 1;
+  return la < lb ? -1 : la > lb;
+}
+
+static int
+t8_msh_file_dghost_compare (const void *a, const void *b)
+{
+  t8_gloidx_t         id_a = ((const t8_msh_file_dghost_t *) a)->gtree_id;
+  t8_gloidx_t         id_b = ((const t8_msh_file_dghost_t *) b)->gtree_id;
+
+  return id_a < id_b ? -1 : id_a > id_b;
+}
+
+/* The maximum number of bytes that a process sends or receives in one
+ * round of t8_msh_file_exchange.  We stay well below INT_MAX, since the
+ * slices of the single messages are rounded up. */
+#define T8_MSH_FILE_EXCHANGE_BYTES (INT_MAX / 2)
+
+/* Send each entry of \a send to the process dest[i] and return the
+ * received entries.  They are ordered by the sending process and
+ * each process' entries keep their order.
+ * MPI counts and displacements are int, thus if any process sends or
+ * receives more than T8_MSH_FILE_EXCHANGE_BYTES, the exchange is split
+ * into rounds. In each round, every message is replaced by the
+ * corresponding equal slice of its entries. */
+static sc_array_t  *
+t8_msh_file_exchange (sc_array_t * send, const int *dest,
+                      sc_MPI_Comm comm, int mpisize)
+{
+  const size_t        elem_size = send->elem_size;
+  sc_array_t         *recv;
+  char               *sendbuf, *round_send, *round_recv;
+  t8_gloidx_t        *send_num, *recv_num;
+  size_t             *send_offset, *recv_offset, *position;
+  int                *send_counts, *send_displs;
+  int                *recv_counts, *recv_displs;
+  size_t              iz, total_send, total_recv;
+  t8_gloidx_t         max_bytes, local_bytes, num_rounds, iround;
+  t8_gloidx_t         first, last;
+  long long           send_pos, recv_pos;
+  int                 irank, mpiret;
+
+  send_num = T8_ALLOC_ZERO (t8_gloidx_t, mpisize);
+  recv_num = T8_ALLOC (t8_gloidx_t, mpisize);
+  send_offset = T8_ALLOC (size_t, mpisize);
+  recv_offset = T8_ALLOC (size_t, mpisize);
+  position = T8_ALLOC (size_t, mpisize);
+  send_counts = T8_ALLOC (int, mpisize);
+  send_displs = T8_ALLOC (int, mpisize);
+  recv_counts = T8_ALLOC (int, mpisize);
+  recv_displs = T8_ALLOC (int, mpisize);
+  /* Count the entries for each process */
+  for (iz = 0; iz < send->elem_count; iz++) {
+    T8_ASSERT (0 <= dest[iz] && dest[iz] < mpisize);
+    send_num[dest[iz]]++;
+  }
+  for (irank = 0, total_send = 0; irank < mpisize; irank++) {
+    send_offset[irank] = position[irank] = total_send;
+    total_send += send_num[irank];
+  }
+  /* Sort the entries by destination */
+  sendbuf = T8_ALLOC (char, total_send * elem_size + 1);
+  for (iz = 0; iz < send->elem_count; iz++) {
+    memcpy (sendbuf + position[dest[iz]] * elem_size,
+            sc_array_index (send, iz), elem_size);
+    position[dest[iz]]++;
+  }
+  mpiret = sc_MPI_Alltoall (send_num, 1, T8_MPI_GLOIDX, recv_num, 1,
+                            T8_MPI_GLOIDX, comm);
+  SC_CHECK_MPI (mpiret);
+  for (irank = 0, total_recv = 0; irank < mpisize; irank++) {
+    recv_offset[irank] = total_recv;
+    total_recv += recv_num[irank];
+  }
+  recv = sc_array_new_count (elem_size, total_recv);
+
+  /* Compute the number of rounds */
+  local_bytes = (t8_gloidx_t) (SC_MAX (total_send, total_recv) * elem_size);
+  mpiret = sc_MPI_Allreduce (&local_bytes, &max_bytes, 1, T8_MPI_GLOIDX,
+                             sc_MPI_MAX, comm);
+  SC_CHECK_MPI (mpiret);
+  num_rounds = SC_MAX (1, (max_bytes + T8_MSH_FILE_EXCHANGE_BYTES - 1)
+                       / T8_MSH_FILE_EXCHANGE_BYTES);
+  if (num_rounds == 1) {
+    /* Everything fits into one message, we do not need to copy */
+    round_send = sendbuf;
+    round_recv = (char *) recv->array;
+  }
+  else {
+    t8_debugf ("msh reader: exchanging %lli bytes in %lli rounds\n",
+               (long long) max_bytes, (long long) num_rounds);
+    round_send = T8_ALLOC (char, max_bytes / num_rounds
+                           + mpisize * elem_size + 1);
+    round_recv = T8_ALLOC (char, max_bytes / num_rounds
+                           + mpisize * elem_size + 1);
+  }
+
+  for (iround = 0; iround < num_rounds; iround++) {
+    /* Pack this round's slice of the entries for each process */
+    for (irank = 0, send_pos = 0; irank < mpisize; irank++) {
+      first = send_num[irank] * iround / num_rounds;
+      last = send_num[irank] * (iround + 1) / num_rounds;
+      send_counts[irank] = (int) ((last - first) * elem_size);
+      send_displs[irank] = (int) send_pos;
+      if (num_rounds > 1) {
+        memcpy (round_send + send_pos,
+                sendbuf + (send_offset[irank] + first) * elem_size,
+                send_counts[irank]);
+      }
+      send_pos += send_counts[irank];
+      SC_CHECK_ABORT (send_pos <= INT_MAX,
+                      "msh reader: message exceeds 2 GiB");
+    }
+    for (irank = 0, recv_pos = 0; irank < mpisize; irank++) {
+      first = recv_num[irank] * iround / num_rounds;
+      last = recv_num[irank] * (iround + 1) / num_rounds;
+      recv_counts[irank] = (int) ((last - first) * elem_size);
+      recv_displs[irank] = (int) recv_pos;
+      recv_pos += recv_counts[irank];
+      SC_CHECK_ABORT (recv_pos <= INT_MAX,
+                      "msh reader: message exceeds 2 GiB");
+    }
+    mpiret = sc_MPI_Alltoallv (round_send, send_counts, send_displs,
+                               sc_MPI_BYTE, round_recv, recv_counts,
+                               recv_displs, sc_MPI_BYTE, comm);
+    SC_CHECK_MPI (mpiret);
+    if (num_rounds > 1) {
+      /* Unpack the received slices */
+      for (irank = 0; irank < mpisize; irank++) {
+        first = recv_num[irank] * iround / num_rounds;
+        memcpy ((char *) recv->array + (recv_offset[irank] + first)
+                * elem_size, round_recv + recv_displs[irank],
+                recv_counts[irank]);
+      }
+    }
+  }
+
+  if (num_rounds > 1) {
+    T8_FREE (round_send);
+    T8_FREE (round_recv);
+  }
+  T8_FREE (sendbuf);
+  T8_FREE (send_num);
+  T8_FREE (recv_num);
+  T8_FREE (send_offset);
+  T8_FREE (recv_offset);
+  T8_FREE (position);
+  T8_FREE (send_counts);
+  T8_FREE (send_displs);
+  T8_FREE (recv_counts);
+  T8_FREE (recv_displs);
+  return recv;
+}
+
+/* The process that is responsible for a node index in the rendezvous
+ * steps. The index range [min_index, max_index] is split evenly. */
+static int
+t8_msh_file_index_owner (long index, long min_index, long max_index,
+                         int mpisize)
+{
+  int                 owner;
+
+  T8_ASSERT (min_index <= index && index <= max_index);
+  owner = (int) (((long double) (index - min_index) * mpisize)
+                 / ((long double) max_index - min_index + 1));
+  return SC_MIN (owner, mpisize - 1);
 }
 
-/* Given two faces and the classes of their volume trees,
- * compute the orientation of the faces to each other */
+/* The first tree of a process in the uniform partition of the trees */
+static              t8_gloidx_t
+t8_msh_file_first_tree (int rank, t8_gloidx_t num_trees, int mpisize)
+{
+  return (t8_gloidx_t) (((long double) rank * num_trees) / mpisize);
+}
+
+/* The process that owns a tree in the uniform partition of the trees */
 static int
-t8_msh_file_face_orientation (t8_msh_file_face_t * Face_a,
-                              t8_msh_file_face_t * Face_b,
-                              t8_eclass_t tree_class_a,
-                              t8_eclass_t tree_class_b)
-{
-  long                vertex_zero;      /* The number of the first vertex of the smaller face */
-  t8_msh_file_face_t *smaller_Face, *bigger_Face;
-  int                 compare, iv;
-  t8_eclass_t         bigger_class;
-  int                 orientation = -1;
-
-  compare = t8_eclass_compare (tree_class_a, tree_class_b);
-  if (compare > 0) {
-    /* tree_class_a is bigger than tree_class_b */
-    smaller_Face = Face_b;
-    bigger_Face = Face_a;
-    bigger_class =
-      (t8_eclass_t) t8_eclass_face_types[tree_class_a][Face_a->face_number];
-  }
-  else if (compare < 0) {
-    /* tree_class_a is smaller than tree_class_b */
-    smaller_Face = Face_a;
-    bigger_Face = Face_b;
-    bigger_class =
-      (t8_eclass_t) t8_eclass_face_types[tree_class_b][Face_b->face_number];
+t8_msh_file_tree_owner (t8_gloidx_t gtree_id, t8_gloidx_t num_trees,
+                        int mpisize)
+{
+  int                 owner;
+
+  T8_ASSERT (0 <= gtree_id && gtree_id < num_trees);
+  owner = (int) (((long double) gtree_id * mpisize) / num_trees);
+  owner = SC_MIN (owner, mpisize - 1);
+  /* Correct rounding errors */
+  while (owner > 0
+         && gtree_id < t8_msh_file_first_tree (owner, num_trees, mpisize)) {
+    owner--;
+  }
+  while (owner < mpisize - 1
+         && gtree_id >= t8_msh_file_first_tree (owner + 1, num_trees,
+                                                mpisize)) {
+    owner++;
+  }
+  return owner;
+}
+
+/* Read a .msh file with all processes of comm and create a cmesh that is
+ * partitioned uniformly by trees.  Returns NULL on failure. */
+static              t8_cmesh_t
+t8_cmesh_from_msh_file_distributed (const char *fileprefix,
+                                    sc_MPI_Comm comm, int dim)
+{
+  t8_cmesh_t          cmesh;
+  char                current_file[BUFSIZ];
+  t8_msh_file_t       file;
+  size_t              range_start, range_end;
+  long                local_markers[T8_MSH_FILE_NUM_MARKERS];
+  long                markers[T8_MSH_FILE_NUM_MARKERS];
+  long                local_range[2], index_range[2];
+  sc_array_t         *nodes, *trees, *recv, *indices, *requests, *replies;
+  sc_array_t         *faces, *joins, *matches, *ghosts;
+  t8_msh_file_node_t *node, lookup;
+  t8_msh_file_dtree_t *tree;
+  t8_msh_file_request_t *request;
+  t8_cmesh_face_key_t *face;
+  t8_cmesh_face_join_t *join, *match;
+  t8_msh_file_dghost_t *dghost;
+  t8_gloidx_t         num_local_trees, first_tree, last_tree, num_trees;
+  t8_eclass_t         eclass;
+  double              tree_vertices[24];
+  long                t8_nodes[8];
+  ssize_t             position;
+  size_t              iz;
+  int                *dest;
+  int                 mpirank, mpisize, mpiret;
+  int                 success, global_success;
+  int                 i;
+  int                 owner;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+
+  snprintf (current_file, BUFSIZ, "%s.msh", fileprefix);
+  /* Each process maps the file, but only touches its part of it */
+  success = !t8_msh_file_open (current_file, &file);
+  if (!success) {
+    t8_errorf ("Could not open file %s\n", current_file);
+  }
+  else if (!file.mapped && mpisize > 1) {
+    t8_global_infof ("Could not map file %s into memory. Each process"
+                     " reads the whole file.\n", current_file);
+  }
+  else if (t8_msh_file_read_format (&file)) {
+    t8_msh_file_close (&file);
+    success = 0;
+  }
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  if (!global_success) {
+    if (success) {
+      t8_msh_file_close (&file);
+    }
+    t8_global_errorf ("Could not read file %s\n", current_file);
+    return NULL;
+  }
+
+  t8_debugf ("Reading file %s in parallel\n", current_file);
+  nodes = sc_array_new (sizeof (t8_msh_file_node_t));
+  trees = sc_array_new (sizeof (t8_msh_file_dtree_t));
+  if (file.version == 2) {
+    /* Each process parses the lines that start in its part of the file.
+     * Each process searches its lines for the section markers
+     * and the minimum offset over all processes is the marker. */
+    range_start = ((long double) mpirank * file.size) / mpisize;
+    range_end = ((long double) (mpirank + 1) * file.size) / mpisize;
+    t8_msh_file_find_markers (&file, range_start, range_end, local_markers);
+    mpiret = sc_MPI_Allreduce (local_markers, markers,
+                               T8_MSH_FILE_NUM_MARKERS, sc_MPI_LONG,
+                               sc_MPI_MIN, comm);
+    SC_CHECK_MPI (mpiret);
+    success = markers[T8_MSH_FILE_END_NODES] != LONG_MAX
+      && markers[T8_MSH_FILE_END_ELEMENTS] != LONG_MAX;
+    if (!success) {
+      t8_global_errorf ("Could not find the nodes and elements in file %s\n",
+                        current_file);
+    }
+    success = success
+      && t8_msh_file2_parse_range (&file, dim, range_start, range_end,
+                                   markers, nodes, trees);
   }
   else {
-    /* both classes are the same, thus
-     * the face with the smaller tree id is the smaller one */
-    if (Face_a->ltree_id < Face_b->ltree_id) {
-      smaller_Face = Face_a;
-      bigger_Face = Face_b;
-      bigger_class =
-        (t8_eclass_t) t8_eclass_face_types[tree_class_b][Face_b->face_number];
+    /* Each process parses its share of the nodes and elements */
+    success = t8_msh_file4_parse_nodes (&file, mpirank, mpisize, nodes)
+      && t8_msh_file4_parse_elements (&file, dim, mpirank, mpisize, trees);
+  }
+  t8_msh_file_close (&file);
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  if (!global_success) {
+    t8_global_errorf ("Error reading file %s\n", current_file);
+    sc_array_destroy (nodes);
+    sc_array_destroy (trees);
+    return NULL;
+  }
+
+  /* The trees are numbered in the order of the file */
+  num_local_trees = trees->elem_count;
+  mpiret = sc_MPI_Exscan (&num_local_trees, &first_tree, 1, T8_MPI_GLOIDX,
+                          sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    first_tree = 0;
+  }
+  mpiret = sc_MPI_Allreduce (&num_local_trees, &num_trees, 1, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Send the trees to their process in the uniform partition */
+  dest = T8_ALLOC (int, trees->elem_count);
+  for (iz = 0; iz < trees->elem_count; iz++) {
+    tree = (t8_msh_file_dtree_t *) sc_array_index (trees, iz);
+    tree->gtree_id = first_tree + iz;
+    dest[iz] = t8_msh_file_tree_owner (tree->gtree_id, num_trees, mpisize);
+  }
+  recv = t8_msh_file_exchange (trees, dest, comm, mpisize);
+  T8_FREE (dest);
+  sc_array_destroy (trees);
+  trees = recv;
+  first_tree = t8_msh_file_first_tree (mpirank, num_trees, mpisize);
+  last_tree = t8_msh_file_first_tree (mpirank + 1, num_trees, mpisize) - 1;
+  T8_ASSERT ((t8_gloidx_t) trees->elem_count == last_tree - first_tree + 1);
+
+  /* Send the nodes to the processes responsible for their index range.
+   * We store the negative maximum to compute both with one reduction. */
+  local_range[0] = local_range[1] = LONG_MAX;
+  for (iz = 0; iz < nodes->elem_count; iz++) {
+    node = (t8_msh_file_node_t *) sc_array_index (nodes, iz);
+    local_range[0] = SC_MIN (local_range[0], node->index);
+    local_range[1] = SC_MIN (local_range[1], -node->index);
+  }
+  mpiret = sc_MPI_Allreduce (local_range, index_range, 2, sc_MPI_LONG,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  index_range[1] = -index_range[1];
+  if (index_range[0] > index_range[1]) {
+    /* There are no nodes */
+    index_range[0] = index_range[1] = 0;
+  }
+  dest = T8_ALLOC (int, nodes->elem_count);
+  for (iz = 0; iz < nodes->elem_count; iz++) {
+    node = (t8_msh_file_node_t *) sc_array_index (nodes, iz);
+    dest[iz] = t8_msh_file_index_owner (node->index, index_range[0],
+                                        index_range[1], mpisize);
+  }
+  recv = t8_msh_file_exchange (nodes, dest, comm, mpisize);
+  T8_FREE (dest);
+  sc_array_destroy (nodes);
+  nodes = recv;
+  sc_array_sort (nodes, t8_msh_file_node_index_compare);
+
+  /* Request the coordinates of the nodes of our trees */
+  indices = sc_array_new (sizeof (long));
+  for (iz = 0; iz < trees->elem_count; iz++) {
+    tree = (t8_msh_file_dtree_t *) sc_array_index (trees, iz);
+    for (i = 0; i < t8_eclass_num_vertices[tree->eclass]; i++) {
+      *(long *) sc_array_push (indices) = tree->nodes[i];
+    }
+  }
+  sc_array_sort (indices, t8_msh_file_long_compare);
+  sc_array_uniq (indices, t8_msh_file_long_compare);
+  requests = sc_array_new_count (sizeof (t8_msh_file_request_t),
+                                 indices->elem_count);
+  dest = T8_ALLOC (int, indices->elem_count);
+  for (iz = 0; iz < indices->elem_count; iz++) {
+    request = (t8_msh_file_request_t *) sc_array_index (requests, iz);
+    request->index = *(long *) sc_array_index (indices, iz);
+    request->rank = mpirank;
+    if (request->index < index_range[0] || request->index > index_range[1]) {
+      t8_errorf ("Node %li does not exist\n", request->index);
+      success = 0;
+      request->index = index_range[0];
+    }
+    dest[iz] = t8_msh_file_index_owner (request->index, index_range[0],
+                                        index_range[1], mpisize);
+  }
+  sc_array_destroy (indices);
+  recv = t8_msh_file_exchange (requests, dest, comm, mpisize);
+  T8_FREE (dest);
+  sc_array_destroy (requests);
+  requests = recv;
+
+  /* Answer the requests that we received */
+  replies = sc_array_new_count (sizeof (t8_msh_file_node_t),
+                                requests->elem_count);
+  dest = T8_ALLOC (int, requests->elem_count);
+  for (iz = 0; iz < requests->elem_count; iz++) {
+    request = (t8_msh_file_request_t *) sc_array_index (requests, iz);
+    node = (t8_msh_file_node_t *) sc_array_index (replies, iz);
+    lookup.index = request->index;
+    position = sc_array_bsearch (nodes, &lookup,
+                                 t8_msh_file_node_index_compare);
+    if (position < 0) {
+      t8_errorf ("Node %li does not exist\n", request->index);
+      success = 0;
+      memset (node, 0, sizeof (*node));
+      node->index = request->index;
     }
     else {
-      smaller_Face = Face_b;
-      bigger_Face = Face_a;
-      bigger_class =
-        (t8_eclass_t) t8_eclass_face_types[tree_class_a][Face_a->face_number];
+      *node = *(t8_msh_file_node_t *) sc_array_index (nodes, position);
     }
+    dest[iz] = request->rank;
   }
-  vertex_zero = smaller_Face->vertices[0];
-  /* Find which point in the bigger face is vertex_zero */
-  for (iv = 0; iv < t8_eclass_num_vertices[bigger_class]; iv++) {
-    if (vertex_zero == bigger_Face->vertices[iv]) {
-      /* We found the corresponding vertex */
-      orientation = iv;
-      /* set condition to break the loop */
-      iv = t8_eclass_num_vertices[bigger_class];
+  sc_array_destroy (nodes);
+  sc_array_destroy (requests);
+  recv = t8_msh_file_exchange (replies, dest, comm, mpisize);
+  T8_FREE (dest);
+  sc_array_destroy (replies);
+  replies = recv;
+  sc_array_sort (replies, t8_msh_file_node_index_compare);
+
+  /* Create the local trees and their faces */
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_dimension (cmesh, dim);
+  faces = sc_array_new (sizeof (t8_cmesh_face_key_t));
+  for (iz = 0; iz < trees->elem_count; iz++) {
+    tree = (t8_msh_file_dtree_t *) sc_array_index (trees, iz);
+    T8_ASSERT (tree->gtree_id == first_tree + (t8_gloidx_t) iz);
+    eclass = (t8_eclass_t) tree->eclass;
+    t8_cmesh_set_tree_class (cmesh, tree->gtree_id, eclass);
+    if (!t8_msh_file_tree_vertices (tree, replies, tree_vertices, t8_nodes)) {
+      /* A node does not exist, we already reported this */
+      T8_ASSERT (!success);
+      memset (tree_vertices, 0, sizeof (tree_vertices));
+      memset (t8_nodes, 0, sizeof (t8_nodes));
     }
+    t8_cmesh_set_tree_vertices (cmesh, tree->gtree_id, t8_get_package_id (),
+                                0, tree_vertices,
+                                t8_eclass_num_vertices[eclass]);
+    t8_cmesh_face_keys_add_tree (faces, tree->gtree_id, eclass, t8_nodes);
   }
-  T8_ASSERT (orientation >= 0);
-  return orientation;
-}
+  sc_array_destroy (replies);
 
-/* Given the number of vertices and for each element a list of its
- * vertices, find the neighborship relations of each element */
-/* This routine does only find neighbors between local trees.
- * Use with care if cmesh is partitioned. */
-static void
-t8_cmesh_msh_file_find_neighbors (t8_cmesh_t cmesh,
-                                  sc_array_t * vertex_indices)
-{
-  sc_hash_t          *faces;
-  t8_msh_file_face_t *Face, **pNeighbor, *Neighbor;
-  sc_mempool_t       *face_mempool;
-  t8_gloidx_t         gtree_it;
-  t8_gloidx_t         gtree_id, gtree_neighbor;
-  t8_eclass_t         eclass, face_class, neighbor_tclass;
-  int                 num_face_vertices, face_it, vertex_it;
-  int                 retval, orientation;
-  long               *tree_vertices;
-  t8_stash_class_struct_t *class_entry;
-
-  face_mempool = sc_mempool_new (sizeof (t8_msh_file_face_t));
-  faces = sc_hash_new (t8_msh_file_face_hash, t8_msh_file_face_equal,
-                       cmesh, NULL);
-
-  /* TODO: Does currently not work with partitioned cmesh */
-  T8_ASSERT (!cmesh->set_partition);
-  /* The cmesh is not allowed to be committed yet */
-  T8_ASSERT (t8_cmesh_is_initialized (cmesh));
-  t8_debugf ("Starting to find tree neighbors\n");
-  /* Iterate over all local trees */
-  for (gtree_it = 0;
-       gtree_it < (t8_gloidx_t) cmesh->stash->classes.elem_count;
-       gtree_it++) {
-    /* We get the class of the current tree.
-     * Since we know that the trees were put into the stash in order
-     * of their tree id's, we can just read the correspoding entry from
-     * the stash.
-     * !WARNING: This does not work in general to find the class of a tree
-     *    since the order in which the trees are added to the stash is arbitrary.
-     *    Use t8_stash_class_bsearch in tat case.
-     */
-    class_entry = (t8_stash_class_struct_t *)
-      t8_sc_array_index_locidx (&cmesh->stash->classes, gtree_it);
-    T8_ASSERT (class_entry->id == gtree_it);
-    eclass = class_entry->eclass;
-    /* Get the vertices of that tree */
-    tree_vertices = *(long **) t8_sc_array_index_locidx (vertex_indices,
-                                                         gtree_it);
-    /* loop over all faces of the tree */
-    for (face_it = 0; face_it < t8_eclass_num_faces[eclass]; face_it++) {
-      /* Create the Face struct */
-      Face = (t8_msh_file_face_t *) sc_mempool_alloc (face_mempool);
-      /* Get its eclass and the number of vertices */
-      face_class = (t8_eclass_t) t8_eclass_face_types[eclass][face_it];
-      num_face_vertices = t8_eclass_num_vertices[face_class];
-      Face->vertices = T8_ALLOC (long, num_face_vertices);
-      Face->num_vertices = num_face_vertices;
-      Face->ltree_id = gtree_it;
-      Face->face_number = face_it;
-      /* Copy the vertices of the face to the face struct */
-      for (vertex_it = 0; vertex_it < num_face_vertices; vertex_it++) {
-        Face->vertices[vertex_it] =
-          tree_vertices[t8_face_vertex_to_tree_vertex[eclass][face_it]
-                        [vertex_it]];
-      }
-      /* Try to insert the face into the hash */
-      retval = sc_hash_insert_unique (faces, Face, (void ***) &pNeighbor);
-      if (!retval) {
-        /* The face was already in the hash */
-        Neighbor = *pNeighbor;
-        T8_ASSERT (Neighbor->ltree_id != gtree_it);
-        /* The current tree is a neighbor to the tree Neighbor->ltree_id */
-        /* We need to identify the face number and the orientation */
-        gtree_id = gtree_it;
-        gtree_neighbor = Neighbor->ltree_id;
-        /* Compute the orientation of the face connection */
-        /* Get the element class of the neighbor tree */
-        class_entry = (t8_stash_class_struct_t *)
-          t8_sc_array_index_locidx (&cmesh->stash->classes,
-                                    Neighbor->ltree_id);
-        T8_ASSERT (class_entry->id == Neighbor->ltree_id);
-        neighbor_tclass = class_entry->eclass;
-        /* Calculate the orientation */
-        orientation = t8_msh_file_face_orientation (Face, Neighbor, eclass,
-                                                    neighbor_tclass);
-        /* Set the face connection */
-        t8_cmesh_set_join (cmesh, gtree_id, gtree_neighbor, face_it,
-                           Neighbor->face_number, orientation);
-        T8_FREE (Face->vertices);
-        sc_mempool_free (face_mempool, Face);
-        /* We can free the neighbor here as well */
-        sc_hash_remove (faces, Neighbor, NULL);
-        T8_FREE (Neighbor->vertices);
-        sc_mempool_free (face_mempool, Neighbor);
-      }
+  /* Send the faces to the process responsible for their smallest vertex.
+   * There, faces with equal vertices are adjacent after sorting. */
+  dest = T8_ALLOC (int, faces->elem_count);
+  for (iz = 0; iz < faces->elem_count; iz++) {
+    face = (t8_cmesh_face_key_t *) sc_array_index (faces, iz);
+    dest[iz] = t8_msh_file_index_owner (SC_MAX (face->key[0],
+                                                index_range[0]),
+                                        index_range[0], index_range[1],
+                                        mpisize);
+  }
+  recv = t8_msh_file_exchange (faces, dest, comm, mpisize);
+  T8_FREE (dest);
+  sc_array_destroy (faces);
+  faces = recv;
+  t8_cmesh_face_keys_sort (faces);
+
+  /* Match the faces and send the connections to the owners of the trees.
+   * As in the serial reader, faces without a neighbor are connected to
+   * themselves to mark them as domain boundaries. */
+  matches = sc_array_new (sizeof (t8_cmesh_face_join_t));
+  t8_cmesh_face_keys_match (faces, matches, 1);
+  joins = sc_array_new (sizeof (t8_cmesh_face_join_t));
+  dest = T8_ALLOC (int, 2 * matches->elem_count);
+  for (iz = 0; iz < matches->elem_count; iz++) {
+    match = (t8_cmesh_face_join_t *) sc_array_index (matches, iz);
+    join = (t8_cmesh_face_join_t *) sc_array_push (joins);
+    *join = *match;
+    owner = t8_msh_file_tree_owner (match->gtree_id, num_trees, mpisize);
+    dest[joins->elem_count - 1] = owner;
+    if (t8_msh_file_tree_owner (match->neighbor, num_trees, mpisize)
+        != owner) {
+      /* The owner of the neighbor needs the connection as well */
+      join = (t8_cmesh_face_join_t *) sc_array_push (joins);
+      join->gtree_id = match->neighbor;
+      join->neighbor = match->gtree_id;
+      join->face_number = match->neighbor_face;
+      join->neighbor_face = match->face_number;
+      join->orientation = match->orientation;
+      join->eclass = match->neighbor_eclass;
+      join->neighbor_eclass = match->eclass;
+      dest[joins->elem_count - 1] =
+        t8_msh_file_tree_owner (match->neighbor, num_trees, mpisize);
+    }
+  }
+  sc_array_destroy (matches);
+  sc_array_destroy (faces);
+  recv = t8_msh_file_exchange (joins, dest, comm, mpisize);
+  T8_FREE (dest);
+  sc_array_destroy (joins);
+  joins = recv;
+
+  /* Set the face connections. The trees across process boundaries are
+   * the ghosts of this process. */
+  ghosts = sc_array_new (sizeof (t8_msh_file_dghost_t));
+  for (iz = 0; iz < joins->elem_count; iz++) {
+    join = (t8_cmesh_face_join_t *) sc_array_index (joins, iz);
+    T8_ASSERT (first_tree <= join->gtree_id && join->gtree_id <= last_tree);
+    t8_cmesh_set_join (cmesh, join->gtree_id, join->neighbor,
+                       join->face_number, join->neighbor_face,
+                       join->orientation);
+    if (join->neighbor < first_tree || join->neighbor > last_tree) {
+      dghost = (t8_msh_file_dghost_t *) sc_array_push (ghosts);
+      dghost->gtree_id = join->neighbor;
+      dghost->eclass = join->neighbor_eclass;
     }
   }
-  /* The remaining faces are domain boundaries */
-  sc_hash_foreach (faces, t8_msh_file_face_set_boundary);
-  /* Free the faces and the hash */
-  sc_hash_foreach (faces, t8_msh_file_face_free);
-  sc_mempool_destroy (face_mempool);
-  sc_hash_destroy (faces);
-  t8_debugf ("Done finding tree neighbors.\n");
+  sc_array_destroy (joins);
+  sc_array_sort (ghosts, t8_msh_file_dghost_compare);
+  sc_array_uniq (ghosts, t8_msh_file_dghost_compare);
+  for (iz = 0; iz < ghosts->elem_count; iz++) {
+    dghost = (t8_msh_file_dghost_t *) sc_array_index (ghosts, iz);
+    t8_cmesh_set_tree_class (cmesh, dghost->gtree_id,
+                             (t8_eclass_t) dghost->eclass);
+  }
+  sc_array_destroy (ghosts);
+  sc_array_destroy (trees);
+
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  if (!global_success) {
+    t8_global_errorf ("Error reading file %s\n", current_file);
+    t8_cmesh_destroy (&cmesh);
+    return NULL;
+  }
+  t8_cmesh_set_partition_range (cmesh, 3, first_tree, last_tree);
+  t8_cmesh_commit (cmesh, comm);
+  t8_debugf ("Read %lli trees in parallel.\n", (long long) num_trees);
+  return cmesh;
 }
 
 t8_cmesh_t
@@ -703,13 +1644,10 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
 {
   int                 mpirank, mpisize, mpiret;
   t8_cmesh_t          cmesh;
-  sc_hash_t          *vertices;
-  t8_locidx_t         num_vertices;
-  sc_mempool_t       *node_mempool = NULL;
-  sc_array_t         *vertex_indices;
-  long               *indices_entry;
+  sc_array_t         *faces;
   char                current_file[BUFSIZ];
-  FILE               *file;
+  t8_msh_file_t       file;
+  int                 retval;
   t8_gloidx_t         num_trees, first_tree, last_tree = -1;
 
   mpiret = sc_MPI_Comm_size (comm, &mpisize);
@@ -717,10 +1655,11 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
   mpiret = sc_MPI_Comm_rank (comm, &mpirank);
   SC_CHECK_MPI (mpiret);
 
-  /* TODO: implement partitioned input using gmesh's
-   * partitioned files.
-   * Or using a single file and computing the partition on the run. */
-  T8_ASSERT (partition == 0 || (master >= 0 && master < mpisize));
+  T8_ASSERT (partition == 0 || master < mpisize);
+  if (partition && master < 0) {
+    /* All processes read a part of the file */
+    return t8_cmesh_from_msh_file_distributed (fileprefix, comm, dim);
+  }
 
   /* initialize cmesh structure */
   t8_cmesh_init (&cmesh);
@@ -732,26 +1671,28 @@ t8_cmesh_from_msh_file (const char *fileprefix, int partition,
     snprintf (current_file, BUFSIZ, "%s.msh", fileprefix);
     /* Open the file */
     t8_debugf ("Opening file %s\n", current_file);
-    file = fopen (current_file, "r");
-    if (file == NULL) {
+    if (t8_msh_file_open (current_file, &file)) {
       t8_global_errorf ("Could not open file %s\n", current_file);
+      t8_cmesh_destroy (&cmesh);
+      return NULL;
+    }
+    /* read the nodes and the trees from the file */
+    faces = sc_array_new (sizeof (t8_cmesh_face_key_t));
+    retval = t8_msh_file_read_format (&file)
+      || t8_cmesh_msh_file_read (cmesh, &file, faces, dim);
+    /* close the file */
+    t8_msh_file_close (&file);
+    if (!retval) {
+      /* Find the face connections, faces without a neighbor
+       * are set as domain boundaries */
+      t8_cmesh_face_match (cmesh, faces, 1);
+    }
+    sc_array_destroy (faces);
+    if (retval) {
+      t8_global_errorf ("Could not read file %s\n", current_file);
+      t8_cmesh_destroy (&cmesh);
       return NULL;
     }
-    /* read nodes from the file */
-    vertices = t8_msh_file_read_nodes (file, &num_vertices, &node_mempool);
-    t8_cmesh_msh_file_read_eles (cmesh, file, vertices, &vertex_indices, dim);
-    /* close the file and free the memory for the nodes */
-    fclose (file);
-    t8_cmesh_msh_file_find_neighbors (cmesh, vertex_indices);
-    if (vertices != NULL) {
-      sc_hash_destroy (vertices);
-    }
-    sc_mempool_destroy (node_mempool);
-    while (vertex_indices->elem_count > 0) {
-      indices_entry = *(long **) sc_array_pop (vertex_indices);
-      T8_FREE (indices_entry);
-    }
-    sc_array_destroy (vertex_indices);
   }
   if (partition) {
     /* The cmesh is not yet committed, since we set the partitioning before */
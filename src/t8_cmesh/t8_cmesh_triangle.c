@@ -25,15 +25,12 @@
 #include <t8_cmesh_vtk.h>
 #include "t8_cmesh_types.h"
 #include "t8_cmesh_stash.h"
+#include "t8_cmesh_face_match.h"
 
 /* TODO: if partitioned then only add the needed face-connections to join faces
  *       maybe also only trees and ghosts to classes.
  *       Specifying all face-connections makes commit algorithm slow! */
 
-/* TODO: eventually compute neighbours only from .node and .ele files, since
- *       creating .neigh files with tetgen/triangle is not common and even seems
- *       to not work sometimes */
-
 /* Read a the next line from a file stream that does not start with '#' or
  * contains only whitespaces (tabs etc.)
  *
@@ -177,16 +174,13 @@ die_node:
 }
 
 /* Open .ele file and read element input
+ * The faces of the elements are added to faces to find their neighbors.
  * On succes the index of the first element is returned (0 or 1).
  * On failure -1 is returned. */
-/* TODO: We can use this file to scan for the neighbors as well
- *       for each node create a list of all nodes (with smaller index)
- *       that it shares a face with. And for each triangle face, look-up
- *       in this list.
- */
 static int
 t8_cmesh_triangle_read_eles (t8_cmesh_t cmesh, int corner_offset,
-                             char *filename, double *vertices, int dim
+                             char *filename, double *vertices,
+                             sc_array_t * faces, int dim
 #ifdef T8_ENABLE_DEBUG
                              , long num_vertices
 #endif
@@ -279,6 +273,7 @@ t8_cmesh_triangle_read_eles (t8_cmesh_t cmesh, int corner_offset,
       /* The volume described is negative. We need to switch two
        * vertices. */
       double              temp;
+      long                temp_corner;
 
       T8_ASSERT (dim == 3);
       t8_debugf ("Correcting negative volume of tree %li\n",
@@ -291,10 +286,17 @@ t8_cmesh_triangle_read_eles (t8_cmesh_t cmesh, int corner_offset,
       }
       T8_ASSERT (!t8_cmesh_tree_vertices_negative_volume
                  (T8_ECLASS_TET, tree_vertices, dim + 1));
+      /* The corner indices have to match the vertices */
+      temp_corner = tcorners[0];
+      tcorners[0] = tcorners[1];
+      tcorners[1] = temp_corner;
     }
     t8_cmesh_set_tree_vertices (cmesh, triangle - triangle_offset,
                                 t8_get_package_id (), 0,
                                 tree_vertices, dim + 1);
+    t8_cmesh_face_keys_add_tree (faces, triangle - triangle_offset,
+                                 dim == 2 ? T8_ECLASS_TRIANGLE :
+                                 T8_ECLASS_TET, tcorners);
   }
   fclose (fp);
   T8_FREE (vertices);
@@ -312,154 +314,6 @@ die_ele:
   return -1;
 }
 
-/* Open .neigh file and read element neighbor information
- * On success 0 is returned.
- * On failure -1 is returned. */
-static int
-t8_cmesh_triangle_read_neigh (t8_cmesh_t cmesh, int element_offset,
-                              char *filename, int dim)
-{
-  FILE               *fp;
-  char               *line = (char *) malloc (1024);
-  size_t              linen = 1024;
-  t8_locidx_t         element, num_elems, tit;
-  t8_locidx_t        *tneighbors;
-  int                 retval;
-  int                 temp;
-  int                 orientation = 0, face1, face2;
-  int                 num_read;
-  const int           num_faces = dim + 1;
-  double             *el_vertices1, *el_vertices2;
-  int                 ivertex, firstvertex;
-
-  /* Open .neigh file and read face neighbor information */
-  T8_ASSERT (filename != NULL);
-  T8_ASSERT (dim == 2 || dim == 3);
-  fp = fopen (filename, "r");
-  if (fp == NULL) {
-    t8_global_errorf ("Failed to open %s.\n", filename);
-    goto die_neigh;
-  }
-  /* read first non-comment line from .ele file */
-  retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-  if (retval < 0) {
-    t8_global_errorf ("Failed to read first line from %s.\n", filename);
-    goto die_neigh;
-  }
-  retval = sscanf (line, "%i %i", &num_elems, &temp);
-  if (retval != 2) {
-    t8_global_errorf ("Premature end of line in   %s.\n", filename);
-    goto die_neigh;
-  }
-  T8_ASSERT (temp == dim + 1);
-
-  tneighbors = T8_ALLOC (t8_locidx_t, num_elems * num_faces);
-
-  /* We read all the neighbors and write them into an array.
-   * Since TRIANGLE provides us for each triangle and each face with
-   * which triangle ist is connected, we still need to find
-   * out with which face of this triangle it is connected. */
-  for (tit = 0; tit < num_elems; tit++) {
-    retval = t8_cmesh_triangle_read_next_line (&line, &linen, fp);
-    if (retval < 0) {
-      t8_global_errorf ("Failed to read line from %s.\n", filename);
-      goto die_neigh;
-    }
-    retval =
-      sscanf (line, "%i %i %i %i%n", &element, tneighbors + num_faces * tit,
-              tneighbors + num_faces * tit + 1,
-              tneighbors + num_faces * tit + 2, &num_read);
-    if (dim == 3) {
-      retval +=
-        sscanf (line + num_read, "%i", tneighbors + num_faces * tit + 3);
-    }
-    if (retval != dim + 2) {
-      t8_global_errorf ("Premature end of line in %s.\n", filename);
-      goto die_neigh;
-    }
-    T8_ASSERT (element - element_offset == tit);
-
-  }
-  /* We are done reading the file. */
-  fclose (fp);
-
-  /* To compute the face neighbor orientations it is necessary to look up the
-   * vertices of a given tree_id. This is only possible if the attribute array
-   * is sorted. */
-  t8_stash_attribute_sort (cmesh->stash);
-  /* Finde the neighboring faces */
-  for (tit = 0; tit < num_elems; tit++) {
-    for (face1 = 0; face1 < num_faces; face1++) {
-      element = tneighbors[num_faces * tit + face1] - element_offset;
-      /* triangle store the neighbor triangle on face1 of tit
-       * or -1 if there is no neighbor */
-      if (element != -1 - element_offset && tit < element) {
-        for (face2 = 0; face2 < 3; face2++) {
-          /* Finde the face number of triangle which is connected to tit */
-          if (tneighbors[num_faces * element + face2] == tit + element_offset) {
-            break;
-          }
-        }
-        /* jump here after break */
-        T8_ASSERT (face2 < num_faces);
-        if (dim == 2) {
-          /* compute orientation after the pattern
-           *         f1
-           *        0 1 2
-           *       ======
-           *    0 | 1 0 1
-           * f2 1 | 0 1 0
-           *    2 | 1 0 1
-           */
-          orientation = (face1 + face2 + 1) % 2;
-        }
-        else {
-          /* TODO: compute correct orientation in 3d
-             or do we do this here? */
-          firstvertex = face1 == 0 ? 1 : 0;
-          el_vertices1 =
-            (double *) t8_stash_get_attribute (cmesh->stash, tit);
-          el_vertices2 =
-            (double *) t8_stash_get_attribute (cmesh->stash, element);
-          el_vertices1 += 3 * firstvertex;
-          for (ivertex = 1; ivertex <= 3; ivertex++) {
-            /* The face with number k consists of the vertices with numbers
-             * k+1, k+2, k+3 (mod 4)
-             * in el_vertices are the coordinates of these vertices in order
-             * v_0x v_0y v_0z v_1x v_1y ... */
-            if (el_vertices1[0] == el_vertices2[3 * ((face2 + ivertex) % 4)]
-                && el_vertices1[1] ==
-                el_vertices2[3 * ((face2 + ivertex) % 4) + 1]
-                && el_vertices1[2] ==
-                el_vertices2[3 * ((face2 + ivertex) % 4) + 2]) {
-              orientation = ivertex;
-              ivertex = 4;      /* Abort loop */
-            }
-          }
-          T8_ASSERT (ivertex == 5);     /* asserts if an orientation was successfully found */
-        }
-        /* Insert this face connection if we did not insert it before */
-        if (tit < element || face1 <= face2) {
-          /* if tit !< element then tit == element,
-           * face1 > face2 would mean that we already inserted this connection */
-          t8_cmesh_set_join (cmesh, tit, element, face1, face2, orientation);
-        }
-      }
-    }
-  }
-  T8_FREE (tneighbors);
-  free (line);
-  return 0;
-die_neigh:
-  /* Clean up on error. */
-  /* Close open file */
-  if (fp != NULL) {
-    fclose (fp);
-  }
-  free (line);
-  return -1;
-}
-
 /* TODO: remove do_dup argument */
 static              t8_cmesh_t
 t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
@@ -485,6 +339,7 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
   {
     int                 retval, corner_offset = 0;
     char                current_file[BUFSIZ];
+    sc_array_t         *faces;
 
     t8_cmesh_init (&cmesh);
     /* read .node file */
@@ -500,9 +355,10 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
       /* read .ele file */
       corner_offset = retval;
       snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
+      faces = sc_array_new (sizeof (t8_cmesh_face_key_t));
       retval =
         t8_cmesh_triangle_read_eles (cmesh, corner_offset, current_file,
-                                     vertices, dim
+                                     vertices, faces, dim
 #ifdef T8_ENABLE_DEBUG
                                      , num_vertices
 #endif
@@ -512,15 +368,10 @@ t8_cmesh_from_tetgen_or_triangle_file (char *fileprefix, int partition,
         t8_cmesh_unref (&cmesh);
       }
       else {
-        /* read .neigh file */
-        snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
-        retval = t8_cmesh_triangle_read_neigh (cmesh, corner_offset,
-                                               current_file, dim);
-        if (retval != 0) {
-          t8_global_errorf ("Error while parsing file %s.\n", current_file);
-          t8_cmesh_unref (&cmesh);
-        }
+        /* Find the face neighbors from the corners of the elements */
+        t8_cmesh_face_match (cmesh, faces, 0);
       }
+      sc_array_destroy (faces);
     }
     T8_ASSERT (cmesh != NULL);
   }
@@ -577,6 +428,7 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
   if (mpirank == 0 || partition) {
     int                 retval, corner_offset;
     char                current_file[BUFSIZ];
+    sc_array_t         *faces;
 
     t8_cmesh_init (&cmesh);
     /* read .node file */
@@ -592,9 +444,10 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
       /* read .ele file */
       corner_offset = retval;
       snprintf (current_file, BUFSIZ, "%s.ele", fileprefix);
+      faces = sc_array_new (sizeof (t8_cmesh_face_key_t));
       retval =
         t8_cmesh_triangle_read_eles (cmesh, corner_offset, current_file,
-                                     vertices, dim
+                                     vertices, faces, dim
 #ifdef T8_ENABLE_DEBUG
                                      , num_vertices
 #endif
@@ -604,15 +457,10 @@ t8_cmesh_from_tetgen_or_triangle_file_time (char *fileprefix,
         t8_cmesh_unref (&cmesh);
       }
       else {
-        /* read .neigh file */
-        snprintf (current_file, BUFSIZ, "%s.neigh", fileprefix);
-        retval = t8_cmesh_triangle_read_neigh (cmesh, corner_offset,
-                                               current_file, dim);
-        if (retval != 0) {
-          t8_global_errorf ("Error while parsing file %s.\n", current_file);
-          t8_cmesh_unref (&cmesh);
-        }
+        /* Find the face neighbors from the corners of the elements */
+        t8_cmesh_face_match (cmesh, faces, 0);
       }
+      sc_array_destroy (faces);
     }
     T8_ASSERT (cmesh != NULL);
   }
@@ -39,6 +39,9 @@ T8_EXTERN_C_BEGIN ();
 /* put declarations here */
 
 /** Read a .msh file and create a cmesh from it.
+ * Supported are the ascii format of version 2 and the ascii and binary
+ * formats of version 4.1.  Where available, the file is mapped into memory
+ * instead of being read line by line.
  * \param [in]    fileprefix    The prefix of the mesh file.
  *                              The file fileprefix.msh is read.
  * \param [in]    partition     If true the file is only opened on one process
@@ -50,7 +53,16 @@ T8_EXTERN_C_BEGIN ();
  *                              can store several dimensions of the mesh and therefore the
  *                              dimension to read has to be set manually.
  * \param [in]    master        If partition is true, a valid MPI rank that will
- *                              read the file and store all the trees alone.
+ *                              read the file and store all the trees alone,
+ *                              or -1.  If -1, all processes read a part
+ *                              of the file in parallel and the cmesh is
+ *                              partitioned uniformly by trees.  The nodes and
+ *                              the face neighbors are then distributed with
+ *                              a parallel sort, such that no process holds
+ *                              the whole mesh.  Each process only touches
+ *                              its part of the mapped file.  Without mmap
+ *                              support, each process reads the whole file
+ *                              into memory while parsing it.
  * \return        A committed cmesh holding the mesh of dimension \a dim in the
  *                specified .msh file.
  */
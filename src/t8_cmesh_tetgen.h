@@ -41,13 +41,14 @@ T8_EXTERN_C_BEGIN ();
 
 /* put declarations here */
 
-/** Open a .node, .ele and .neigh file created by TETGEN to read
+/** Open a .node and .ele file created by TETGEN to read
  * and create a cmesh from them. The cmesh will be replicated.
  * The files are opened and read by one process and the cmesh is then
  * broadcasted to the other processes.
  * \param [in] fileprefix A string holding the prefix of the TETGEN files.
- *                        The files \a fileprefix.node, \a fileprefix.ele and
- *                        \a fileprefix.neigh are read.
+ *                        The files \a fileprefix.node and \a fileprefix.ele
+ *                        are read.  The face neighbors are computed from
+ *                        the corners of the elements.
  * \param [in] partition  In the future this flag can decide whether the returned
  *                        cmesh is partitioned or not. Currently it is always replicated.
  * \param [in] comm       The mpi communicator to be used.
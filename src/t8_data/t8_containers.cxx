@@ -28,6 +28,15 @@
 #include <sc_containers.h>
 #include <t8_data/t8_containers.h>
 
+/* The number of elements up to which t8_element_array_family_starts
+ * uses buffers on the stack. This is the maximum number of children of
+ * an element of the default schemes. */
+#define T8_ELEMENT_ARRAY_FAMILY_BUFFER 10
+
+/* The number of elements whose keys are computed at once in
+ * t8_element_array_encode. Their levels are stored on the stack. */
+#define T8_ELEMENT_ARRAY_ENCODE_CHUNK 256
+
 T8_EXTERN_C_BEGIN ();
 
 #ifdef T8_ENABLE_DEBUG
@@ -45,9 +54,10 @@ t8_element_array_is_valid (t8_element_array_t * element_array)
   }
 
   /* Check that the element size of the scheme matches the size of data elements
-   * stored in the array. */
+   * stored in the array. A compact array stores keys instead. */
   is_valid = is_valid
-    && element_array->scheme->t8_element_size () ==
+    && (element_array->compact ? sizeof (t8_linearidx_t) :
+        element_array->scheme->t8_element_size ()) ==
     element_array->array.elem_size;
 
   return is_valid;
@@ -92,6 +102,7 @@ t8_element_array_init (t8_element_array_t * element_array,
 
   /* set the scheme */
   element_array->scheme = scheme;
+  element_array->compact = 0;
   /* get the size of an element and initialize the array member */
   elem_size = scheme->t8_element_size ();
   sc_array_init (&element_array->array, elem_size);
@@ -106,6 +117,7 @@ t8_element_array_init_size (t8_element_array_t * element_array,
   T8_ASSERT (element_array != NULL);
 
   element_array->scheme = scheme;
+  element_array->compact = 0;
   /* allocate the elements */
   sc_array_init_size (&element_array->array, scheme->t8_element_size (),
                       num_elements);
@@ -130,6 +142,7 @@ t8_element_array_init_view (t8_element_array_t * view,
   sc_array_init_view (&view->array, &array->array, offset, length);
   /* Set the scheme */
   view->scheme = array->scheme;
+  view->compact = array->compact;
   T8_ASSERT (t8_element_array_is_valid (view));
 }
 
@@ -142,6 +155,7 @@ t8_element_array_init_data (t8_element_array_t * view, t8_element_t * base,
                       elem_count);
   /* set the scheme */
   view->scheme = scheme;
+  view->compact = 0;
   T8_ASSERT (t8_element_array_is_valid (view));
 }
 
@@ -183,6 +197,7 @@ t8_element_array_resize (t8_element_array_t * element_array, size_t new_count)
 {
   size_t              old_count;
   T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (!element_array->compact);
   /* Store the old number of elements */
   old_count = t8_element_array_get_count (element_array);
   /* resize the data array */
@@ -205,6 +220,12 @@ t8_element_array_copy (t8_element_array_t * dest, t8_element_array_t * src)
   T8_ASSERT (t8_element_array_is_valid (dest));
   T8_ASSERT (t8_element_array_is_valid (src));
   T8_ASSERT (dest->scheme == src->scheme);
+  if (dest->compact != src->compact) {
+    /* Change the storage of dest to the one of src */
+    sc_array_reset (&dest->array);
+    sc_array_init (&dest->array, src->array.elem_size);
+    dest->compact = src->compact;
+  }
   sc_array_copy (&dest->array, &src->array);
 }
 
@@ -213,6 +234,7 @@ t8_element_array_push (t8_element_array_t * element_array)
 {
   t8_element_t       *new_element;
   T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (!element_array->compact);
   new_element = (t8_element_t *)
     sc_array_push (&element_array->array);
   element_array->scheme->t8_element_init (1, new_element, 0);
@@ -224,6 +246,7 @@ t8_element_t
   (t8_element_array_t * element_array, size_t count) {
   t8_element_t       *new_elements;
   T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (!element_array->compact);
   /* grow the array */
   new_elements = (t8_element_t *)
     sc_array_push_count (&element_array->array, count);
@@ -237,6 +260,7 @@ t8_element_t
                                    t8_locidx_t index)
 {
   T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (!element_array->compact);
   return (t8_element_t *)
     t8_sc_array_index_locidx (&element_array->array, index);
 }
@@ -245,6 +269,7 @@ t8_element_t
   * t8_element_array_index_int (t8_element_array_t * element_array, int index)
 {
   T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (!element_array->compact);
   return (t8_element_t *)
     sc_array_index_int (&element_array->array, index);
 }
@@ -274,6 +299,7 @@ t8_element_t       *
 t8_element_array_get_data (t8_element_array_t * element_array)
 {
   T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (!element_array->compact);
 
   if (element_array->array.elem_count > 0) {
     return (t8_element_t *) t8_element_array_index_locidx (element_array, 0);
@@ -305,4 +331,296 @@ t8_element_array_truncate (t8_element_array_t * element_array)
   sc_array_truncate (&element_array->array);
 }
 
+/* Return true if elements of dimension dim up to level max_level can be
+ * encoded in a key */
+static int
+t8_element_array_key_fits (int dim, int max_level)
+{
+  return max_level < 1 << T8_ELEMENT_KEY_LEVEL_BITS
+    && dim * max_level + T8_ELEMENT_KEY_LEVEL_BITS <= 64;
+}
+
+/* Compute the keys of a range of elements of a non-compact array.
+ * If keys is NULL, we only check whether all elements can be encoded.
+ * The levels are computed in chunks, such that we do not allocate memory.
+ * Returns false if not all elements can be encoded, in which case the
+ * content of keys is undefined. */
+static int
+t8_element_array_encode_range (t8_element_array_t * element_array,
+                               size_t first, size_t count,
+                               t8_linearidx_t * keys)
+{
+  t8_eclass_scheme_c *scheme = element_array->scheme;
+  int                 levels[T8_ELEMENT_ARRAY_ENCODE_CHUNK];
+  int                 dim, max_level;
+  size_t              chunk_first, chunk_count, ielem;
+  t8_linearidx_t     *key;
+
+  T8_ASSERT (!element_array->compact);
+  if (scheme->eclass == T8_ECLASS_PYRAMID) {
+    /* The number of children of a pyramid is not a power of two */
+    return 0;
+  }
+  dim = t8_eclass_to_dimension[scheme->eclass];
+  for (chunk_first = 0; chunk_first < count;
+       chunk_first += T8_ELEMENT_ARRAY_ENCODE_CHUNK) {
+    chunk_count =
+      SC_MIN (count - chunk_first, T8_ELEMENT_ARRAY_ENCODE_CHUNK);
+    /* Get the levels of the chunk and check whether each element
+     * fits into a key */
+    scheme->t8_element_array_levels (element_array, first + chunk_first,
+                                     chunk_count, levels);
+    max_level = 0;
+    for (ielem = 0; ielem < chunk_count; ielem++) {
+      max_level = SC_MAX (max_level, levels[ielem]);
+    }
+    if (!t8_element_array_key_fits (dim, max_level)) {
+      return 0;
+    }
+    if (keys == NULL) {
+      continue;
+    }
+    /* We compute all linear ids of the chunk at its maximum level in one
+     * sweep. The linear id of an element at its own level is obtained by
+     * removing the dim * (max_level - level) lowest bits. */
+    key = keys + chunk_first;
+    scheme->t8_element_array_linear_ids (element_array, first + chunk_first,
+                                         chunk_count, max_level, key);
+    for (ielem = 0; ielem < chunk_count; ielem++) {
+      key[ielem] = (key[ielem] >> (dim * (max_level - levels[ielem])))
+        << T8_ELEMENT_KEY_LEVEL_BITS | (t8_linearidx_t) levels[ielem];
+    }
+  }
+  return 1;
+}
+
+int
+t8_element_array_can_encode (t8_element_array_t * element_array,
+                             size_t first, size_t count)
+{
+  t8_eclass_scheme_c *scheme;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (first + count <= element_array->array.elem_count);
+
+  if (element_array->compact) {
+    return 1;
+  }
+  scheme = element_array->scheme;
+  if (scheme->eclass != T8_ECLASS_PYRAMID
+      && t8_element_array_key_fits (t8_eclass_to_dimension[scheme->eclass],
+                                    scheme->t8_element_maxlevel ())) {
+    /* Every element of this scheme can be encoded */
+    return 1;
+  }
+  return t8_element_array_encode_range (element_array, first, count, NULL);
+}
+
+int
+t8_element_array_encode (t8_element_array_t * element_array, size_t first,
+                         size_t count, t8_linearidx_t * keys)
+{
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (first + count <= element_array->array.elem_count);
+
+  if (element_array->compact) {
+    /* The keys are stored in the array */
+    memcpy (keys, sc_array_index (&element_array->array, first),
+            count * sizeof (t8_linearidx_t));
+    return 1;
+  }
+  return t8_element_array_encode_range (element_array, first, count, keys);
+}
+
+int
+t8_element_array_compact (t8_element_array_t * element_array)
+{
+  sc_array_t          keys;
+  size_t              num_elements;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (element_array->array.byte_alloc >= 0);
+
+  if (element_array->compact) {
+    return 1;
+  }
+  num_elements = element_array->array.elem_count;
+  sc_array_init_size (&keys, sizeof (t8_linearidx_t), num_elements);
+  if (!t8_element_array_encode_range (element_array, 0, num_elements,
+                                      (t8_linearidx_t *) keys.array)) {
+    /* Not all elements can be encoded */
+    sc_array_reset (&keys);
+    return 0;
+  }
+
+  /* Replace the elements by the keys */
+  sc_array_reset (&element_array->array);
+  element_array->array = keys;
+  element_array->compact = 1;
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  return 1;
+}
+
+/* Construct the element encoded by a compact key */
+static void
+t8_element_array_decode_key (t8_eclass_scheme_c * scheme,
+                             t8_linearidx_t key, t8_element_t * element)
+{
+  const t8_linearidx_t level_mask =
+    ((t8_linearidx_t) 1 << T8_ELEMENT_KEY_LEVEL_BITS) - 1;
+
+  scheme->t8_element_set_linear_id (element, (int) (key & level_mask),
+                                    key >> T8_ELEMENT_KEY_LEVEL_BITS);
+}
+
+void
+t8_element_array_decode_keys (t8_element_array_t * element_array,
+                              size_t first, size_t count,
+                              const t8_linearidx_t * keys)
+{
+  size_t              ielem;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (first + count <= element_array->array.elem_count);
+
+  if (element_array->compact) {
+    memcpy (sc_array_index (&element_array->array, first), keys,
+            count * sizeof (t8_linearidx_t));
+    return;
+  }
+  for (ielem = 0; ielem < count; ielem++) {
+    t8_element_array_decode_key (element_array->scheme, keys[ielem],
+                                 (t8_element_t *)
+                                 sc_array_index (&element_array->array,
+                                                 first + ielem));
+  }
+}
+
+void
+t8_element_array_expand (t8_element_array_t * element_array)
+{
+  t8_element_array_t  elements;
+  size_t              num_elements;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (element_array->array.byte_alloc >= 0);
+
+  if (!element_array->compact) {
+    return;
+  }
+  num_elements = element_array->array.elem_count;
+  t8_element_array_init_size (&elements, element_array->scheme,
+                              num_elements);
+  t8_element_array_decode_keys (&elements, 0, num_elements,
+                                (const t8_linearidx_t *)
+                                element_array->array.array);
+  /* Replace the keys by the elements */
+  sc_array_reset (&element_array->array);
+  element_array->array = elements.array;
+  element_array->compact = 0;
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+}
+
+int
+t8_element_array_is_compact (t8_element_array_t * element_array)
+{
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  return element_array->compact;
+}
+
+void
+t8_element_array_decode (t8_element_array_t * element_array, size_t index,
+                         t8_element_t * element)
+{
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (index < element_array->array.elem_count);
+
+  if (element_array->compact) {
+    t8_element_array_decode_key (element_array->scheme,
+                                 *(t8_linearidx_t *)
+                                 sc_array_index (&element_array->array,
+                                                 index), element);
+  }
+  else {
+    element_array->scheme->t8_element_copy ((t8_element_t *)
+                                            sc_array_index
+                                            (&element_array->array, index),
+                                            element);
+  }
+}
+
+void
+t8_element_array_family_starts (t8_element_array_t * element_array,
+                                size_t first, size_t count,
+                                int8_t * family_start)
+{
+  t8_eclass_scheme_c *scheme;
+  int                 levels_buffer[T8_ELEMENT_ARRAY_FAMILY_BUFFER];
+  int                 child_ids_buffer[T8_ELEMENT_ARRAY_FAMILY_BUFFER];
+  int                *levels, *child_ids;
+  size_t              ielem, j;
+  int                 num_children;
+
+  T8_ASSERT (t8_element_array_is_valid (element_array));
+  T8_ASSERT (first + count <= element_array->array.elem_count);
+
+  if (count == 0) {
+    return;
+  }
+  scheme = element_array->scheme;
+  /* Short ranges, such as a single family, do not allocate memory */
+  if (count <= T8_ELEMENT_ARRAY_FAMILY_BUFFER) {
+    levels = levels_buffer;
+    child_ids = child_ids_buffer;
+  }
+  else {
+    levels = T8_ALLOC (int, count);
+    child_ids = T8_ALLOC (int, count);
+  }
+  if (element_array->compact) {
+    const t8_linearidx_t *key =
+      (const t8_linearidx_t *) element_array->array.array + first;
+    const t8_linearidx_t level_mask =
+      ((t8_linearidx_t) 1 << T8_ELEMENT_KEY_LEVEL_BITS) - 1;
+
+    /* The child id of an element is given by the lowest bits of its
+     * linear id */
+    num_children = 1 << t8_eclass_to_dimension[scheme->eclass];
+    for (ielem = 0; ielem < count; ielem++) {
+      levels[ielem] = (int) (key[ielem] & level_mask);
+      child_ids[ielem] = (int) ((key[ielem] >> T8_ELEMENT_KEY_LEVEL_BITS)
+                                & (num_children - 1));
+    }
+  }
+  else {
+    num_children =
+      scheme->t8_element_num_children (t8_element_array_index_locidx
+                                       (element_array, first));
+    scheme->t8_element_array_levels (element_array, first, count, levels);
+    scheme->t8_element_array_child_ids (element_array, first, count,
+                                        child_ids);
+  }
+
+  /* Elements with child ids 0, ..., num_children - 1 and the same level
+   * form a family */
+  for (ielem = 0; ielem < count; ielem++) {
+    family_start[ielem] = 0;
+    if (child_ids[ielem] != 0 || levels[ielem] == 0
+        || ielem + num_children > count) {
+      continue;
+    }
+    for (j = 1; j < (size_t) num_children; j++) {
+      if (child_ids[ielem + j] != (int) j
+          || levels[ielem + j] != levels[ielem]) {
+        break;
+      }
+    }
+    family_start[ielem] = j == (size_t) num_children;
+  }
+  if (levels != levels_buffer) {
+    T8_FREE (levels);
+    T8_FREE (child_ids);
+  }
+}
+
 T8_EXTERN_C_END ();
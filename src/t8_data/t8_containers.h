@@ -37,13 +37,29 @@
  * the eclass function either \ref t8_element_new or \ref t8_element_init is called
  * for the element.
  * Thus, each element in a \ref t8_element_array_t is automatically initialized properly.
+ *
+ * An element array can be switched to a compact storage with
+ * \ref t8_element_array_compact. It then stores one 64 bit key per element
+ * that encodes the element's linear id and level, see \ref T8_ELEMENT_KEY_LEVEL_BITS.
+ * Single elements can be decoded from a compact array with
+ * \ref t8_element_array_decode, \ref t8_element_array_expand restores the
+ * full storage. The functions that return pointers to elements or change the
+ * number of elements may only be called on an array that is not compact.
  */
 typedef struct
 {
   t8_eclass_scheme_c *scheme; /**< An eclass scheme of which elements should be stored */
   sc_array_t          array;  /**< The array in which the elements are stored */
+  int                 compact; /**< If true, \a array stores a t8_linearidx_t key per element instead of the element. */
 } t8_element_array_t;
 
+/** The number of low bits of a compact element key that store the level.
+ * The remaining high bits store the linear id of the element at its own level.
+ * An element of dimension d and level l can thus be stored compactly if
+ * d * l + T8_ELEMENT_KEY_LEVEL_BITS <= 64.
+ */
+#define T8_ELEMENT_KEY_LEVEL_BITS 6
+
 T8_EXTERN_C_BEGIN ();
 
 /** Creates a new array structure with 0 elements.
@@ -233,6 +249,111 @@ void                t8_element_array_reset (t8_element_array_t *
 void                t8_element_array_truncate (t8_element_array_t *
                                                element_array);
 
+/** Switch an element array to compact storage.
+ * Each element is replaced by a 64 bit key encoding its linear id and level.
+ * This reduces the memory of the array to 8 bytes per element.
+ * \param [in,out]  element_array  Element array structure. Must not be a view.
+ * \return                  True if the array is compact on output.
+ *                          False if not all elements can be encoded in 64 bits,
+ *                          in which case \a element_array is not changed.
+ * \note If the array is already compact, nothing is done and true is returned.
+ */
+int                 t8_element_array_compact (t8_element_array_t *
+                                              element_array);
+
+/** Restore the full element storage of a compact element array.
+ * \param [in,out]  element_array  Element array structure. Must not be a view.
+ *                          On output the elements are stored as elements
+ *                          of the array's scheme.
+ * \note If the array is not compact, nothing is done.
+ */
+void                t8_element_array_expand (t8_element_array_t *
+                                             element_array);
+
+/** Query whether an element array uses compact storage.
+ * \param [in]  element_array  Element array structure.
+ * \return                  True if \a element_array is compact.
+ */
+int                 t8_element_array_is_compact (t8_element_array_t *
+                                                 element_array);
+
+/** Query whether a range of elements of an element array can be encoded
+ * in compact keys, see \ref t8_element_array_compact.
+ * \param [in]  element_array  Element array structure.
+ * \param [in]  first          The index of the first element of the range.
+ * \param [in]  count          The number of elements in the range.
+ * \return                  True if all elements of the range can be encoded.
+ */
+int                 t8_element_array_can_encode (t8_element_array_t *
+                                                 element_array, size_t first,
+                                                 size_t count);
+
+/** Compute the compact keys of a range of elements of an element array.
+ * If the array is compact, its keys are copied.
+ * \param [in]  element_array  Element array structure.
+ * \param [in]  first          The index of the first element of the range.
+ * \param [in]  count          The number of elements in the range.
+ * \param [out] keys           Array of length \a count. On output the key
+ *                          of element \a first + i is stored in \a keys[i].
+ *                          This may point into a message buffer.
+ * \return                  True if all elements of the range can be encoded,
+ *                          see \ref t8_element_array_can_encode.
+ *                          Otherwise the content of \a keys is undefined.
+ */
+int                 t8_element_array_encode (t8_element_array_t *
+                                             element_array, size_t first,
+                                             size_t count,
+                                             t8_linearidx_t * keys);
+
+/** Store the elements encoded by compact keys in a range of an element
+ * array. If the array is compact, the keys are copied.
+ * \param [in,out] element_array  Element array structure. The positions
+ *                          \a first, ..., \a first + \a count - 1 must exist.
+ * \param [in]  first          The index of the first element of the range.
+ * \param [in]  count          The number of keys.
+ * \param [in]  keys           Array of \a count keys, as computed by
+ *                          \ref t8_element_array_encode.
+ */
+void                t8_element_array_decode_keys (t8_element_array_t *
+                                                  element_array,
+                                                  size_t first, size_t count,
+                                                  const t8_linearidx_t *
+                                                  keys);
+
+/** Decode an element from an element array.
+ * If the array is compact, the element is constructed from its key,
+ * otherwise it is copied.
+ * \param [in]  element_array  Element array structure.
+ * \param [in]  index          The index of an element within the array.
+ * \param [in,out] element     An allocated element of the array's scheme.
+ *                          On output the element at position \a index.
+ */
+void                t8_element_array_decode (t8_element_array_t *
+                                             element_array, size_t index,
+                                             t8_element_t * element);
+
+/** Find the families in a range of elements of an element array.
+ * For each element of the range we determine whether it is the first
+ * element of a family, whose elements are all contained in the range.
+ * All elements of the array must have the same number of children.
+ * The levels and child ids of the elements are computed with one call
+ * to the array versions of the scheme functions, or, if the array is
+ * compact, read from the keys without calling the scheme.
+ * \param [in]  element_array  Element array structure.
+ * \param [in]  first          The index of the first element of the range.
+ * \param [in]  count          The number of elements in the range.
+ * \param [out] family_start   Array of length \a count. On output entry i
+ *                          is true if and only if the elements
+ *                          \a first + i, ..., \a first + i + n - 1 form a
+ *                          family, where n is the number of children of an
+ *                          element.
+ */
+void                t8_element_array_family_starts (t8_element_array_t *
+                                                    element_array,
+                                                    size_t first,
+                                                    size_t count,
+                                                    int8_t * family_start);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_CONTAINERS_HXX */
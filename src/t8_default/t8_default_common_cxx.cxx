@@ -21,64 +21,329 @@
 */
 
 #include "t8_default_common_cxx.hxx"
+#ifdef T8_DEFAULT_MEMPOOL_THREADS
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
-/** This class independent function assumes an sc_mempool_t as context.
- * It is suitable as the elem_new callback in \ref t8_eclass_scheme_t.
- * We assume that the mempool has been created with the correct element size.
- * \param [in,out] ts_context   An element is allocated in this sc_mempool_t.
- * \param [in]     length       Non-negative number of elements to allocate.
- * \param [in,out] elem         Array of correct size whose members are filled.
- */
-static void         t8_default_mempool_alloc (sc_mempool_t * ts_context,
-                                              int length,
-                                              t8_element_t ** elem);
-
-/** This class independent function assumes an sc_mempool_t as context.
- * It is suitable as the elem_destroy callback in \ref t8_eclass_scheme_t.
- * We assume that the mempool has been created with the correct element size.
- * \param [in,out] ts_context   An element is returned to this sc_mempool_t.
- * \param [in]     length       Non-negative number of elements to destroy.
- * \param [in,out] elem         Array whose members are returned to the mempool.
- */
-static void         t8_default_mempool_free (sc_mempool_t * ts_context,
-                                             int length,
-                                             t8_element_t ** elem);
+#ifdef T8_DEFAULT_MEMPOOL_THREADS
 
-/* Destructor */
-t8_default_scheme_common_c::~t8_default_scheme_common_c ()
+struct t8_default_thread_pool;
+
+/* Each element allocated from a thread pool is preceded by this header.
+ * While the element is in use, it stores the pool that allocated it.
+ * When the element was freed by a different thread, it is the link in the
+ * stack of remotely freed elements of its pool. */
+typedef union t8_default_mempool_header
 {
-  T8_ASSERT (ts_context != NULL);
-  sc_mempool_destroy ((sc_mempool_t *) ts_context);
+  struct t8_default_thread_pool *owner;
+  union t8_default_mempool_header *next;
+  double              align_double;
+  int64_t             align_int64;
+} t8_default_mempool_header_t;
+
+/* The memory pool of one thread.  Only the owning thread allocates from
+ * and frees to the sc_mempool.  Other threads push the elements that they
+ * free onto remote_free, from where the owner returns them to its
+ * sc_mempool on its next allocation.
+ * When the owner exits, the pool is orphaned and the next thread that
+ * starts to use the mempool adopts it. */
+typedef struct t8_default_thread_pool
+{
+  sc_mempool_t       *mempool;      /* Elements including their header */
+  std::atomic < std::thread::id > thread;   /* The owner of this pool */
+  std::atomic < int > orphaned;     /* True if the owner has exited */
+  /* The elements of this pool that were freed by other threads */
+  std::atomic < t8_default_mempool_header_t * >remote_free;
+  struct t8_default_thread_pool *next;      /* The pool of another thread */
+} t8_default_thread_pool_t;
+
+/* The context of a default scheme. */
+typedef struct t8_default_mempool
+{
+  size_t              elem_size;    /* The size of one element */
+  size_t              id;           /* Unique id of this mempool */
+  /* The list of the thread pools */
+  std::atomic < t8_default_thread_pool_t * >threads;
+  struct t8_default_mempool *next;  /* The next mempool in the registry */
+} t8_default_mempool_t;
+
+/* All existing mempools, such that an exiting thread finds its pools.
+ * The registry is only locked when a mempool is created or destroyed and
+ * when a thread that used a mempool exits. */
+static t8_default_mempool_t *t8_default_mempool_registry;
+static std::mutex   t8_default_mempool_registry_mutex;
+
+/* The destructor of this thread local object orphans the pools of the
+ * exiting thread.  It is constructed when the thread creates its first
+ * pool. */
+struct t8_default_mempool_thread_exit
+{
+  int                 registered;
+                     ~t8_default_mempool_thread_exit ();
+};
+static thread_local t8_default_mempool_thread_exit
+  t8_default_mempool_exit;
+
+/* The number of mempools for which each thread caches its thread pool */
+#define T8_DEFAULT_MEMPOOL_CACHE 8
+
+/* Each mempool gets a unique id, such that the cache entries of a
+ * destroyed mempool can never match a new one. */
+static std::atomic < size_t > t8_default_mempool_next_id (1);
+
+/* The thread pools that this thread used recently */
+static thread_local struct
+{
+  size_t              id;
+  t8_default_thread_pool_t *pool;
+} t8_default_mempool_cache[T8_DEFAULT_MEMPOOL_CACHE];
+static thread_local int t8_default_mempool_cache_next;
+
+static void         t8_default_mempool_drain (t8_default_thread_pool_t *
+                                              pool);
+
+/* Try to adopt a pool whose owner has exited.
+ * Returns the adopted pool or NULL if there is no orphaned pool. */
+static t8_default_thread_pool_t *
+t8_default_mempool_adopt (t8_default_mempool_t * mempool,
+                          std::thread::id self)
+{
+  t8_default_thread_pool_t *pool;
+  int                 orphaned;
+
+  for (pool = mempool->threads.load (std::memory_order_acquire);
+       pool != NULL; pool = pool->next) {
+    orphaned = 1;
+    if (pool->orphaned.load (std::memory_order_relaxed)
+        && pool->orphaned.compare_exchange_strong (orphaned, 0,
+                                                   std::memory_order_acquire,
+                                                   std::memory_order_relaxed))
+    {
+      /* We own the pool now and return the elements that were freed
+       * since its previous owner exited */
+      pool->thread.store (self, std::memory_order_relaxed);
+      t8_default_mempool_drain (pool);
+      return pool;
+    }
+  }
+  return NULL;
 }
 
-/** Compute the number of corners of a given element. */
-int
-t8_default_scheme_common_c::t8_element_num_corners (const t8_element_t * elem)
+/* Return the pool of the calling thread, create it if it does not exist. */
+static t8_default_thread_pool_t *
+t8_default_mempool_thread (t8_default_mempool_t * mempool)
 {
-  /* use the lookup table of the eclasses.
-   * Pyramids should implement their own version of this function. */
-  return t8_eclass_num_vertices[eclass];
+  t8_default_thread_pool_t *pool;
+  const std::thread::id self = std::this_thread::get_id ();
+  int                 i;
+
+  for (i = 0; i < T8_DEFAULT_MEMPOOL_CACHE; ++i) {
+    if (t8_default_mempool_cache[i].id == mempool->id) {
+      return t8_default_mempool_cache[i].pool;
+    }
+  }
+  /* Search the pool of this thread in the list.  An orphaned pool may
+   * carry our id if the id of its exited owner was reused. */
+  for (pool = mempool->threads.load (std::memory_order_acquire);
+       pool != NULL
+       && (pool->thread.load (std::memory_order_relaxed) != self
+           || pool->orphaned.load (std::memory_order_acquire));
+       pool = pool->next) {
+  }
+  if (pool == NULL) {
+    /* This thread did not use the mempool before.  Make sure that its
+     * pools are orphaned when it exits. */
+    t8_default_mempool_exit.registered = 1;
+    pool = t8_default_mempool_adopt (mempool, self);
+  }
+  if (pool == NULL) {
+    /* There is no orphaned pool, we create a new one */
+    pool = new t8_default_thread_pool_t;
+    pool->mempool =
+      sc_mempool_new (sizeof (t8_default_mempool_header_t) +
+                      mempool->elem_size);
+    pool->thread.store (self, std::memory_order_relaxed);
+    pool->orphaned.store (0, std::memory_order_relaxed);
+    pool->remote_free.store (NULL, std::memory_order_relaxed);
+    pool->next = mempool->threads.load (std::memory_order_relaxed);
+    while (!mempool->threads.compare_exchange_weak
+           (pool->next, pool, std::memory_order_release,
+            std::memory_order_relaxed)) {
+    }
+  }
+  i = t8_default_mempool_cache_next;
+  t8_default_mempool_cache[i].id = mempool->id;
+  t8_default_mempool_cache[i].pool = pool;
+  t8_default_mempool_cache_next = (i + 1) % T8_DEFAULT_MEMPOOL_CACHE;
+  return pool;
+}
+
+/* Return the elements that other threads freed to the sc_mempool of a
+ * thread pool.  Only the owner of the pool may call this while other
+ * threads are active. */
+static void
+t8_default_mempool_drain (t8_default_thread_pool_t * pool)
+{
+  t8_default_mempool_header_t *header, *next;
+
+  header = pool->remote_free.exchange (NULL, std::memory_order_acquire);
+  for (; header != NULL; header = next) {
+    next = header->next;
+    sc_mempool_free (pool->mempool, header);
+  }
+}
+
+t8_default_mempool_thread_exit::~t8_default_mempool_thread_exit ()
+{
+  const std::thread::id self = std::this_thread::get_id ();
+  std::lock_guard < std::mutex > lock (t8_default_mempool_registry_mutex);
+  t8_default_mempool_t *mempool;
+  t8_default_thread_pool_t *pool;
+
+  for (mempool = t8_default_mempool_registry; mempool != NULL;
+       mempool = mempool->next) {
+    for (pool = mempool->threads.load (std::memory_order_acquire);
+         pool != NULL; pool = pool->next) {
+      if (pool->thread.load (std::memory_order_relaxed) == self
+          && !pool->orphaned.load (std::memory_order_relaxed)) {
+        /* Hand the pool over to the next thread that registers */
+        t8_default_mempool_drain (pool);
+        pool->orphaned.store (1, std::memory_order_release);
+      }
+    }
+  }
+}
+
+void               *
+t8_default_mempool_new (size_t elem_size)
+{
+  t8_default_mempool_t *mempool;
+
+  mempool = new t8_default_mempool_t;
+  mempool->elem_size = elem_size;
+  mempool->id = t8_default_mempool_next_id.fetch_add (1);
+  mempool->threads.store (NULL);
+  {
+    std::lock_guard < std::mutex > lock (t8_default_mempool_registry_mutex);
+    mempool->next = t8_default_mempool_registry;
+    t8_default_mempool_registry = mempool;
+  }
+  return mempool;
 }
 
 void
-t8_default_scheme_common_c::t8_element_new (int length, t8_element_t ** elem)
+t8_default_mempool_destroy (void *ts_context)
 {
-  t8_default_mempool_alloc ((sc_mempool_t *) this->ts_context, length, elem);
+  t8_default_mempool_t *mempool = (t8_default_mempool_t *) ts_context;
+  t8_default_mempool_t **pmempool;
+  t8_default_thread_pool_t *pool, *next;
+
+  T8_ASSERT (mempool != NULL);
+  {
+    /* Remove the mempool from the registry */
+    std::lock_guard < std::mutex > lock (t8_default_mempool_registry_mutex);
+    for (pmempool = &t8_default_mempool_registry; *pmempool != mempool;
+         pmempool = &(*pmempool)->next) {
+      T8_ASSERT (*pmempool != NULL);
+    }
+    *pmempool = mempool->next;
+  }
+  for (pool = mempool->threads.load (); pool != NULL; pool = next) {
+    next = pool->next;
+    t8_default_mempool_drain (pool);
+    sc_mempool_destroy (pool->mempool);
+    delete              pool;
+  }
+  delete              mempool;
+}
+
+static void
+t8_default_mempool_alloc (void *ts_context, int length, t8_element_t ** elem)
+{
+  t8_default_thread_pool_t *pool;
+  t8_default_mempool_header_t *header;
+  int                 i;
+
+  T8_ASSERT (ts_context != NULL);
+  T8_ASSERT (0 <= length);
+  T8_ASSERT (elem != NULL);
+
+  pool = t8_default_mempool_thread ((t8_default_mempool_t *) ts_context);
+  if (pool->remote_free.load (std::memory_order_relaxed) != NULL) {
+    t8_default_mempool_drain (pool);
+  }
+  for (i = 0; i < length; ++i) {
+    header = (t8_default_mempool_header_t *) sc_mempool_alloc (pool->mempool);
+    header->owner = pool;
+    elem[i] = (t8_element_t *) (header + 1);
+  }
+}
+
+/* Push an element onto the stack of remotely freed elements of a pool.
+ * Any number of threads may push concurrently, while the owner of the
+ * pool takes the whole stack at once, see t8_default_mempool_alloc. */
+static void
+t8_default_mempool_push_remote (t8_default_thread_pool_t * pool,
+                                t8_default_mempool_header_t * header)
+{
+  std::atomic < t8_default_mempool_header_t * >*stack = &pool->remote_free;
+
+  header->next = stack->load (std::memory_order_relaxed);
+  while (!stack->compare_exchange_weak (header->next, header,
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed)) {
+  }
+}
+
+static void
+t8_default_mempool_free (void *ts_context, int length, t8_element_t ** elem)
+{
+  t8_default_thread_pool_t *pool;
+  t8_default_mempool_header_t *header;
+  int                 i;
+
+  T8_ASSERT (ts_context != NULL);
+  T8_ASSERT (0 <= length);
+  T8_ASSERT (elem != NULL);
+
+  pool = t8_default_mempool_thread ((t8_default_mempool_t *) ts_context);
+  for (i = 0; i < length; ++i) {
+    header = (t8_default_mempool_header_t *) elem[i] - 1;
+    if (header->owner == pool) {
+      sc_mempool_free (pool->mempool, header);
+    }
+    else {
+      /* The element belongs to another thread, we push it onto the
+       * stack of remotely freed elements of its pool */
+      t8_default_mempool_push_remote (header->owner, header);
+    }
+  }
+}
+
+#else /* !T8_DEFAULT_MEMPOOL_THREADS */
+
+/* Without thread support the context is a single sc_mempool_t */
+
+void               *
+t8_default_mempool_new (size_t elem_size)
+{
+  return sc_mempool_new (elem_size);
 }
 
 void
-t8_default_scheme_common_c::t8_element_destroy (int length,
-                                                t8_element_t ** elem)
+t8_default_mempool_destroy (void *ts_context)
 {
-  t8_default_mempool_free ((sc_mempool_t *) this->ts_context, length, elem);
+  T8_ASSERT (ts_context != NULL);
+  sc_mempool_destroy ((sc_mempool_t *) ts_context);
 }
 
 static void
-t8_default_mempool_alloc (sc_mempool_t * ts_context, int length,
-                          t8_element_t ** elem)
+t8_default_mempool_alloc (void *ts_context, int length, t8_element_t ** elem)
 {
   int                 i;
 
@@ -87,13 +352,12 @@ t8_default_mempool_alloc (sc_mempool_t * ts_context, int length,
   T8_ASSERT (elem != NULL);
 
   for (i = 0; i < length; ++i) {
-    elem[i] = (t8_element_t *) sc_mempool_alloc (ts_context);
+    elem[i] = (t8_element_t *) sc_mempool_alloc ((sc_mempool_t *) ts_context);
   }
 }
 
 static void
-t8_default_mempool_free (sc_mempool_t * ts_context, int length,
-                         t8_element_t ** elem)
+t8_default_mempool_free (void *ts_context, int length, t8_element_t ** elem)
 {
   int                 i;
 
@@ -102,8 +366,38 @@ t8_default_mempool_free (sc_mempool_t * ts_context, int length,
   T8_ASSERT (elem != NULL);
 
   for (i = 0; i < length; ++i) {
-    sc_mempool_free (ts_context, elem[i]);
+    sc_mempool_free ((sc_mempool_t *) ts_context, elem[i]);
   }
 }
 
+#endif /* T8_DEFAULT_MEMPOOL_THREADS */
+
+/* Destructor */
+t8_default_scheme_common_c::~t8_default_scheme_common_c ()
+{
+  t8_default_mempool_destroy (ts_context);
+}
+
+/** Compute the number of corners of a given element. */
+int
+t8_default_scheme_common_c::t8_element_num_corners (const t8_element_t * elem)
+{
+  /* use the lookup table of the eclasses.
+   * Pyramids should implement their own version of this function. */
+  return t8_eclass_num_vertices[eclass];
+}
+
+void
+t8_default_scheme_common_c::t8_element_new (int length, t8_element_t ** elem)
+{
+  t8_default_mempool_alloc (this->ts_context, length, elem);
+}
+
+void
+t8_default_scheme_common_c::t8_element_destroy (int length,
+                                                t8_element_t ** elem)
+{
+  t8_default_mempool_free (this->ts_context, length, elem);
+}
+
 T8_EXTERN_C_END ();
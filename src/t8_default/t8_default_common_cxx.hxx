@@ -28,12 +28,48 @@
 #define T8_DEFAULT_COMMON_CXX_HXX
 
 #include <t8_element_cxx.hxx>
+#include <typeinfo>
 
 /* Macro to check whether a pointer (VAR) to a base class, comes from an
  * implementation of a child class (TYPE). */
 #define T8_COMMON_IS_TYPE(VAR, TYPE) \
   ((dynamic_cast<TYPE> (VAR)) != NULL)
 
+/* Macro to check whether the dynamic type of the object that a pointer (VAR)
+ * points to is exactly the class TYPE and not a class derived from it. */
+#define T8_COMMON_IS_EXACT_TYPE(VAR, TYPE) \
+  (typeid (*(VAR)) == typeid (TYPE))
+
+/* With C++11 the memory pools of the default schemes keep one sc_mempool
+ * per thread, such that elements can be allocated and freed concurrently.
+ * sc counts the memory of its mempools globally, which is only thread-safe
+ * if libsc is configured with --enable-pthread. */
+#if __cplusplus >= 201103L && defined (SC_ENABLE_PTHREAD)
+#define T8_DEFAULT_MEMPOOL_THREADS
+#endif
+
+T8_EXTERN_C_BEGIN ();
+
+/** Create the memory pool that the default schemes use as ts_context.
+ * If T8_DEFAULT_MEMPOOL_THREADS is defined, each thread allocates from its
+ * own sc_mempool_t, so \ref t8_element_new and \ref t8_element_destroy may
+ * be called concurrently by different threads without locking.
+ * An element may be destroyed by another thread than the one that
+ * allocated it.  Otherwise the pool is a single sc_mempool_t and
+ * must not be used concurrently.
+ * \param [in] elem_size  The size of one element in bytes.
+ * \return                The memory pool.
+ */
+void               *t8_default_mempool_new (size_t elem_size);
+
+/** Destroy a memory pool created with \ref t8_default_mempool_new.
+ * This frees all elements that are still allocated from it.
+ * \param [in,out] ts_context  The memory pool.
+ */
+void                t8_default_mempool_destroy (void *ts_context);
+
+T8_EXTERN_C_END ();
+
 class               t8_default_scheme_common_c:public t8_eclass_scheme_c
 {
 public:
@@ -50,4 +86,203 @@ public:
   virtual void        t8_element_destroy (int length, t8_element_t ** elem);
 };
 
+/** Extract every second (\a dim = 2) or every third (\a dim = 3) bit of a
+ * Morton index, starting at bit 0.  This is the x coordinate of the anchor
+ * node encoded in the Morton index.
+ * \param [in] morton  A Morton index of at most 64 bits.
+ * \param [in] dim     The dimension, 2 or 3.
+ * \return             The bits 0, dim, 2 * dim, ... of \a morton, stored
+ *                     in the bits 0, 1, 2, ... of the return value.
+ */
+static inline       t8_linearidx_t
+t8_default_morton_compact (t8_linearidx_t morton, int dim)
+{
+  t8_linearidx_t      x = morton;
+
+  T8_ASSERT (dim == 2 || dim == 3);
+  if (dim == 2) {
+    x &= 0x5555555555555555ULL;
+    x = (x | x >> 1) & 0x3333333333333333ULL;
+    x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0fULL;
+    x = (x | x >> 4) & 0x00ff00ff00ff00ffULL;
+    x = (x | x >> 8) & 0x0000ffff0000ffffULL;
+    x = (x | x >> 16) & 0x00000000ffffffffULL;
+  }
+  else {
+    x &= 0x1249249249249249ULL;
+    x = (x | x >> 2) & 0x10c30c30c30c30c3ULL;
+    x = (x | x >> 4) & 0x100f00f00f00f00fULL;
+    x = (x | x >> 8) & 0x001f0000ff0000ffULL;
+    x = (x | x >> 16) & 0x001f00000000ffffULL;
+    x = (x | x >> 32) & 0x00000000001fffffULL;
+  }
+  return x;
+}
+
+/* The following templates implement the array versions of the scheme
+ * functions for a default scheme TScheme whose elements are stored as TElem.
+ * The element functions called in the loops are qualified with TScheme, thus
+ * they are resolved at compile time and can be inlined.
+ * If the dynamic type of the scheme is a class derived from TScheme, it may
+ * override these element functions. In this case we call the default
+ * implementation of t8_eclass_scheme_c, which calls the virtual functions.
+ * The arrays must not be compact, see t8_element_array_compact. */
+
+/** Array version of t8_element_get_linear_id for a default scheme. */
+template < class TScheme, class TElem > void
+t8_default_array_linear_ids (TScheme * ts, t8_element_array_t * elements,
+                             size_t first, size_t count, int level,
+                             t8_linearidx_t * ids)
+{
+  const TElem        *elems;
+  size_t              ielem;
+
+  if (!T8_COMMON_IS_EXACT_TYPE (ts, TScheme)) {
+    ts->t8_eclass_scheme_c::t8_element_array_linear_ids (elements, first,
+                                                         count, level, ids);
+    return;
+  }
+  T8_ASSERT (elements->scheme == ts);
+  T8_ASSERT (!t8_element_array_is_compact (elements));
+  T8_ASSERT (elements->array.elem_size == sizeof (TElem));
+  T8_ASSERT (first + count <= elements->array.elem_count);
+
+  elems = (const TElem *) elements->array.array + first;
+  for (ielem = 0; ielem < count; ielem++) {
+    ids[ielem] =
+      ts->TScheme::t8_element_get_linear_id ((const t8_element_t *)
+                                             (elems + ielem), level);
+  }
+}
+
+/** Array version of t8_element_level for a default scheme. */
+template < class TScheme, class TElem > void
+t8_default_array_levels (TScheme * ts, t8_element_array_t * elements,
+                         size_t first, size_t count, int *levels)
+{
+  const TElem        *elems;
+  size_t              ielem;
+
+  if (!T8_COMMON_IS_EXACT_TYPE (ts, TScheme)) {
+    ts->t8_eclass_scheme_c::t8_element_array_levels (elements, first, count,
+                                                     levels);
+    return;
+  }
+  T8_ASSERT (elements->scheme == ts);
+  T8_ASSERT (!t8_element_array_is_compact (elements));
+  T8_ASSERT (elements->array.elem_size == sizeof (TElem));
+  T8_ASSERT (first + count <= elements->array.elem_count);
+
+  elems = (const TElem *) elements->array.array + first;
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] =
+      ts->TScheme::t8_element_level ((const t8_element_t *)
+                                     (elems + ielem));
+  }
+}
+
+/** Array version of t8_element_child_id for a default scheme. */
+template < class TScheme, class TElem > void
+t8_default_array_child_ids (TScheme * ts, t8_element_array_t * elements,
+                            size_t first, size_t count, int *child_ids)
+{
+  const TElem        *elems;
+  size_t              ielem;
+
+  if (!T8_COMMON_IS_EXACT_TYPE (ts, TScheme)) {
+    ts->t8_eclass_scheme_c::t8_element_array_child_ids (elements, first,
+                                                        count, child_ids);
+    return;
+  }
+  T8_ASSERT (elements->scheme == ts);
+  T8_ASSERT (!t8_element_array_is_compact (elements));
+  T8_ASSERT (elements->array.elem_size == sizeof (TElem));
+  T8_ASSERT (first + count <= elements->array.elem_count);
+
+  elems = (const TElem *) elements->array.array + first;
+  for (ielem = 0; ielem < count; ielem++) {
+    child_ids[ielem] =
+      ts->TScheme::t8_element_child_id ((const t8_element_t *)
+                                        (elems + ielem));
+  }
+}
+
+/** Array version of t8_element_parent for a default scheme. */
+template < class TScheme, class TElem > void
+t8_default_array_parents (TScheme * ts, t8_element_array_t * elements,
+                          size_t first, size_t count,
+                          t8_element_array_t * parents, size_t parents_first)
+{
+  const TElem        *elems;
+  TElem              *parent_elems;
+  size_t              ielem;
+
+  if (!T8_COMMON_IS_EXACT_TYPE (ts, TScheme)) {
+    ts->t8_eclass_scheme_c::t8_element_array_parents (elements, first, count,
+                                                      parents, parents_first);
+    return;
+  }
+  T8_ASSERT (elements->scheme == ts && parents->scheme == ts);
+  T8_ASSERT (!t8_element_array_is_compact (elements));
+  T8_ASSERT (!t8_element_array_is_compact (parents));
+  T8_ASSERT (elements->array.elem_size == sizeof (TElem));
+  T8_ASSERT (first + count <= elements->array.elem_count);
+  T8_ASSERT (parents_first + count <= parents->array.elem_count);
+
+  elems = (const TElem *) elements->array.array + first;
+  parent_elems = (TElem *) parents->array.array + parents_first;
+  for (ielem = 0; ielem < count; ielem++) {
+    ts->TScheme::t8_element_parent ((const t8_element_t *) (elems + ielem),
+                                    (t8_element_t *) (parent_elems + ielem));
+  }
+}
+
+/** Array version of t8_element_children for a default scheme.
+ * All elements of the scheme must have the same number of children. */
+template < class TScheme, class TElem > size_t
+t8_default_array_children (TScheme * ts, t8_element_array_t * elements,
+                           size_t first, size_t count,
+                           t8_element_array_t * children,
+                           size_t children_first)
+{
+  const TElem        *elems;
+  TElem              *child_elems;
+  t8_element_t      **child_pointers;
+  size_t              ielem;
+  int                 num_children, ichild;
+
+  if (!T8_COMMON_IS_EXACT_TYPE (ts, TScheme)) {
+    return ts->t8_eclass_scheme_c::t8_element_array_children (elements, first,
+                                                              count, children,
+                                                              children_first);
+  }
+  T8_ASSERT (elements->scheme == ts && children->scheme == ts);
+  T8_ASSERT (elements != children);
+  T8_ASSERT (!t8_element_array_is_compact (elements));
+  T8_ASSERT (!t8_element_array_is_compact (children));
+  T8_ASSERT (elements->array.elem_size == sizeof (TElem));
+  T8_ASSERT (first + count <= elements->array.elem_count);
+
+  if (count == 0) {
+    return 0;
+  }
+  elems = (const TElem *) elements->array.array + first;
+  num_children =
+    ts->TScheme::t8_element_num_children ((const t8_element_t *) elems);
+  T8_ASSERT (children_first + count * num_children <=
+             children->array.elem_count);
+  child_elems = (TElem *) children->array.array + children_first;
+  child_pointers = T8_ALLOC (t8_element_t *, num_children);
+  for (ielem = 0; ielem < count; ielem++) {
+    for (ichild = 0; ichild < num_children; ichild++) {
+      child_pointers[ichild] = (t8_element_t *) (child_elems + ichild);
+    }
+    ts->TScheme::t8_element_children ((const t8_element_t *) (elems + ielem),
+                                      num_children, child_pointers);
+    child_elems += num_children;
+  }
+  T8_FREE (child_pointers);
+  return count * num_children;
+}
+
 #endif /* !T8_DEFAULT_COMMON_CXX_HXX */
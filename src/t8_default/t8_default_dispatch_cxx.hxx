@@ -0,0 +1,238 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_default_dispatch_cxx.hxx
+ * We provide a dispatch from a scheme pointer to its exact default scheme
+ * class. Code that is templated on the scheme class, called through this
+ * dispatch once per tree and that calls the element functions through the
+ * t8_default_call_* functions below resolves the element functions of the
+ * default quad, hex, triangle and tet schemes at compile time.
+ */
+
+#ifndef T8_DEFAULT_DISPATCH_CXX_HXX
+#define T8_DEFAULT_DISPATCH_CXX_HXX
+
+#include <t8_element_cxx.hxx>
+#include "t8_default_common_cxx.hxx"
+#include "t8_default_quad_cxx.hxx"
+#include "t8_default_hex_cxx.hxx"
+#include "t8_default_tri_cxx.hxx"
+#include "t8_default_tet_cxx.hxx"
+
+/** Call a functor with a scheme pointer of the exact type of the scheme.
+ * If the dynamic type of \a ts is exactly one of the default quad, hex,
+ * triangle or tet schemes, the functor is called with a pointer to the
+ * respective class, otherwise with \a ts itself. Thus a class derived from
+ * a default scheme always takes the generic path and its overrides of the
+ * element functions are respected.
+ * \param [in] ts       An element scheme.
+ * \param [in,out] functor An object with a templated
+ *                      template <class TScheme> void operator() (TScheme *ts).
+ */
+template < class TFunctor > void
+t8_default_scheme_dispatch (t8_eclass_scheme_c * ts, TFunctor & functor)
+{
+  if (T8_COMMON_IS_EXACT_TYPE (ts, t8_default_scheme_quad_c)) {
+    functor (static_cast < t8_default_scheme_quad_c * >(ts));
+  }
+  else if (T8_COMMON_IS_EXACT_TYPE (ts, t8_default_scheme_hex_c)) {
+    functor (static_cast < t8_default_scheme_hex_c * >(ts));
+  }
+  else if (T8_COMMON_IS_EXACT_TYPE (ts, t8_default_scheme_tri_c)) {
+    functor (static_cast < t8_default_scheme_tri_c * >(ts));
+  }
+  else if (T8_COMMON_IS_EXACT_TYPE (ts, t8_default_scheme_tet_c)) {
+    functor (static_cast < t8_default_scheme_tet_c * >(ts));
+  }
+  else {
+    /* Generic path through the virtual functions */
+    functor (ts);
+  }
+}
+
+/* The following functions call an element function of a scheme.
+ * The templated version is chosen for a pointer to a default scheme class
+ * and calls the function qualified with this class, thus without virtual
+ * dispatch. The overload for t8_eclass_scheme_c is chosen for the generic
+ * path and calls the virtual function. Code that is called through
+ * t8_default_scheme_dispatch uses these functions for its element calls. */
+
+template < class TScheme > inline int
+t8_default_call_level (TScheme * ts, const t8_element_t * elem)
+{
+  return ts->TScheme::t8_element_level (elem);
+}
+
+inline int
+t8_default_call_level (t8_eclass_scheme_c * ts, const t8_element_t * elem)
+{
+  return ts->t8_element_level (elem);
+}
+
+template < class TScheme > inline void
+t8_default_call_copy (TScheme * ts, const t8_element_t * source,
+                      t8_element_t * dest)
+{
+  ts->TScheme::t8_element_copy (source, dest);
+}
+
+inline void
+t8_default_call_copy (t8_eclass_scheme_c * ts, const t8_element_t * source,
+                      t8_element_t * dest)
+{
+  ts->t8_element_copy (source, dest);
+}
+
+template < class TScheme > inline int
+t8_default_call_compare (TScheme * ts, const t8_element_t * elem1,
+                         const t8_element_t * elem2)
+{
+  return ts->TScheme::t8_element_compare (elem1, elem2);
+}
+
+inline int
+t8_default_call_compare (t8_eclass_scheme_c * ts, const t8_element_t * elem1,
+                         const t8_element_t * elem2)
+{
+  return ts->t8_element_compare (elem1, elem2);
+}
+
+template < class TScheme > inline void
+t8_default_call_parent (TScheme * ts, const t8_element_t * elem,
+                        t8_element_t * parent)
+{
+  ts->TScheme::t8_element_parent (elem, parent);
+}
+
+inline void
+t8_default_call_parent (t8_eclass_scheme_c * ts, const t8_element_t * elem,
+                        t8_element_t * parent)
+{
+  ts->t8_element_parent (elem, parent);
+}
+
+template < class TScheme > inline int
+t8_default_call_num_children (TScheme * ts, const t8_element_t * elem)
+{
+  return ts->TScheme::t8_element_num_children (elem);
+}
+
+inline int
+t8_default_call_num_children (t8_eclass_scheme_c * ts,
+                              const t8_element_t * elem)
+{
+  return ts->t8_element_num_children (elem);
+}
+
+template < class TScheme > inline void
+t8_default_call_children (TScheme * ts, const t8_element_t * elem,
+                          int length, t8_element_t * c[])
+{
+  ts->TScheme::t8_element_children (elem, length, c);
+}
+
+inline void
+t8_default_call_children (t8_eclass_scheme_c * ts, const t8_element_t * elem,
+                          int length, t8_element_t * c[])
+{
+  ts->t8_element_children (elem, length, c);
+}
+
+template < class TScheme > inline int
+t8_default_call_child_id (TScheme * ts, const t8_element_t * elem)
+{
+  return ts->TScheme::t8_element_child_id (elem);
+}
+
+inline int
+t8_default_call_child_id (t8_eclass_scheme_c * ts, const t8_element_t * elem)
+{
+  return ts->t8_element_child_id (elem);
+}
+
+template < class TScheme > inline int
+t8_default_call_ancestor_id (TScheme * ts, const t8_element_t * elem,
+                             int level)
+{
+  return ts->TScheme::t8_element_ancestor_id (elem, level);
+}
+
+inline int
+t8_default_call_ancestor_id (t8_eclass_scheme_c * ts,
+                             const t8_element_t * elem, int level)
+{
+  return ts->t8_element_ancestor_id (elem, level);
+}
+
+template < class TScheme > inline int
+t8_default_call_is_family (TScheme * ts, t8_element_t ** fam)
+{
+  return ts->TScheme::t8_element_is_family (fam);
+}
+
+inline int
+t8_default_call_is_family (t8_eclass_scheme_c * ts, t8_element_t ** fam)
+{
+  return ts->t8_element_is_family (fam);
+}
+
+template < class TScheme > inline void
+t8_default_call_nca (TScheme * ts, const t8_element_t * elem1,
+                     const t8_element_t * elem2, t8_element_t * nca)
+{
+  ts->TScheme::t8_element_nca (elem1, elem2, nca);
+}
+
+inline void
+t8_default_call_nca (t8_eclass_scheme_c * ts, const t8_element_t * elem1,
+                     const t8_element_t * elem2, t8_element_t * nca)
+{
+  ts->t8_element_nca (elem1, elem2, nca);
+}
+
+template < class TScheme > inline void
+t8_default_call_new (TScheme * ts, int length, t8_element_t ** elems)
+{
+  ts->TScheme::t8_element_new (length, elems);
+}
+
+inline void
+t8_default_call_new (t8_eclass_scheme_c * ts, int length,
+                     t8_element_t ** elems)
+{
+  ts->t8_element_new (length, elems);
+}
+
+template < class TScheme > inline void
+t8_default_call_destroy (TScheme * ts, int length, t8_element_t ** elems)
+{
+  ts->TScheme::t8_element_destroy (length, elems);
+}
+
+inline void
+t8_default_call_destroy (t8_eclass_scheme_c * ts, int length,
+                         t8_element_t ** elems)
+{
+  ts->t8_element_destroy (length, elems);
+}
+
+#endif /* !T8_DEFAULT_DISPATCH_CXX_HXX */
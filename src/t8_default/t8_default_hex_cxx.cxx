@@ -44,13 +44,6 @@ t8_default_scheme_hex_c::t8_element_child_eclass (int childid)
 }
 /* *INDENT-ON* */
 
-int
-t8_default_scheme_hex_c::t8_element_level (const t8_element_t * elem)
-{
-  T8_ASSERT (t8_element_is_valid (elem));
-  return (int) ((const p8est_quadrant_t *) elem)->level;
-}
-
 void
 t8_default_scheme_hex_c::t8_element_copy (const t8_element_t * source,
                                           t8_element_t * dest)
@@ -677,6 +670,91 @@ t8_default_scheme_hex_c::t8_element_vertex_coords (const t8_element_t * t,
   coords[2] = q1->z + (vertex & 4 ? 1 : 0) * len;
 }
 
+void
+t8_default_scheme_hex_c::t8_element_array_linear_ids (t8_element_array_t *
+                                                      elements, size_t first,
+                                                      size_t count, int level,
+                                                      t8_linearidx_t * ids)
+{
+  t8_default_array_linear_ids < t8_default_scheme_hex_c,
+    t8_phex_t > (this, elements, first, count, level, ids);
+}
+
+void
+t8_default_scheme_hex_c::t8_element_array_levels (t8_element_array_t *
+                                                  elements, size_t first,
+                                                  size_t count, int *levels)
+{
+  t8_default_array_levels < t8_default_scheme_hex_c,
+    t8_phex_t > (this, elements, first, count, levels);
+}
+
+void
+t8_default_scheme_hex_c::t8_element_array_child_ids (t8_element_array_t *
+                                                     elements, size_t first,
+                                                     size_t count, int
+                                                     *child_ids)
+{
+  t8_default_array_child_ids < t8_default_scheme_hex_c,
+    t8_phex_t > (this, elements, first, count, child_ids);
+}
+
+void
+t8_default_scheme_hex_c::t8_element_array_parents (t8_element_array_t *
+                                                   elements, size_t first,
+                                                   size_t count,
+                                                   t8_element_array_t *
+                                                   parents, size_t
+                                                   parents_first)
+{
+  t8_default_array_parents < t8_default_scheme_hex_c,
+    t8_phex_t > (this, elements, first, count, parents, parents_first);
+}
+
+size_t
+t8_default_scheme_hex_c::t8_element_array_children (t8_element_array_t *
+                                                    elements, size_t first,
+                                                    size_t count,
+                                                    t8_element_array_t *
+                                                    children, size_t
+                                                    children_first)
+{
+  return t8_default_array_children < t8_default_scheme_hex_c,
+    t8_phex_t > (this, elements, first, count, children,
+                        children_first);
+}
+
+void
+t8_default_scheme_hex_c::t8_element_array_set_linear_ids (t8_element_array_t *
+                                                          elements, size_t
+                                                          first, int level,
+                                                          t8_linearidx_t
+                                                          id_begin,
+                                                          t8_linearidx_t
+                                                          id_end)
+{
+  p8est_quadrant_t   *q;
+  t8_linearidx_t      id;
+  const int           shift = P8EST_MAXLEVEL - level;
+
+  T8_ASSERT (elements->scheme == this);
+  T8_ASSERT (elements->array.elem_size == sizeof (t8_phex_t));
+  T8_ASSERT (0 <= level && level <= P8EST_QMAXLEVEL);
+  T8_ASSERT (id_begin <= id_end);
+  T8_ASSERT (id_end <= ((t8_linearidx_t) 1) << P8EST_DIM * level);
+  T8_ASSERT (first + (id_end - id_begin) <= elements->array.elem_count);
+
+  /* Each hexahedron is computed from its Morton index independently
+   * of the others */
+  q = (p8est_quadrant_t *) elements->array.array + first;
+  for (id = id_begin; id < id_end; id++, q++) {
+    q->x = (p4est_qcoord_t) t8_default_morton_compact (id, 3) << shift;
+    q->y = (p4est_qcoord_t) t8_default_morton_compact (id >> 1, 3) << shift;
+    q->z = (p4est_qcoord_t) t8_default_morton_compact (id >> 2, 3) << shift;
+    q->level = level;
+  }
+}
+
 void
 t8_default_scheme_hex_c::t8_element_new (int length, t8_element_t ** elem)
 {
@@ -731,7 +809,7 @@ t8_default_scheme_hex_c::t8_default_scheme_hex_c (void)
 {
   eclass = T8_ECLASS_HEX;
   element_size = sizeof (t8_phex_t);
-  ts_context = sc_mempool_new (element_size);
+  ts_context = t8_default_mempool_new (element_size);
 }
 
 t8_default_scheme_hex_c::~t8_default_scheme_hex_c ()
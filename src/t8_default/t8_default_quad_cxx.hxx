@@ -103,8 +103,13 @@ public:
 /** Return the type of each child in the ordering of the implementation. */
   virtual t8_eclass_t t8_element_child_eclass (int childid);
 
-/** Return the refinement level of an element. */
-  virtual int         t8_element_level (const t8_element_t * elem);
+/** Return the refinement level of an element.
+ * Defined inline, such that it can be inlined in specialized code paths. */
+  virtual int         t8_element_level (const t8_element_t * elem)
+  {
+    T8_ASSERT (t8_element_is_valid (elem));
+    return (int) ((const p4est_quadrant_t *) elem)->level;
+  }
 
 /** Copy one element to another */
   virtual void        t8_element_copy (const t8_element_t * source,
@@ -301,6 +306,47 @@ public:
   virtual void        t8_element_vertex_coords (const t8_element_t * t,
                                                 int vertex, int coords[]);
 
+  /** Compute the linear ids of a range of elements in an array. */
+  virtual void        t8_element_array_linear_ids (t8_element_array_t *
+                                                   elements, size_t first,
+                                                   size_t count, int level,
+                                                   t8_linearidx_t * ids);
+
+  /** Compute the levels of a range of elements in an array. */
+  virtual void        t8_element_array_levels (t8_element_array_t *
+                                               elements, size_t first,
+                                               size_t count, int *levels);
+
+  /** Compute the child ids of a range of elements in an array. */
+  virtual void        t8_element_array_child_ids (t8_element_array_t *
+                                                  elements, size_t first,
+                                                  size_t count,
+                                                  int *child_ids);
+
+  /** Compute the parents of a range of elements in an array. */
+  virtual void        t8_element_array_parents (t8_element_array_t *
+                                                elements, size_t first,
+                                                size_t count,
+                                                t8_element_array_t * parents,
+                                                size_t parents_first);
+
+  /** Compute the children of a range of elements in an array. */
+  virtual size_t      t8_element_array_children (t8_element_array_t *
+                                                 elements, size_t first,
+                                                 size_t count,
+                                                 t8_element_array_t *
+                                                 children,
+                                                 size_t children_first);
+
+  /** Initialize a range of elements in an array with consecutive linear ids. */
+  virtual void        t8_element_array_set_linear_ids (t8_element_array_t *
+                                                       elements,
+                                                       size_t first,
+                                                       int level,
+                                                       t8_linearidx_t
+                                                       id_begin,
+                                                       t8_linearidx_t id_end);
+
 #ifdef T8_ENABLE_DEBUG
   /** Query whether an element is valid */
   virtual int         t8_element_is_valid (const t8_element_t * t) const;
@@ -37,13 +37,6 @@ t8_default_scheme_tet_c::t8_element_maxlevel (void)
   return T8_DTET_MAXLEVEL;
 }
 
-int
-t8_default_scheme_tet_c::t8_element_level (const t8_element_t * elem)
-{
-  T8_ASSERT (t8_element_is_valid (elem));
-  return t8_dtet_get_level ((t8_dtet_t *) elem);
-}
-
 void
 t8_default_scheme_tet_c::t8_element_copy (const t8_element_t * source,
                                           t8_element_t * dest)
@@ -546,6 +539,77 @@ t8_default_scheme_tet_c::t8_element_is_valid (const t8_element_t * t) const
 }
 #endif
 
+void
+t8_default_scheme_tet_c::t8_element_array_linear_ids (t8_element_array_t *
+                                                      elements, size_t first,
+                                                      size_t count, int level,
+                                                      t8_linearidx_t * ids)
+{
+  t8_default_array_linear_ids < t8_default_scheme_tet_c,
+    t8_dtet_t > (this, elements, first, count, level, ids);
+}
+
+void
+t8_default_scheme_tet_c::t8_element_array_levels (t8_element_array_t *
+                                                  elements, size_t first,
+                                                  size_t count, int *levels)
+{
+  t8_default_array_levels < t8_default_scheme_tet_c,
+    t8_dtet_t > (this, elements, first, count, levels);
+}
+
+void
+t8_default_scheme_tet_c::t8_element_array_child_ids (t8_element_array_t *
+                                                     elements, size_t first,
+                                                     size_t count, int
+                                                     *child_ids)
+{
+  t8_default_array_child_ids < t8_default_scheme_tet_c,
+    t8_dtet_t > (this, elements, first, count, child_ids);
+}
+
+void
+t8_default_scheme_tet_c::t8_element_array_parents (t8_element_array_t *
+                                                   elements, size_t first,
+                                                   size_t count,
+                                                   t8_element_array_t *
+                                                   parents, size_t
+                                                   parents_first)
+{
+  t8_default_array_parents < t8_default_scheme_tet_c,
+    t8_dtet_t > (this, elements, first, count, parents, parents_first);
+}
+
+size_t
+t8_default_scheme_tet_c::t8_element_array_children (t8_element_array_t *
+                                                    elements, size_t first,
+                                                    size_t count,
+                                                    t8_element_array_t *
+                                                    children, size_t
+                                                    children_first)
+{
+  return t8_default_array_children < t8_default_scheme_tet_c,
+    t8_dtet_t > (this, elements, first, count, children, children_first);
+}
+
+void
+t8_default_scheme_tet_c::t8_element_array_set_linear_ids (t8_element_array_t *
+                                                          elements, size_t
+                                                          first, int level,
+                                                          t8_linearidx_t
+                                                          id_begin,
+                                                          t8_linearidx_t
+                                                          id_end)
+{
+  T8_ASSERT (elements->scheme == this);
+  T8_ASSERT (elements->array.elem_size == sizeof (t8_default_tet_t));
+  T8_ASSERT (0 <= level && level <= T8_DTET_MAXLEVEL);
+  T8_ASSERT (first + (id_end - id_begin) <= elements->array.elem_count);
+
+  t8_dtet_init_linear_id_range ((t8_dtet_t *) elements->array.array + first,
+                                level, id_begin, id_end);
+}
+
 void
 t8_default_scheme_tet_c::t8_element_new (int length, t8_element_t ** elem)
 {
@@ -583,7 +647,7 @@ t8_default_scheme_tet_c::t8_default_scheme_tet_c (void)
 {
   eclass = T8_ECLASS_TET;
   element_size = sizeof (t8_dtet_t);
-  ts_context = sc_mempool_new (element_size);
+  ts_context = t8_default_mempool_new (element_size);
 }
 
  /* Destructor */
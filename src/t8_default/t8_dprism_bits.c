@@ -25,6 +25,10 @@
 #include "t8_dline_bits.h"
 #include "t8_dprism_bits.h"
 #include "t8_dtri_bits.h"
+#include "t8_dtri_connectivity.h"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 int                 t8_dprism_face_corners[5][4] = {
   {1, 2, 4, 5},
@@ -34,6 +38,96 @@ int                 t8_dprism_face_corners[5][4] = {
   {3, 4, 5, -1}
 };
 
+/* A prism linear id consists of one octal digit per level. The lower two
+ * bits of each digit are the local index of the triangle and the upper bit
+ * is the local index of the line. These masks select the triangle part and
+ * the line part of the digits. */
+#define T8_DPRISM_ID_MASK_TRI 0x36db6db6db6db6dbULL
+#define T8_DPRISM_ID_MASK_LINE 0x4924924924924924ULL
+
+/* Spread the lowest T8_DPRISM_MAXLEVEL bits of x, such that bit i is moved
+ * to bit 3 * i. */
+static inline       t8_linearidx_t
+t8_dprism_spread3 (t8_linearidx_t x)
+{
+  x &= 0x1fffffULL;
+  x = (x | x << 32) & 0x001f00000000ffffULL;
+  x = (x | x << 16) & 0x001f0000ff0000ffULL;
+  x = (x | x << 8) & 0x100f00f00f00f00fULL;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+  x = (x | x << 2) & 0x1249249249249249ULL;
+  return x;
+}
+
+/* The inverse of t8_dprism_spread3. */
+static inline       t8_linearidx_t
+t8_dprism_compact3 (t8_linearidx_t x)
+{
+  x &= 0x1249249249249249ULL;
+  x = (x | x >> 2) & 0x10c30c30c30c30c3ULL;
+  x = (x | x >> 4) & 0x100f00f00f00f00fULL;
+  x = (x | x >> 8) & 0x001f0000ff0000ffULL;
+  x = (x | x >> 16) & 0x001f00000000ffffULL;
+  x = (x | x >> 32) & 0x00000000001fffffULL;
+  return x;
+}
+
+/* Spread the lowest 32 bits of x, such that bit i is moved to bit 2 * i. */
+static inline       t8_linearidx_t
+t8_dprism_spread2 (t8_linearidx_t x)
+{
+  x &= 0xffffffffULL;
+  x = (x | x << 16) & 0x0000ffff0000ffffULL;
+  x = (x | x << 8) & 0x00ff00ff00ff00ffULL;
+  x = (x | x << 4) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & 0x5555555555555555ULL;
+  return x;
+}
+
+/* The inverse of t8_dprism_spread2. */
+static inline       t8_linearidx_t
+t8_dprism_compact2 (t8_linearidx_t x)
+{
+  x &= 0x5555555555555555ULL;
+  x = (x | x >> 1) & 0x3333333333333333ULL;
+  x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | x >> 4) & 0x00ff00ff00ff00ffULL;
+  x = (x | x >> 8) & 0x0000ffff0000ffffULL;
+  x = (x | x >> 16) & 0x00000000ffffffffULL;
+  return x;
+}
+
+/* Interleave the base 4 digits of a triangle id and the bits of a line id
+ * of the same level into the octal digits of a prism id. */
+static inline       t8_linearidx_t
+t8_dprism_interleave_id (t8_linearidx_t tri_id, t8_linearidx_t line_id)
+{
+#ifdef __BMI2__
+  return _pdep_u64 (tri_id, T8_DPRISM_ID_MASK_TRI)
+    | _pdep_u64 (line_id, T8_DPRISM_ID_MASK_LINE);
+#else
+  return t8_dprism_spread3 (t8_dprism_compact2 (tri_id))
+    | t8_dprism_spread3 (t8_dprism_compact2 (tri_id >> 1)) << 1
+    | t8_dprism_spread3 (line_id) << 2;
+#endif
+}
+
+/* The inverse of t8_dprism_interleave_id. */
+static inline void
+t8_dprism_deinterleave_id (t8_linearidx_t id, t8_linearidx_t * tri_id,
+                           t8_linearidx_t * line_id)
+{
+#ifdef __BMI2__
+  *tri_id = _pext_u64 (id, T8_DPRISM_ID_MASK_TRI);
+  *line_id = _pext_u64 (id, T8_DPRISM_ID_MASK_LINE);
+#else
+  *tri_id = t8_dprism_spread2 (t8_dprism_compact3 (id))
+    | t8_dprism_spread2 (t8_dprism_compact3 (id >> 1)) << 1;
+  *line_id = t8_dprism_compact3 (id >> 2);
+#endif
+}
+
 int
 t8_dprism_get_level (const t8_dprism_t * p)
 {
@@ -71,35 +165,20 @@ t8_dprism_compare (const t8_dprism_t * p1, const t8_dprism_t * p2)
   return id1 < id2 ? -1 : id1 != id2;
 }
 
+/* We split the octal digits of the id into the triangle and the line id
+ * and set the triangle and line coordinates directly from these. */
 void
 t8_dprism_init_linear_id (t8_dprism_t * p, int level, uint64_t id)
 {
-  uint64_t            tri_id = 0;
-  uint64_t            line_id = 0;
-  int                 i;
-  int                 triangles_of_size_i = 1;
+  t8_linearidx_t      tri_id, line_id;
 
   T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
-  T8_ASSERT (id < sc_intpow64u (T8_DPRISM_CHILDREN, level));
-
-  for (i = 0; i <= level; i++) {
-    /*Get the number of the i-th prism and get the related triangle number
-     * then multiplicate it by the number of triangles of level size.*/
-    tri_id += (id % T8_DTRI_CHILDREN) * triangles_of_size_i;
-
-    /*If id % 8 is larger than 3, the prism is in the upper part of the
-     * parent prism. => line_id + 2^i*/
-    line_id +=
-      (id % T8_DPRISM_CHILDREN) / T8_DTRI_CHILDREN *
-      sc_intpow64u (T8_DLINE_CHILDREN, i);
-
-    /*Each Prism divides into 8 children */
-    id /= T8_DPRISM_CHILDREN;
-    /*Each triangle divides into 4 children */
-    triangles_of_size_i *= T8_DTRI_CHILDREN;
-  }
+  T8_ASSERT (id < ((t8_linearidx_t) 1) << (3 * level));
+
+  t8_dprism_deinterleave_id (id, &tri_id, &line_id);
   t8_dtri_init_linear_id (&p->tri, tri_id, level);
-  t8_dline_init_linear_id (&p->line, level, line_id);
+  p->line.level = level;
+  p->line.x = line_id << (T8_DLINE_MAXLEVEL - level);
 
   T8_ASSERT (p->line.level == p->tri.level);
 }
@@ -111,7 +190,9 @@ t8_dprism_parent (const t8_dprism_t * p, t8_dprism_t * parent)
   T8_ASSERT (p->line.level == p->tri.level);
 
   t8_dtri_parent (&p->tri, &parent->tri);
-  t8_dline_parent (&p->line, &parent->line);
+  /* The parent of the line: zero out the bit of p's level */
+  parent->line.x = p->line.x & ~T8_DLINE_LEN (p->line.level);
+  parent->line.level = p->line.level - 1;
 
   T8_ASSERT (parent->line.level == parent->tri.level);
 }
@@ -120,7 +201,8 @@ int
 t8_dprism_child_id (const t8_dprism_t * p)
 {
   int                 tri_child_id = t8_dtri_child_id (&p->tri);
-  int                 line_child_id = t8_dline_child_id (&p->line);
+  int                 line_child_id =
+    (p->line.x & T8_DLINE_LEN (p->line.level)) != 0;
   T8_ASSERT (p->line.level == p->tri.level);
   /*Prism in lower plane has the same id as the triangle, in the upper plane
    * it's a shift by the number of children a triangle has*/
@@ -252,8 +334,12 @@ t8_dprism_child (const t8_dprism_t * p, int childid, t8_dprism_t * child)
 {
   T8_ASSERT (0 <= childid && childid < T8_DPRISM_CHILDREN);
   T8_ASSERT (p->line.level == p->tri.level);
+  /* The line child is computed first, since p may equal child */
+  child->line.x =
+    p->line.x + (childid / T8_DTRI_CHILDREN) * T8_DLINE_LEN (p->line.level +
+                                                             1);
+  child->line.level = p->line.level + 1;
   t8_dtri_child (&p->tri, childid % T8_DTRI_CHILDREN, &child->tri);
-  t8_dline_child (&p->line, childid / T8_DTRI_CHILDREN, &child->line);
   T8_ASSERT (child->line.level == child->tri.level);
 }
 
@@ -314,16 +400,52 @@ t8_dprism_get_face_corner (const t8_dprism_t * p, int face, int corner)
   return t8_dprism_face_corners[face][corner];
 }
 
+/* We compute the coordinates and types of the four triangle children once
+ * and combine them with the lower and upper line child. */
 void
 t8_dprism_childrenpv (const t8_dprism_t * p, int length, t8_dprism_t * c[])
 {
-  int                 i;
+  const int8_t        level = p->line.level + 1;
+  const t8_dtri_coord_t h = T8_DTRI_LEN (level);
+  const t8_dline_coord_t line_h = T8_DLINE_LEN (level);
+  const t8_dtri_coord_t x = p->tri.x, y = p->tri.y;
+  const t8_dline_coord_t z = p->line.x;
+  const int           p_type = p->tri.type;
+  int                 i, cid, type;
+  t8_dtri_coord_t     child_x, child_y;
+
   T8_ASSERT (length == T8_DPRISM_CHILDREN);
   T8_ASSERT (p->line.level < T8_DPRISM_MAXLEVEL &&
              p->tri.level == p->line.level);
-  for (i = 7; i >= 0; i--) {
-    t8_dprism_child (p, i, c[i]);
+  /* We stored the coordinates and type of p, since the function may
+   * be called with p = c[0]. */
+  for (i = 0; i < T8_DTRI_CHILDREN; i++) {
+    cid = t8_dtri_parenttype_Iloc_to_cid[p_type][i];
+    type = t8_dtri_parenttype_Iloc_to_type[p_type][i];
+    child_x = x + (cid & 1) * h;
+    child_y = y + ((cid >> 1) & 1) * h;
+    c[i]->tri.x = c[i + T8_DTRI_CHILDREN]->tri.x = child_x;
+    c[i]->tri.y = c[i + T8_DTRI_CHILDREN]->tri.y = child_y;
+    c[i]->tri.type = c[i + T8_DTRI_CHILDREN]->tri.type = type;
+    c[i]->tri.n = c[i + T8_DTRI_CHILDREN]->tri.n = 0;
+    c[i]->tri.level = c[i + T8_DTRI_CHILDREN]->tri.level = level;
+    c[i]->line.x = z;
+    c[i + T8_DTRI_CHILDREN]->line.x = z + line_h;
+    c[i]->line.level = c[i + T8_DTRI_CHILDREN]->line.level = level;
+  }
+#ifdef T8_ENABLE_DEBUG
+  {
+    t8_dprism_t         child;
+    t8_dprism_t         parent;
+
+    t8_dprism_parent (c[0], &parent);
+    for (i = 0; i < T8_DPRISM_CHILDREN; i++) {
+      t8_dprism_child (&parent, i, &child);
+      T8_ASSERT (t8_dprism_compare (&child, c[i]) == 0);
+      T8_ASSERT (child.tri.type == c[i]->tri.type);
+    }
   }
+#endif
 }
 
 int
@@ -458,48 +580,31 @@ t8_dprism_extrude_face (const t8_element_t * face,
   }
 }
 
+/* If p is not the last child of its parent, the successor is the next
+ * sibling. Otherwise it is the prism whose linear id at level is one
+ * larger. If level is larger than the level of p, this is the successor
+ * of the first descendant of p at level. If level is smaller, it is the
+ * successor of the ancestor of p at level. */
 void
 t8_dprism_successor (const t8_dprism_t * p, t8_dprism_t * succ, int level)
 {
-  int                 prism_child_id;
-  t8_dprism_copy (p, succ);
-  /*update the level */
-  succ->line.level = level;
-  succ->tri.level = level;
-  prism_child_id = t8_dprism_child_id (succ);
+  t8_linearidx_t      id;
+  int                 child_id;
+
   T8_ASSERT (1 <= level && level <= T8_DPRISM_MAXLEVEL);
   T8_ASSERT (p->line.level == p->tri.level);
-  /*The next prism is the child with local ID 0 of the next parent prism */
-  if (prism_child_id == T8_DPRISM_CHILDREN - 1) {
-    t8_dprism_successor (p, succ, level - 1);
-    /*Zero out the bits of higher level, caused by recursion */
-#if 1
-    succ->tri.x =
-      (succ->tri.x >> (T8_DTRI_MAXLEVEL - level + 1)) << (T8_DTRI_MAXLEVEL -
-                                                          level + 1);
-    succ->tri.y =
-      (succ->tri.y >> (T8_DTRI_MAXLEVEL - level + 1)) << (T8_DTRI_MAXLEVEL -
-                                                          level + 1);
-#endif
-#if 1
-    succ->line.x =
-      (succ->line.x >> (T8_DLINE_MAXLEVEL - level + 1)) <<
-      (T8_DLINE_MAXLEVEL - level + 1);
-#endif
-    /*Set the level to the actual level */
-    succ->line.level = level;
-    succ->tri.level = level;
-  }
-  /*The next prism is one plane up, local_tri_id = 0 */
-  else if ((prism_child_id + 1) % T8_DTRI_CHILDREN == 0) {
-    /*parent is computed with succ, cause there are the updated datas */
-    t8_dprism_parent (succ, succ);
-    t8_dprism_child (succ, prism_child_id + 1, succ);
-  }
-  /*The next Prism is in the same plane, but has the next base-triangle */
-  else {
-    t8_dtri_successor (&p->tri, &succ->tri, level);
+
+  if (level == p->line.level) {
+    child_id = t8_dprism_child_id (p);
+    if (child_id < T8_DPRISM_CHILDREN - 1) {
+      t8_dprism_parent (p, succ);
+      t8_dprism_child (succ, child_id + 1, succ);
+      return;
+    }
   }
+  id = t8_dprism_linear_id (p, level);
+  T8_ASSERT (id + 1 < ((t8_linearidx_t) 1) << (3 * level));
+  t8_dprism_init_linear_id (succ, level, id + 1);
   T8_ASSERT (succ->line.level == succ->tri.level);
 }
 
@@ -564,51 +669,28 @@ t8_dprism_vertex_coords (const t8_dprism_t * p, int vertex, int coords[3])
   coords[2] /= T8_DPRISM_ROOT_BY_DLINE_ROOT;
 }
 
+/* We compute the triangle and line ids and interleave them.
+ * If level is smaller than p's level, this is the id of p's ancestor
+ * of that level. */
 uint64_t
 t8_dprism_linear_id (const t8_dprism_t * p, int level)
 {
-  uint64_t            id = 0;
-  uint64_t            tri_id;
-  uint64_t            line_id;
-  int                 i;
-  uint64_t            prisms_of_size_i = 1;
-  /*line_level = Num_of_Line_children ^ (level - 1) */
-  uint64_t            line_level;
-  /*prism_shift = Num_of_Prism_children / Num_of_line-Children * 8 ^ (level - 1) */
-  uint64_t            prism_shift;
+  t8_linearidx_t      tri_id;
+  t8_linearidx_t      line_id;
+  const int           p_level = p->line.level;
+
   T8_ASSERT (0 <= level && level <= T8_DPRISM_MAXLEVEL);
   T8_ASSERT (p->line.level == p->tri.level);
-  /*id = 0 for root element */
-  if (level == 0) {
-    return 0;
-  }
 
-  line_level = sc_intpow64u (T8_DLINE_CHILDREN, level - 1);
-  /* *INDENT-OFF* */
-  prism_shift =
-    (T8_DPRISM_CHILDREN / T8_DLINE_CHILDREN) *
-    sc_intpow64u (T8_DPRISM_CHILDREN, level - 1);
-  /* *INDENT-ON* */
-  tri_id = t8_dtri_linear_id (&p->tri, level);
-  line_id = t8_dline_linear_id (&p->line, level);
-  for (i = 0; i < level; i++) {
-    /*Compute via getting the local id of each ancestor triangle in which
-     *elem->tri lies, the prism id, that elem would have, if it lies on the
-     * lowest plane of the prism of level 0 */
-    id += (tri_id % T8_DTRI_CHILDREN) * prisms_of_size_i;
-    tri_id /= T8_DTRI_CHILDREN;
-    prisms_of_size_i *= T8_DPRISM_CHILDREN;
+  if (level < p_level) {
+    /* The id of p's ancestor consists of the first digits of p's id */
+    tri_id = t8_dtri_linear_id (&p->tri, p_level)
+      >> (T8_DTRI_DIM * (p_level - level));
   }
-  /*Now add the actual plane in which the prism is, which is computed via
-   * line_id*/
-  for (i = level - 1; i >= 0; i--) {
-    /*The number to add to the id computed via the tri_id is 4*8^(level-i)
-     *for each plane in a prism of size i*/
-    id += line_id / line_level * prism_shift;
-    line_id = (uint64_t) (line_id % line_level);
-    prism_shift /= T8_DPRISM_CHILDREN;
-    line_level /= T8_DLINE_CHILDREN;
+  else {
+    tri_id = t8_dtri_linear_id (&p->tri, level);
   }
+  line_id = t8_dline_linear_id (&p->line, level);
 
-  return id;
+  return t8_dprism_interleave_id (tri_id, line_id);
 }
@@ -308,6 +308,9 @@ void                t8_dprism_vertex_coords (const t8_dprism_t * p,
 
 /** Computes the linear position of a prism in an uniform grid.
  * \param [in] p  Prism whose id will be computed.
+ * \param [in] level The level of the uniform grid. If smaller than the
+ *                level of \a p, the id of \a p's ancestor of this level
+ *                is computed.
  * \return Returns the linear position of this prism on a grid.
  */
 uint64_t            t8_dprism_linear_id (const t8_dprism_t * p, int level);
@@ -34,8 +34,17 @@ T8_EXTERN_C_BEGIN ();
 /** The spatial dimension */
 #define T8_DTET_DIM (3)
 
+/** The alignment of the connectivity tables that are used by the
+ * frequently called element functions.  We align them to cache lines,
+ * such that each of them is loaded with as few cache misses as possible. */
+#ifdef __GNUC__
+#define T8_DTET_TABLE_ALIGN __attribute__ ((aligned (64)))
+#else
+#define T8_DTET_TABLE_ALIGN
+#endif
+
 /** Store the type of parent for each (cube-id,type) combination. */
-extern const int    t8_dtet_cid_type_to_parenttype[8][6];
+extern const int    t8_dtet_cid_type_to_parenttype[8][6] T8_DTET_TABLE_ALIGN;
 
 /** Store the type of child for each (type,child number) combination,
   * where child number is the number in Bey order. */
@@ -61,13 +70,13 @@ extern const int    t8_dtet_type_cid_to_beyid[6][8];
 extern const int    t8_dtet_parenttype_beyid_to_Iloc[6][8];
 
 /** Store the local index for each (type,cube-id) combination. */
-extern const int    t8_dtet_type_cid_to_Iloc[6][8];
+extern const int    t8_dtet_type_cid_to_Iloc[6][8] T8_DTET_TABLE_ALIGN;
 
 /** Store the type for each (parenttype,local Index) combination. */
-extern const int    t8_dtet_parenttype_Iloc_to_type[6][8];
+extern const int    t8_dtet_parenttype_Iloc_to_type[6][8] T8_DTET_TABLE_ALIGN;
 
 /** Store the cube-id for each (parenttype,local Index) combination. */
-extern const int    t8_dtet_parenttype_Iloc_to_cid[6][8];
+extern const int    t8_dtet_parenttype_Iloc_to_cid[6][8] T8_DTET_TABLE_ALIGN;
 
 /** Store for each (type, face_index) the combination (category, type)
  *  of the respective boundary triangle.
@@ -107,6 +116,38 @@ extern const int    t8_dtet_face_corner[4][3];
  * \see t8_dtet_face_parent_face
  */
 extern const int    t8_dtet_parent_type_type_to_face[6][6];
+
+/** Store the local indices of an element and its parent for each
+ * (type,cube-ids of element and parent) combination. \see t8_dtet_linear_id */
+extern const int8_t t8_dtet_type_cid2_to_Iloc2[6][64];
+
+/** Store the type of the grandparent for each
+ * (type,cube-ids of element and parent) combination. */
+extern const int8_t t8_dtet_type_cid2_to_parenttype2[6][64];
+
+/** Store the cube-ids of child and grandchild for each
+ * (type,local indices of child and grandchild) combination.
+ * \see t8_dtet_init_linear_id */
+extern const int8_t t8_dtet_parenttype_Iloc2_to_cid2[6][64];
+
+/** Store the type of the grandchild for each
+ * (type,local indices of child and grandchild) combination. */
+extern const int8_t t8_dtet_parenttype_Iloc2_to_type2[6][64];
+
+/** Store the type of the face neighbour of a tetrahedron for each
+ * (type, face) combination. \see t8_dtet_face_neighbour */
+extern const int8_t t8_dtet_type_face_to_nb_type[6][4] T8_DTET_TABLE_ALIGN;
+
+/** Store the face of the face neighbour of a tetrahedron at which it
+ * touches the tetrahedron for each (type, face) combination. */
+extern const int8_t t8_dtet_type_face_to_nb_face[6][4] T8_DTET_TABLE_ALIGN;
+
+/** Store the offset of the anchor node of the face neighbour of a
+ * tetrahedron for each (type, face) combination.  The offset is given
+ * in multiples of the length of the tetrahedron. */
+extern const int8_t t8_dtet_type_face_to_nb_offset[6][4][3]
+  T8_DTET_TABLE_ALIGN;
+
 T8_EXTERN_C_END ();
 
 #endif /* T8_DTET_CONNECTIVITY_H */
@@ -27,6 +27,9 @@
 #include "t8_dtet_bits.h"
 #include "t8_dtet_connectivity.h"
 #endif
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 
 typedef int8_t      t8_dtri_cube_id_t;
 
@@ -397,105 +400,100 @@ t8_dtri_compute_all_coords (const t8_dtri_t * t,
 #endif
 }
 
-/* The childid here is the Morton child id
- * (TODO: define this)
+/* The childid here is the Morton child id, which is the local index of
+ * the child.  The anchor node of the child is the anchor node of t plus
+ * the cube-id of the child times the length of the child.
  * It is possible that the function is called with
  * elem = child */
 void
 t8_dtri_child (const t8_dtri_t * t, int childid, t8_dtri_t * child)
 {
   t8_dtri_t          *c = (t8_dtri_t *) child;
+  const int           type = t->type;
+  const t8_dtri_coord_t h = T8_DTRI_LEN (t->level + 1);
+  int                 cid;
+#ifdef T8_ENABLE_DEBUG
   t8_dtri_coord_t     t_coordinates[T8_DTRI_DIM];
-  int                 vertex;
+  t8_dtri_t           parent;
   int                 Bey_cid;
 
+  /* We store t, since the function may be called with t = child. */
+  parent = *t;
+#endif
+
   T8_ASSERT (t->level < T8_DTRI_MAXLEVEL);
   T8_ASSERT (0 <= childid && childid < T8_DTRI_CHILDREN);
 
-  Bey_cid = t8_dtri_index_to_bey_number[t->type][childid];
-
-  /* Compute anchor coordinates of child */
-  if (Bey_cid == 0) {
-    /* TODO: would it be better do drop this if and
-     *       capture it with (t->x+t->x)>>1 below? */
-    c->x = t->x;
-    c->y = t->y;
+  cid = t8_dtri_parenttype_Iloc_to_cid[type][childid];
+  c->x = t->x + (cid & 1) * h;
+  c->y = t->y + ((cid >> 1) & 1) * h;
 #ifdef T8_DTRI_TO_DTET
-    c->z = t->z;
+  c->z = t->z + (cid >> 2) * h;
 #endif
-  }
-  else {
-    vertex = t8_dtri_beyid_to_vertex[Bey_cid];
-    /* i-th anchor coordinate of child is (X_(0,i)+X_(vertex,i))/2
-     * where X_(i,j) is the j-th coordinate of t's ith node */
-    t8_dtri_compute_coords (t, vertex, t_coordinates);
-    c->x = (t->x + t_coordinates[0]) >> 1;
-    c->y = (t->y + t_coordinates[1]) >> 1;
+  c->type = t8_dtri_parenttype_Iloc_to_type[type][childid];
+  c->level = t->level + 1;
+#ifdef T8_ENABLE_DEBUG
+  /* We check whether the child computed here equals the child
+   * computed via the Bey order. */
+  Bey_cid = t8_dtri_index_to_bey_number[type][childid];
+  t8_dtri_compute_coords (&parent, t8_dtri_beyid_to_vertex[Bey_cid],
+                          t_coordinates);
+  T8_ASSERT (c->x == (parent.x + t_coordinates[0]) >> 1);
+  T8_ASSERT (c->y == (parent.y + t_coordinates[1]) >> 1);
 #ifdef T8_DTRI_TO_DTET
-    c->z = (t->z + t_coordinates[2]) >> 1;
+  T8_ASSERT (c->z == (parent.z + t_coordinates[2]) >> 1);
+#endif
+  T8_ASSERT (c->type == t8_dtri_type_of_child[type][Bey_cid]);
 #endif
-  }
-
-  /* Compute type of child */
-  c->type = t8_dtri_type_of_child[t->type][Bey_cid];
-
-  c->level = t->level + 1;
 }
 
 void
 t8_dtri_childrenpv (const t8_dtri_t * t, t8_dtri_t * c[T8_DTRI_CHILDREN])
 {
-  t8_dtri_coord_t     t_coordinates[T8_DTRI_FACES][T8_DTRI_DIM];
+  const t8_dtri_coord_t h = T8_DTRI_LEN (t->level + 1);
+  const t8_dtri_coord_t x = t->x, y = t->y;
+#ifdef T8_DTRI_TO_DTET
+  const t8_dtri_coord_t z = t->z;
+#endif
   const int8_t        level = t->level + 1;
-  int                 i;
-  int                 Bey_cid;
-  int                 vertex;
-  t8_dtri_type_t      t_type = t->type;
+  const int           t_type = t->type;
+  int                 i, cid;
 
   T8_ASSERT (t->level < T8_DTRI_MAXLEVEL);
-  t8_dtri_compute_all_coords (t, t_coordinates);
-  /* We use t_coordinates[0] for t->x,y,z to ensure that the function is valid
-   * if called with t = c[0]. If we would use t->x later it would be the newly
-   * computed value c[0]->x. */
-  c[0]->x = t_coordinates[0][0];        /* t->x */
-  c[0]->y = t_coordinates[0][1];        /* t->y */
+  /* We store the coordinates and type of t, since the function may
+   * be called with t = c[0]. */
+  for (i = 0; i < T8_DTRI_CHILDREN; i++) {
+    cid = t8_dtri_parenttype_Iloc_to_cid[t_type][i];
+    c[i]->x = x + (cid & 1) * h;
+    c[i]->y = y + ((cid >> 1) & 1) * h;
 #ifdef T8_DTRI_TO_DTET
-  c[0]->z = t_coordinates[0][2];        /* t->z */
-#endif
-  c[0]->type = t_type;
-  c[0]->level = level;
-  for (i = 1; i < T8_DTRI_CHILDREN; i++) {
-    Bey_cid = t8_dtri_index_to_bey_number[t_type][i];
-    vertex = t8_dtri_beyid_to_vertex[Bey_cid];
-    /* i-th anchor coordinate of child is (X_(0,i)+X_(vertex,i))/2
-     * where X_(i,j) is the j-th coordinate of t's ith node */
-    c[i]->x = (t_coordinates[0][0] + t_coordinates[vertex][0]) >> 1;
-    c[i]->y = (t_coordinates[0][1] + t_coordinates[vertex][1]) >> 1;
-#ifdef T8_DTRI_TO_DTET
-    c[i]->z = (t_coordinates[0][2] + t_coordinates[vertex][2]) >> 1;
+    c[i]->z = z + (cid >> 2) * h;
 #endif
-    c[i]->type = t8_dtri_type_of_child[t_type][Bey_cid];
+    c[i]->type = t8_dtri_parenttype_Iloc_to_type[t_type][i];
     c[i]->level = level;
+  }
 #ifdef T8_ENABLE_DEBUG
-    {
-      /* We check whether the child computed here equals to the child
-       * computed in the t8_dtri_child function. */
-      t8_dtri_t           check_child;
-      /* We use c[0] here instead of t, since we explicitly allow t=c[0] as input
-       * and thus the values of t may be already overwritten. However the only
-       * difference from c[0] to t is in the level. */
-      c[0]->level--;
-      t8_dtri_child (c[0], i, &check_child);
-      T8_ASSERT (check_child.x == c[i]->x && check_child.y == c[i]->y);
-      T8_ASSERT (check_child.type == c[i]->type
-                 && check_child.level == c[i]->level);
+  {
+    /* We check whether the children computed here equal the children
+     * computed via the Bey order. */
+    t8_dtri_coord_t     t_coordinates[T8_DTRI_DIM];
+    t8_dtri_t           parent;
+    int                 Bey_cid;
+
+    t8_dtri_parent (c[0], &parent);
+    for (i = 0; i < T8_DTRI_CHILDREN; i++) {
+      Bey_cid = t8_dtri_index_to_bey_number[t_type][i];
+      t8_dtri_compute_coords (&parent, t8_dtri_beyid_to_vertex[Bey_cid],
+                              t_coordinates);
+      T8_ASSERT (c[i]->x == (x + t_coordinates[0]) >> 1);
+      T8_ASSERT (c[i]->y == (y + t_coordinates[1]) >> 1);
 #ifdef T8_DTRI_TO_DTET
-      T8_ASSERT (check_child.z == c[i]->z);
+      T8_ASSERT (c[i]->z == (z + t_coordinates[2]) >> 1);
 #endif
-      c[0]->level++;
+      T8_ASSERT (c[i]->type == t8_dtri_type_of_child[t_type][Bey_cid]);
     }
-#endif
   }
+#endif
 }
 
 #ifndef T8_DTRI_TO_DTET
@@ -554,75 +552,21 @@ int
 t8_dtri_face_neighbour (const t8_dtri_t * t, int face, t8_dtri_t * n)
 {
   /* TODO: document what happens if outside of root tet */
-  int                 type_new, type_old;
-#ifdef T8_DTRI_TO_DTET
-  int                 sign;
-#endif
-  int                 ret = -1;
-  int8_t              level;
-  t8_dtri_coord_t     coords[3];
+  const int           type = t->type;
+  const t8_dtri_coord_t h = T8_DTRI_LEN (t->level);
+  const int8_t       *offset;
 
   T8_ASSERT (0 <= face && face < T8_DTRI_FACES);
 
-  level = t->level;
-  type_old = t->type;
-  type_new = type_old;
-  coords[0] = t->x;
-  coords[1] = t->y;
-#ifdef T8_DTRI_TO_DTET
-  coords[2] = t->z;
-#endif
-
-#ifndef T8_DTRI_TO_DTET
-  /* 2D */
-  ret = 2 - face;
-  type_new = 1 - type_old;
-  if (face == 0) {
-    coords[type_old] += T8_DTRI_LEN (level);
-  }
-  else if (face == 2) {
-    coords[1 - type_old] -= T8_DTRI_LEN (level);
-  }
-  /* 2D end */
-#else
-  /* 3D */
-  type_new += 6;                /* We want to compute modulo six and dont want negative numbers */
-  if (face == 1 || face == 2) {
-    sign = (type_new % 2 == 0 ? 1 : -1);
-    sign *= (face % 2 == 0 ? 1 : -1);
-    type_new += sign;
-    type_new %= 6;
-    ret = face;
-  }
-  else {
-    if (face == 0) {
-      /* type: 0,1 --> x+1
-       *       2,3 --> y+1
-       *       4,5 --> z+1 */
-      coords[type_old / 2] += T8_DTRI_LEN (level);
-      type_new += (type_new % 2 == 0 ? 4 : 2);
-    }
-    else {                      /* face == 3 */
-
-      /* type: 1,2 --> z-1
-       *       3,4 --> x-1
-       *       5,0 --> y-1 */
-      coords[((type_new + 3) % 6) / 2] -= T8_DTRI_LEN (level);
-      type_new += (type_new % 2 == 0 ? 2 : 4);
-    }
-    type_new %= 6;
-    ret = 3 - face;
-  }
-  /* 3D end */
-#endif
-  n->x = coords[0];
-  n->y = coords[1];
+  offset = t8_dtri_type_face_to_nb_offset[type][face];
+  n->x = t->x + offset[0] * h;
+  n->y = t->y + offset[1] * h;
 #ifdef T8_DTRI_TO_DTET
-  n->z = coords[2];
+  n->z = t->z + offset[2] * h;
 #endif
-  n->level = level;
-  n->type = type_new;
-  return ret;
+  n->level = t->level;
+  n->type = t8_dtri_type_face_to_nb_type[type][face];
+  return t8_dtri_type_face_to_nb_face[type][face];
 }
 
 void
@@ -696,18 +640,9 @@ t8_dtri_children_at_face (const t8_dtri_t * tri, int face,
   else {
     child_ids = child_ids_local;
   }
-#ifndef T8_DTRI_TO_DTET
-  /* Triangle version */
-  /* The first child is '0' for faces 1 and 2 and '1+type' for face 0 */
-  child_ids[0] = face == 0 ? 1 + tri->type : 0;
-  /* The second child is '1 + type' for face 2 and '3' for faces 0 and 1 */
-  child_ids[1] = face == 2 ? 1 + tri->type : 3;
-#else
-  /* Tetrahedron version */
-  for (i = 0; i < T8_DTET_FACE_CHILDREN; i++) {
-    child_ids[i] = t8_dtet_face_child_id_by_type[tri->type][face][i];
+  for (i = 0; i < T8_DTRI_FACE_CHILDREN; i++) {
+    child_ids[i] = t8_dtri_face_child_id_by_type[tri->type][face][i];
   }
-#endif
 
   /* Compute the children at the face.
    * We revert the order to compute children[0] last, since the usage
@@ -1318,8 +1253,154 @@ t8_dtri_linear_id_corner_desc (const t8_dtri_t * t, int corner, int level)
   return id;
 }
 
+/* The masks of the bits of the x, y (and z) coordinates in a Morton index */
+#ifndef T8_DTRI_TO_DTET
+#define T8_DTRI_MORTON_MASK_X 0x5555555555555555ULL
+#else
+#define T8_DTRI_MORTON_MASK_X 0x9249249249249249ULL
+#endif
+
+/* Spread the lowest T8_DTRI_MAXLEVEL bits of a coordinate, such that
+ * bit i is moved to bit T8_DTRI_DIM * i. */
+static inline       t8_linearidx_t
+t8_dtri_morton_spread (t8_linearidx_t x)
+{
+#ifdef __BMI2__
+  return _pdep_u64 (x, T8_DTRI_MORTON_MASK_X);
+#elif !defined (T8_DTRI_TO_DTET)
+  x &= 0xffffffffULL;
+  x = (x | x << 16) & 0x0000ffff0000ffffULL;
+  x = (x | x << 8) & 0x00ff00ff00ff00ffULL;
+  x = (x | x << 4) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | x << 2) & 0x3333333333333333ULL;
+  x = (x | x << 1) & 0x5555555555555555ULL;
+  return x;
+#else
+  x &= 0x1fffffULL;
+  x = (x | x << 32) & 0x001f00000000ffffULL;
+  x = (x | x << 16) & 0x001f0000ff0000ffULL;
+  x = (x | x << 8) & 0x100f00f00f00f00fULL;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ULL;
+  x = (x | x << 2) & 0x1249249249249249ULL;
+  return x;
+#endif
+}
+
+/* The inverse of t8_dtri_morton_spread. */
+static inline       t8_linearidx_t
+t8_dtri_morton_compact (t8_linearidx_t x)
+{
+#ifdef __BMI2__
+  return _pext_u64 (x, T8_DTRI_MORTON_MASK_X);
+#elif !defined (T8_DTRI_TO_DTET)
+  x &= 0x5555555555555555ULL;
+  x = (x | x >> 1) & 0x3333333333333333ULL;
+  x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | x >> 4) & 0x00ff00ff00ff00ffULL;
+  x = (x | x >> 8) & 0x0000ffff0000ffffULL;
+  x = (x | x >> 16) & 0x00000000ffffffffULL;
+  return x;
+#else
+  x &= 0x1249249249249249ULL;
+  x = (x | x >> 2) & 0x10c30c30c30c30c3ULL;
+  x = (x | x >> 4) & 0x100f00f00f00f00fULL;
+  x = (x | x >> 8) & 0x001f0000ff0000ffULL;
+  x = (x | x >> 16) & 0x001f00000000ffffULL;
+  x = (x | x >> 32) & 0x00000000001fffffULL;
+  return x;
+#endif
+}
+
+/* Compute the Morton index of the anchor node of t at t's level.
+ * The cube-id of t's ancestor at level i is stored in the bits
+ * T8_DTRI_DIM * (t->level - i), ..., T8_DTRI_DIM * (t->level - i + 1) - 1. */
+static inline       t8_linearidx_t
+t8_dtri_anchor_morton (const t8_dtri_t * t)
+{
+  const int           shift = T8_DTRI_MAXLEVEL - t->level;
+  t8_linearidx_t      morton;
+
+  morton = t8_dtri_morton_spread ((t8_linearidx_t) t->x >> shift);
+  morton |= t8_dtri_morton_spread ((t8_linearidx_t) t->y >> shift) << 1;
+#ifdef T8_DTRI_TO_DTET
+  morton |= t8_dtri_morton_spread ((t8_linearidx_t) t->z >> shift) << 2;
+#endif
+  return morton;
+}
+
+/* We compute the linear id from the Morton index of t's anchor node.
+ * Starting at t's level, we translate the cube-ids of two levels at a time
+ * into local indices, while keeping track of the type of the ancestors. */
 t8_linearidx_t
 t8_dtri_linear_id (const t8_dtri_t * t, int level)
+{
+  const t8_linearidx_t cid2_mask = T8_DTRI_CHILDREN * T8_DTRI_CHILDREN - 1;
+  t8_linearidx_t      id = 0, morton, cid2;
+  int                 type, shift, exponent;
+  const int           num_bits = T8_DTRI_DIM * t->level;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  /* If the given level is bigger than t's level
+   * we first fill up with the ids of t's descendants at t's
+   * origin with the same type as t */
+  exponent = level > t->level ? (level - t->level) * T8_DTRI_DIM : 0;
+  morton = t8_dtri_anchor_morton (t);
+  type = t->type;
+  for (shift = 0; shift + 2 * T8_DTRI_DIM <= num_bits;
+       shift += 2 * T8_DTRI_DIM) {
+    cid2 = (morton >> shift) & cid2_mask;
+    id |= (t8_linearidx_t) t8_dtri_type_cid2_to_Iloc2[type][cid2] << shift;
+    type = t8_dtri_type_cid2_to_parenttype2[type][cid2];
+  }
+  if (shift < num_bits) {
+    /* t's level is odd, we process the remaining level 1 ancestor */
+    id |= (t8_linearidx_t) t8_dtri_type_cid_to_Iloc[type][morton >> shift]
+      << shift;
+  }
+  T8_ASSERT (id == t8_dtri_linear_id_reference (t, t->level));
+  return id << exponent;
+}
+
+/* We compute the Morton index of the anchor node of t from the local
+ * indices in id, two levels at a time starting at the root. */
+void
+t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
+{
+  const t8_linearidx_t iloc2_mask = T8_DTRI_CHILDREN * T8_DTRI_CHILDREN - 1;
+  t8_linearidx_t      morton = 0, iloc2, local_index;
+  int                 type, i, shift, coord_shift;
+  T8_ASSERT (0 <= id && id <= ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level));
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+
+  type = 0;                     /* This is the type of the root triangle */
+  for (i = 1; i < level; i += 2) {
+    /* The local indices of the ancestors of level i and i + 1 */
+    shift = T8_DTRI_DIM * (level - i - 1);
+    iloc2 = (id >> shift) & iloc2_mask;
+    morton |=
+      (t8_linearidx_t) t8_dtri_parenttype_Iloc2_to_cid2[type][iloc2] << shift;
+    type = t8_dtri_parenttype_Iloc2_to_type2[type][iloc2];
+  }
+  if (i == level) {
+    /* level is odd, we process the last level */
+    local_index = id & (T8_DTRI_CHILDREN - 1);
+    morton |= t8_dtri_parenttype_Iloc_to_cid[type][local_index];
+    type = t8_dtri_parenttype_Iloc_to_type[type][local_index];
+  }
+  coord_shift = T8_DTRI_MAXLEVEL - level;
+  t->level = level;
+  t->type = type;
+  t->x = (t8_dtri_coord_t) t8_dtri_morton_compact (morton) << coord_shift;
+  t->y = (t8_dtri_coord_t) t8_dtri_morton_compact (morton >> 1) << coord_shift;
+#ifdef T8_DTRI_TO_DTET
+  t->z = (t8_dtri_coord_t) t8_dtri_morton_compact (morton >> 2) << coord_shift;
+#else
+  t->n = 0;
+#endif
+}
+
+t8_linearidx_t
+t8_dtri_linear_id_reference (const t8_dtri_t * t, int level)
 {
   t8_linearidx_t      id = 0;
   int8_t              type_temp = 0;
@@ -1350,7 +1431,8 @@ t8_dtri_linear_id (const t8_dtri_t * t, int level)
 }
 
 void
-t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id, int level)
+t8_dtri_init_linear_id_reference (t8_dtri_t * t, t8_linearidx_t id,
+                                  int level)
 {
   int                 i;
   int                 offset_coords, offset_index;
@@ -1461,6 +1543,58 @@ t8_dtri_successor (const t8_dtri_t * t, t8_dtri_t * s, int level)
   t8_dtri_succ_pred_recursion (t, s, level, 1);
 }
 
+/* We store the types of all ancestors of the current triangle.
+ * From one linear id to the next only the local indices of the last few
+ * levels change, on average less than two.  Only these levels are
+ * recomputed from the type of the parent. */
+void
+t8_dtri_init_linear_id_range (t8_dtri_t * t, int level,
+                              t8_linearidx_t id_begin, t8_linearidx_t id_end)
+{
+  int                 types[T8_DTRI_MAXLEVEL + 1];
+  t8_linearidx_t      id, changed;
+  t8_dtri_coord_t     h;
+  t8_dtri_t          *s;
+  int                 i, first_level, local_index, cid;
+
+  T8_ASSERT (0 <= level && level <= T8_DTRI_MAXLEVEL);
+  T8_ASSERT (id_begin <= id_end);
+  T8_ASSERT (id_end <= ((t8_linearidx_t) 1) << (T8_DTRI_DIM * level));
+
+  if (id_begin >= id_end) {
+    return;
+  }
+  t8_dtri_init_linear_id (t, id_begin, level);
+  /* Compute the types of the ancestors of the first triangle */
+  types[level] = t->type;
+  for (i = level; i > 0; i--) {
+    cid = compute_cubeid (t, i);
+    types[i - 1] = t8_dtri_cid_type_to_parenttype[cid][types[i]];
+  }
+  for (id = id_begin + 1, s = t + 1; id < id_end; id++, s++) {
+    t8_dtri_copy (s - 1, s);
+    /* Find the smallest level whose local index changes */
+    changed = id ^ (id - 1);
+    for (first_level = level; changed >> T8_DTRI_DIM; first_level--) {
+      changed >>= T8_DTRI_DIM;
+    }
+    T8_ASSERT (first_level > 0);
+    for (i = first_level; i <= level; i++) {
+      local_index = (id >> (T8_DTRI_DIM * (level - i)))
+        & (T8_DTRI_CHILDREN - 1);
+      cid = t8_dtri_parenttype_Iloc_to_cid[types[i - 1]][local_index];
+      types[i] = t8_dtri_parenttype_Iloc_to_type[types[i - 1]][local_index];
+      h = T8_DTRI_LEN (i);
+      s->x = cid & 1 ? s->x | h : s->x & ~h;
+      s->y = cid & 2 ? s->y | h : s->y & ~h;
+#ifdef T8_DTRI_TO_DTET
+      s->z = cid & 4 ? s->z | h : s->z & ~h;
+#endif
+    }
+    s->type = types[level];
+  }
+}
+
 void
 t8_dtri_first_descendant (const t8_dtri_t * t, t8_dtri_t * s, int level)
 {
@@ -284,6 +284,28 @@ t8_linearidx_t      t8_dtri_linear_id (const t8_dtri_t * t, int level);
 void                t8_dtri_init_linear_id (t8_dtri_t * t, t8_linearidx_t id,
                                             int level);
 
+/** Computes the linear position of a triangle in a uniform grid by
+ * traversing the levels one at a time.
+ * This is a reference implementation of \ref t8_dtri_linear_id, which it
+ * must match. It is used for verification and timings.
+ * \param [in] t  Triangle whose id will be computed.
+ * \param [in] level level of uniform grid to be considered.
+ * \return Returns the linear position of this triangle on a grid of level \a level.
+ */
+t8_linearidx_t      t8_dtri_linear_id_reference (const t8_dtri_t * t,
+                                                int level);
+
+/** Initialize a triangle as the triangle with a given global id in a uniform
+ *  refinement of a given level by traversing the levels one at a time.
+ * This is a reference implementation of \ref t8_dtri_init_linear_id.
+ * \param [in,out] t  Existing Triangle whose data will be filled.
+ * \param [in] id     Index to be considered.
+ * \param [in] level  level of uniform grid to be considered.
+ */
+void                t8_dtri_init_linear_id_reference (t8_dtri_t * t,
+                                                      t8_linearidx_t id,
+                                                      int level);
+
 /** Initialize a triangle as the root triangle (type 0 at level 0)
  * \param [in,out] t Existing triangle whose data will be filled.
  */
@@ -298,6 +320,23 @@ void                t8_dtri_init_root (t8_dtri_t * t);
 void                t8_dtri_successor (const t8_dtri_t * t, t8_dtri_t * s,
                                        int level);
 
+/** Initialize a range of triangles in a uniform refinement of a given
+ * level with consecutive linear ids.
+ * This is equivalent to calling \ref t8_dtri_init_linear_id for the
+ * first triangle and \ref t8_dtri_successor for the remaining ones, but
+ * only updates the levels whose local index changes from one triangle to the
+ * next.
+ * \param [in,out] t  An array of at least \a id_end - \a id_begin
+ *                    triangles. On output t[i] is the triangle with linear id
+ *                    \a id_begin + i.
+ * \param [in] level  level of uniform grid to be considered.
+ * \param [in] id_begin The linear id of the first triangle.
+ * \param [in] id_end One past the linear id of the last triangle.
+ */
+void                t8_dtri_init_linear_id_range (t8_dtri_t * t, int level,
+                                                  t8_linearidx_t id_begin,
+                                                  t8_linearidx_t id_end);
+
 /** Compute the first descendant of a triangle at a given level. This is the descendant of
  * the triangle in a uniform maxlevel refinement that has the smaller id.
  * \param [in] t        Triangle whose descendant is computed.
@@ -98,3 +98,57 @@ const int           t8_dtri_corner_face[3][2] = {
   {0, 2},
   {0, 1}
 };
+
+/* Line b, row c gives the local indices of an element T of type b and
+ * its parent for the cube-ids c = (cid of parent) * 4 + (cid of T).
+ * The result is (local index of parent) * 4 + (local index of T).
+ * We use this table to compute the linear id two levels at a time. */
+const int8_t        t8_dtri_type_cid2_to_Iloc2[2][16] = {
+  {0, 1, 1, 3, 4, 5, 9, 7, 4, 5, 9, 7, 12, 13, 13, 15},
+  {0, 2, 2, 3, 8, 6, 10, 11, 8, 6, 10, 11, 12, 14, 14, 15}
+};
+
+/* Line b, row c gives the type of the grandparent of an element T of
+ * type b for the cube-ids c = (cid of parent) * 4 + (cid of T). */
+const int8_t        t8_dtri_type_cid2_to_parenttype2[2][16] = {
+  {0, 0, 1, 0, 0, 0, 0, 0, 1, 1, 1, 1, 0, 0, 1, 0},
+  {1, 0, 1, 1, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 1, 1}
+};
+
+/* Line b, row I gives the cube-ids of the child and grandchild of an
+ * element of type b for the local indices I = (index of child) * 4 +
+ * (index of grandchild). The result is (cid of child) * 4 + (cid of
+ * grandchild). We use this table to construct an element from its linear id
+ * two levels at a time. */
+const int8_t        t8_dtri_parenttype_Iloc2_to_cid2[2][16] = {
+  {0, 1, 1, 3, 4, 5, 5, 7, 4, 6, 6, 7, 12, 13, 13, 15},
+  {0, 2, 2, 3, 8, 9, 9, 11, 8, 10, 10, 11, 12, 14, 14, 15}
+};
+
+/* Line b, row I gives the type of the grandchild of an element of type
+ * b for the local indices I = (index of child) * 4 + (index of grandchild). */
+const int8_t        t8_dtri_parenttype_Iloc2_to_type2[2][16] = {
+  {0, 0, 1, 0, 0, 0, 1, 0, 1, 0, 1, 1, 0, 0, 1, 0},
+  {1, 0, 1, 1, 0, 0, 1, 0, 1, 0, 1, 1, 1, 0, 1, 1}
+};
+
+const int           t8_dtri_face_child_id_by_type[2][3][2] = {
+  /* face 0  face 1  face 2 */
+  {{1, 3}, {0, 3}, {0, 1}},     /* type 0 */
+  {{2, 3}, {0, 3}, {0, 2}}      /* type 1 */
+};
+
+const int8_t        t8_dtri_type_face_to_nb_type[2][3] = {
+  {1, 1, 1},
+  {0, 0, 0}
+};
+
+const int8_t        t8_dtri_type_face_to_nb_face[2][3] = {
+  {2, 1, 0},
+  {2, 1, 0}
+};
+
+const int8_t        t8_dtri_type_face_to_nb_offset[2][3][2] = {
+  {{1, 0}, {0, 0}, {0, -1}},
+  {{0, 1}, {0, 0}, {-1, 0}}
+};
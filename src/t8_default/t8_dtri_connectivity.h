@@ -33,8 +33,17 @@ T8_EXTERN_C_BEGIN ();
 /** The spatial dimension */
 #define T8_DTRI_DIM (2)
 
+/** The alignment of the connectivity tables that are used by the
+ * frequently called element functions.  We align them to cache lines,
+ * such that each of them is loaded with as few cache misses as possible. */
+#ifdef __GNUC__
+#define T8_DTRI_TABLE_ALIGN __attribute__ ((aligned (64)))
+#else
+#define T8_DTRI_TABLE_ALIGN
+#endif
+
 /** Store the type of parent for each (cube-id,type) combination. */
-extern const int    t8_dtri_cid_type_to_parenttype[4][2];
+extern const int    t8_dtri_cid_type_to_parenttype[4][2] T8_DTRI_TABLE_ALIGN;
 
 /** Store the type of child for each (type,child number) combination,
   * where child number is the number in Bey order. */
@@ -60,13 +69,13 @@ extern const int    t8_dtri_type_cid_to_beyid[2][4];
 extern const int    t8_dtri_parenttype_beyid_to_Iloc[2][4];
 
 /** Store the local index for each (type,cube-id) combination.*/
-extern const int    t8_dtri_type_cid_to_Iloc[2][4];
+extern const int    t8_dtri_type_cid_to_Iloc[2][4] T8_DTRI_TABLE_ALIGN;
 
 /** Store the type for each (parenttype,local Index) combination. */
-extern const int    t8_dtri_parenttype_Iloc_to_type[2][4];
+extern const int    t8_dtri_parenttype_Iloc_to_type[2][4] T8_DTRI_TABLE_ALIGN;
 
 /** Store the cube-id for each (parenttype,local Index) combination. */
-extern const int    t8_dtri_parenttype_Iloc_to_cid[2][4];
+extern const int    t8_dtri_parenttype_Iloc_to_cid[2][4] T8_DTRI_TABLE_ALIGN;
 
 /** Store the indices of the corner of each face of a triangle. */
 extern const int    t8_dtri_face_corner[3][2];
@@ -74,6 +83,44 @@ extern const int    t8_dtri_face_corner[3][2];
 /** Store the indices of the faces of each corner of a triangle. */
 extern const int    t8_dtri_corner_face[3][2];
 
+
+/** Store the local indices of an element and its parent for each
+ * (type,cube-ids of element and parent) combination. \see t8_dtri_linear_id */
+extern const int8_t t8_dtri_type_cid2_to_Iloc2[2][16];
+
+/** Store the type of the grandparent for each
+ * (type,cube-ids of element and parent) combination. */
+extern const int8_t t8_dtri_type_cid2_to_parenttype2[2][16];
+
+/** Store the cube-ids of child and grandchild for each
+ * (type,local indices of child and grandchild) combination.
+ * \see t8_dtri_init_linear_id */
+extern const int8_t t8_dtri_parenttype_Iloc2_to_cid2[2][16];
+
+/** Store the type of the grandchild for each
+ * (type,local indices of child and grandchild) combination. */
+extern const int8_t t8_dtri_parenttype_Iloc2_to_type2[2][16];
+
+/** Store for each (type, face_index) the child_ids of the children of a
+ * triangle of the given type that share the given face.
+ * The order of the children is the order along the face.
+ */
+extern const int    t8_dtri_face_child_id_by_type[2][3][2];
+
+/** Store the type of the face neighbour of a triangle for each
+ * (type, face) combination. \see t8_dtri_face_neighbour */
+extern const int8_t t8_dtri_type_face_to_nb_type[2][3] T8_DTRI_TABLE_ALIGN;
+
+/** Store the face of the face neighbour of a triangle at which it
+ * touches the triangle for each (type, face) combination. */
+extern const int8_t t8_dtri_type_face_to_nb_face[2][3] T8_DTRI_TABLE_ALIGN;
+
+/** Store the offset of the anchor node of the face neighbour of a
+ * triangle for each (type, face) combination.  The offset is given
+ * in multiples of the length of the triangle. */
+extern const int8_t t8_dtri_type_face_to_nb_offset[2][3][2]
+  T8_DTRI_TABLE_ALIGN;
+
 T8_EXTERN_C_END ();
 
 #endif /* T8_DTRI_CONNECTIVITY_H */
@@ -63,6 +63,14 @@ T8_EXTERN_C_BEGIN ();
 #define t8_dtri_parenttype_Iloc_to_cid t8_dtet_parenttype_Iloc_to_cid
 #define t8_dtri_type_cid_to_Iloc t8_dtet_type_cid_to_Iloc
 #define t8_dtri_face_corner t8_dtet_face_corner
+#define t8_dtri_face_child_id_by_type t8_dtet_face_child_id_by_type
+#define t8_dtri_type_face_to_nb_type t8_dtet_type_face_to_nb_type
+#define t8_dtri_type_face_to_nb_face t8_dtet_type_face_to_nb_face
+#define t8_dtri_type_face_to_nb_offset t8_dtet_type_face_to_nb_offset
+#define t8_dtri_type_cid2_to_Iloc2 t8_dtet_type_cid2_to_Iloc2
+#define t8_dtri_type_cid2_to_parenttype2 t8_dtet_type_cid2_to_parenttype2
+#define t8_dtri_parenttype_Iloc2_to_cid2 t8_dtet_parenttype_Iloc2_to_cid2
+#define t8_dtri_parenttype_Iloc2_to_type2 t8_dtet_parenttype_Iloc2_to_type2
 
 /* functions in d8_dtri_bits.h */
 #define t8_dtri_is_equal t8_dtet_is_equal
@@ -91,8 +99,11 @@ T8_EXTERN_C_BEGIN ();
 #define t8_dtri_linear_id t8_dtet_linear_id
 #define t8_dtri_linear_id_corner_desc t8_dtet_linear_id_corner_desc
 #define t8_dtri_init_linear_id t8_dtet_init_linear_id
+#define t8_dtri_linear_id_reference t8_dtet_linear_id_reference
+#define t8_dtri_init_linear_id_reference t8_dtet_init_linear_id_reference
 #define t8_dtri_init_root t8_dtet_init_root
 #define t8_dtri_successor t8_dtet_successor
+#define t8_dtri_init_linear_id_range t8_dtet_init_linear_id_range
 #define t8_dtri_first_descendant t8_dtet_first_descendant
 #define t8_dtri_last_descendant t8_dtet_last_descendant
 #define t8_dtri_corner_descendant t8_dtet_corner_descendant
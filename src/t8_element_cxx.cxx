@@ -68,6 +68,152 @@ t8_eclass_scheme::t8_element_array_index (sc_array_t * array, size_t it)
   return (t8_element_t *) sc_array_index (array, it);
 }
 
+/* Default implementation for array_linear_ids */
+void
+t8_eclass_scheme::t8_element_array_linear_ids (t8_element_array_t * elements,
+                                               size_t first, size_t count,
+                                               int level,
+                                               t8_linearidx_t * ids)
+{
+  size_t              ielem;
+
+  T8_ASSERT (elements != NULL && elements->scheme == this);
+  T8_ASSERT (first + count <= t8_element_array_get_count (elements));
+
+  for (ielem = 0; ielem < count; ielem++) {
+    ids[ielem] =
+      t8_element_get_linear_id (t8_element_array_index
+                                (&elements->array, first + ielem), level);
+  }
+}
+
+/* Default implementation for array_levels */
+void
+t8_eclass_scheme::t8_element_array_levels (t8_element_array_t * elements,
+                                           size_t first, size_t count,
+                                           int *levels)
+{
+  size_t              ielem;
+
+  T8_ASSERT (elements != NULL && elements->scheme == this);
+  T8_ASSERT (first + count <= t8_element_array_get_count (elements));
+
+  for (ielem = 0; ielem < count; ielem++) {
+    levels[ielem] =
+      t8_element_level (t8_element_array_index
+                        (&elements->array, first + ielem));
+  }
+}
+
+/* Default implementation for array_child_ids */
+void
+t8_eclass_scheme::t8_element_array_child_ids (t8_element_array_t * elements,
+                                              size_t first, size_t count,
+                                              int *child_ids)
+{
+  size_t              ielem;
+
+  T8_ASSERT (elements != NULL && elements->scheme == this);
+  T8_ASSERT (first + count <= t8_element_array_get_count (elements));
+
+  for (ielem = 0; ielem < count; ielem++) {
+    child_ids[ielem] =
+      t8_element_child_id (t8_element_array_index
+                           (&elements->array, first + ielem));
+  }
+}
+
+/* Default implementation for array_parents */
+void
+t8_eclass_scheme::t8_element_array_parents (t8_element_array_t * elements,
+                                            size_t first, size_t count,
+                                            t8_element_array_t * parents,
+                                            size_t parents_first)
+{
+  size_t              ielem;
+
+  T8_ASSERT (elements != NULL && elements->scheme == this);
+  T8_ASSERT (parents != NULL && parents->scheme == this);
+  T8_ASSERT (first + count <= t8_element_array_get_count (elements));
+  T8_ASSERT (parents_first + count <= t8_element_array_get_count (parents));
+
+  for (ielem = 0; ielem < count; ielem++) {
+    t8_element_parent (t8_element_array_index
+                       (&elements->array, first + ielem),
+                       t8_element_array_index (&parents->array,
+                                               parents_first + ielem));
+  }
+}
+
+/* Default implementation for array_children */
+size_t
+t8_eclass_scheme::t8_element_array_children (t8_element_array_t * elements,
+                                             size_t first, size_t count,
+                                             t8_element_array_t * children,
+                                             size_t children_first)
+{
+  size_t              ielem, ichild;
+  int                 num_children, max_children, ic;
+  t8_element_t       *elem, **child_pointers;
+
+  T8_ASSERT (elements != NULL && elements->scheme == this);
+  T8_ASSERT (children != NULL && children->scheme == this);
+  T8_ASSERT (elements != children);
+  T8_ASSERT (first + count <= t8_element_array_get_count (elements));
+
+  max_children = 0;
+  child_pointers = NULL;
+  ichild = children_first;
+  for (ielem = 0; ielem < count; ielem++) {
+    elem = t8_element_array_index (&elements->array, first + ielem);
+    num_children = t8_element_num_children (elem);
+    T8_ASSERT (ichild + num_children <=
+               t8_element_array_get_count (children));
+    if (num_children > max_children) {
+      /* The number of children may vary between elements */
+      child_pointers = T8_REALLOC (child_pointers, t8_element_t *,
+                                   num_children);
+      max_children = num_children;
+    }
+    for (ic = 0; ic < num_children; ic++) {
+      child_pointers[ic] =
+        t8_element_array_index (&children->array, ichild + ic);
+    }
+    t8_element_children (elem, num_children, child_pointers);
+    ichild += num_children;
+  }
+  T8_FREE (child_pointers);
+  return ichild - children_first;
+}
+
+/* Default implementation for array_set_linear_ids */
+void
+t8_eclass_scheme::t8_element_array_set_linear_ids (t8_element_array_t *
+                                                   elements, size_t first,
+                                                   int level,
+                                                   t8_linearidx_t id_begin,
+                                                   t8_linearidx_t id_end)
+{
+  t8_element_t       *element, *element_succ;
+  size_t              ielem;
+
+  T8_ASSERT (elements != NULL && elements->scheme == this);
+  T8_ASSERT (id_begin <= id_end);
+  T8_ASSERT (first + (id_end - id_begin) <=
+             t8_element_array_get_count (elements));
+
+  if (id_begin >= id_end) {
+    return;
+  }
+  element = t8_element_array_index (&elements->array, first);
+  t8_element_set_linear_id (element, level, id_begin);
+  for (ielem = 1; ielem < id_end - id_begin; ielem++) {
+    element_succ = t8_element_array_index (&elements->array, first + ielem);
+    t8_element_successor (element, element_succ, level);
+    element = element_succ;
+  }
+}
+
 T8_EXTERN_C_END ();
 
 #if 0
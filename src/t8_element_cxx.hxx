@@ -33,6 +33,7 @@
 #include <sc_refcount.h>
 #include <t8_eclass.h>
 #include <t8_element.h>
+#include <t8_data/t8_containers.h>
 
 T8_EXTERN_C_BEGIN ();
 
@@ -579,6 +580,118 @@ public:
   virtual t8_element_t *t8_element_array_index (sc_array_t * array,
                                                 size_t it);
 
+  /** Compute the linear ids of a range of elements in an element array.
+   * \param [in] elements  An array of elements of this class.
+   * \param [in] first     The index of the first element of the range.
+   * \param [in] count     The number of elements in the range.
+   * \param [in] level     The level at which the linear ids are computed,
+   *                       as in \ref t8_element_get_linear_id.
+   * \param [out] ids      On output the linear id of element first + i
+   *                       is stored in \a ids[i]. Must have room for \a count
+   *                       entries.
+   * We provide a default implementation that calls \ref t8_element_get_linear_id
+   * for each element.
+   */
+  virtual void        t8_element_array_linear_ids (t8_element_array_t *
+                                                   elements, size_t first,
+                                                   size_t count, int level,
+                                                   t8_linearidx_t * ids);
+
+  /** Compute the levels of a range of elements in an element array.
+   * \param [in] elements  An array of elements of this class.
+   * \param [in] first     The index of the first element of the range.
+   * \param [in] count     The number of elements in the range.
+   * \param [out] levels   On output the level of element first + i
+   *                       is stored in \a levels[i].
+   * We provide a default implementation that calls \ref t8_element_level
+   * for each element.
+   */
+  virtual void        t8_element_array_levels (t8_element_array_t *
+                                               elements, size_t first,
+                                               size_t count, int *levels);
+
+  /** Compute the child ids of a range of elements in an element array.
+   * \param [in] elements  An array of elements of this class.
+   * \param [in] first     The index of the first element of the range.
+   * \param [in] count     The number of elements in the range.
+   * \param [out] child_ids On output the child id of element first + i
+   *                       is stored in \a child_ids[i].
+   * We provide a default implementation that calls \ref t8_element_child_id
+   * for each element.
+   */
+  virtual void        t8_element_array_child_ids (t8_element_array_t *
+                                                  elements, size_t first,
+                                                  size_t count,
+                                                  int *child_ids);
+
+  /** Compute the parents of a range of elements in an element array.
+   * \param [in] elements  An array of elements of this class.
+   *                       All elements in the range must have level > 0
+   *                       and their parents must be of this class.
+   * \param [in] first     The index of the first element of the range.
+   * \param [in] count     The number of elements in the range.
+   * \param [in,out] parents An array of elements of this class.
+   *                       On output the parent of element first + i is
+   *                       stored at position \a parents_first + i.
+   *                       These positions must exist.
+   *                       \a parents may be the same array as \a elements.
+   * \param [in] parents_first The position of the first parent in \a parents.
+   * We provide a default implementation that calls \ref t8_element_parent
+   * for each element.
+   */
+  virtual void        t8_element_array_parents (t8_element_array_t *
+                                                elements, size_t first,
+                                                size_t count,
+                                                t8_element_array_t * parents,
+                                                size_t parents_first);
+
+  /** Compute the children of a range of elements in an element array.
+   * \param [in] elements  An array of elements of this class.
+   *                       The children of all elements in the range must be
+   *                       of this class.
+   * \param [in] first     The index of the first element of the range.
+   * \param [in] count     The number of elements in the range.
+   * \param [in,out] children An array of elements of this class, different
+   *                       from \a elements.
+   *                       On output the children of the elements are stored
+   *                       consecutively, in the order of the elements, starting
+   *                       at position \a children_first.
+   *                       These positions must exist.
+   * \param [in] children_first The position of the first child in \a children.
+   * \return               The number of children that were stored.
+   * We provide a default implementation that calls \ref t8_element_children
+   * for each element.
+   */
+  virtual size_t      t8_element_array_children (t8_element_array_t *
+                                                 elements, size_t first,
+                                                 size_t count,
+                                                 t8_element_array_t *
+                                                 children,
+                                                 size_t children_first);
+
+  /** Initialize a range of elements in an element array as the elements
+   * with consecutive linear ids in a uniform refinement of a given level.
+   * \param [in,out] elements  An array of elements of this class.
+   * \param [in] first     The position of the first element to be set.
+   *                       The positions \a first, ..., \a first + \a id_end
+   *                       - \a id_begin - 1 must exist.
+   * \param [in] level     The level of the uniform refinement.
+   * \param [in] id_begin  The linear id of the first element.
+   * \param [in] id_end    One past the linear id of the last element.
+   *                       On output the element at position \a first + i
+   *                       is the element with linear id \a id_begin + i.
+   * We provide a default implementation that calls
+   * \ref t8_element_set_linear_id for the first element and
+   * \ref t8_element_successor for all others.
+   */
+  virtual void        t8_element_array_set_linear_ids (t8_element_array_t *
+                                                       elements,
+                                                       size_t first,
+                                                       int level,
+                                                       t8_linearidx_t
+                                                       id_begin,
+                                                       t8_linearidx_t id_end);
+
 #ifdef T8_ENABLE_DEBUG
   /** Query whether a given element can be considered as 'valid' and it is
    *  safe to perform any of the above algorithms on it.
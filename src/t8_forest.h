@@ -48,6 +48,16 @@ typedef enum
   T8_GHOST_VERTICES   /**< Consider all vertex (codimension 3) and edge and face neighbors. */
 } t8_ghost_type_t;
 
+/** This type controls how the elements of a forest are stored in a
+ * checkpoint. \see t8_forest_save_ext */
+typedef enum
+{
+  T8_FOREST_SAVE_ELEMENTS = 0,  /**< Store the linear id and level of each element. */
+  T8_FOREST_SAVE_REFINEMENT     /**< Store one bit per node of the refinement trees
+                                     that is set if the node is refined. This needs
+                                     about one bit per element. */
+} t8_forest_save_encoding_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /* TODO: if eclass is a vertex then num_outgoing/num_incoming are always
@@ -333,10 +343,46 @@ void                t8_forest_set_ghost_ext (t8_forest_t forest, int do_ghost,
                                              t8_ghost_type_t ghost_type,
                                              int ghost_version);
 
-/* TODO: use assertions and document that the forest_set (..., from) and
- *       set_load are mutually exclusive. */
+/** Set a forest to be loaded from a checkpoint written with
+ * \ref t8_forest_save.
+ * The checkpoint may be loaded on any number of processes, the elements
+ * are uniformly repartitioned among them.
+ * It is not allowed to combine this with \ref t8_forest_set_copy,
+ * \ref t8_forest_set_adapt, \ref t8_forest_set_partition or
+ * \ref t8_forest_set_balance.
+ * The scheme must be set with \ref t8_forest_set_scheme. The coarse mesh
+ * may be set with \ref t8_forest_set_cmesh, in which case it must have
+ * the same trees as the saved one. Otherwise it is loaded from the
+ * checkpoint as well. A partitioned coarse mesh can only be loaded on at
+ * least as many processes as it was saved on.
+ * \param [in, out] forest     The forest.
+ * \param [in]      fileprefix The prefix that was passed to \ref t8_forest_save.
+ * \param [in]      comm       The MPI communicator to use. If a cmesh was set,
+ *                             it must be the same communicator.
+ */
 void                t8_forest_set_load (t8_forest_t forest,
-                                        const char *filename);
+                                        const char *fileprefix,
+                                        sc_MPI_Comm comm);
+
+/** Store the elements of the local trees as compact keys after commit,
+ * see \ref t8_element_array_compact.
+ * This reduces the memory of forests whose element types are larger than
+ * 64 bits. A compact forest is meant to be kept as the source of a later
+ * \ref t8_forest_set_partition, \ref t8_forest_set_adapt,
+ * \ref t8_forest_set_balance or \ref t8_forest_set_copy.
+ * Partition reads the keys directly. All other methods restore the full
+ * element storage of the source forest on commit.
+ * \param [in, out] forest      The forest.
+ * \param [in]      set_compact If true, the local trees are compacted at
+ *                              the end of \ref t8_forest_commit. Trees whose
+ *                              elements cannot be encoded stay uncompacted.
+ * \note The element access functions, for example
+ * \ref t8_forest_get_element, must not be used on a compact forest.
+ * Compact storage is disabled by default.
+ * The forest must not be committed before calling this function.
+ */
+void                t8_forest_set_compact (t8_forest_t forest,
+                                           int set_compact);
 
 /** Compute the global number of elements in a forest as the sum
  *  of the local element counts.
@@ -726,8 +772,39 @@ t8_gloidx_t         t8_forest_element_face_neighbor (t8_forest_t forest,
                                                      neigh_scheme, int face,
                                                      int *neigh_face);
 
-/* TODO: implement */
-void                t8_forest_save (t8_forest_t forest);
+/** Write a checkpoint of a committed forest that can be read back with
+ * \ref t8_forest_set_load.
+ * The coarse mesh is saved with \ref t8_cmesh_save to the files
+ * \a fileprefix_RANK.cmesh. The elements of all processes are written with
+ * MPI I/O, if available, to the single file \a fileprefix.forest, together
+ * with the element class and the global index of the first element of each tree.
+ * This function is collective.
+ * \param [in]      forest     A committed forest.
+ * \param [in]      fileprefix The prefix of the checkpoint files.
+ * \return                     True if successful, false otherwise.
+ *                             The return value is the same on all processes.
+ */
+int                 t8_forest_save (t8_forest_t forest,
+                                    const char *fileprefix);
+
+/** Write a checkpoint of a committed forest with a given encoding of the
+ * elements. The checkpoint can be read back with \ref t8_forest_set_load.
+ * This function is collective.
+ * \param [in]      forest     A committed forest.
+ * \param [in]      fileprefix The prefix of the checkpoint files.
+ * \param [in]      encoding   The way the elements are stored.
+ *                             \ref t8_forest_save uses T8_FOREST_SAVE_ELEMENTS.
+ * \param [in]      compress   If true and the encoding is T8_FOREST_SAVE_REFINEMENT,
+ *                             the refinement bits are compressed with zlib,
+ *                             if sc is configured with zlib.
+ * \return                     True if successful, false otherwise.
+ *                             The return value is the same on all processes.
+ * \see t8_forest_save
+ */
+int                 t8_forest_save_ext (t8_forest_t forest,
+                                        const char *fileprefix,
+                                        t8_forest_save_encoding_t encoding,
+                                        int compress);
 
 /** Write the forest in a parallel vtu format. There is one master
  * .pvtu file and each process writes in its own .vtu file.
@@ -746,9 +823,6 @@ void                t8_forest_save (t8_forest_t forest);
 void                t8_forest_write_vtk (t8_forest_t forest,
                                          const char *filename);
 
-/* TODO: implement */
-void                t8_forest_iterate (t8_forest_t forest);
-
 /** Compute the coordinates of a given vertex of an element if the
  * vertex coordinates of the surrounding tree are known.
  * \param [in]      forest     The forest.
@@ -868,6 +942,30 @@ void                t8_forest_element_face_normal (t8_forest_t forest,
                                                    *tree_vertices,
                                                    double normal[3]);
 
+/** Query whether a given point lies inside an element.
+ * The reference coordinates of the point are computed with respect to the
+ * geometry that \ref t8_forest_element_coordinate induces on the element.
+ * For elements of lower dimension than 3 the point must furthermore lie
+ * in the element's line/plane up to \a tolerance times the element size.
+ * \param [in]      forest     The forest.
+ * \param [in]      ltree_id   The forest local id of the tree in which the element is.
+ * \param [in]      element    The element.
+ * \param [in]      tree_vertices An array storing the vertex coordinates of the tree.
+ * \param [in]      point      3-dimensional coordinates of the point to check.
+ * \param [in]      tolerance  Relative tolerance (in reference coordinates)
+ *                             up to which a point is accepted as inside.
+ * \return                     True if \a point is inside \a element.
+ * \a forest must be committed when calling this function.
+ */
+int                 t8_forest_element_point_inside (t8_forest_t forest,
+                                                    t8_locidx_t ltreeid,
+                                                    const t8_element_t *
+                                                    element,
+                                                    const double
+                                                    *tree_vertices,
+                                                    const double point[3],
+                                                    double tolerance);
+
 /* TODO: if set level and partition/adapt/balance all give NULL, then
  * refine uniformly and partition/adapt/balance the unfiform forest. */
 /** Build a uniformly refined forest on a coarse mesh.
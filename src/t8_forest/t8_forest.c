@@ -29,6 +29,7 @@
 #include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest/t8_forest_adapt.h>
 #include <t8_forest/t8_forest_balance.h>
+#include <t8_forest/t8_forest_save.h>
 #include <t8_forest_vtk.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
 #include <t8_cmesh/t8_cmesh_trees.h>
@@ -97,7 +98,9 @@ t8_forest_set_mpicomm (t8_forest_t forest, sc_MPI_Comm mpicomm, int do_dup)
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->rc.refcount > 0);
   T8_ASSERT (!forest->committed);
-  T8_ASSERT (forest->mpicomm == sc_MPI_COMM_NULL);
+  /* The communicator may already be set by t8_forest_set_load */
+  T8_ASSERT (forest->mpicomm == sc_MPI_COMM_NULL
+             || (forest->set_load != NULL && forest->mpicomm == mpicomm));
   T8_ASSERT (forest->set_from == NULL);
 
   T8_ASSERT (mpicomm != sc_MPI_COMM_NULL);
@@ -271,6 +274,30 @@ t8_forest_set_ghost (t8_forest_t forest, int do_ghost,
   t8_forest_set_ghost_ext (forest, do_ghost, ghost_type, 3);
 }
 
+void
+t8_forest_set_load (t8_forest_t forest, const char *fileprefix,
+                    sc_MPI_Comm comm)
+{
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (forest->rc.refcount > 0);
+  T8_ASSERT (!forest->committed);
+  T8_ASSERT (forest->set_from == NULL);
+  T8_ASSERT (forest->set_load == NULL);
+
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (comm != sc_MPI_COMM_NULL);
+
+  forest->set_load = T8_ALLOC (char, strlen (fileprefix) + 1);
+  strcpy (forest->set_load, fileprefix);
+  if (forest->mpicomm == sc_MPI_COMM_NULL) {
+    t8_forest_set_mpicomm (forest, comm, 0);
+  }
+  else {
+    /* The communicator was set together with the cmesh */
+    T8_ASSERT (forest->mpicomm == comm);
+  }
+}
+
 void
 t8_forest_set_adapt (t8_forest_t forest, const t8_forest_t set_from,
                      t8_forest_adapt_t adapt_fn, int recursive)
@@ -336,6 +363,29 @@ t8_forest_comm_global_num_elements (t8_forest_t forest)
   forest->global_num_elements = global_num_el;
 }
 
+/* Compact or expand the element arrays of all local trees of a forest.
+ * \see t8_forest_set_compact */
+static void
+t8_forest_compact_trees (t8_forest_t forest, int compact)
+{
+  t8_locidx_t         itree;
+  t8_tree_t           tree;
+
+  if (forest->trees == NULL) {
+    return;
+  }
+  for (itree = 0; itree < (t8_locidx_t) forest->trees->elem_count; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    if (compact) {
+      /* If the elements of the tree cannot be encoded, it stays as is */
+      (void) t8_element_array_compact (&tree->elements);
+    }
+    else {
+      t8_element_array_expand (&tree->elements);
+    }
+  }
+}
+
 void
 t8_forest_commit (t8_forest_t forest)
 {
@@ -356,7 +406,7 @@ t8_forest_commit (t8_forest_t forest)
     /* This forest is constructed solely from its cmesh as a uniform
      * forest */
     T8_ASSERT (forest->mpicomm != sc_MPI_COMM_NULL);
-    T8_ASSERT (forest->cmesh != NULL);
+    T8_ASSERT (forest->cmesh != NULL || forest->set_load != NULL);
     T8_ASSERT (forest->scheme_cxx != NULL);
     T8_ASSERT (forest->from_method == T8_FOREST_FROM_LAST);
 
@@ -366,19 +416,30 @@ t8_forest_commit (t8_forest_t forest)
       SC_CHECK_MPI (mpiret);
       forest->mpicomm = comm_dup;
     }
-    forest->dimension = forest->cmesh->dimension;
 
     /* Set mpirank and mpisize */
     mpiret = sc_MPI_Comm_size (forest->mpicomm, &forest->mpisize);
     SC_CHECK_MPI (mpiret);
     mpiret = sc_MPI_Comm_rank (forest->mpicomm, &forest->mpirank);
     SC_CHECK_MPI (mpiret);
-    /* Compute the maximum allowed refinement level */
-    t8_forest_compute_maxlevel (forest);
-    T8_ASSERT (forest->set_level <= forest->maxlevel);
-    /* populate a new forest with tree and quadrant objects */
-    t8_forest_populate (forest);
-    forest->global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
+    if (forest->set_load != NULL) {
+      /* Read the elements (and possibly the cmesh) from a checkpoint.
+       * This sets the dimension and the maximum level. */
+      t8_forest_load (forest);
+      T8_FREE (forest->set_load);
+      forest->set_load = NULL;
+      /* The cmesh may have to be repartitioned to match the new elements */
+      partitioned = 1;
+    }
+    else {
+      forest->dimension = forest->cmesh->dimension;
+      /* Compute the maximum allowed refinement level */
+      t8_forest_compute_maxlevel (forest);
+      T8_ASSERT (forest->set_level <= forest->maxlevel);
+      /* populate a new forest with tree and quadrant objects */
+      t8_forest_populate (forest);
+      forest->global_num_trees = t8_cmesh_get_num_trees (forest->cmesh);
+    }
   }
   else {                        /* set_from != NULL */
     t8_forest_t         forest_from = forest->set_from; /* temporarily store set_from, since we may overwrite it */
@@ -388,6 +449,7 @@ t8_forest_commit (t8_forest_t forest)
     T8_ASSERT (forest->cmesh == NULL);
     T8_ASSERT (forest->scheme_cxx == NULL);
     T8_ASSERT (!forest->do_dup);
+    T8_ASSERT (forest->set_load == NULL);
     T8_ASSERT (forest->from_method >= T8_FOREST_FROM_FIRST &&
                forest->from_method < T8_FOREST_FROM_LAST);
 
@@ -420,6 +482,11 @@ t8_forest_commit (t8_forest_t forest)
 
     /* Compute the maximum allowed refinement level */
     t8_forest_compute_maxlevel (forest);
+    if (forest->from_method != T8_FOREST_FROM_PARTITION) {
+      /* Only partition reads compact trees, for all other methods we
+       * restore the elements of a compact input forest */
+      t8_forest_compact_trees (forest->set_from, 0);
+    }
     if (forest->from_method == T8_FOREST_FROM_COPY) {
       SC_CHECK_ABORT (forest->set_from != NULL,
                       "No forest to copy from was specified.");
@@ -591,6 +658,9 @@ t8_forest_commit (t8_forest_t forest)
                                forest->profile != NULL);
   }
 
+  /* Cache the face connections of the local trees */
+  t8_forest_compute_tree_face_info (forest);
+
   if (forest->mpisize > 1) {
     /* Construct a ghost layer, if desired */
     if (forest->do_ghost) {
@@ -611,6 +681,11 @@ t8_forest_commit (t8_forest_t forest)
     }
   forest->do_ghost = 0;
   }
+
+  if (forest->set_compact) {
+    /* Store the local elements as compact keys */
+    t8_forest_compact_trees (forest, 1);
+  }
 }
 
 t8_locidx_t
@@ -1121,6 +1196,14 @@ t8_forest_get_coarse_tree (t8_forest_t forest, t8_locidx_t ltreeid)
   return t8_forest_get_coarse_tree_ext (forest, ltreeid, NULL, NULL);
 }
 
+void
+t8_forest_set_compact (t8_forest_t forest, int set_compact)
+{
+  T8_ASSERT (t8_forest_is_initialized (forest));
+
+  forest->set_compact = (set_compact != 0);
+}
+
 void
 t8_forest_set_profiling (t8_forest_t forest, int set_profiling)
 {
@@ -1369,6 +1452,9 @@ t8_forest_reset (t8_forest_t * pforest)
       /* in this case we have taken ownership and not released it yet */
       t8_forest_unref (&forest->set_from);
     }
+    if (forest->set_load != NULL) {
+      T8_FREE (forest->set_load);
+    }
   }
   else {
     T8_ASSERT (forest->set_from == NULL);
@@ -1395,6 +1481,10 @@ t8_forest_reset (t8_forest_t * pforest)
     t8_cmesh_unref (&forest->cmesh);
   }
 
+  /* free the memory of the tree face connections */
+  if (forest->tree_face_info != NULL) {
+    T8_FREE (forest->tree_face_info);
+  }
   /* free the memory of the offset array */
   if (forest->element_offsets != NULL) {
     t8_shmem_array_destroy (&forest->element_offsets);
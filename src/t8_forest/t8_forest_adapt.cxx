@@ -25,25 +25,32 @@
 #include <t8_forest.h>
 #include <t8_data/t8_containers.h>
 #include <t8_element_cxx.hxx>
+#include <t8_default/t8_default_dispatch_cxx.hxx>
 
-/* We want to export the whole implementation to be callable from "C" */
-T8_EXTERN_C_BEGIN ();
+/* The functions in this file up to t8_forest_adapt are templated on the
+ * scheme class. They are instantiated for the default quad, hex, triangle
+ * and tet schemes, such that their element functions are called without
+ * virtual dispatch, and for the generic t8_eclass_scheme_c.
+ * \see t8_default_scheme_dispatch */
 
-/* The last inserted element must be the last element of a family. */
-static void
+/* The last inserted element must be the last element of a family.
+ * el_buffer and family_buffer are buffers of length num_children. */
+template < class TScheme > static void
 t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_locidx_t lelement_id,
-                                   t8_eclass_scheme_c * ts,
+                                   TScheme * ts,
                                    t8_element_array_t * telement,
                                    t8_locidx_t el_coarsen,
                                    t8_locidx_t * el_inserted,
-                                   t8_element_t ** el_buffer)
+                                   t8_element_t ** el_buffer,
+                                   int8_t * family_buffer)
 {
   t8_element_t       *element;
   t8_element_t      **fam;
   t8_locidx_t         pos;
   size_t              elements_in_array;
   int                 num_children, i, isfamily;
+  int8_t             *family_start;
   /* el_inserted is the index of the last element in telement plus one.
    * el_coarsen is the index of the first element which could possibly
    * be coarsened. */
@@ -54,25 +61,25 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   element = t8_element_array_index_locidx (telement, *el_inserted - 1);
   /* TODO: This assumes that the number of children is the same for each
    *       element in that class. This may not be the case. */
-  num_children = ts->t8_element_num_children (element);
-  T8_ASSERT (ts->t8_element_child_id (element) == num_children - 1);
+  num_children = t8_default_call_num_children (ts, element);
+  T8_ASSERT (t8_default_call_child_id (ts, element) == num_children - 1);
 
   fam = el_buffer;
+  family_start = family_buffer;
   pos = *el_inserted - num_children;
   isfamily = 1;
-  while (isfamily && pos >= el_coarsen && ts->t8_element_child_id (element)
-         == num_children - 1) {
-    isfamily = 1;
-    /* Get all elements at indices pos, pos + 1, ... ,pos + num_children - 1 */
-    for (i = 0; i < num_children; i++) {
-      fam[i] = t8_element_array_index_locidx (telement, pos + i);
-      if (ts->t8_element_child_id (fam[i]) != i) {
-        /* These elements cannot form a family. Stop coarsening. */
-        isfamily = 0;
-        break;
+  while (isfamily && pos >= el_coarsen) {
+    /* Check whether the elements at indices pos, pos + 1, ...,
+     * pos + num_children - 1 form a family */
+    t8_element_array_family_starts (telement, pos, num_children,
+                                    family_start);
+    isfamily = family_start[0];
+    if (isfamily) {
+      for (i = 0; i < num_children; i++) {
+        fam[i] = t8_element_array_index_locidx (telement, pos + i);
       }
     }
-    T8_ASSERT (!isfamily || ts->t8_element_is_family (fam));
+    T8_ASSERT (!isfamily || t8_default_call_is_family (ts, fam));
     if (isfamily
         && forest->set_adapt_fn (forest, forest->set_from, ltreeid,
                                  lelement_id, ts, num_children, fam) < 0) {
@@ -80,7 +87,7 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
       *el_inserted -= num_children - 1;
       /* remove num_children - 1 elements from the array */
       T8_ASSERT (elements_in_array == t8_element_array_get_count (telement));
-      ts->t8_element_parent (fam[0], fam[0]);
+      t8_default_call_parent (ts, fam[0], fam[0]);
       elements_in_array -= num_children - 1;
       t8_element_array_resize (telement, elements_in_array);
       /* Set element to the new constructed parent. Since resizing the array
@@ -96,10 +103,10 @@ t8_forest_adapt_coarsen_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
-static void
+template < class TScheme > static void
 t8_forest_adapt_refine_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
                                   t8_locidx_t lelement_id,
-                                  t8_eclass_scheme_c * ts,
+                                  TScheme * ts,
                                   sc_list_t * elem_list,
                                   t8_element_array_t * telements,
                                   t8_locidx_t * num_inserted,
@@ -114,14 +121,14 @@ t8_forest_adapt_refine_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
   }
   while (elem_list->elem_count > 0) {
     el_buffer[0] = (t8_element_t *) sc_list_pop (elem_list);
-    num_children = ts->t8_element_num_children (el_buffer[0]);
+    num_children = t8_default_call_num_children (ts, el_buffer[0]);
     if (forest->set_adapt_fn (forest, forest->set_from, ltreeid, lelement_id,
                               ts, 1, el_buffer) > 0) {
       /* The element should be refined */
-      if (ts->t8_element_level (el_buffer[0]) < forest->maxlevel) {
+      if (t8_default_call_level (ts, el_buffer[0]) < forest->maxlevel) {
         /* only refine, if we do not exceed the maximum allowed level */
-        ts->t8_element_new (num_children - 1, el_buffer + 1);
-        ts->t8_element_children (el_buffer[0], num_children, el_buffer);
+        t8_default_call_new (ts, num_children - 1, el_buffer + 1);
+        t8_default_call_children (ts, el_buffer[0], num_children, el_buffer);
         for (ci = num_children - 1; ci >= 0; ci--) {
           (void) sc_list_prepend (elem_list, el_buffer[ci]);
         }
@@ -129,36 +136,187 @@ t8_forest_adapt_refine_recursive (t8_forest_t forest, t8_locidx_t ltreeid,
     }
     else {
       insert_el = t8_element_array_push (telements);
-      ts->t8_element_copy (el_buffer[0], insert_el);
-      ts->t8_element_destroy (1, el_buffer);
+      t8_default_call_copy (ts, el_buffer[0], insert_el);
+      t8_default_call_destroy (ts, 1, el_buffer);
       (*num_inserted)++;
     }
   }
 }
 
-/* TODO: optimize this when we own forest_from */
-void
-t8_forest_adapt (t8_forest_t forest)
+/* Adapt the elements of one local tree of forest->set_from and store
+ * the new elements in the corresponding tree of forest.
+ * Returns the number of elements in the new tree. */
+template < class TScheme > static t8_locidx_t
+t8_forest_adapt_tree (t8_forest_t forest, t8_locidx_t ltree_id,
+                      TScheme * tscheme, sc_list_t * refine_list)
 {
-  t8_forest_t         forest_from;
-  sc_list_t          *refine_list = NULL;       /* This is only needed when we adapt recursively */
+  t8_forest_t         forest_from = forest->set_from;
   t8_element_array_t *telements, *telements_from;
-  t8_locidx_t         ltree_id, num_trees;
   t8_locidx_t         el_considered;
   t8_locidx_t         el_inserted;
   t8_locidx_t         el_coarsen;
   t8_locidx_t         num_el_from;
-  t8_locidx_t         el_offset;
   size_t              num_children, zz;
   t8_tree_t           tree, tree_from;
-  t8_eclass_scheme_c *tscheme;
   t8_element_t      **elements, **elements_from, *elpop;
+  int8_t             *family_start;
   int                 refine;
   int                 ci;
   int                 num_elements;
-#ifdef T8_ENABLE_DEBUG
   int                 is_family;
-#endif
+
+  tree = t8_forest_get_tree (forest, ltree_id);
+  tree_from = t8_forest_get_tree (forest_from, ltree_id);
+  telements = &tree->elements;
+  telements_from = &tree_from->elements;
+  num_el_from = (t8_locidx_t) t8_element_array_get_count (telements_from);
+  el_considered = 0;
+  el_inserted = 0;
+  el_coarsen = 0;
+  /* TODO: this will generate problems with pyramidal elements */
+  num_children =
+    t8_default_call_num_children (tscheme,
+                                  t8_element_array_index_locidx
+                                  (telements_from, 0));
+  elements = T8_ALLOC (t8_element_t *, num_children);
+  elements_from = T8_ALLOC (t8_element_t *, num_children);
+  /* Find all families of the old tree in one pass. The last num_children
+   * entries of family_start are the buffer for the recursive coarsening. */
+  family_start = T8_ALLOC (int8_t, num_el_from + num_children);
+  t8_element_array_family_starts (telements_from, 0, num_el_from,
+                                  family_start);
+  while (el_considered < num_el_from) {
+    is_family = family_start[el_considered];
+    num_elements = is_family ? num_children : 1;
+    for (zz = 0; zz < (size_t) num_elements; zz++) {
+      elements_from[zz] = t8_element_array_index_locidx (telements_from,
+                                                         el_considered +
+                                                         zz);
+    }
+    T8_ASSERT (!is_family
+               || t8_default_call_is_family (tscheme, elements_from));
+    refine =
+      forest->set_adapt_fn (forest, forest->set_from, ltree_id,
+                            el_considered, tscheme, num_elements,
+                            elements_from);
+    T8_ASSERT (is_family || refine >= 0);
+    if (refine > 0 && t8_default_call_level (tscheme, elements_from[0]) >=
+        forest->maxlevel) {
+      /* Only refine an element if it does not exceed the maximum level */
+      refine = 0;
+    }
+    if (refine > 0) {
+      /* The first element is to be refined */
+      if (forest->set_adapt_recursive) {
+        /* el_coarsen is the index of the first element in the new element
+         * array which could be coarsened recursively.
+         * We can set this here, since a family that emerges from a refinement will never be coarsened */
+        el_coarsen = el_inserted + num_children;
+        t8_default_call_new (tscheme, num_children, elements);
+        t8_default_call_children (tscheme, elements_from[0], num_children,
+                                  elements);
+        for (ci = num_children - 1; ci >= 0; ci--) {
+          (void) sc_list_prepend (refine_list, elements[ci]);
+        }
+        t8_forest_adapt_refine_recursive (forest, ltree_id, el_considered,
+                                          tscheme, refine_list, telements,
+                                          &el_inserted, elements);
+      }
+      else {
+        /* add the children to the element array of the current tree */
+        (void) t8_element_array_push_count (telements, num_children);
+        for (zz = 0; zz < num_children; zz++) {
+          elements[zz] =
+            t8_element_array_index_locidx (telements, el_inserted + zz);
+        }
+        t8_default_call_children (tscheme, elements_from[0], num_children,
+                                  elements);
+        el_inserted += num_children;
+      }
+      el_considered++;
+    }
+    else if (refine < 0) {
+      /* The elements form a family and are to be coarsened */
+      elements[0] = t8_element_array_push (telements);
+      t8_default_call_parent (tscheme, elements_from[0], elements[0]);
+      el_inserted++;
+      if (forest->set_adapt_recursive) {
+        if ((size_t) t8_default_call_child_id (tscheme, elements[0])
+            == num_children - 1) {
+          t8_forest_adapt_coarsen_recursive (forest, ltree_id,
+                                             el_considered, tscheme,
+                                             telements, el_coarsen,
+                                             &el_inserted, elements,
+                                             family_start + num_el_from);
+        }
+      }
+      el_considered += num_children;
+    }
+    else {
+      /* The considered elements are neither to be coarsened nor is the first
+       * one to be refined */
+      T8_ASSERT (refine == 0);
+      elements[0] = t8_element_array_push (telements);
+      t8_default_call_copy (tscheme, elements_from[0], elements[0]);
+      el_inserted++;
+      if (forest->set_adapt_recursive &&
+          (size_t) t8_default_call_child_id (tscheme, elements[0])
+          == num_children - 1) {
+        t8_forest_adapt_coarsen_recursive (forest, ltree_id, el_considered,
+                                           tscheme, telements, el_coarsen,
+                                           &el_inserted, elements,
+                                           family_start + num_el_from);
+      }
+      el_considered++;
+    }
+  }
+  if (forest->set_adapt_recursive) {
+    while (refine_list->elem_count > 0) {
+      SC_ABORT_NOT_REACHED ();
+      elpop = (t8_element_t *) sc_list_pop (refine_list);
+      elements[0] = t8_element_array_push (telements);
+      t8_default_call_copy (tscheme, elpop, elements[0]);
+      t8_default_call_destroy (tscheme, 1, &elpop);
+      el_inserted++;
+    }
+  }
+  t8_element_array_resize (telements, el_inserted);
+
+  T8_FREE (elements);
+  T8_FREE (elements_from);
+  T8_FREE (family_start);
+  return el_inserted;
+}
+
+/* Functor passed to t8_default_scheme_dispatch to call t8_forest_adapt_tree
+ * with the scheme of the current tree. */
+struct t8_forest_adapt_tree_functor
+{
+  t8_forest_t         forest;
+  t8_locidx_t         ltree_id;
+  sc_list_t          *refine_list;
+  t8_locidx_t         num_inserted;
+
+  template < class TScheme > void operator () (TScheme * tscheme)
+  {
+    num_inserted =
+      t8_forest_adapt_tree (forest, ltree_id, tscheme, refine_list);
+  }
+};
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* TODO: optimize this when we own forest_from */
+void
+t8_forest_adapt (t8_forest_t forest)
+{
+  t8_forest_t         forest_from;
+  sc_list_t          *refine_list = NULL;       /* This is only needed when we adapt recursively */
+  t8_locidx_t         ltree_id, num_trees;
+  t8_locidx_t         el_offset;
+  t8_tree_t           tree;
+  t8_forest_adapt_tree_functor adapt_tree;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (forest->set_from != NULL);
@@ -189,134 +347,17 @@ t8_forest_adapt (t8_forest_t forest)
   forest->local_num_elements = 0;
   el_offset = 0;
   num_trees = t8_forest_get_num_local_trees (forest);
+  adapt_tree.forest = forest;
+  adapt_tree.refine_list = refine_list;
   for (ltree_id = 0; ltree_id < num_trees; ltree_id++) {
     tree = t8_forest_get_tree (forest, ltree_id);
-    tree_from = t8_forest_get_tree (forest_from, ltree_id);
-    telements = &tree->elements;
-    telements_from = &tree_from->elements;
-    num_el_from = (t8_locidx_t) t8_element_array_get_count (telements_from);
-    tscheme = forest->scheme_cxx->eclass_schemes[tree->eclass];
-    el_considered = 0;
-    el_inserted = 0;
-    el_coarsen = 0;
-    /* TODO: this will generate problems with pyramidal elements */
-    num_children =
-      tscheme->t8_element_num_children (t8_element_array_index_locidx
-                                        (telements_from, 0));
-    elements = T8_ALLOC (t8_element_t *, num_children);
-    elements_from = T8_ALLOC (t8_element_t *, num_children);
-    while (el_considered < num_el_from) {
-#ifdef T8_ENABLE_DEBUG
-      is_family = 1;
-#endif
-      num_elements = num_children;
-      for (zz = 0; zz < num_children &&
-           el_considered + (t8_locidx_t) zz < num_el_from; zz++) {
-        elements_from[zz] = t8_element_array_index_locidx (telements_from,
-                                                           el_considered +
-                                                           zz);
-        if ((size_t) tscheme->t8_element_child_id (elements_from[zz]) != zz) {
-          break;
-        }
-      }
-      if (zz != num_children) {
-        num_elements = 1;
-#ifdef T8_ENABLE_DEBUG
-        is_family = 0;
-#endif
-      }
-      T8_ASSERT (!is_family || tscheme->t8_element_is_family (elements_from));
-      refine =
-        forest->set_adapt_fn (forest, forest->set_from, ltree_id,
-                              el_considered, tscheme, num_elements,
-                              elements_from);
-      T8_ASSERT (is_family || refine >= 0);
-      if (refine > 0 && tscheme->t8_element_level (elements_from[0]) >=
-          forest->maxlevel) {
-        /* Only refine an element if it does not exceed the maximum level */
-        refine = 0;
-      }
-      if (refine > 0) {
-        /* The first element is to be refined */
-        if (forest->set_adapt_recursive) {
-          /* el_coarsen is the index of the first element in the new element
-           * array which could be coarsened recursively.
-           * We can set this here, since a family that emerges from a refinement will never be coarsened */
-          el_coarsen = el_inserted + num_children;
-          tscheme->t8_element_new (num_children, elements);
-          tscheme->t8_element_children (elements_from[0], num_children,
-                                        elements);
-          for (ci = num_children - 1; ci >= 0; ci--) {
-            (void) sc_list_prepend (refine_list, elements[ci]);
-          }
-          t8_forest_adapt_refine_recursive (forest, ltree_id, el_considered,
-                                            tscheme, refine_list, telements,
-                                            &el_inserted, elements);
-        }
-        else {
-          /* add the children to the element array of the current tree */
-          (void) t8_element_array_push_count (telements, num_children);
-          for (zz = 0; zz < num_children; zz++) {
-            elements[zz] =
-              t8_element_array_index_locidx (telements, el_inserted + zz);
-          }
-          tscheme->t8_element_children (elements_from[0], num_children,
-                                        elements);
-          el_inserted += num_children;
-        }
-        el_considered++;
-      }
-      else if (refine < 0) {
-        /* The elements form a family and are to be coarsened */
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_parent (elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive) {
-          if ((size_t) tscheme->t8_element_child_id (elements[0])
-              == num_children - 1) {
-            t8_forest_adapt_coarsen_recursive (forest, ltree_id,
-                                               el_considered, tscheme,
-                                               telements, el_coarsen,
-                                               &el_inserted, elements);
-          }
-        }
-        el_considered += num_children;
-      }
-      else {
-        /* The considered elements are neither to be coarsened nor is the first
-         * one to be refined */
-        T8_ASSERT (refine == 0);
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_copy (elements_from[0], elements[0]);
-        el_inserted++;
-        if (forest->set_adapt_recursive &&
-            (size_t) tscheme->t8_element_child_id (elements[0])
-            == num_children - 1) {
-          t8_forest_adapt_coarsen_recursive (forest, ltree_id, el_considered,
-                                             tscheme, telements, el_coarsen,
-                                             &el_inserted, elements);
-        }
-        el_considered++;
-      }
-    }
-    if (forest->set_adapt_recursive) {
-      while (refine_list->elem_count > 0) {
-        SC_ABORT_NOT_REACHED ();
-        elpop = (t8_element_t *) sc_list_pop (refine_list);
-        elements[0] = t8_element_array_push (telements);
-        tscheme->t8_element_copy (elpop, elements[0]);
-        tscheme->t8_element_destroy (1, &elpop);
-        el_inserted++;
-      }
-    }
+    adapt_tree.ltree_id = ltree_id;
+    /* Call the adapt loop specialized for the scheme of this tree */
+    t8_default_scheme_dispatch (forest->scheme_cxx->eclass_schemes
+                                [tree->eclass], adapt_tree);
     tree->elements_offset = el_offset;
-    el_offset += el_inserted;
-    forest->local_num_elements += el_inserted;
-    t8_element_array_resize (telements, el_inserted);
-
-    T8_FREE (elements);
-    T8_FREE (elements_from);
-    /* TODO: compute tree->element_offset */
+    el_offset += adapt_tree.num_inserted;
+    forest->local_num_elements += adapt_tree.num_inserted;
   }
   if (forest->set_adapt_recursive) {
     sc_list_destroy (refine_list);
@@ -30,6 +30,7 @@
 #include <t8_forest/t8_forest_private.h>
 #include <t8_forest/t8_forest_ghost.h>
 #include <t8_forest/t8_forest_balance.h>
+#include <t8_forest/t8_forest_iterate.h>
 #include <t8_element_cxx.hxx>
 #include <t8_cmesh/t8_cmesh_trees.h>
 #include <t8_cmesh/t8_cmesh_offset.h>
@@ -939,6 +940,264 @@ t8_forest_element_face_normal (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+/* Evaluate the reference map of an element of a given class at the
+ * reference coordinates xi. The element is given by its corner coordinates.
+ * The map is affine for lines/triangles/tets, multilinear for quads/hexes
+ * and affine times linear for prisms, which is exactly the geometry that
+ * \ref t8_forest_element_coordinate induces on a subelement of a tree.
+ * On output x is the image of xi and the first dim columns of jacobian store
+ * the partial derivatives of the map. */
+static void
+t8_forest_element_reference_map (t8_eclass_t eclass,
+                                 const double corners[][3],
+                                 const double xi[3], double x[3],
+                                 double jacobian[3][3])
+{
+  double              s, t, u;
+  int                 i;
+
+  s = xi[0];
+  t = xi[1];
+  u = xi[2];
+  for (i = 0; i < 3; i++) {
+    switch (eclass) {
+    case T8_ECLASS_LINE:
+      x[i] = corners[0][i] + (corners[1][i] - corners[0][i]) * s;
+      jacobian[i][0] = corners[1][i] - corners[0][i];
+      break;
+    case T8_ECLASS_TRIANGLE:
+      x[i] = corners[0][i] + (corners[1][i] - corners[0][i]) * s
+        + (corners[2][i] - corners[0][i]) * t;
+      jacobian[i][0] = corners[1][i] - corners[0][i];
+      jacobian[i][1] = corners[2][i] - corners[0][i];
+      break;
+    case T8_ECLASS_TET:
+      x[i] = corners[0][i] + (corners[1][i] - corners[0][i]) * s
+        + (corners[2][i] - corners[0][i]) * t
+        + (corners[3][i] - corners[0][i]) * u;
+      jacobian[i][0] = corners[1][i] - corners[0][i];
+      jacobian[i][1] = corners[2][i] - corners[0][i];
+      jacobian[i][2] = corners[3][i] - corners[0][i];
+      break;
+    case T8_ECLASS_QUAD:
+      x[i] = corners[0][i] * (1 - s) * (1 - t) + corners[1][i] * s * (1 - t)
+        + corners[2][i] * (1 - s) * t + corners[3][i] * s * t;
+      jacobian[i][0] = (corners[1][i] - corners[0][i]) * (1 - t)
+        + (corners[3][i] - corners[2][i]) * t;
+      jacobian[i][1] = (corners[2][i] - corners[0][i]) * (1 - s)
+        + (corners[3][i] - corners[1][i]) * s;
+      break;
+    case T8_ECLASS_HEX:
+      x[i] = (corners[0][i] * (1 - s) * (1 - t)
+              + corners[1][i] * s * (1 - t)
+              + corners[2][i] * (1 - s) * t
+              + corners[3][i] * s * t) * (1 - u)
+        + (corners[4][i] * (1 - s) * (1 - t)
+           + corners[5][i] * s * (1 - t)
+           + corners[6][i] * (1 - s) * t + corners[7][i] * s * t) * u;
+      jacobian[i][0] = ((corners[1][i] - corners[0][i]) * (1 - t)
+                        + (corners[3][i] - corners[2][i]) * t) * (1 - u)
+        + ((corners[5][i] - corners[4][i]) * (1 - t)
+           + (corners[7][i] - corners[6][i]) * t) * u;
+      jacobian[i][1] = ((corners[2][i] - corners[0][i]) * (1 - s)
+                        + (corners[3][i] - corners[1][i]) * s) * (1 - u)
+        + ((corners[6][i] - corners[4][i]) * (1 - s)
+           + (corners[7][i] - corners[5][i]) * s) * u;
+      jacobian[i][2] = (corners[4][i] * (1 - s) * (1 - t)
+                        + corners[5][i] * s * (1 - t)
+                        + corners[6][i] * (1 - s) * t
+                        + corners[7][i] * s * t)
+        - (corners[0][i] * (1 - s) * (1 - t)
+           + corners[1][i] * s * (1 - t)
+           + corners[2][i] * (1 - s) * t + corners[3][i] * s * t);
+      break;
+    case T8_ECLASS_PRISM:
+      {
+        double              bottom, top;
+        /* The prism is a triangle at the bottom and the top that are linearly
+         * interpolated in between. */
+        bottom = corners[0][i] + (corners[1][i] - corners[0][i]) * s
+          + (corners[2][i] - corners[0][i]) * t;
+        top = corners[3][i] + (corners[4][i] - corners[3][i]) * s
+          + (corners[5][i] - corners[3][i]) * t;
+        x[i] = (1 - u) * bottom + u * top;
+        jacobian[i][0] = (1 - u) * (corners[1][i] - corners[0][i])
+          + u * (corners[4][i] - corners[3][i]);
+        jacobian[i][1] = (1 - u) * (corners[2][i] - corners[0][i])
+          + u * (corners[5][i] - corners[3][i]);
+        jacobian[i][2] = top - bottom;
+      }
+      break;
+    default:
+      SC_ABORT ("Point inside test is supported only for "
+                "lines/triangles/tets/quads/prisms/hexes.");
+    }
+  }
+}
+
+/* Solve the dim x dim system A x = b via Gaussian elimination with
+ * partial pivoting. Return false if A is (numerically) singular. */
+static int
+t8_forest_solve_small_system (double A[3][3], double b[3], int dim)
+{
+  int                 i, j, k, pivot;
+  double              factor, swap;
+
+  for (k = 0; k < dim; k++) {
+    /* Find the pivot row */
+    pivot = k;
+    for (i = k + 1; i < dim; i++) {
+      if (fabs (A[i][k]) > fabs (A[pivot][k])) {
+        pivot = i;
+      }
+    }
+    if (fabs (A[pivot][k]) < 1e-300) {
+      return 0;
+    }
+    if (pivot != k) {
+      for (j = 0; j < dim; j++) {
+        swap = A[k][j];
+        A[k][j] = A[pivot][j];
+        A[pivot][j] = swap;
+      }
+      swap = b[k];
+      b[k] = b[pivot];
+      b[pivot] = swap;
+    }
+    /* Eliminate the entries below the pivot */
+    for (i = k + 1; i < dim; i++) {
+      factor = A[i][k] / A[k][k];
+      for (j = k; j < dim; j++) {
+        A[i][j] -= factor * A[k][j];
+      }
+      b[i] -= factor * b[k];
+    }
+  }
+  /* Back substitution */
+  for (k = dim - 1; k >= 0; k--) {
+    for (j = k + 1; j < dim; j++) {
+      b[k] -= A[k][j] * b[j];
+    }
+    b[k] /= A[k][k];
+  }
+  return 1;
+}
+
+int
+t8_forest_element_point_inside (t8_forest_t forest, t8_locidx_t ltreeid,
+                                const t8_element_t * element,
+                                const double *tree_vertices,
+                                const double point[3], double tolerance)
+{
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  double              corners[T8_ECLASS_MAX_CORNERS][3];
+  double              xi[3], x[3], residual[3], jacobian[3][3];
+  double              normal_matrix[3][3], rhs[3];
+  double              diam, dist, update;
+  int                 num_corners, icorner, dim, iter, i, j, k;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  eclass = t8_forest_get_tree_class (forest, ltreeid);
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  T8_ASSERT (ts->t8_element_is_valid (element));
+
+  if (eclass == T8_ECLASS_VERTEX) {
+    /* A vertex element coincides with the vertex of its tree */
+    return t8_vec_dist (tree_vertices, point) <= tolerance;
+  }
+
+  dim = t8_eclass_to_dimension[eclass];
+  num_corners = ts->t8_element_num_corners (element);
+  T8_ASSERT (num_corners <= T8_ECLASS_MAX_CORNERS);
+  diam = 0;
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    t8_forest_element_coordinate (forest, ltreeid, element, tree_vertices,
+                                  icorner, corners[icorner]);
+    if (icorner > 0) {
+      diam = SC_MAX (diam, t8_vec_dist (corners[0], corners[icorner]));
+    }
+  }
+
+  /* We invert the reference map with a Gauss-Newton iteration on the
+   * normal equations J^T J dxi = J^T (point - x(xi)).
+   * For affine elements a single step suffices. We start at the
+   * reference centroid. */
+  xi[0] = xi[1] = xi[2] = 0;
+  for (i = 0; i < dim; i++) {
+    xi[i] = (eclass == T8_ECLASS_TRIANGLE) ? 1. / 3 :
+      (eclass == T8_ECLASS_TET) ? 1. / 4 : 0.5;
+  }
+  if (eclass == T8_ECLASS_PRISM) {
+    xi[0] = xi[1] = 1. / 3;
+  }
+  for (iter = 0; iter < 20; iter++) {
+    t8_forest_element_reference_map (eclass, corners, xi, x, jacobian);
+    for (i = 0; i < 3; i++) {
+      residual[i] = point[i] - x[i];
+    }
+    for (i = 0; i < dim; i++) {
+      rhs[i] = 0;
+      for (k = 0; k < 3; k++) {
+        rhs[i] += jacobian[k][i] * residual[k];
+      }
+      for (j = 0; j < dim; j++) {
+        normal_matrix[i][j] = 0;
+        for (k = 0; k < 3; k++) {
+          normal_matrix[i][j] += jacobian[k][i] * jacobian[k][j];
+        }
+      }
+    }
+    if (!t8_forest_solve_small_system (normal_matrix, rhs, dim)) {
+      /* The element is degenerated */
+      return 0;
+    }
+    update = 0;
+    for (i = 0; i < dim; i++) {
+      xi[i] += rhs[i];
+      update = SC_MAX (update, fabs (rhs[i]));
+    }
+    if (update < 1e-14) {
+      break;
+    }
+  }
+
+  /* Check whether the reference coordinates lie in the reference element */
+  switch (eclass) {
+  case T8_ECLASS_TRIANGLE:
+    if (xi[0] < -tolerance || xi[1] < -tolerance
+        || xi[0] + xi[1] > 1 + tolerance) {
+      return 0;
+    }
+    break;
+  case T8_ECLASS_TET:
+    if (xi[0] < -tolerance || xi[1] < -tolerance || xi[2] < -tolerance
+        || xi[0] + xi[1] + xi[2] > 1 + tolerance) {
+      return 0;
+    }
+    break;
+  case T8_ECLASS_PRISM:
+    if (xi[0] < -tolerance || xi[1] < -tolerance
+        || xi[0] + xi[1] > 1 + tolerance
+        || xi[2] < -tolerance || xi[2] > 1 + tolerance) {
+      return 0;
+    }
+    break;
+  default:
+    for (i = 0; i < dim; i++) {
+      if (xi[i] < -tolerance || xi[i] > 1 + tolerance) {
+        return 0;
+      }
+    }
+  }
+  /* For elements of dimension < 3 the point may lie outside of the
+   * element's line/plane. We compare the remaining distance with the
+   * element's size. */
+  t8_forest_element_reference_map (eclass, corners, xi, x, jacobian);
+  dist = t8_vec_dist (x, point);
+  return dist <= tolerance * diam;
+}
+
 /* For each tree in a forest compute its first and last descendant */
 void
 t8_forest_compute_desc (t8_forest_t forest)
@@ -986,9 +1245,8 @@ t8_forest_populate (t8_forest_t forest)
   t8_locidx_t         num_tree_elements;
   t8_locidx_t         num_local_trees;
   t8_gloidx_t         jt, first_ctree;
-  t8_gloidx_t         start, end, et;
+  t8_gloidx_t         start, end;
   t8_tree_t           tree;
-  t8_element_t       *element, *element_succ;
   t8_element_array_t *telements;
   t8_eclass_t         tree_class;
   t8_eclass_scheme_c *eclass_scheme;
@@ -1055,17 +1313,11 @@ t8_forest_populate (t8_forest_t forest)
       /* Allocate elements for this processor. */
       t8_element_array_init_size (telements, eclass_scheme,
                                   num_tree_elements);
-      element = t8_element_array_index_locidx (telements, 0);
-      eclass_scheme->t8_element_set_linear_id (element, forest->set_level,
-                                               start);
-      count_elements++;
-      for (et = start + 1; et < end; et++, count_elements++) {
-        element_succ = t8_element_array_index_locidx (telements, et - start);
-        eclass_scheme->t8_element_successor (element, element_succ,
-                                             forest->set_level);
-        /* TODO: process elements here */
-        element = element_succ;
-      }
+      /* Generate the elements with linear ids start, ..., end - 1 */
+      eclass_scheme->t8_element_array_set_linear_ids (telements, 0,
+                                                      forest->set_level,
+                                                      start, end);
+      count_elements += num_tree_elements;
     }
   }
   forest->local_num_elements = count_elements;
@@ -1208,13 +1460,7 @@ t8_forest_copy_trees (t8_forest_t forest, t8_forest_t from, int copy_elements)
   }
 }
 
-/* Search for a linear element id (at forest->maxlevel) in a sorted array of
- * elements. If the element does not exist, return the largest index i
- * such that the element at position i has a smaller id than the given one.
- * If no such i exists, return -1.
- */
-/* TODO: should return t8_locidx_t */
-static t8_locidx_t
+t8_locidx_t
 t8_forest_bin_search_lower (t8_element_array_t * elements,
                             t8_linearidx_t element_id, int maxlevel)
 {
@@ -1307,6 +1553,119 @@ t8_forest_element_neighbor_eclass (t8_forest_t forest,
   }
 }
 
+/* Compute the connection of a face of a local tree to its neighbor tree
+ * from the face information of the cmesh. */
+static void
+t8_forest_tree_face_info_compute (t8_forest_t forest, t8_locidx_t ltreeid,
+                                  int tree_face,
+                                  t8_forest_tree_face_info_t * info)
+{
+  t8_cmesh_t          cmesh;
+  t8_eclass_t         eclass, neigh_eclass;
+  t8_locidx_t         lctree_id, lcneigh_id;
+  t8_locidx_t        *face_neighbor;
+  t8_cghost_t         ghost;
+  int8_t             *ttf;
+  int                 tree_neigh_face;
+  int                 eclass_compare;
+  int                 F;
+
+  cmesh = forest->cmesh;
+  eclass = t8_forest_get_tree (forest, ltreeid)->eclass;
+  /* compute coarse tree id */
+  lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
+    /* This face is a domain boundary. */
+    info->neigh_tree = -1;
+    return;
+  }
+  /* Get the face neighbor information of the coarse tree. */
+  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees,
+                                      lctree_id, &face_neighbor, &ttf);
+  /* Compute the local id of the face neighbor tree. */
+  lcneigh_id = face_neighbor[tree_face];
+  /* F is needed to compute the neighbor face number and the orientation.
+   * tree_neigh_face = ttf % F
+   * or = ttf / F
+   */
+  F = t8_eclass_max_num_faces[cmesh->dimension];
+  /* compute the neighbor face */
+  tree_neigh_face = ttf[tree_face] % F;
+  if (lcneigh_id == lctree_id && tree_face == tree_neigh_face) {
+    /* This face is a domain boundary and there is no neighbor */
+    info->neigh_tree = -1;
+    return;
+  }
+  /* We now compute the eclass of the neighbor tree. */
+  if (lcneigh_id < t8_cmesh_get_num_local_trees (cmesh)) {
+    /* The face neighbor is a local tree */
+    /* Get the eclass of the neighbor tree */
+    neigh_eclass = t8_cmesh_get_tree_class (cmesh, lcneigh_id);
+    info->neigh_tree = lcneigh_id + t8_cmesh_get_first_treeid (cmesh);
+  }
+  else {
+    /* The face neighbor is a ghost tree */
+    T8_ASSERT (cmesh->num_local_trees <= lcneigh_id
+               && lcneigh_id < cmesh->num_ghosts + cmesh->num_local_trees);
+    /* Get the eclass of the neighbor tree */
+    ghost = t8_cmesh_trees_get_ghost (cmesh->trees,
+                                      lcneigh_id -
+                                      t8_cmesh_get_num_local_trees (cmesh));
+    neigh_eclass = ghost->eclass;
+    info->neigh_tree = ghost->treeid;
+  }
+  info->neigh_eclass = neigh_eclass;
+  info->neigh_face = tree_neigh_face;
+  info->orientation = ttf[tree_face] / F;
+  /* We need to find out which face is the smaller one that is the one
+   * according to which the orientation was computed.
+   * face_a is smaller then face_b if either eclass_a < eclass_b
+   * or eclass_a = eclass_b and face_a < face_b. */
+  /* -1 eclass < neigh_eclass, 0 eclass = neigh_eclass, 1 eclass > neigh_eclass */
+  eclass_compare = t8_eclass_compare (eclass, neigh_eclass);
+  if (eclass_compare == -1) {
+    /* The face in the current tree is the smaller one */
+    info->is_smaller = 1;
+  }
+  else if (eclass_compare == 1) {
+    /* The face in the other tree is the smaller one */
+    info->is_smaller = 0;
+  }
+  else {
+    T8_ASSERT (eclass_compare == 0);
+    /* Check if the face of the current tree has a smaller index then
+     * the face of the neighbor tree. */
+    info->is_smaller = tree_face <= tree_neigh_face;
+  }
+  info->sign =
+    t8_eclass_face_orientation[eclass][tree_face] ==
+    t8_eclass_face_orientation[neigh_eclass][tree_neigh_face];
+}
+
+void
+t8_forest_compute_tree_face_info (t8_forest_t forest)
+{
+  t8_locidx_t         itree, num_trees;
+  t8_eclass_t         eclass;
+  int                 iface;
+
+  T8_ASSERT (forest != NULL);
+  if (forest->tree_face_info != NULL) {
+    T8_FREE (forest->tree_face_info);
+  }
+  num_trees = t8_forest_get_num_local_trees (forest);
+  forest->tree_face_info =
+    T8_ALLOC (t8_forest_tree_face_info_t, num_trees * T8_ECLASS_MAX_FACES);
+  for (itree = 0; itree < num_trees; itree++) {
+    eclass = t8_forest_get_tree (forest, itree)->eclass;
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      t8_forest_tree_face_info_compute (forest, itree, iface,
+                                        forest->tree_face_info +
+                                        itree * T8_ECLASS_MAX_FACES + iface);
+    }
+  }
+}
+
 t8_gloidx_t
 t8_forest_element_face_neighbor (t8_forest_t forest,
                                  t8_locidx_t ltreeid,
@@ -1314,6 +1673,20 @@ t8_forest_element_face_neighbor (t8_forest_t forest,
                                  t8_element_t * neigh,
                                  t8_eclass_scheme_c * neigh_scheme,
                                  int face, int *neigh_face)
+{
+  return t8_forest_element_face_neighbor_ext (forest, ltreeid, elem, neigh,
+                                              neigh_scheme, face, neigh_face,
+                                              NULL);
+}
+
+t8_gloidx_t
+t8_forest_element_face_neighbor_ext (t8_forest_t forest,
+                                     t8_locidx_t ltreeid,
+                                     const t8_element_t * elem,
+                                     t8_element_t * neigh,
+                                     t8_eclass_scheme_c * neigh_scheme,
+                                     int face, int *neigh_face,
+                                     t8_element_t * face_element)
 {
   t8_eclass_scheme_c *ts;
   t8_tree_t           tree;
@@ -1332,112 +1705,75 @@ t8_forest_element_face_neighbor (t8_forest_t forest,
     /* The neighbor does not lie inside the current tree. The content of neigh
      * is undefined right now. */
     t8_eclass_scheme_c *boundary_scheme, *neighbor_scheme;
-    t8_eclass_t         neigh_eclass, boundary_class;
-    t8_element_t       *face_element;
-    t8_cmesh_t          cmesh;
-    t8_locidx_t         lctree_id, lcneigh_id;
-    t8_locidx_t        *face_neighbor;
-    t8_gloidx_t         global_neigh_id;
-    t8_cghost_t         ghost;
-    int8_t             *ttf;
-    int                 tree_face, tree_neigh_face;
-    int                 is_smaller, eclass_compare;
-    int                 F, sign;
-
-    cmesh = forest->cmesh;
-    /* Get the scheme associated to the element class of the
-     * boundary element. */
+    t8_eclass_t         boundary_class;
+    t8_forest_tree_face_info_t info_computed;
+    const t8_forest_tree_face_info_t *info;
+    int                 tree_face, allocate_face_element = 0;
+
     /* Compute the face of elem_tree at which the face connection is. */
     tree_face = ts->t8_element_tree_face (elem, face);
-    /* compute coarse tree id */
-    lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
-    if (t8_cmesh_tree_face_is_boundary (cmesh, lctree_id, tree_face)) {
-      /* This face is a domain boundary. We do not need to continue */
+    if (forest->tree_face_info != NULL) {
+      /* Look up the connection of the tree face */
+      info = forest->tree_face_info + ltreeid * T8_ECLASS_MAX_FACES
+        + tree_face;
+    }
+    else {
+      /* The forest is not yet committed, we compute the connection
+       * from the cmesh */
+      t8_forest_tree_face_info_compute (forest, ltreeid, tree_face,
+                                        &info_computed);
+      info = &info_computed;
+    }
+    if (info->neigh_tree < 0) {
+      /* This face is a domain boundary and there is no neighbor */
       return -1;
     }
     /* Get the eclass scheme for the boundary */
     boundary_class = (t8_eclass_t) t8_eclass_face_types[eclass][tree_face];
     boundary_scheme = t8_forest_get_eclass_scheme (forest, boundary_class);
-    /* Allocate the face element */
-    boundary_scheme->t8_element_new (1, &face_element);
+    /* Allocate the face element, if none was given */
+    if (face_element == NULL) {
+      boundary_scheme->t8_element_new (1, &face_element);
+      allocate_face_element = 1;
+    }
     /* Compute the face element. */
     ts->t8_element_boundary_face (elem, face, face_element, boundary_scheme);
-    /* Get the coarse tree that contains elem.
-     * Also get the face neighbor information of the coarse tree. */
-    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees,
-                                        lctree_id, &face_neighbor, &ttf);
-    /* Compute the local id of the face neighbor tree. */
-    lcneigh_id = face_neighbor[tree_face];
-    /* F is needed to compute the neighbor face number and the orientation.
-     * tree_neigh_face = ttf % F
-     * or = ttf / F
-     */
-    F = t8_eclass_max_num_faces[cmesh->dimension];
-    /* compute the neighbor face */
-    tree_neigh_face = ttf[tree_face] % F;
-    if (lcneigh_id == lctree_id && tree_face == tree_neigh_face) {
-      /* This face is a domain boundary and there is no neighbor */
-      return -1;
-    }
-    /* We now compute the eclass of the neighbor tree. */
-    if (lcneigh_id < t8_cmesh_get_num_local_trees (cmesh)) {
-      /* The face neighbor is a local tree */
-      /* Get the eclass of the neighbor tree */
-      neigh_eclass = t8_cmesh_get_tree_class (cmesh, lcneigh_id);
-      global_neigh_id = lcneigh_id + t8_cmesh_get_first_treeid (cmesh);
-    }
-    else {
-      /* The face neighbor is a ghost tree */
-      T8_ASSERT (cmesh->num_local_trees <= lcneigh_id
-                 && lcneigh_id < cmesh->num_ghosts + cmesh->num_local_trees);
-      /* Get the eclass of the neighbor tree */
-      ghost = t8_cmesh_trees_get_ghost (cmesh->trees,
-                                        lcneigh_id -
-                                        t8_cmesh_get_num_local_trees (cmesh));
-      neigh_eclass = ghost->eclass;
-      global_neigh_id = ghost->treeid;
-    }
-    /* We need to find out which face is the smaller one that is the one
-     * according to which the orientation was computed.
-     * face_a is smaller then face_b if either eclass_a < eclass_b
-     * or eclass_a = eclass_b and face_a < face_b. */
-    /* -1 eclass < neigh_eclass, 0 eclass = neigh_eclass, 1 eclass > neigh_eclass */
-    eclass_compare = t8_eclass_compare (eclass, neigh_eclass);
-    is_smaller = 0;
-    if (eclass_compare == -1) {
-      /* The face in the current tree is the smaller one */
-      is_smaller = 1;
-    }
-    else if (eclass_compare == 1) {
-      /* The face in the other tree is the smaller one */
-      is_smaller = 0;
-    }
-    else {
-
-      T8_ASSERT (eclass_compare == 0);
-      /* Check if the face of the current tree has a smaller index then
-       * the face of the neighbor tree. */
-      is_smaller = tree_face <= tree_neigh_face;
-    }
     /* We now transform the face element to the other tree. */
-    sign =
-      t8_eclass_face_orientation[eclass][tree_face] ==
-      t8_eclass_face_orientation[neigh_eclass][tree_neigh_face];
     boundary_scheme->t8_element_transform_face (face_element,
                                                 face_element,
-                                                ttf[tree_face] / F, sign,
-                                                is_smaller);
+                                                info->orientation, info->sign,
+                                                info->is_smaller);
     /* And now we extrude the face to the new neighbor element */
-    neighbor_scheme = forest->scheme_cxx->eclass_schemes[neigh_eclass];
+    neighbor_scheme = forest->scheme_cxx->eclass_schemes[info->neigh_eclass];
     *neigh_face =
       neighbor_scheme->t8_element_extrude_face (face_element,
                                                 boundary_scheme, neigh,
-                                                tree_neigh_face);
+                                                info->neigh_face);
+    if (allocate_face_element) {
+      boundary_scheme->t8_element_destroy (1, &face_element);
+    }
 
-    return global_neigh_id;
+    return info->neigh_tree;
   }
 }
 
+int
+t8_forest_tree_face_orientation (t8_forest_t forest, t8_locidx_t ltreeid,
+                                 int tree_face)
+{
+  t8_cmesh_t          cmesh;
+  t8_locidx_t         lctree_id, *face_neighbor;
+  int8_t             *ttf;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  cmesh = forest->cmesh;
+  lctree_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltreeid);
+  (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, lctree_id,
+                                      &face_neighbor, &ttf);
+  /* ttf = orientation * F + neighbor face */
+  return ttf[tree_face] / t8_eclass_max_num_faces[cmesh->dimension];
+}
+
 t8_gloidx_t
 t8_forest_element_half_face_neighbors (t8_forest_t forest,
                                        t8_locidx_t ltreeid,
@@ -1514,6 +1850,56 @@ t8_forest_element_half_face_neighbors (t8_forest_t forest,
   return neighbor_tree;
 }
 
+/* Compute the leaf face neighbors of a leaf in a possibly unbalanced forest.
+ * The parameters are the same as for t8_forest_leaf_face_neighbors. */
+static void
+t8_forest_leaf_face_neighbors_unbalanced (t8_forest_t forest,
+                                          t8_locidx_t ltreeid,
+                                          const t8_element_t * leaf,
+                                          t8_element_t ** pneighbor_leafs[],
+                                          int face, int *dual_faces[],
+                                          int *num_neighbors,
+                                          t8_locidx_t ** pelement_indices,
+                                          t8_eclass_scheme_c ** pneigh_scheme)
+{
+  t8_eclass_t         neigh_class;
+  t8_eclass_scheme_c *neigh_scheme;
+  t8_forest_iter_face_side_t *neighbor_side;
+  sc_array_t          sides;
+  int                 ineigh;
+
+  neigh_class =
+    t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
+  neigh_scheme = *pneigh_scheme =
+    t8_forest_get_eclass_scheme (forest, neigh_class);
+  /* Find the neighbor leafs, they are not copied */
+  sc_array_init (&sides, sizeof (t8_forest_iter_face_side_t));
+  t8_forest_leaf_face_neighbors_all (forest, ltreeid, leaf, face, &sides);
+  *num_neighbors = (int) sides.elem_count;
+  if (*num_neighbors == 0) {
+    /* There exists no face neighbor across this face */
+    *dual_faces = NULL;
+    *pelement_indices = NULL;
+    *pneighbor_leafs = NULL;
+    sc_array_reset (&sides);
+    return;
+  }
+  /* Copy the neighbor leafs to the output arrays */
+  *pneighbor_leafs = T8_ALLOC (t8_element_t *, *num_neighbors);
+  neigh_scheme->t8_element_new (*num_neighbors, *pneighbor_leafs);
+  *dual_faces = T8_ALLOC (int, *num_neighbors);
+  *pelement_indices = T8_ALLOC (t8_locidx_t, *num_neighbors);
+  for (ineigh = 0; ineigh < *num_neighbors; ineigh++) {
+    neighbor_side =
+      (t8_forest_iter_face_side_t *) sc_array_index_int (&sides, ineigh);
+    neigh_scheme->t8_element_copy (neighbor_side->element,
+                                   (*pneighbor_leafs)[ineigh]);
+    (*dual_faces)[ineigh] = neighbor_side->face;
+    (*pelement_indices)[ineigh] = neighbor_side->element_index;
+  }
+  sc_array_reset (&sides);
+}
+
 void
 t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
                                const t8_element_t * leaf,
@@ -1538,7 +1924,6 @@ t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
   /* TODO: implement is_leaf check to apply to leaf */
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (!forest_is_balanced || t8_forest_is_balanced (forest));
-  SC_CHECK_ABORT (forest_is_balanced, "leaf face neighbors is not implemented " "for unbalanced forests.\n");   /* TODO: write version for unbalanced forests */
   SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
                   "Ghost structure is needed for t8_forest_leaf_face_neighbors "
                   "but was not found in forest.\n");
@@ -1808,8 +2193,13 @@ t8_forest_leaf_face_neighbors (t8_forest_t forest, t8_locidx_t ltreeid,
     T8_FREE (owners);
   }
   else {
-    /* TODO: implement unbalanced version */
-    SC_ABORT_NOT_REACHED ();
+    /* The neighbor leafs may have arbitrary levels. We find them via
+     * binary searches in the leaf arrays and the face iteration. */
+    t8_forest_leaf_face_neighbors_unbalanced (forest, ltreeid, leaf,
+                                              pneighbor_leafs, face,
+                                              dual_faces, num_neighbors,
+                                              pelement_indices,
+                                              pneigh_scheme);
   }
 }
 
@@ -2494,6 +2884,8 @@ t8_forest_element_owners_bounds (t8_forest_t forest, t8_gloidx_t gtreeid,
                                              eclass, *lower, *upper, *lower, 1);
   *upper = t8_forest_element_find_owner_ext (forest, gtreeid, last_desc,
                                              eclass, *lower, *upper, *upper, 1);
+  ts->t8_element_destroy (1, &first_desc);
+  ts->t8_element_destroy (1, &last_desc);
 }
 
 void
@@ -0,0 +1,153 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_face_connectivity.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest.h>
+#include <t8_element_cxx.hxx>
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+t8_forest_face_connectivity_t
+t8_forest_face_connectivity_new (t8_forest_t forest)
+{
+  t8_forest_face_connectivity_t conn;
+  t8_locidx_t         num_local_trees, itree, ielement, num_elements;
+  t8_locidx_t         element_index, num_faces_total;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  t8_forest_iter_face_side_t *neighbor_side;
+  t8_forest_face_neighbor_t *neighbor;
+  sc_array_t          sides, face_offsets, neighbors;
+  size_t              ineigh;
+  int                 num_faces, iface, orientation;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+
+  conn = T8_ALLOC (t8_forest_face_connectivity_struct_t, 1);
+  conn->num_local_elements = t8_forest_get_num_element (forest);
+  conn->num_ghosts = t8_forest_get_num_ghosts (forest);
+  conn->element_faces = T8_ALLOC (t8_locidx_t, conn->num_local_elements + 1);
+
+  sc_array_init (&sides, sizeof (t8_forest_iter_face_side_t));
+  sc_array_init (&face_offsets, sizeof (t8_locidx_t));
+  sc_array_init (&neighbors, sizeof (t8_forest_face_neighbor_t));
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  element_index = 0;
+  num_faces_total = 0;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, element_index++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      num_faces = ts->t8_element_num_faces (element);
+      conn->element_faces[element_index] = num_faces_total;
+      num_faces_total += num_faces;
+      for (iface = 0; iface < num_faces; iface++) {
+        *(t8_locidx_t *) sc_array_push (&face_offsets) =
+          (t8_locidx_t) neighbors.elem_count;
+        sc_array_resize (&sides, 0);
+        t8_forest_leaf_face_neighbors_all (forest, itree, element, iface,
+                                           &sides);
+        if (sides.elem_count == 0) {
+          /* This is a boundary face */
+          continue;
+        }
+        /* All neighbors of a face are in the same tree, thus the
+         * orientation is the same for all of them */
+        orientation = 0;
+        if (ts->t8_element_is_root_boundary (element, iface)) {
+          orientation =
+            t8_forest_tree_face_orientation (forest, itree,
+                                             ts->t8_element_tree_face
+                                             (element, iface));
+        }
+        for (ineigh = 0; ineigh < sides.elem_count; ineigh++) {
+          neighbor_side =
+            (t8_forest_iter_face_side_t *) sc_array_index (&sides, ineigh);
+          neighbor = (t8_forest_face_neighbor_t *) sc_array_push (&neighbors);
+          neighbor->neighbor = neighbor_side->element_index;
+          neighbor->dual_face = (int8_t) neighbor_side->face;
+          neighbor->orientation = (int8_t) orientation;
+        }
+      }
+    }
+  }
+  T8_ASSERT (element_index == conn->num_local_elements);
+  conn->element_faces[element_index] = num_faces_total;
+  *(t8_locidx_t *) sc_array_push (&face_offsets) =
+    (t8_locidx_t) neighbors.elem_count;
+
+  /* Copy the arrays to the connectivity */
+  conn->face_offsets = T8_ALLOC (t8_locidx_t, face_offsets.elem_count);
+  memcpy (conn->face_offsets, face_offsets.array,
+          face_offsets.elem_count * sizeof (t8_locidx_t));
+  conn->neighbors =
+    T8_ALLOC (t8_forest_face_neighbor_t, SC_MAX (neighbors.elem_count, 1));
+  memcpy (conn->neighbors, neighbors.array,
+          neighbors.elem_count * sizeof (t8_forest_face_neighbor_t));
+
+  sc_array_reset (&sides);
+  sc_array_reset (&face_offsets);
+  sc_array_reset (&neighbors);
+  return conn;
+}
+
+int
+t8_forest_face_connectivity_get_neighbors (t8_forest_face_connectivity_t
+                                           conn, t8_locidx_t element_index,
+                                           int face,
+                                           const t8_forest_face_neighbor_t **
+                                           neighbors)
+{
+  t8_locidx_t         face_number;
+
+  T8_ASSERT (conn != NULL);
+  T8_ASSERT (0 <= element_index && element_index < conn->num_local_elements);
+  face_number = conn->element_faces[element_index] + face;
+  T8_ASSERT (face_number < conn->element_faces[element_index + 1]);
+
+  *neighbors = conn->neighbors + conn->face_offsets[face_number];
+  return conn->face_offsets[face_number + 1] -
+    conn->face_offsets[face_number];
+}
+
+void
+t8_forest_face_connectivity_destroy (t8_forest_face_connectivity_t * pconn)
+{
+  t8_forest_face_connectivity_t conn;
+
+  T8_ASSERT (pconn != NULL && *pconn != NULL);
+  conn = *pconn;
+  T8_FREE (conn->element_faces);
+  T8_FREE (conn->face_offsets);
+  T8_FREE (conn->neighbors);
+  T8_FREE (conn);
+  *pconn = NULL;
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,99 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_face_connectivity.h
+ * We define a table storing the face neighbor leafs of all local leaf
+ * elements of a forest. It is computed once for a committed forest and can
+ * then be used for repeated sweeps over the faces without any neighbor
+ * computation.
+ */
+
+#ifndef T8_FOREST_FACE_CONNECTIVITY_H
+#define T8_FOREST_FACE_CONNECTIVITY_H
+
+#include <t8.h>
+#include <t8_forest.h>
+
+/** One neighbor leaf of an element face. */
+typedef struct
+{
+  t8_locidx_t         neighbor;         /**< The index of the neighbor leaf. Local elements are
+                                             numbered 0, ..., num_local_elements - 1,
+                                             ghost elements num_local_elements, ...,
+                                             num_local_elements + num_ghosts - 1. */
+  int8_t              dual_face;        /**< The face of the neighbor leaf at which the element is. */
+  int8_t              orientation;      /**< The orientation of the face connection if it is
+                                             across a tree boundary, 0 otherwise. */
+} t8_forest_face_neighbor_t;
+
+/** The face connectivity of the local leafs of a forest in CSR format.
+ * The faces of local element e are numbered
+ * element_faces[e], ..., element_faces[e + 1] - 1, such that
+ * face f of e has number element_faces[e] + f. The neighbors of the face
+ * with number i are neighbors[face_offsets[i]], ...,
+ * neighbors[face_offsets[i + 1] - 1]. A boundary face has no neighbors.
+ */
+typedef struct t8_forest_face_connectivity
+{
+  t8_locidx_t         num_local_elements;       /**< The number of local elements. */
+  t8_locidx_t         num_ghosts;       /**< The number of ghost elements. */
+  t8_locidx_t        *element_faces;    /**< For each local element its first face number,
+                                             with num_local_elements + 1 entries. */
+  t8_locidx_t        *face_offsets;     /**< For each face number its first neighbor,
+                                             with element_faces[num_local_elements] + 1 entries. */
+  t8_forest_face_neighbor_t *neighbors; /**< The neighbors of all faces. */
+} t8_forest_face_connectivity_struct_t;
+
+typedef t8_forest_face_connectivity_struct_t *t8_forest_face_connectivity_t;
+
+T8_EXTERN_C_BEGIN ();
+
+/** Compute the face connectivity of the local leafs of a forest.
+ * The forest does not need to be balanced.
+ * \param [in] forest   A committed forest. If it has more than one process,
+ *                      a ghost layer must exist.
+ * \return              The face connectivity of \a forest. It stays valid as
+ *                      long as \a forest is not changed.
+ */
+t8_forest_face_connectivity_t t8_forest_face_connectivity_new (t8_forest_t
+                                                               forest);
+
+/** Return the neighbor leafs of a face of a local element.
+ * \param [in]  conn          A face connectivity.
+ * \param [in]  element_index The index of a local element.
+ * \param [in]  face          A face of the element.
+ * \param [out] neighbors     On output a pointer to the first neighbor of the face.
+ * \return                    The number of neighbors of the face, 0 if it is a boundary face.
+ */
+int                 t8_forest_face_connectivity_get_neighbors
+  (t8_forest_face_connectivity_t conn, t8_locidx_t element_index, int face,
+   const t8_forest_face_neighbor_t ** neighbors);
+
+/** Free the memory of a face connectivity.
+ * \param [in,out] pconn  The face connectivity. Set to NULL on output.
+ */
+void                t8_forest_face_connectivity_destroy
+  (t8_forest_face_connectivity_t * pconn);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_FACE_CONNECTIVITY_H */
@@ -1190,6 +1190,19 @@ t8_forest_ghost_fill_remote (t8_forest_t forest, t8_forest_ghost_t ghost,
   }
 }
 
+/* Return true if we send the elements of a remote tree as compact keys.
+ * This is the case if the elements are larger than a key and all of
+ * them can be encoded. */
+static int
+t8_forest_ghost_remote_tree_is_compact (t8_ghost_remote_tree_t * remote_tree)
+{
+  t8_element_array_t *elements = &remote_tree->elements;
+
+  return t8_element_array_get_size (elements) > sizeof (t8_linearidx_t)
+    && t8_element_array_can_encode (elements, 0,
+                                    t8_element_array_get_count (elements));
+}
+
 /* Begin sending the ghost elements from the remote ranks
  * using non-blocking communication.
  * Afterward
@@ -1214,7 +1227,7 @@ t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
 #ifdef T8_ENABLE_DEBUG
   size_t              acc_el_count = 0;
 #endif
-  int                 mpiret;
+  int                 mpiret, compact, is_encoded;
 
   /* Allocate a send_buffer for each remote rank */
   num_remotes = ghost->remote_processes->elem_count;
@@ -1258,12 +1271,20 @@ t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
       current_send_info->num_bytes +=
         T8_ADD_PADDING (current_send_info->num_bytes);
       current_send_info->num_bytes += sizeof (t8_eclass_t);
-      /* add padding before the elements */
+      /* add padding before the compact flag */
+      current_send_info->num_bytes +=
+        T8_ADD_PADDING (current_send_info->num_bytes);
+      current_send_info->num_bytes += sizeof (int);
+      /* add padding before the number of elements */
       current_send_info->num_bytes +=
         T8_ADD_PADDING (current_send_info->num_bytes);
-      /* The byte count of the elements */
-      element_size = t8_element_array_get_size (&remote_tree->elements);
+      /* The byte count of the elements. If they are larger than a compact
+       * key and can be encoded, we send their keys instead. */
       element_count = t8_element_array_get_count (&remote_tree->elements);
+      element_size =
+        t8_forest_ghost_remote_tree_is_compact (remote_tree) ?
+        sizeof (t8_linearidx_t) :
+        t8_element_array_get_size (&remote_tree->elements);
       element_bytes = element_size * element_count;
       /* We will store the number of elements */
       current_send_info->num_bytes += sizeof (size_t);
@@ -1311,19 +1332,36 @@ t8_forest_ghost_send_start (t8_forest_t forest, t8_forest_ghost_t ghost,
               sizeof (t8_eclass_t));
       bytes_written += sizeof (t8_eclass_t);
       bytes_written += T8_ADD_PADDING (bytes_written);
+      /* Store whether we send the elements as compact keys */
+      compact = t8_forest_ghost_remote_tree_is_compact (remote_tree);
+      memcpy (current_buffer + bytes_written, &compact, sizeof (int));
+      bytes_written += sizeof (int);
+      bytes_written += T8_ADD_PADDING (bytes_written);
       /* Store the number of elements in the buffer */
       element_count = t8_element_array_get_count (&remote_tree->elements);
       memcpy (current_buffer + bytes_written, &element_count,
               sizeof (size_t));
       bytes_written += sizeof (size_t);
       bytes_written += T8_ADD_PADDING (bytes_written);
-      /* The byte count of the elements */
-      element_size = t8_element_array_get_size (&remote_tree->elements);
-      element_bytes = element_size * element_count;
-      /* Copy the elements into the send buffer */
-      memcpy (current_buffer + bytes_written,
-              t8_element_array_get_data (&remote_tree->elements),
-              element_bytes);
+      if (compact) {
+        /* Encode the keys of the elements directly into the send buffer */
+        is_encoded =
+          t8_element_array_encode (&remote_tree->elements, 0, element_count,
+                                   (t8_linearidx_t *) (current_buffer +
+                                                       bytes_written));
+        T8_ASSERT (is_encoded);
+        (void) is_encoded;
+        element_bytes = sizeof (t8_linearidx_t) * element_count;
+      }
+      else {
+        /* The byte count of the elements */
+        element_size = t8_element_array_get_size (&remote_tree->elements);
+        element_bytes = element_size * element_count;
+        /* Copy the elements into the send buffer */
+        memcpy (current_buffer + bytes_written,
+                t8_element_array_get_data (&remote_tree->elements),
+                element_bytes);
+      }
       bytes_written += element_bytes;
       /* add padding after the elements */
       bytes_written += T8_ADD_PADDING (bytes_written);
@@ -1401,10 +1439,12 @@ t8_forest_ghost_receive_message (int recv_rank, sc_MPI_Comm comm,
 /* Parse a message from a remote process and correctly include the received
  * elements in the ghost structure.
  * The message looks like:
- * num_trees | pad | treeid 0 | pad | eclass 0 | pad | num_elems 0 | pad | elements | pad | treeid 1 | ...
- *  size_t   |     |t8_gloidx |     |t8_eclass |     | size_t      |     | t8_element_t |
+ * num_trees | pad | treeid 0 | pad | eclass 0 | pad | compact 0 | pad | num_elems 0 | pad | elements | pad | treeid 1 | ...
+ *  size_t   |     |t8_gloidx |     |t8_eclass |     | int       |     | size_t      |     | t8_element_t |
  *
  * pad is paddind, see T8_ADD_PADDING
+ * If compact is true, the elements are sent as compact keys,
+ * see \ref t8_element_array_compact.
  *
  * current_element_offset is updated in each step to store the element offset
  * of the next ghost tree to be inserted.
@@ -1429,6 +1469,8 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
   t8_eclass_scheme_c *ts;
   t8_element_t       *element_insert;
   t8_ghost_process_hash_t *process_hash;
+  int                 compact;
+  size_t              recv_element_size;
 #ifdef T8_ENABLE_DEBUG
   int                 added_process;
 #endif
@@ -1458,6 +1500,10 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
     eclass = *(t8_eclass_t *) (recv_buffer + bytes_read);
     bytes_read += sizeof (t8_eclass_t);
     bytes_read += T8_ADD_PADDING (bytes_read);
+    /* read whether the elements were sent as compact keys */
+    compact = *(int *) (recv_buffer + bytes_read);
+    bytes_read += sizeof (int);
+    bytes_read += T8_ADD_PADDING (bytes_read);
     /* read the number of elements sent */
     num_elements = *(size_t *) (recv_buffer + bytes_read);
 
@@ -1523,10 +1569,20 @@ t8_forest_ghost_parse_received_message (t8_forest_t forest,
       first_element_index = old_elem_count;
     }
     /* Insert the new elements */
-    memcpy (element_insert, recv_buffer + bytes_read,
-            num_elements * ts->t8_element_size ());
+    if (compact) {
+      /* Decode the received keys directly into the element array */
+      t8_element_array_decode_keys (&ghost_tree->elements, old_elem_count,
+                                    num_elements, (const t8_linearidx_t *)
+                                    (recv_buffer + bytes_read));
+      recv_element_size = sizeof (t8_linearidx_t);
+    }
+    else {
+      memcpy (element_insert, recv_buffer + bytes_read,
+              num_elements * ts->t8_element_size ());
+      recv_element_size = ts->t8_element_size ();
+    }
 
-    bytes_read += num_elements * ts->t8_element_size ();
+    bytes_read += num_elements * recv_element_size;
     bytes_read += T8_ADD_PADDING (bytes_read);
     *current_element_offset += num_elements;
   }
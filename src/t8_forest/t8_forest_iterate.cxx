@@ -22,14 +22,16 @@
 
 #include <t8_forest/t8_forest_iterate.h>
 #include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_partition.h>
+#include <t8_forest/t8_forest_ghost.h>
+#include <t8_cmesh/t8_cmesh_offset.h>
 #include <t8_forest.h>
 #include <t8_element_cxx.hxx>
+#include <t8_default/t8_default_dispatch_cxx.hxx>
 
 #include <t8_default/t8_dtri.h>
 
-/* We want to export the whole implementation to be callable from "C" */
-T8_EXTERN_C_BEGIN ();
-
 typedef struct
 {
   t8_eclass_scheme_c *ts;
@@ -40,36 +42,38 @@ typedef struct
 /* This is the function that we call in sc_split_array to determine for an
  * element E that is a descendant of an element e, of which of e's children,
  * E is a descendant. */
-static              size_t
+template < class TScheme > static size_t
 t8_forest_determine_child_type (sc_array_t * leaf_elements,
                                 size_t index, void *data)
 {
   t8_forest_child_type_query_t *query_data =
     (t8_forest_child_type_query_t *) data;
+  TScheme            *ts = static_cast < TScheme * >(query_data->ts);
   t8_element_t       *element;
 
   /* Get a pointer to the element */
   element = (t8_element_t *) t8_sc_array_index_locidx (leaf_elements, index);
-  T8_ASSERT (query_data->level < query_data->ts->t8_element_level (element));
+  T8_ASSERT (query_data->level < t8_default_call_level (ts, element));
   /* Compute the element's ancestor id at the stored level and return it
    * as the element's type */
-  return query_data->ts->t8_element_ancestor_id (element,
-                                                 query_data->level + 1);
+  return t8_default_call_ancestor_id (ts, element, query_data->level + 1);
 }
 
-void
-t8_forest_split_array (const t8_element_t * element,
-                       t8_element_array_t * leaf_elements, size_t * offsets)
+/* t8_forest_split_array with the scheme of leaf_elements given as
+ * its exact type. */
+template < class TScheme > static void
+t8_forest_split_array_scheme (const t8_element_t * element,
+                              t8_element_array_t * leaf_elements,
+                              size_t * offsets, TScheme * ts)
 {
   sc_array_t          offset_view;
   sc_array_t         *element_array;
   t8_forest_child_type_query_t query_data;
-  t8_eclass_scheme_c *ts;
 
-  ts = t8_element_array_get_scheme (leaf_elements);
+  T8_ASSERT (ts == t8_element_array_get_scheme (leaf_elements));
   /* Store the number of children and the level of element */
-  query_data.num_children = ts->t8_element_num_children (element);
-  query_data.level = ts->t8_element_level (element);
+  query_data.num_children = t8_default_call_num_children (ts, element);
+  query_data.level = t8_default_call_level (ts, element);
   query_data.ts = ts;
 
   element_array = t8_element_array_get_array (leaf_elements);
@@ -81,35 +85,46 @@ t8_forest_split_array (const t8_element_t * element,
   sc_array_init_data (&offset_view, offsets, sizeof (size_t),
                       query_data.num_children + 1);
   sc_array_split (element_array, &offset_view, query_data.num_children,
-                  t8_forest_determine_child_type, (void *) &query_data);
+                  t8_forest_determine_child_type < TScheme >,
+                  (void *) &query_data);
 }
 
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
 void
-t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
-                         const t8_element_t * element, int face,
-                         t8_element_array_t * leaf_elements, void *user_data,
-                         t8_locidx_t tree_lindex_of_first_leaf,
-                         t8_forest_iterate_face_fn callback)
+t8_forest_split_array (const t8_element_t * element,
+                       t8_element_array_t * leaf_elements, size_t * offsets)
+{
+  t8_forest_split_array_scheme (element, leaf_elements, offsets,
+                                t8_element_array_get_scheme (leaf_elements));
+}
+
+/* The recursion of t8_forest_iterate_faces.
+ * The scheme is taken from the leaf array, such that we can also iterate
+ * over the leafs of ghost trees. In this case ltreeid is the local id
+ * of the ghost tree. */
+static void
+t8_forest_iterate_faces_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
+                                   const t8_element_t * element, int face,
+                                   t8_element_array_t * leaf_elements,
+                                   void *user_data,
+                                   t8_locidx_t tree_lindex_of_first_leaf,
+                                   t8_forest_iterate_face_fn callback)
 {
   t8_eclass_scheme_c *ts;
-  t8_eclass_t         eclass;
   t8_element_t       *leaf, **face_children;
   int                 child_face, num_face_children, iface;
   int                *child_indices;
   size_t             *split_offsets, indexa, indexb, elem_count;
   t8_element_array_t  face_child_leafs;
 
-  T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (0 <= ltreeid
-             && ltreeid < t8_forest_get_num_local_trees (forest));
-
   elem_count = t8_element_array_get_count (leaf_elements);
   if (elem_count == 0) {
     /* There are no leafs left, so we have nothing to do */
     return;
   }
-  eclass = t8_forest_get_tree_class (forest, ltreeid);
-  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  ts = t8_element_array_get_scheme (leaf_elements);
 
   if (elem_count == 1) {
     /* There is only one leaf left, we check whether it is the same as element
@@ -163,10 +178,11 @@ t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
         /* Compute the corresponding face number of this face child */
         child_face = ts->t8_element_face_child_face (element, face, iface);
         /* Enter the recursion */
-        t8_forest_iterate_faces (forest, ltreeid, face_children[iface],
-                                 child_face, &face_child_leafs, user_data,
-                                 indexa + tree_lindex_of_first_leaf,
-                                 callback);
+        t8_forest_iterate_faces_recursion (forest, ltreeid,
+                                           face_children[iface], child_face,
+                                           &face_child_leafs, user_data,
+                                           indexa + tree_lindex_of_first_leaf,
+                                           callback);
       }
     }
     /* clean-up */
@@ -177,29 +193,61 @@ t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
   }
 }
 
+void
+t8_forest_iterate_faces (t8_forest_t forest, t8_locidx_t ltreeid,
+                         const t8_element_t * element, int face,
+                         t8_element_array_t * leaf_elements, void *user_data,
+                         t8_locidx_t tree_lindex_of_first_leaf,
+                         t8_forest_iterate_face_fn callback)
+{
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= ltreeid
+             && ltreeid < t8_forest_get_num_local_trees (forest));
+  T8_ASSERT (t8_element_array_get_scheme (leaf_elements) ==
+             t8_forest_get_eclass_scheme (forest,
+                                          t8_forest_get_tree_class (forest,
+                                                                    ltreeid)));
+
+  t8_forest_iterate_faces_recursion (forest, ltreeid, element, face,
+                                     leaf_elements, user_data,
+                                     tree_lindex_of_first_leaf, callback);
+}
+
+T8_EXTERN_C_END ();
+
 /* The recursion that is called from t8_forest_search_tree
  * Input is an element and an array of all leaf elements of this element.
  * The callback function is called on element and if it returns true,
- * the search continues with the children of the element. */
-static void
+ * the search continues with the children of the element.
+ * If queries is not NULL, active_queries stores the indices of those
+ * queries that still have to be checked for element. The query callback
+ * is called for each of them and only the queries for which it returns
+ * true are passed on to the children of element. If no query remains
+ * active, the recursion stops. */
+template < class TScheme > static void
 t8_forest_search_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
                             t8_eclass_t eclass, t8_element_t * element,
-                            t8_eclass_scheme_c * ts,
+                            TScheme * ts,
                             t8_element_array_t * leaf_elements,
                             t8_locidx_t tree_lindex_of_first_leaf,
                             t8_forest_search_query_fn search_fn,
-                            void *user_data)
+                            t8_forest_query_fn query_fn,
+                            sc_array_t * queries,
+                            sc_array_t * active_queries, void *user_data)
 {
   t8_element_t       *leaf, **children;
   int                 num_children, ichild;
   size_t             *split_offsets, indexa, indexb;
   t8_element_array_t  child_leafs;
-  size_t              elem_count;
-  int                 ret;
+  size_t              elem_count, iquery, query_index;
+  sc_array_t          new_active_queries;
+  int                 ret, is_leaf;
+  t8_locidx_t         element_leaf_index;
 
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (0 <= ltreeid
              && ltreeid < t8_forest_get_num_local_trees (forest));
+  T8_ASSERT (queries == NULL || (query_fn != NULL && active_queries != NULL));
 
   elem_count = t8_element_array_get_count (leaf_elements);
   if (elem_count == 0) {
@@ -207,82 +255,122 @@ t8_forest_search_recursion (t8_forest_t forest, t8_locidx_t ltreeid,
     return;
   }
 
+  is_leaf = 0;
   if (elem_count == 1) {
-    /* There is only one leaf left, we check whether it is the same as element
-     * and if so call the callback function */
+    /* There is only one leaf left, we check whether it is the same as element */
     leaf = t8_element_array_index_locidx (leaf_elements, 0);
 
-    SC_CHECK_ABORT (ts->t8_element_level (element) <=
-                    ts->t8_element_level (leaf),
+    SC_CHECK_ABORT (t8_default_call_level (ts, element) <=
+                    t8_default_call_level (ts, leaf),
                     "Search: element level greater than leaf level\n");
-    if (ts->t8_element_level (element) == ts->t8_element_level (leaf)) {
-      T8_ASSERT (!ts->t8_element_compare (element, leaf));
-      /* The element is the leaf, we are at the last stage of the recursion
-       * and can call the callback. */
-      (void) search_fn (forest, ltreeid, leaf, leaf_elements, user_data,
-                        tree_lindex_of_first_leaf);
-      return;
+    if (t8_default_call_level (ts, element) ==
+        t8_default_call_level (ts, leaf)) {
+      T8_ASSERT (!t8_default_call_compare (ts, element, leaf));
+      /* The element is the leaf, we are at the last stage of the recursion */
+      is_leaf = 1;
+      element = leaf;
     }
   }
-  /* Call the callback function for the element, we pass -index -1 as index to indicate
-   * element is not a leaf */
-  ret = search_fn (forest, ltreeid, element, leaf_elements, user_data,
-                   -tree_lindex_of_first_leaf - 1);
+  /* For non-leaf elements we pass -index -1 as index */
+  element_leaf_index = is_leaf ? tree_lindex_of_first_leaf :
+    -tree_lindex_of_first_leaf - 1;
 
-  if (ret) {
-    /* Enter the recursion */
-    /* We compute all children of E, compute their leaf arrays and
-     * call search_recursion */
-    /* allocate the memory to store the children */
-    num_children = ts->t8_element_num_children (element);
-    children = T8_ALLOC (t8_element_t *, num_children);
-    ts->t8_element_new (num_children, children);
-    /* Memory for the indices that split the leaf_elements array */
-    split_offsets = T8_ALLOC (size_t, num_children + 1);
-    /* Compute the children */
-    ts->t8_element_children (element, num_children, children);
-    /* Split the leafs array in portions belonging to the children of element */
-    t8_forest_split_array (element, leaf_elements, split_offsets);
-    for (ichild = 0; ichild < num_children; ichild++) {
-      /* Check if there are any leaf elements for this child */
-      indexa = split_offsets[ichild];   /* first leaf of this child */
-      indexb = split_offsets[ichild + 1];       /* first leaf of next child */
-      if (indexa < indexb) {
-        /* There exist leafs of this child in leaf_elements,
-         * we construct an array of these leafs */
-        t8_element_array_init_view (&child_leafs, leaf_elements, indexa,
-                                    indexb - indexa);
-        /* Enter the recursion */
-        t8_forest_search_recursion (forest, ltreeid, eclass, children[ichild],
-                                    ts, &child_leafs,
-                                    indexa + tree_lindex_of_first_leaf,
-                                    search_fn, user_data);
+  /* Call the callback function for the element. If no callback is
+   * given we always continue. */
+  ret = search_fn == NULL ? 1 :
+    search_fn (forest, ltreeid, element, leaf_elements, user_data,
+               element_leaf_index);
+  if (!ret) {
+    /* The search does not continue for this element */
+    return;
+  }
+
+  if (queries != NULL) {
+    /* Call the query callback for all active queries and collect the
+     * ones that remain active for the children */
+    sc_array_init (&new_active_queries, sizeof (size_t));
+    for (iquery = 0; iquery < active_queries->elem_count; iquery++) {
+      query_index = *(size_t *) sc_array_index (active_queries, iquery);
+      ret = query_fn (forest, ltreeid, element, leaf_elements, user_data,
+                      element_leaf_index,
+                      sc_array_index (queries, query_index), query_index);
+      if (ret && !is_leaf) {
+        *(size_t *) sc_array_push (&new_active_queries) = query_index;
       }
     }
-    /* clean-up */
-    ts->t8_element_destroy (num_children, children);
-    T8_FREE (children);
-    T8_FREE (split_offsets);
+    if (new_active_queries.elem_count == 0) {
+      /* No query is active anymore, we do not continue */
+      sc_array_reset (&new_active_queries);
+      return;
+    }
+  }
+  if (is_leaf) {
+    return;
+  }
+
+  /* Enter the recursion */
+  /* We compute all children of E, compute their leaf arrays and
+   * call search_recursion */
+  /* allocate the memory to store the children */
+  num_children = t8_default_call_num_children (ts, element);
+  children = T8_ALLOC (t8_element_t *, num_children);
+  t8_default_call_new (ts, num_children, children);
+  /* Memory for the indices that split the leaf_elements array */
+  split_offsets = T8_ALLOC (size_t, num_children + 1);
+  /* Compute the children */
+  t8_default_call_children (ts, element, num_children, children);
+  /* Split the leafs array in portions belonging to the children of element */
+  t8_forest_split_array_scheme (element, leaf_elements, split_offsets, ts);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    /* Check if there are any leaf elements for this child */
+    indexa = split_offsets[ichild];     /* first leaf of this child */
+    indexb = split_offsets[ichild + 1]; /* first leaf of next child */
+    if (indexa < indexb) {
+      /* There exist leafs of this child in leaf_elements,
+       * we construct an array of these leafs */
+      t8_element_array_init_view (&child_leafs, leaf_elements, indexa,
+                                  indexb - indexa);
+      /* Enter the recursion */
+      t8_forest_search_recursion (forest, ltreeid, eclass, children[ichild],
+                                  ts, &child_leafs,
+                                  indexa + tree_lindex_of_first_leaf,
+                                  search_fn, query_fn, queries,
+                                  queries != NULL ? &new_active_queries :
+                                  NULL, user_data);
+    }
+  }
+  /* clean-up */
+  t8_default_call_destroy (ts, num_children, children);
+  T8_FREE (children);
+  T8_FREE (split_offsets);
+  if (queries != NULL) {
+    sc_array_reset (&new_active_queries);
   }
 }
 
-/* Perform a top-down search in one tree of the forest */
-static void
+/* Perform a top-down search in one tree of the forest.
+ * ts must be the scheme of the tree. */
+template < class TScheme > static void
 t8_forest_search_tree (t8_forest_t forest, t8_locidx_t ltreeid,
-                       t8_forest_search_query_fn search_fn, void *user_data)
+                       TScheme * ts, t8_forest_search_query_fn search_fn,
+                       t8_forest_query_fn query_fn, sc_array_t * queries,
+                       void *user_data)
 {
   t8_eclass_t         eclass;
-  t8_eclass_scheme_c *ts;
   t8_element_t       *nca, *first_el, *last_el;
   t8_element_array_t *leaf_elements;
+  sc_array_t          active_queries;
+  size_t              iquery;
 
-  /* Get the element class, scheme and leaf elements of this tree */
+  /* Get the element class and leaf elements of this tree */
   eclass = t8_forest_get_eclass (forest, ltreeid);
-  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  T8_ASSERT (ts == t8_forest_get_eclass_scheme (forest, eclass));
   leaf_elements = t8_forest_tree_get_leafs (forest, ltreeid);
 
-  /* assert for empty tree */
-  T8_ASSERT (t8_element_array_get_count (leaf_elements) >= 0);
+  if (t8_element_array_get_count (leaf_elements) == 0) {
+    /* This tree is empty */
+    return;
+  }
   /* Get the first and last leaf of this tree */
   first_el = t8_element_array_index_locidx (leaf_elements, 0);
   last_el =
@@ -290,22 +378,1177 @@ t8_forest_search_tree (t8_forest_t forest, t8_locidx_t ltreeid,
                                    t8_element_array_get_count (leaf_elements)
                                    - 1);
   /* Compute their nearest common ancestor */
-  ts->t8_element_new (1, &nca);
-  ts->t8_element_nca (first_el, last_el, nca);
+  t8_default_call_new (ts, 1, &nca);
+  t8_default_call_nca (ts, first_el, last_el, nca);
+
+  if (queries != NULL) {
+    /* Initially all queries are active */
+    sc_array_init_size (&active_queries, sizeof (size_t),
+                        queries->elem_count);
+    for (iquery = 0; iquery < queries->elem_count; iquery++) {
+      *(size_t *) sc_array_index (&active_queries, iquery) = iquery;
+    }
+  }
   /* Start the top-down search */
   t8_forest_search_recursion (forest, ltreeid, eclass, nca, ts, leaf_elements,
-                              0, search_fn, user_data);
+                              0, search_fn, query_fn, queries,
+                              queries != NULL ? &active_queries : NULL,
+                              user_data);
+  /* clean-up */
+  if (queries != NULL) {
+    sc_array_reset (&active_queries);
+  }
+  t8_default_call_destroy (ts, 1, &nca);
 }
 
+/* Functor passed to t8_default_scheme_dispatch to call
+ * t8_forest_search_tree with the scheme of the current tree. */
+struct t8_forest_search_tree_functor
+{
+  t8_forest_t         forest;
+  t8_locidx_t         ltreeid;
+  t8_forest_search_query_fn search_fn;
+  t8_forest_query_fn  query_fn;
+  sc_array_t         *queries;
+  void               *user_data;
+
+  template < class TScheme > void operator () (TScheme * ts)
+  {
+    t8_forest_search_tree (forest, ltreeid, ts, search_fn, query_fn,
+                           queries, user_data);
+  }
+};
+
+T8_EXTERN_C_BEGIN ();
+
 void
 t8_forest_search (t8_forest_t forest, t8_forest_search_query_fn search_fn,
                   void *user_data)
 {
+  t8_forest_search_ext (forest, search_fn, NULL, NULL, user_data);
+}
+
+void
+t8_forest_search_ext (t8_forest_t forest,
+                      t8_forest_search_query_fn search_fn,
+                      t8_forest_query_fn query_fn, sc_array_t * queries,
+                      void *user_data)
+{
+  t8_locidx_t         num_local_trees, itree;
+  t8_forest_search_tree_functor search_tree;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (search_fn != NULL || queries != NULL);
+  T8_ASSERT (queries == NULL || query_fn != NULL);
+
+  if (queries != NULL && queries->elem_count == 0) {
+    /* There is nothing to search for */
+    return;
+  }
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  search_tree.forest = forest;
+  search_tree.search_fn = search_fn;
+  search_tree.query_fn = query_fn;
+  search_tree.queries = queries;
+  search_tree.user_data = user_data;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    search_tree.ltreeid = itree;
+    /* Search the tree with the scheme specialized for its element class */
+    t8_default_scheme_dispatch (t8_forest_get_eclass_scheme
+                                (forest,
+                                 t8_forest_get_eclass (forest, itree)),
+                                search_tree);
+  }
+}
+
+/* The data that we pass to the callbacks of t8_forest_locate_points */
+typedef struct
+{
+  double              tolerance;        /* Tolerance for the inside check */
+  t8_locidx_t        *element_indices;  /* The output array */
+  double              bbox_min[3];      /* Bounding box of the current element */
+  double              bbox_max[3];
+} t8_forest_locate_points_data_t;
+
+/* The search callback of t8_forest_locate_points.
+ * Compute the (enlarged) bounding box of the current element, such
+ * that the query callback can check all active points against it. */
+static int
+t8_forest_locate_points_element_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                                    const t8_element_t * element,
+                                    t8_element_array_t * leaf_elements,
+                                    void *user_data,
+                                    t8_locidx_t tree_leaf_index)
+{
+  t8_forest_locate_points_data_t *data =
+    (t8_forest_locate_points_data_t *) user_data;
+  t8_eclass_scheme_c *ts;
+  double             *tree_vertices, coords[3], width;
+  int                 num_corners, icorner, i;
+
+  tree_vertices = t8_forest_get_tree_vertices (forest, ltreeid);
+  if (t8_forest_get_tree_class (forest, ltreeid) == T8_ECLASS_VERTEX) {
+    for (i = 0; i < 3; i++) {
+      data->bbox_min[i] = tree_vertices[i] - data->tolerance;
+      data->bbox_max[i] = tree_vertices[i] + data->tolerance;
+    }
+    return 1;
+  }
+  ts = t8_element_array_get_scheme (leaf_elements);
+  num_corners = ts->t8_element_num_corners (element);
+  /* The element is contained in the convex hull of its corners */
+  for (icorner = 0; icorner < num_corners; icorner++) {
+    t8_forest_element_coordinate (forest, ltreeid, element, tree_vertices,
+                                  icorner, coords);
+    for (i = 0; i < 3; i++) {
+      if (icorner == 0 || coords[i] < data->bbox_min[i]) {
+        data->bbox_min[i] = coords[i];
+      }
+      if (icorner == 0 || coords[i] > data->bbox_max[i]) {
+        data->bbox_max[i] = coords[i];
+      }
+    }
+  }
+  /* Enlarge the bounding box by the tolerance */
+  width = 0;
+  for (i = 0; i < 3; i++) {
+    width = SC_MAX (width, data->bbox_max[i] - data->bbox_min[i]);
+  }
+  for (i = 0; i < 3; i++) {
+    data->bbox_min[i] -= data->tolerance * width;
+    data->bbox_max[i] += data->tolerance * width;
+  }
+  return 1;
+}
+
+/* The query callback of t8_forest_locate_points.
+ * For non-leaf elements we check the point against the bounding box,
+ * for leafs we perform the exact inside test. */
+static int
+t8_forest_locate_points_query_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                                  const t8_element_t * element,
+                                  t8_element_array_t * leaf_elements,
+                                  void *user_data,
+                                  t8_locidx_t tree_leaf_index, void *query,
+                                  size_t query_index)
+{
+  t8_forest_locate_points_data_t *data =
+    (t8_forest_locate_points_data_t *) user_data;
+  const double       *point = (const double *) query;
+  int                 i;
+
+  if (data->element_indices[query_index] >= 0) {
+    /* This point was already found in another element */
+    return 0;
+  }
+  for (i = 0; i < 3; i++) {
+    if (point[i] < data->bbox_min[i] || point[i] > data->bbox_max[i]) {
+      return 0;
+    }
+  }
+  if (tree_leaf_index >= 0) {
+    /* The element is a leaf, we check whether the point is inside */
+    if (t8_forest_element_point_inside (forest, ltreeid, element,
+                                        t8_forest_get_tree_vertices (forest,
+                                                                     ltreeid),
+                                        point, data->tolerance)) {
+      data->element_indices[query_index] =
+        t8_forest_get_tree_element_offset (forest, ltreeid) + tree_leaf_index;
+    }
+  }
+  return 1;
+}
+
+void
+t8_forest_locate_points (t8_forest_t forest, const double *points,
+                         size_t num_points, double tolerance,
+                         t8_locidx_t * element_indices)
+{
+  t8_forest_locate_points_data_t data;
+  sc_array_t          queries;
+  size_t              ipoint;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (num_points == 0 || (points != NULL && element_indices != NULL));
+  T8_ASSERT (tolerance >= 0);
+
+  for (ipoint = 0; ipoint < num_points; ipoint++) {
+    element_indices[ipoint] = -1;
+  }
+  if (num_points == 0) {
+    return;
+  }
+  data.tolerance = tolerance;
+  data.element_indices = element_indices;
+  /* View the points as an array of queries */
+  sc_array_init_data (&queries, (void *) points, 3 * sizeof (double),
+                      num_points);
+  t8_forest_search_ext (forest, t8_forest_locate_points_element_fn,
+                        t8_forest_locate_points_query_fn, &queries, &data);
+}
+
+/* The recursion of t8_forest_search_partition.
+ * element is an element of the global tree gtreeid whose descendants are
+ * owned by the processes pfirst, ..., plast.
+ * The search stops at an element if either a callback returns false for it
+ * or if it is owned by a single process.
+ * If the class of the tree is not known, element and ts are NULL and the
+ * search stops after the callbacks for the whole tree. */
+static void
+t8_forest_search_partition_recursion (t8_forest_t forest,
+                                      t8_gloidx_t gtreeid,
+                                      t8_eclass_t eclass,
+                                      const t8_element_t * element,
+                                      t8_eclass_scheme_c * ts,
+                                      int pfirst, int plast,
+                                      t8_forest_partition_search_fn
+                                      search_fn,
+                                      t8_forest_partition_query_fn query_fn,
+                                      sc_array_t * queries,
+                                      sc_array_t * active_queries,
+                                      void *user_data)
+{
+  t8_element_t      **children;
+  int                 num_children, ichild;
+  int                 child_pfirst, child_plast;
+  size_t              iquery, query_index;
+  sc_array_t          new_active_queries;
+  int                 ret;
+
+  T8_ASSERT (0 <= pfirst && pfirst <= plast && plast < forest->mpisize);
+
+  ret = search_fn == NULL ? 1 :
+    search_fn (forest, gtreeid, element, eclass, pfirst, plast, user_data);
+  if (!ret) {
+    /* The search does not continue for this element */
+    return;
+  }
+  if (queries != NULL) {
+    /* Call the query callback for all active queries and collect the
+     * ones that remain active for the children */
+    sc_array_init (&new_active_queries, sizeof (size_t));
+    for (iquery = 0; iquery < active_queries->elem_count; iquery++) {
+      query_index = *(size_t *) sc_array_index (active_queries, iquery);
+      ret = query_fn (forest, gtreeid, element, eclass, pfirst, plast,
+                      user_data, sc_array_index (queries, query_index),
+                      query_index);
+      if (ret && pfirst < plast) {
+        *(size_t *) sc_array_push (&new_active_queries) = query_index;
+      }
+    }
+    if (new_active_queries.elem_count == 0) {
+      /* No query is active anymore, we do not continue */
+      sc_array_reset (&new_active_queries);
+      return;
+    }
+  }
+  if (pfirst == plast || element == NULL) {
+    /* The element is owned by a single process or we cannot construct its
+     * children, we do not refine further */
+    if (queries != NULL) {
+      sc_array_reset (&new_active_queries);
+    }
+    return;
+  }
+
+  /* Enter the recursion */
+  num_children = ts->t8_element_num_children (element);
+  children = T8_ALLOC (t8_element_t *, num_children);
+  ts->t8_element_new (num_children, children);
+  ts->t8_element_children (element, num_children, children);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    /* Compute the owners of the child. They must be in the range of
+     * element's owners. */
+    child_pfirst = pfirst;
+    child_plast = plast;
+    t8_forest_element_owners_bounds (forest, gtreeid, children[ichild],
+                                     eclass, &child_pfirst, &child_plast);
+    t8_forest_search_partition_recursion (forest, gtreeid, eclass,
+                                          children[ichild], ts,
+                                          child_pfirst, child_plast,
+                                          search_fn, query_fn, queries,
+                                          queries != NULL ?
+                                          &new_active_queries : NULL,
+                                          user_data);
+  }
+  /* clean-up */
+  ts->t8_element_destroy (num_children, children);
+  T8_FREE (children);
+  if (queries != NULL) {
+    sc_array_reset (&new_active_queries);
+  }
+}
+
+void
+t8_forest_search_partition (t8_forest_t forest,
+                            t8_forest_partition_search_fn search_fn,
+                            t8_forest_partition_query_fn query_fn,
+                            sc_array_t * queries, void *user_data)
+{
+  t8_cmesh_t          cmesh;
+  t8_locidx_t         num_local_ctrees, ictree;
+  t8_gloidx_t         gtreeid, *tree_offsets;
+  t8_eclass_t         eclass;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *root;
+  sc_array_t          active_queries;
+  size_t              iquery;
+  int                 pfirst, plast, some_owner;
+  int                 create_element_offsets = 0, create_tree_offsets = 0;
+  int                 create_first_desc = 0;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (search_fn != NULL || queries != NULL);
+  T8_ASSERT (queries == NULL || query_fn != NULL);
+
+  if (queries != NULL && queries->elem_count == 0) {
+    /* There is nothing to search for */
+    return;
+  }
+  if (t8_forest_get_global_num_elements (forest) == 0) {
+    /* The forest is empty and has no owners */
+    return;
+  }
+  /* The owner computations need the partition tables of the forest */
+  if (forest->element_offsets == NULL) {
+    create_element_offsets = 1;
+    t8_forest_partition_create_offsets (forest);
+  }
+  if (forest->tree_offsets == NULL) {
+    create_tree_offsets = 1;
+    t8_forest_partition_create_tree_offsets (forest);
+  }
+  if (forest->global_first_desc == NULL) {
+    create_first_desc = 1;
+    t8_forest_partition_create_first_desc (forest);
+  }
+
+  if (queries != NULL) {
+    /* Initially all queries are active */
+    sc_array_init_size (&active_queries, sizeof (size_t),
+                        queries->elem_count);
+    for (iquery = 0; iquery < queries->elem_count; iquery++) {
+      *(size_t *) sc_array_index (&active_queries, iquery) = iquery;
+    }
+  }
+
+  /* Iterate over all global trees. If the cmesh is partitioned, we do not
+   * know the class of trees that are neither local nor ghost trees in it.
+   * For these we only compute the owners of the whole tree from the tree
+   * offsets of the forest. */
+  cmesh = t8_forest_get_cmesh (forest);
+  num_local_ctrees = t8_cmesh_get_num_local_trees (cmesh);
+  tree_offsets = t8_shmem_array_get_gloidx_array (forest->tree_offsets);
+  for (gtreeid = 0; gtreeid < forest->global_num_trees; gtreeid++) {
+    ictree = t8_cmesh_get_local_id (cmesh, gtreeid);
+    if (ictree < 0) {
+      /* The class of this tree is unknown */
+      some_owner = -1;
+      pfirst = t8_offset_first_owner_of_tree (forest->mpisize, gtreeid,
+                                              tree_offsets, &some_owner);
+      plast = t8_offset_last_owner_of_tree (forest->mpisize, gtreeid,
+                                            tree_offsets, &some_owner);
+      t8_forest_search_partition_recursion (forest, gtreeid,
+                                            T8_ECLASS_COUNT, NULL, NULL,
+                                            pfirst, plast, search_fn,
+                                            query_fn, queries,
+                                            queries != NULL ? &active_queries
+                                            : NULL, user_data);
+      continue;
+    }
+    eclass = ictree < num_local_ctrees ?
+      t8_cmesh_get_tree_class (cmesh, ictree) :
+      t8_cmesh_get_ghost_class (cmesh, ictree - num_local_ctrees);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    /* Construct the root element of this tree and compute its owners */
+    ts->t8_element_new (1, &root);
+    ts->t8_element_set_linear_id (root, 0, 0);
+    pfirst = 0;
+    plast = forest->mpisize - 1;
+    t8_forest_element_owners_bounds (forest, gtreeid, root, eclass, &pfirst,
+                                     &plast);
+    t8_forest_search_partition_recursion (forest, gtreeid, eclass, root, ts,
+                                          pfirst, plast, search_fn,
+                                          query_fn, queries,
+                                          queries != NULL ? &active_queries
+                                          : NULL, user_data);
+    ts->t8_element_destroy (1, &root);
+  }
+
+  /* clean-up */
+  if (queries != NULL) {
+    sc_array_reset (&active_queries);
+  }
+  if (create_element_offsets) {
+    t8_shmem_array_destroy (&forest->element_offsets);
+  }
+  if (create_tree_offsets) {
+    t8_shmem_array_destroy (&forest->tree_offsets);
+  }
+  if (create_first_desc) {
+    t8_shmem_array_destroy (&forest->global_first_desc);
+  }
+}
+
+/* The data passed to t8_forest_leaf_neighbors_face_fn */
+typedef struct
+{
+  sc_array_t         *neighbors;        /* The array of found neighbor leafs */
+  t8_locidx_t         index_offset;     /* Index of the first leaf of the tree */
+  int                 is_ghost;         /* True if the leafs are ghosts */
+} t8_forest_leaf_neighbors_data_t;
+
+/* Callback for t8_forest_iterate_faces_recursion that stores all leafs
+ * at the face in an array. */
+static int
+t8_forest_leaf_neighbors_face_fn (t8_forest_t forest, t8_locidx_t ltreeid,
+                                  const t8_element_t * element, int face,
+                                  void *user_data,
+                                  t8_locidx_t tree_leaf_index)
+{
+  t8_forest_leaf_neighbors_data_t *data =
+    (t8_forest_leaf_neighbors_data_t *) user_data;
+  t8_forest_iter_face_side_t *neighbor;
+
+  if (tree_leaf_index >= 0) {
+    /* This is a leaf at the face */
+    neighbor = (t8_forest_iter_face_side_t *) sc_array_push (data->neighbors);
+    neighbor->treeid = ltreeid;
+    neighbor->element = element;
+    neighbor->element_index = data->index_offset + tree_leaf_index;
+    neighbor->face = face;
+    neighbor->is_ghost = data->is_ghost;
+  }
+  /* Continue the recursion */
+  return 1;
+}
+
+/* Find all leafs in the sorted array leaf_elements that touch the face
+ * dual_face of neighbor and append them to neighbors.
+ * neighbor and the workspace element desc are elements of the same scheme
+ * as leaf_elements.
+ * These leafs are either one ancestor of neighbor (or neighbor itself)
+ * or descendants of neighbor. */
+static void
+t8_forest_leaf_neighbors_in_array (t8_forest_t forest, t8_locidx_t treeid,
+                                   int is_ghost,
+                                   t8_element_array_t * leaf_elements,
+                                   t8_locidx_t index_offset,
+                                   const t8_element_t * neighbor,
+                                   int dual_face, t8_element_t * desc,
+                                   sc_array_t * neighbors)
+{
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *leaf;
+  t8_forest_iter_face_side_t *neighbor_side;
+  t8_forest_leaf_neighbors_data_t data;
+  t8_element_array_t  face_leafs;
+  t8_linearidx_t      first_id, last_id, leaf_id;
+  t8_locidx_t         lower, upper;
+  int                 neigh_level, leaf_level;
+
+  if (t8_element_array_get_count (leaf_elements) == 0) {
+    return;
+  }
+  ts = t8_element_array_get_scheme (leaf_elements);
+  neigh_level = ts->t8_element_level (neighbor);
+  /* Compute the linear ids of the first and last descendant of neighbor */
+  first_id = ts->t8_element_get_linear_id (neighbor, forest->maxlevel);
+  ts->t8_element_last_descendant (neighbor, desc, forest->maxlevel);
+  last_id = ts->t8_element_get_linear_id (desc, forest->maxlevel);
+
+  /* The last leaf whose first descendant is not bigger than neighbor's */
+  lower = t8_forest_bin_search_lower (leaf_elements, first_id,
+                                      forest->maxlevel);
+  if (lower >= 0) {
+    leaf = t8_element_array_index_locidx (leaf_elements, lower);
+    leaf_level = ts->t8_element_level (leaf);
+    ts->t8_element_last_descendant (leaf, desc, forest->maxlevel);
+    if (leaf_level <= neigh_level
+        && ts->t8_element_get_linear_id (desc, forest->maxlevel) >= first_id) {
+      /* The leaf is an ancestor of neighbor or neighbor itself.
+       * We compute the face of the leaf by climbing up from neighbor. */
+      ts->t8_element_copy (neighbor, desc);
+      while (ts->t8_element_level (desc) > leaf_level) {
+        dual_face = ts->t8_element_face_parent_face (desc, dual_face);
+        T8_ASSERT (dual_face >= 0);
+        ts->t8_element_parent (desc, desc);
+      }
+      neighbor_side =
+        (t8_forest_iter_face_side_t *) sc_array_push (neighbors);
+      neighbor_side->treeid = treeid;
+      neighbor_side->element = leaf;
+      neighbor_side->element_index = index_offset + lower;
+      neighbor_side->face = dual_face;
+      neighbor_side->is_ghost = is_ghost;
+      return;
+    }
+    leaf_id = ts->t8_element_get_linear_id (leaf, forest->maxlevel);
+    if (leaf_id < first_id) {
+      /* This leaf is before neighbor */
+      lower++;
+    }
+  }
+  else {
+    lower = 0;
+  }
+  /* The leafs lower, ..., upper - 1 are the descendants of neighbor */
+  upper = t8_forest_bin_search_lower (leaf_elements, last_id,
+                                      forest->maxlevel) + 1;
+  if (lower >= upper) {
+    /* There are no leafs in neighbor */
+    return;
+  }
+  /* Collect the descendants of neighbor at the face */
+  t8_element_array_init_view (&face_leafs, leaf_elements, lower,
+                              upper - lower);
+  data.neighbors = neighbors;
+  data.index_offset = index_offset;
+  data.is_ghost = is_ghost;
+  t8_forest_iterate_faces_recursion (forest, treeid, neighbor, dual_face,
+                                     &face_leafs, &data, lower,
+                                     t8_forest_leaf_neighbors_face_fn);
+}
+
+void
+t8_forest_leaf_face_neighbors_all (t8_forest_t forest, t8_locidx_t ltreeid,
+                                   const t8_element_t * leaf, int face,
+                                   sc_array_t * neighbors)
+{
+  t8_eclass_t         neigh_class;
+  t8_eclass_scheme_c *neigh_scheme;
+  t8_element_t       *neighbor, *desc;
+  t8_gloidx_t         gneigh_treeid;
+  t8_locidx_t         lneigh_treeid, lghost_treeid;
+  int                 dual_face;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (0 <= ltreeid
+             && ltreeid < t8_forest_get_num_local_trees (forest));
+  T8_ASSERT (neighbors->elem_size == sizeof (t8_forest_iter_face_side_t));
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "Ghost structure is needed for face neighbor leafs "
+                  "but was not found in forest.\n");
+
+  /* Compute the same level face neighbor of leaf */
+  neigh_class =
+    t8_forest_element_neighbor_eclass (forest, ltreeid, leaf, face);
+  neigh_scheme = t8_forest_get_eclass_scheme (forest, neigh_class);
+  neigh_scheme->t8_element_new (1, &neighbor);
+  neigh_scheme->t8_element_new (1, &desc);
+  gneigh_treeid =
+    t8_forest_element_face_neighbor (forest, ltreeid, leaf, neighbor,
+                                     neigh_scheme, face, &dual_face);
+  if (gneigh_treeid >= 0) {
+    /* The leafs at the face may be local elements, ghost elements or both */
+    lneigh_treeid = t8_forest_get_local_id (forest, gneigh_treeid);
+    if (lneigh_treeid >= 0) {
+      t8_forest_leaf_neighbors_in_array (forest, lneigh_treeid, 0,
+                                         t8_forest_get_tree_element_array
+                                         (forest, lneigh_treeid),
+                                         t8_forest_get_tree_element_offset
+                                         (forest, lneigh_treeid), neighbor,
+                                         dual_face, desc, neighbors);
+    }
+    if (forest->ghosts != NULL) {
+      lghost_treeid =
+        t8_forest_ghost_get_ghost_treeid (forest, gneigh_treeid);
+      if (lghost_treeid >= 0) {
+        t8_forest_leaf_neighbors_in_array (forest, lghost_treeid, 1,
+                                           t8_forest_ghost_get_tree_elements
+                                           (forest, lghost_treeid),
+                                           t8_forest_get_num_element (forest)
+                                           +
+                                           t8_forest_ghost_get_tree_element_offset
+                                           (forest, lghost_treeid), neighbor,
+                                           dual_face, desc, neighbors);
+      }
+    }
+  }
+  neigh_scheme->t8_element_destroy (1, &neighbor);
+  neigh_scheme->t8_element_destroy (1, &desc);
+}
+
+/* The work memory of t8_forest_iterate for the elements of one class.
+ * All buffers have one row for each level below the maximum level and
+ * store the children of an element of this level. Thus the recursion
+ * never overwrites elements or offsets that are still in use.
+ * The buffers at the faces exist twice, for the two sides of a face. */
+typedef struct
+{
+  int                 maxlevel; /* The maximum level of the class */
+  int                 num_children;     /* The number of children of an element */
+  int                 num_face_children;        /* The maximum number of children at a face */
+  t8_element_t       *root[2];  /* The root elements of the two sides of a tree face */
+  t8_element_t       *neighbor; /* The neighbor of a child inside its parent */
+  t8_element_t      **children; /* The children in the volume recursion */
+  size_t             *child_offsets;    /* Their offsets in the local and ghost leafs */
+  t8_element_t      **face_children[2]; /* The children at a face */
+  int                *child_indices[2]; /* Their child ids */
+  size_t             *face_offsets[2];  /* The offsets of all children in the leafs */
+} t8_forest_iterate_buffers_t;
+
+/* The state of t8_forest_iterate */
+typedef struct
+{
+  t8_forest_iter_face_fn face_fn;
+  void               *user_data;
+  t8_forest_iterate_buffers_t *buffers[T8_ECLASS_COUNT];
+  t8_element_t       *face_elements[T8_ECLASS_COUNT];   /* Face elements across trees */
+} t8_forest_iterate_context_t;
+
+/* One side of a face in t8_forest_iterate: An element of a tree together
+ * with the local leafs and the ghost leafs of the tree that are descendants
+ * of the element. */
+typedef struct
+{
+  t8_eclass_scheme_c *ts;       /* The scheme of the tree */
+  const t8_element_t *element;  /* The element */
+  int                 level;    /* The level of element */
+  int                 face;     /* The face of element */
+  t8_element_array_t  leafs[2]; /* The local and the ghost leafs in element */
+  t8_locidx_t         treeid[2];        /* The local id and the ghost id of the tree, or -1 */
+  t8_locidx_t         first_index[2];   /* The element index of the first leaf in leafs */
+} t8_forest_iterate_side_t;
+
+/* Return the buffers for the class of ts.
+ * They are allocated when they are first used. */
+static t8_forest_iterate_buffers_t *
+t8_forest_iterate_get_buffers (t8_forest_iterate_context_t * context,
+                               t8_eclass_scheme_c * ts)
+{
+  t8_forest_iterate_buffers_t *buffers;
+  int                 iface, iside, num_rows;
+
+  buffers = context->buffers[ts->eclass];
+  if (buffers != NULL) {
+    return buffers;
+  }
+  buffers = T8_ALLOC (t8_forest_iterate_buffers_t, 1);
+  ts->t8_element_new (2, buffers->root);
+  ts->t8_element_set_linear_id (buffers->root[0], 0, 0);
+  ts->t8_element_new (1, &buffers->neighbor);
+  buffers->maxlevel = ts->t8_element_maxlevel ();
+  buffers->num_children = ts->t8_element_num_children (buffers->root[0]);
+  buffers->num_face_children = 0;
+  for (iface = 0; iface < ts->t8_element_num_faces (buffers->root[0]);
+       iface++) {
+    buffers->num_face_children =
+      SC_MAX (buffers->num_face_children,
+              ts->t8_element_num_face_children (buffers->root[0], iface));
+  }
+  num_rows = buffers->maxlevel;
+  buffers->children =
+    T8_ALLOC (t8_element_t *, num_rows * buffers->num_children);
+  ts->t8_element_new (num_rows * buffers->num_children, buffers->children);
+  buffers->child_offsets =
+    T8_ALLOC (size_t, num_rows * 2 * (buffers->num_children + 1));
+  for (iside = 0; iside < 2; iside++) {
+    buffers->face_children[iside] =
+      T8_ALLOC (t8_element_t *, num_rows * buffers->num_face_children);
+    ts->t8_element_new (num_rows * buffers->num_face_children,
+                        buffers->face_children[iside]);
+    buffers->child_indices[iside] =
+      T8_ALLOC (int, num_rows * buffers->num_face_children);
+    buffers->face_offsets[iside] =
+      T8_ALLOC (size_t, num_rows * 2 * (buffers->num_children + 1));
+  }
+  context->buffers[ts->eclass] = buffers;
+  return buffers;
+}
+
+static void
+t8_forest_iterate_destroy_buffers (t8_forest_iterate_buffers_t * buffers,
+                                   t8_eclass_scheme_c * ts)
+{
+  int                 iside, num_rows = buffers->maxlevel;
+
+  ts->t8_element_destroy (2, buffers->root);
+  ts->t8_element_destroy (1, &buffers->neighbor);
+  ts->t8_element_destroy (num_rows * buffers->num_children,
+                          buffers->children);
+  T8_FREE (buffers->children);
+  T8_FREE (buffers->child_offsets);
+  for (iside = 0; iside < 2; iside++) {
+    ts->t8_element_destroy (num_rows * buffers->num_face_children,
+                            buffers->face_children[iside]);
+    T8_FREE (buffers->face_children[iside]);
+    T8_FREE (buffers->child_indices[iside]);
+    T8_FREE (buffers->face_offsets[iside]);
+  }
+  T8_FREE (buffers);
+}
+
+/* Initialize a side with the root element of a global tree and all local
+ * and ghost leafs of this tree. */
+static void
+t8_forest_iterate_side_init_tree (t8_forest_t forest,
+                                  t8_forest_iterate_side_t * side,
+                                  t8_eclass_scheme_c * ts,
+                                  const t8_element_t * root,
+                                  t8_gloidx_t gtreeid, int face)
+{
+  t8_element_array_t *leafs;
+  t8_locidx_t         ltreeid, lghost_treeid;
+
+  side->ts = ts;
+  side->element = root;
+  side->level = 0;
+  side->face = face;
+  ltreeid = t8_forest_get_local_id (forest, gtreeid);
+  if (ltreeid >= 0) {
+    leafs = t8_forest_get_tree_element_array (forest, ltreeid);
+    t8_element_array_init_view (&side->leafs[0], leafs, 0,
+                                t8_element_array_get_count (leafs));
+    side->first_index[0] = t8_forest_get_tree_element_offset (forest,
+                                                              ltreeid);
+  }
+  else {
+    t8_element_array_init (&side->leafs[0], ts);
+    side->first_index[0] = 0;
+  }
+  side->treeid[0] = ltreeid;
+  lghost_treeid = forest->ghosts == NULL ? -1 :
+    t8_forest_ghost_get_ghost_treeid (forest, gtreeid);
+  if (lghost_treeid >= 0) {
+    leafs = t8_forest_ghost_get_tree_elements (forest, lghost_treeid);
+    t8_element_array_init_view (&side->leafs[1], leafs, 0,
+                                t8_element_array_get_count (leafs));
+    side->first_index[1] = t8_forest_get_num_element (forest)
+      + t8_forest_ghost_get_tree_element_offset (forest, lghost_treeid);
+  }
+  else {
+    t8_element_array_init (&side->leafs[1], ts);
+    side->first_index[1] = 0;
+  }
+  side->treeid[1] = lghost_treeid;
+}
+
+/* Return the number of local and ghost leafs of a side */
+static              size_t
+t8_forest_iterate_side_count (t8_forest_iterate_side_t * side)
+{
+  return t8_element_array_get_count (&side->leafs[0])
+    + t8_element_array_get_count (&side->leafs[1]);
+}
+
+/* If the element of a side is a leaf, return it and set view to 0 if it is
+ * a local leaf and to 1 if it is a ghost. Otherwise return NULL. */
+static const t8_element_t *
+t8_forest_iterate_side_leaf (t8_forest_iterate_side_t * side, int *view)
+{
+  const t8_element_t *leaf;
+
+  if (t8_forest_iterate_side_count (side) != 1) {
+    return NULL;
+  }
+  *view = t8_element_array_get_count (&side->leafs[0]) == 1 ? 0 : 1;
+  leaf = t8_element_array_index_locidx (&side->leafs[*view], 0);
+  /* The only leaf is a descendant of the element or the element itself */
+  return side->ts->t8_element_level (leaf) == side->level ? leaf : NULL;
+}
+
+/* Split the local and ghost leafs of a side according to the children of
+ * its element. The offsets of each child in the local leafs are stored in
+ * the first num_children + 1 entries of offsets, those in the ghost leafs
+ * in the next num_children + 1 entries. */
+static void
+t8_forest_iterate_side_split (t8_forest_iterate_side_t * side,
+                              int num_children, size_t * offsets)
+{
+  int                 view, ichild;
+
+  for (view = 0; view < 2; view++) {
+    if (t8_element_array_get_count (&side->leafs[view]) > 0) {
+      t8_forest_split_array (side->element, &side->leafs[view],
+                             offsets + view * (num_children + 1));
+    }
+    else {
+      for (ichild = 0; ichild <= num_children; ichild++) {
+        offsets[view * (num_children + 1) + ichild] = 0;
+      }
+    }
+  }
+}
+
+/* Initialize the side of a child of the element of a side.
+ * offsets are the offsets computed by t8_forest_iterate_side_split. */
+static void
+t8_forest_iterate_side_child (t8_forest_iterate_side_t * side,
+                              int num_children, const size_t * offsets,
+                              int ichild, const t8_element_t * child,
+                              int face, t8_forest_iterate_side_t * child_side)
+{
+  const size_t       *view_offsets;
+  int                 view;
+
+  child_side->ts = side->ts;
+  child_side->element = child;
+  child_side->level = side->level + 1;
+  child_side->face = face;
+  for (view = 0; view < 2; view++) {
+    view_offsets = offsets + view * (num_children + 1);
+    t8_element_array_init_view (&child_side->leafs[view], &side->leafs[view],
+                                view_offsets[ichild],
+                                view_offsets[ichild + 1] -
+                                view_offsets[ichild]);
+    child_side->treeid[view] = side->treeid[view];
+    child_side->first_index[view] =
+      side->first_index[view] + view_offsets[ichild];
+  }
+}
+
+/* Call the face callback for a leaf of side and a leaf of neighbor_side,
+ * or for a leaf at the domain boundary if neighbor_side is NULL.
+ * The first side passed to the callback is a local leaf. If both leafs
+ * are local, it is the finer one or for leafs of the same level the one
+ * with the smaller index. */
+static void
+t8_forest_iterate_visit (t8_forest_t forest,
+                         t8_forest_iterate_context_t * context,
+                         t8_forest_iterate_side_t * side,
+                         const t8_element_t * leaf, int view,
+                         t8_forest_iterate_side_t * neighbor_side,
+                         const t8_element_t * neighbor_leaf,
+                         int neighbor_view)
+{
+  t8_forest_iter_face_side_t sides[2];
+  int                 first;
+
+  sides[0].treeid = side->treeid[view];
+  sides[0].element = leaf;
+  sides[0].element_index = side->first_index[view];
+  sides[0].face = side->face;
+  sides[0].is_ghost = view;
+  if (neighbor_side == NULL) {
+    if (!sides[0].is_ghost) {
+      context->face_fn (forest, &sides[0], NULL, context->user_data);
+    }
+    return;
+  }
+  sides[1].treeid = neighbor_side->treeid[neighbor_view];
+  sides[1].element = neighbor_leaf;
+  sides[1].element_index = neighbor_side->first_index[neighbor_view];
+  sides[1].face = neighbor_side->face;
+  sides[1].is_ghost = neighbor_view;
+  if (sides[0].is_ghost && sides[1].is_ghost) {
+    /* This face is not adjacent to a local leaf */
+    return;
+  }
+  if (sides[0].is_ghost || sides[1].is_ghost) {
+    first = sides[0].is_ghost;
+  }
+  else if (side->level != neighbor_side->level) {
+    first = neighbor_side->level > side->level;
+  }
+  else {
+    first = sides[1].element_index < sides[0].element_index
+      || (sides[1].element_index == sides[0].element_index
+          && sides[1].face < sides[0].face);
+  }
+  context->face_fn (forest, &sides[first], &sides[1 - first],
+                    context->user_data);
+}
+
+/* The face recursion of t8_forest_iterate.
+ * side and neighbor_side are two elements of the same level that share
+ * a face, or neighbor_side is NULL if the face of side is at the domain
+ * boundary. The tree of side must be a local tree.
+ * If the two elements are in different trees, face_element is workspace
+ * to compute neighbors across the tree face, otherwise it is NULL.
+ * The recursion descends into the children of the elements at the face
+ * until a leaf is reached on both sides. */
+static void
+t8_forest_iterate_face_recursion (t8_forest_t forest,
+                                  t8_forest_iterate_context_t * context,
+                                  t8_forest_iterate_side_t * side,
+                                  t8_forest_iterate_side_t * neighbor_side,
+                                  t8_element_t * face_element)
+{
+  t8_forest_iterate_buffers_t *buffers, *neighbor_buffers;
+  t8_forest_iterate_side_t *refine_side, *fixed_side;
+  t8_forest_iterate_side_t child_side, neighbor_child_side;
+  t8_eclass_scheme_c *ts, *neigh_ts;
+  const t8_element_t *leaf, *neighbor_leaf;
+  t8_element_t      **face_children, **neighbors;
+  size_t             *offsets, *neighbor_offsets;
+  int                *child_indices;
+  int                 view = 0, neighbor_view = 0, iside, iface;
+  int                 num_face_children, child_face, dual_face;
+  int                 neighbor_child;
+
+  if (t8_element_array_get_count (&side->leafs[0]) == 0
+      && (neighbor_side == NULL
+          || t8_element_array_get_count (&neighbor_side->leafs[0]) == 0)) {
+    /* There is no local leaf at this face */
+    return;
+  }
+  if (t8_forest_iterate_side_count (side) == 0
+      || (neighbor_side != NULL
+          && t8_forest_iterate_side_count (neighbor_side) == 0)) {
+    /* One side has no leafs at this face */
+    return;
+  }
+  leaf = t8_forest_iterate_side_leaf (side, &view);
+  neighbor_leaf = neighbor_side == NULL ? NULL :
+    t8_forest_iterate_side_leaf (neighbor_side, &neighbor_view);
+  if (leaf != NULL && (neighbor_side == NULL || neighbor_leaf != NULL)) {
+    /* We reached a leaf on each side */
+    t8_forest_iterate_visit (forest, context, side, leaf, view,
+                             neighbor_side, neighbor_leaf, neighbor_view);
+    return;
+  }
+  if (leaf != NULL || neighbor_side == NULL || neighbor_leaf != NULL) {
+    /* One side is a leaf or at the boundary. We only descend into the
+     * children at the face of the other side. */
+    iside = leaf != NULL;
+    refine_side = iside ? neighbor_side : side;
+    fixed_side = iside ? side : neighbor_side;
+    ts = refine_side->ts;
+    buffers = t8_forest_iterate_get_buffers (context, ts);
+    face_children = buffers->face_children[iside]
+      + refine_side->level * buffers->num_face_children;
+    child_indices = buffers->child_indices[iside]
+      + refine_side->level * buffers->num_face_children;
+    offsets = buffers->face_offsets[iside]
+      + refine_side->level * 2 * (buffers->num_children + 1);
+    num_face_children =
+      ts->t8_element_num_face_children (refine_side->element,
+                                        refine_side->face);
+    ts->t8_element_children_at_face (refine_side->element, refine_side->face,
+                                     face_children, num_face_children,
+                                     child_indices);
+    t8_forest_iterate_side_split (refine_side, buffers->num_children,
+                                  offsets);
+    for (iface = 0; iface < num_face_children; iface++) {
+      child_face = ts->t8_element_face_child_face (refine_side->element,
+                                                   refine_side->face, iface);
+      t8_forest_iterate_side_child (refine_side, buffers->num_children,
+                                    offsets, child_indices[iface],
+                                    face_children[iface], child_face,
+                                    &child_side);
+      if (iside == 0) {
+        t8_forest_iterate_face_recursion (forest, context, &child_side,
+                                          fixed_side, face_element);
+      }
+      else {
+        t8_forest_iterate_face_recursion (forest, context, fixed_side,
+                                          &child_side, face_element);
+      }
+    }
+    return;
+  }
+
+  /* Both elements are refined. We descend into the children of side at the
+   * face and pair each of them with its face neighbor, which is a child of
+   * the element of neighbor_side. */
+  T8_ASSERT (side->level == neighbor_side->level);
+  T8_ASSERT (side->treeid[0] >= 0);
+  ts = side->ts;
+  neigh_ts = neighbor_side->ts;
+  buffers = t8_forest_iterate_get_buffers (context, ts);
+  neighbor_buffers = t8_forest_iterate_get_buffers (context, neigh_ts);
+  face_children = buffers->face_children[0]
+    + side->level * buffers->num_face_children;
+  child_indices = buffers->child_indices[0]
+    + side->level * buffers->num_face_children;
+  offsets = buffers->face_offsets[0]
+    + side->level * 2 * (buffers->num_children + 1);
+  neighbors = neighbor_buffers->face_children[1]
+    + neighbor_side->level * neighbor_buffers->num_face_children;
+  neighbor_offsets = neighbor_buffers->face_offsets[1]
+    + neighbor_side->level * 2 * (neighbor_buffers->num_children + 1);
+  num_face_children = ts->t8_element_num_face_children (side->element,
+                                                        side->face);
+  ts->t8_element_children_at_face (side->element, side->face, face_children,
+                                   num_face_children, child_indices);
+  t8_forest_iterate_side_split (side, buffers->num_children, offsets);
+  t8_forest_iterate_side_split (neighbor_side, neighbor_buffers->num_children,
+                                neighbor_offsets);
+  for (iface = 0; iface < num_face_children; iface++) {
+    child_face = ts->t8_element_face_child_face (side->element, side->face,
+                                                 iface);
+    t8_forest_iterate_side_child (side, buffers->num_children, offsets,
+                                  child_indices[iface], face_children[iface],
+                                  child_face, &child_side);
+    if (t8_forest_iterate_side_count (&child_side) == 0) {
+      continue;
+    }
+    /* Compute the face neighbor of the child */
+    if (face_element == NULL) {
+      T8_ASSERT (ts == neigh_ts);
+      (void) ts->t8_element_face_neighbor_inside (face_children[iface],
+                                                  neighbors[iface],
+                                                  child_face, &dual_face);
+    }
+    else {
+      (void) t8_forest_element_face_neighbor_ext (forest, side->treeid[0],
+                                                  face_children[iface],
+                                                  neighbors[iface], neigh_ts,
+                                                  child_face, &dual_face,
+                                                  face_element);
+    }
+    neighbor_child = neigh_ts->t8_element_child_id (neighbors[iface]);
+    t8_forest_iterate_side_child (neighbor_side,
+                                  neighbor_buffers->num_children,
+                                  neighbor_offsets, neighbor_child,
+                                  neighbors[iface], dual_face,
+                                  &neighbor_child_side);
+    t8_forest_iterate_face_recursion (forest, context, &child_side,
+                                      &neighbor_child_side, face_element);
+  }
+}
+
+/* The volume recursion of t8_forest_iterate.
+ * We visit all faces between the children of the element of side that
+ * are inside the element and continue the recursion with the children. */
+static void
+t8_forest_iterate_volume_recursion (t8_forest_t forest,
+                                    t8_forest_iterate_context_t * context,
+                                    t8_forest_iterate_side_t * side)
+{
+  t8_forest_iterate_buffers_t *buffers;
+  t8_forest_iterate_side_t child_side, neighbor_side;
+  t8_eclass_scheme_c *ts = side->ts;
+  t8_element_t      **children;
+  size_t             *offsets;
+  int                 view, num_children, ichild, iface, num_faces;
+  int                 neighbor_child, dual_face;
+
+  if (t8_element_array_get_count (&side->leafs[0]) == 0
+      || t8_forest_iterate_side_leaf (side, &view) != NULL) {
+    /* There is no local leaf or the element is a leaf */
+    return;
+  }
+  buffers = t8_forest_iterate_get_buffers (context, ts);
+  children = buffers->children + side->level * buffers->num_children;
+  offsets = buffers->child_offsets
+    + side->level * 2 * (buffers->num_children + 1);
+  num_children = ts->t8_element_num_children (side->element);
+  T8_ASSERT (num_children == buffers->num_children);
+  ts->t8_element_children (side->element, num_children, children);
+  t8_forest_iterate_side_split (side, num_children, offsets);
+
+  /* The faces between two children. Each of them is visited from the
+   * child with the smaller child id. */
+  for (ichild = 0; ichild < num_children; ichild++) {
+    num_faces = ts->t8_element_num_faces (children[ichild]);
+    for (iface = 0; iface < num_faces; iface++) {
+      if (ts->t8_element_face_parent_face (children[ichild], iface) >= 0) {
+        /* This face is on the boundary of the element */
+        continue;
+      }
+      (void) ts->t8_element_face_neighbor_inside (children[ichild],
+                                                  buffers->neighbor, iface,
+                                                  &dual_face);
+      neighbor_child = ts->t8_element_child_id (buffers->neighbor);
+      T8_ASSERT (neighbor_child != ichild);
+      if (neighbor_child < ichild) {
+        continue;
+      }
+      t8_forest_iterate_side_child (side, num_children, offsets, ichild,
+                                    children[ichild], iface, &child_side);
+      t8_forest_iterate_side_child (side, num_children, offsets,
+                                    neighbor_child, children[neighbor_child],
+                                    dual_face, &neighbor_side);
+      t8_forest_iterate_face_recursion (forest, context, &child_side,
+                                        &neighbor_side, NULL);
+    }
+  }
+  /* Continue with the children */
+  for (ichild = 0; ichild < num_children; ichild++) {
+    t8_forest_iterate_side_child (side, num_children, offsets, ichild,
+                                  children[ichild], -1, &child_side);
+    t8_forest_iterate_volume_recursion (forest, context, &child_side);
+  }
+}
+
+void
+t8_forest_iterate (t8_forest_t forest, t8_forest_iter_face_fn face_fn,
+                   void *user_data)
+{
+  t8_forest_iterate_context_t context;
+  t8_forest_iterate_buffers_t *buffers, *neighbor_buffers;
+  t8_forest_iterate_side_t side, neighbor_side;
+  t8_eclass_scheme_c *ts, *neigh_ts;
+  t8_eclass_t         eclass, neigh_class, face_class;
   t8_locidx_t         num_local_trees, itree;
+  t8_gloidx_t         gtreeid, gneigh_treeid;
+  int                 iface, num_faces, dual_face, ieclass;
 
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (face_fn != NULL);
+  SC_CHECK_ABORT (forest->mpisize == 1 || forest->ghosts != NULL,
+                  "Ghost structure is needed for face iteration "
+                  "but was not found in forest.\n");
+
+  context.face_fn = face_fn;
+  context.user_data = user_data;
+  for (ieclass = 0; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    context.buffers[ieclass] = NULL;
+    context.face_elements[ieclass] = NULL;
+  }
   num_local_trees = t8_forest_get_num_local_trees (forest);
   for (itree = 0; itree < num_local_trees; itree++) {
-    t8_forest_search_tree (forest, itree, search_fn, user_data);
+    eclass = t8_forest_get_tree_class (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest, eclass);
+    buffers = t8_forest_iterate_get_buffers (&context, ts);
+    gtreeid = t8_forest_global_tree_id (forest, itree);
+    t8_forest_iterate_side_init_tree (forest, &side, ts, buffers->root[0],
+                                      gtreeid, -1);
+    /* Visit the faces inside the tree */
+    t8_forest_iterate_volume_recursion (forest, &context, &side);
+
+    /* Visit the faces at the tree faces */
+    num_faces = ts->t8_element_num_faces (buffers->root[0]);
+    for (iface = 0; iface < num_faces; iface++) {
+      side.face = iface;
+      face_class = (t8_eclass_t) t8_eclass_face_types[eclass]
+        [ts->t8_element_tree_face (buffers->root[0], iface)];
+      if (context.face_elements[face_class] == NULL) {
+        t8_forest_get_eclass_scheme (forest, face_class)->t8_element_new
+          (1, &context.face_elements[face_class]);
+      }
+      neigh_class = t8_forest_element_neighbor_eclass (forest, itree,
+                                                       buffers->root[0],
+                                                       iface);
+      neigh_ts = t8_forest_get_eclass_scheme (forest, neigh_class);
+      neighbor_buffers = t8_forest_iterate_get_buffers (&context, neigh_ts);
+      gneigh_treeid =
+        t8_forest_element_face_neighbor_ext (forest, itree, buffers->root[0],
+                                             neighbor_buffers->root[1],
+                                             neigh_ts, iface, &dual_face,
+                                             context.face_elements
+                                             [face_class]);
+      if (gneigh_treeid < 0) {
+        /* The tree face is at the domain boundary */
+        t8_forest_iterate_face_recursion (forest, &context, &side, NULL,
+                                          NULL);
+        continue;
+      }
+      if (t8_forest_get_local_id (forest, gneigh_treeid) >= 0
+          && (gneigh_treeid < gtreeid
+              || (gneigh_treeid == gtreeid && dual_face < iface))) {
+        /* The faces are visited from the local neighbor tree */
+        continue;
+      }
+      t8_forest_iterate_side_init_tree (forest, &neighbor_side, neigh_ts,
+                                        neighbor_buffers->root[1],
+                                        gneigh_treeid, dual_face);
+      t8_forest_iterate_face_recursion (forest, &context, &side,
+                                        &neighbor_side,
+                                        context.face_elements[face_class]);
+    }
+  }
+  /* clean-up */
+  for (ieclass = 0; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    ts = t8_forest_get_eclass_scheme (forest, (t8_eclass_t) ieclass);
+    if (context.buffers[ieclass] != NULL) {
+      t8_forest_iterate_destroy_buffers (context.buffers[ieclass], ts);
+    }
+    if (context.face_elements[ieclass] != NULL) {
+      ts->t8_element_destroy (1, &context.face_elements[ieclass]);
+    }
   }
 }
 
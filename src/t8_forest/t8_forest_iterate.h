@@ -51,6 +51,105 @@ typedef int         (*t8_forest_search_query_fn) (t8_forest_t forest,
                                                   t8_locidx_t
                                                   tree_leaf_index);
 
+/** A callback that is called in \ref t8_forest_search_ext for each
+ * active query and each element of the search.
+ * \param [in] forest          The forest.
+ * \param [in] ltreeid         The local tree id of the current tree.
+ * \param [in] element         The current element.
+ * \param [in] leaf_elements   The leaf elements of the tree that are descendants of \a element.
+ * \param [in] user_data       The user data passed to \ref t8_forest_search_ext.
+ * \param [in] tree_leaf_index If \a element is a leaf, its index in the leafs of the tree.
+ *                             Otherwise - (index of first leaf in \a leaf_elements + 1).
+ * \param [in] query           A pointer to the current query.
+ * \param [in] query_index     The index of \a query in the query array.
+ * \return                     True if \a query remains active for the
+ *                             descendants of \a element.
+ */
+typedef int         (*t8_forest_query_fn) (t8_forest_t forest,
+                                           t8_locidx_t ltreeid,
+                                           const t8_element_t * element,
+                                           t8_element_array_t *
+                                           leaf_elements, void *user_data,
+                                           t8_locidx_t tree_leaf_index,
+                                           void *query, size_t query_index);
+
+/** A callback that is called in \ref t8_forest_search_partition for each
+ * element of the search. The element does not need to be a local element.
+ * \param [in] forest          The forest.
+ * \param [in] gtreeid         The global id of the current tree.
+ * \param [in] element         The current element. NULL if the class of the
+ *                             tree is not known, in this case the callback
+ *                             is called once for the whole tree.
+ * \param [in] eclass          The element class of the tree \a gtreeid,
+ *                             T8_ECLASS_COUNT if it is not known.
+ * \param [in] pfirst          The first process owning descendants of \a element.
+ * \param [in] plast           The last process owning descendants of \a element.
+ *                             If \a pfirst == \a plast, \a element is owned by
+ *                             a single process and the search stops after this call.
+ * \param [in] user_data       The user data passed to \ref t8_forest_search_partition.
+ * \return                     True if the search should continue with the children.
+ */
+typedef int         (*t8_forest_partition_search_fn) (t8_forest_t forest,
+                                                      t8_gloidx_t gtreeid,
+                                                      const t8_element_t *
+                                                      element,
+                                                      t8_eclass_t eclass,
+                                                      int pfirst, int plast,
+                                                      void *user_data);
+
+/** A callback that is called in \ref t8_forest_search_partition for each
+ * element and active query. The parameters are the same as for
+ * \ref t8_forest_partition_search_fn, additionally the current query and its
+ * index in the query array are passed.
+ * \return                     True if the query remains active for the
+ *                             children of \a element.
+ */
+typedef int         (*t8_forest_partition_query_fn) (t8_forest_t forest,
+                                                     t8_gloidx_t gtreeid,
+                                                     const t8_element_t *
+                                                     element,
+                                                     t8_eclass_t eclass,
+                                                     int pfirst, int plast,
+                                                     void *user_data,
+                                                     void *query,
+                                                     size_t query_index);
+
+/** One side of a face between leaf elements.
+ * \see t8_forest_iterate, t8_forest_leaf_face_neighbors_all
+ */
+typedef struct
+{
+  t8_locidx_t         treeid;   /**< The local id of the tree of \a element, or its
+                                     local ghost tree id if \a is_ghost is true. */
+  const t8_element_t *element;  /**< The leaf element. */
+  t8_locidx_t         element_index; /**< The index of \a element. Local elements are
+                                          numbered 0, ..., num_local_elements - 1,
+                                          ghost elements num_local_elements, ...,
+                                          num_local_elements + num_ghosts - 1. */
+  int                 face;     /**< The face of \a element. */
+  int                 is_ghost; /**< True if \a element is a ghost element. */
+} t8_forest_iter_face_side_t;
+
+/** The callback of \ref t8_forest_iterate. It is called once for each
+ * pair of leafs sharing a (possibly hanging) face and once for each face
+ * at the domain boundary.
+ * \param [in] forest        The forest.
+ * \param [in] side          The local leaf and its face.
+ * \param [in] neighbor_side The leaf on the other side of the face and the face of it.
+ *                           If the face is at the domain boundary, NULL.
+ *                           If the face is hanging, \a side and \a neighbor_side
+ *                           are a pair of the finer and the coarser leaf.
+ * \param [in] user_data     The user data passed to \ref t8_forest_iterate.
+ */
+typedef void        (*t8_forest_iter_face_fn) (t8_forest_t forest,
+                                               const
+                                               t8_forest_iter_face_side_t *
+                                               side,
+                                               const
+                                               t8_forest_iter_face_side_t *
+                                               neighbor_side,
+                                               void *user_data);
+
 T8_EXTERN_C_BEGIN ();
 
 /* TODO: Document */
@@ -86,6 +185,117 @@ void                t8_forest_search (t8_forest_t forest,
                                       t8_forest_search_query_fn search_fn,
                                       void *user_data);
 
+/** Perform a top-down search of the forest with multiple queries.
+ * For each element the search callback is called first, if it returns
+ * true the query callback is called for each query that is still active
+ * for this element. Only the queries for which the query callback returns
+ * true are active for the children of the element. The recursion stops
+ * as soon as no query is active anymore.
+ * \param [in] forest      A committed forest.
+ * \param [in] search_fn   Callback called once per element. If NULL, the
+ *                         search always continues.
+ * \param [in] query_fn    Callback called per element and active query.
+ *                         Must not be NULL if \a queries is not NULL.
+ * \param [in] queries     An array of queries or NULL. If NULL, this
+ *                         function behaves as \ref t8_forest_search.
+ * \param [in] user_data   A pointer that is passed to the callbacks.
+ */
+void                t8_forest_search_ext (t8_forest_t forest,
+                                          t8_forest_search_query_fn
+                                          search_fn,
+                                          t8_forest_query_fn query_fn,
+                                          sc_array_t * queries,
+                                          void *user_data);
+
+/** Locate a batch of points in the local elements of a forest.
+ * The points are passed as queries to \ref t8_forest_search_ext. Points
+ * are discarded in the search as soon as they are not inside the bounding
+ * box of an element, thus each tree is only entered with the points
+ * that lie in its bounding box.
+ * \param [in] forest      A committed forest.
+ * \param [in] points      The coordinates of the points, 3 doubles per point.
+ * \param [in] num_points  The number of points.
+ * \param [in] tolerance   Tolerance for the inside check, see
+ *                         \ref t8_forest_element_point_inside.
+ * \param [out] element_indices Array of length \a num_points. On output the
+ *                         local index of a local element containing the
+ *                         respective point or -1 if no local element contains it.
+ *                         If a point lies on an element boundary, the first
+ *                         element containing it is returned.
+ */
+void                t8_forest_locate_points (t8_forest_t forest,
+                                             const double *points,
+                                             size_t num_points,
+                                             double tolerance,
+                                             t8_locidx_t * element_indices);
+
+/** Perform a top-down search of the partition of the forest, similar to
+ * p4est_search_partition.
+ * Starting at the root element of each tree, the callbacks are called
+ * with the range of processes owning descendants of the current element.
+ * The owners are computed from the forest's partition tables alone, thus no
+ * element of a remote process is accessed and no communication is necessary.
+ * The recursion stops at elements that are owned by a single process.
+ * In particular, a query that is active at such an element can be sent to
+ * its unique owner process.
+ * \param [in] forest      A committed forest.
+ * \param [in] search_fn   Callback called once per element. If NULL, the
+ *                         search always continues.
+ * \param [in] query_fn    Callback called per element and active query.
+ *                         Must not be NULL if \a queries is not NULL.
+ * \param [in] queries     An array of queries or NULL.
+ * \param [in] user_data   A pointer that is passed to the callbacks.
+ * \note All global trees are searched. If the coarse mesh of \a forest is
+ *       partitioned, the class of a tree that is neither a local nor a ghost
+ *       tree of it is not known. For such a tree the callbacks are called
+ *       once with a NULL element and the owners of the whole tree, which are
+ *       computed from the tree offsets of \a forest, and the search does not
+ *       descend into it.
+ * \note This function is collective, since the partition tables of
+ *       \a forest are created if they do not exist yet.
+ */
+void                t8_forest_search_partition (t8_forest_t forest,
+                                                t8_forest_partition_search_fn
+                                                search_fn,
+                                                t8_forest_partition_query_fn
+                                                query_fn,
+                                                sc_array_t * queries,
+                                                void *user_data);
+
+/** Compute all leaf elements across a face of a local leaf element.
+ * In contrast to \ref t8_forest_leaf_face_neighbors, the forest does not need
+ * to be balanced and no element is copied.
+ * \param [in] forest      A committed forest. If it has more than one process,
+ *                         a ghost layer must exist.
+ * \param [in] ltreeid     The local id of the tree of \a leaf.
+ * \param [in] leaf        A local leaf element.
+ * \param [in] face        A face of \a leaf.
+ * \param [in,out] neighbors An array of \ref t8_forest_iter_face_side_t.
+ *                         On output all leafs (local and ghost) across \a face
+ *                         are appended, together with their face at which \a leaf is.
+ *                         If \a face is at the domain boundary, nothing is appended.
+ */
+void                t8_forest_leaf_face_neighbors_all (t8_forest_t forest,
+                                                       t8_locidx_t ltreeid,
+                                                       const t8_element_t *
+                                                       leaf, int face,
+                                                       sc_array_t *
+                                                       neighbors);
+
+/** Iterate over all faces of the local leafs of a forest, similar to
+ * p4est_iterate. Each face between two local leafs is visited exactly once,
+ * as is each face between a local leaf and a ghost leaf and each boundary face.
+ * A hanging face is visited once for each pair of the coarse leaf and one of
+ * the fine leafs. The faces are also found across tree boundaries.
+ * \param [in] forest      A committed forest. If it has more than one process,
+ *                         a ghost layer must exist.
+ * \param [in] face_fn     The callback that is called for each face.
+ * \param [in] user_data   A pointer that is passed to \a face_fn.
+ */
+void                t8_forest_iterate (t8_forest_t forest,
+                                       t8_forest_iter_face_fn face_fn,
+                                       void *user_data);
+
 /** Given two forest where the elemnts in one forest are either direct children or
  * parents of the elements in the other forest.
  * Compare the two forests and for each refined element or coarsened
@@ -38,6 +38,7 @@ typedef struct
   t8_gloidx_t         gtree_id; /* The global id of that tree *//* TODO: we could optimize this out */
   t8_eclass_t         eclass;   /* The element class of that tree */
   t8_locidx_t         num_elements;     /* The number of elements from this tree that were sent */
+  int                 compact;  /* True if the elements were sent as compact keys */
 } t8_forest_partition_tree_info_t;
 
 /* Given the element offset array and a rank, return the first
@@ -497,7 +498,12 @@ t8_forest_partition_tree_first_last_el (t8_tree_t tree,
  */
 /* The send buffer will look like this:
  *
- * | number of trees | padding | tree_1 info | ... | tree_n info | tree_1 elements | ... | tree_n elements |
+ * | number of trees | padding | tree_1 info | ... | tree_n info | tree_1 elements | padding | ... | tree_n elements | padding |
+ *
+ * If the elements of a tree are larger than a compact key and can be
+ * encoded, or if the tree is stored compact, we send their keys instead,
+ * see \ref t8_element_array_compact. The keys are computed directly in
+ * the send buffer.
  */
 /* If send_data is true, data must be an array of length forest_from->num_local elements
  * and instead of shipping the elements of forest_from, we ship the data entries. */
@@ -516,13 +522,17 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
   int                 last_element_is_last_tree_element = 0;
   t8_forest_partition_tree_info_t *tree_info;
   t8_locidx_t        *pnum_trees_send;
-  void               *pfirst_element;
+  sc_array_t          send_compact;
+  int8_t              compact;
   size_t              elem_size;
+  int                 is_encoded;
 
   current_element = first_element_send;
   tree_id = *current_tree;
   element_alloc = 0;
   num_trees_send = 0;
+  /* For each tree that we send, whether we send its elements as keys */
+  sc_array_init (&send_compact, sizeof (int8_t));
   /* At first we calculate the number of bytes that fit in the buffer */
   while (current_element <= last_element_send) {
     /* Get the first tree that we send elements from */
@@ -540,8 +550,22 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
     /* We now know how many elements this tree will send */
     num_elements_send = last_tree_element - first_tree_element + 1;
     T8_ASSERT (num_elements_send > 0);
-    elem_size = t8_element_array_get_size (&tree->elements);
+    /* If the elements are larger than a compact key, we try to send the
+     * keys instead. The elements of a compact tree are always sent
+     * as keys. */
+    compact = t8_element_array_is_compact (&tree->elements)
+      || (t8_element_array_get_size (&tree->elements) >
+          sizeof (t8_linearidx_t)
+          && t8_element_array_can_encode (&tree->elements,
+                                          first_tree_element,
+                                          num_elements_send));
+    *(int8_t *) sc_array_push (&send_compact) = compact;
+    elem_size = compact ? sizeof (t8_linearidx_t) :
+      t8_element_array_get_size (&tree->elements);
     element_alloc += num_elements_send * elem_size;
+    /* We pad the elements of each tree, such that the keys of the
+     * next tree are aligned */
+    element_alloc += T8_ADD_PADDING (element_alloc);
     current_element += num_elements_send;
     num_trees_send++;
     tree_id++;
@@ -560,9 +584,8 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
   element_pos = byte_alloc;
   /* and the bytes for each tree's elements */
   byte_alloc += element_alloc;
-  /* Note, that we do not add padding after the info structs and
-   * each tree's elements, since these are multiples of structs and
-   * structs are padded correctly */
+  /* Note, that we do not add padding after the info structs,
+   * since these are multiples of structs and structs are padded correctly */
   /* We allocate the buffer */
   *send_buffer = T8_ALLOC (char, byte_alloc);
   /* We store the number of trees at first in the send buffer */
@@ -590,15 +613,33 @@ t8_forest_partition_fill_buffer (t8_forest_t forest_from,
     tree_info->gtree_id = tree_id + *current_tree +
       forest_from->first_local_tree;
     tree_info->num_elements = num_elements_send;
+    tree_info->compact = *(int8_t *) sc_array_index_int (&send_compact,
+                                                         tree_id);
     tree_info_pos += sizeof (t8_forest_partition_tree_info_t);
-    /* We can now fill the send buffer with all elements of that tree */
-    pfirst_element =
-      t8_element_array_index_locidx (&tree->elements, first_tree_element);
-    elem_size = t8_element_array_get_size (&tree->elements);
-    memcpy (*send_buffer + element_pos, pfirst_element,
-            num_elements_send * elem_size);
+    /* We can now fill the send buffer with all elements, or their
+     * compact keys, of that tree */
+    if (tree_info->compact) {
+      elem_size = sizeof (t8_linearidx_t);
+      is_encoded =
+        t8_element_array_encode (&tree->elements, first_tree_element,
+                                 num_elements_send,
+                                 (t8_linearidx_t *) (*send_buffer +
+                                                     element_pos));
+      T8_ASSERT (is_encoded);
+      (void) is_encoded;
+    }
+    else {
+      elem_size = t8_element_array_get_size (&tree->elements);
+      memcpy (*send_buffer + element_pos,
+              t8_element_array_index_locidx (&tree->elements,
+                                             first_tree_element),
+              num_elements_send * elem_size);
+    }
     element_pos += num_elements_send * elem_size;
+    element_pos += T8_ADD_PADDING (element_pos);
   }
+  T8_ASSERT (element_pos == byte_alloc);
+  sc_array_reset (&send_compact);
   *current_tree += num_trees_send - 1 + last_element_is_last_tree_element;
   *buffer_alloc = byte_alloc;
   t8_debugf ("Post send of %i trees\n", num_trees_send);
@@ -892,8 +933,9 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
   size_t              tree_cursor, element_cursor;
   t8_forest_partition_tree_info_t *tree_info;
   t8_tree_t           tree, last_tree;
-  size_t              element_size;
+  size_t              element_size, recv_element_size;
   void               *first_new_element;
+  const char         *recv_elements;
   t8_eclass_scheme_c *eclass_scheme;
 
   if (proc != forest->mpirank) {
@@ -939,6 +981,15 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
   for (itree = 0; itree < num_trees; itree++) {
     num_elements_recv += tree_info->num_elements;
     T8_ASSERT (tree_info->gtree_id >= forest->last_local_tree);
+    /* Get the size of an element of the tree */
+    eclass_scheme =
+      t8_forest_get_eclass_scheme (forest->set_from, tree_info->eclass);
+    element_size = eclass_scheme->t8_element_size ();
+    /* If the elements were sent as compact keys, we decode them directly
+     * into the element array of the tree */
+    recv_element_size = tree_info->compact ? sizeof (t8_linearidx_t) :
+      element_size;
+    recv_elements = recv_buffer + element_cursor;
     if (tree_info->gtree_id > forest->last_local_tree) {
       /* We will insert a new tree in the forest */
       tree = (t8_tree_t) sc_array_push (forest->trees);
@@ -961,18 +1012,23 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
         tree->elements_offset = 0;
       }
       /* Done calculating the element offset */
-      /* Get the size of an element of the tree */
-      eclass_scheme =
-        t8_forest_get_eclass_scheme (forest->set_from, tree->eclass);
-      element_size = eclass_scheme->t8_element_size ();
-      /* initialize the elements array and copy the elements from the receive buffer */
-      T8_ASSERT (element_cursor + tree_info->num_elements * element_size <=
-                 (size_t) recv_bytes);
+      /* initialize the elements array and copy the received elements */
+      T8_ASSERT (element_cursor + tree_info->num_elements * recv_element_size
+                 <= (size_t) recv_bytes);
       t8_debugf ("[H} init array for tree %i\n", itree);
-      t8_element_array_init_copy (&tree->elements, eclass_scheme,
-                                  (t8_element_t *) (recv_buffer +
-                                                    element_cursor),
-                                  tree_info->num_elements);
+      if (tree_info->compact) {
+        t8_element_array_init_size (&tree->elements, eclass_scheme,
+                                    tree_info->num_elements);
+        t8_element_array_decode_keys (&tree->elements, 0,
+                                      tree_info->num_elements,
+                                      (const t8_linearidx_t *)
+                                      recv_elements);
+      }
+      else {
+        t8_element_array_init_copy (&tree->elements, eclass_scheme,
+                                    (t8_element_t *) recv_elements,
+                                    tree_info->num_elements);
+      }
 #if 0
       /* Debugging output */
       t8_debugf ("receive %li elements for tree %lli\n",
@@ -995,22 +1051,26 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
       new_num_elements = old_num_elements + tree_info->num_elements;
       /* Enlarge the elements array */
       t8_element_array_resize (&tree->elements, new_num_elements);
-      first_new_element = t8_element_array_index_locidx (&tree->elements,
-                                                         old_num_elements);
 #if 0
       /* Debugging output */
       t8_debugf ("receive %li elements for tree %lli\n",
                  (long) tree_info->num_elements,
                  (long long) tree_info->gtree_id);
 #endif
-      /* Get the size of an element of the tree */
-      eclass_scheme =
-        t8_forest_get_eclass_scheme (forest->set_from, tree->eclass);
-      element_size = eclass_scheme->t8_element_size ();
       T8_ASSERT (element_size == t8_element_array_get_size (&tree->elements));
-      /* Copy the elements from the receive buffer to the elements array */
-      memcpy (first_new_element, recv_buffer + element_cursor,
-              tree_info->num_elements * element_size);
+      if (tree_info->compact) {
+        t8_element_array_decode_keys (&tree->elements, old_num_elements,
+                                      tree_info->num_elements,
+                                      (const t8_linearidx_t *)
+                                      recv_elements);
+      }
+      else {
+        /* Copy the received elements to the elements array */
+        first_new_element =
+          t8_element_array_index_locidx (&tree->elements, old_num_elements);
+        memcpy (first_new_element, recv_elements,
+                tree_info->num_elements * element_size);
+      }
     }
 
     /* compute the new number of local elements */
@@ -1018,7 +1078,8 @@ t8_forest_partition_recv_message (t8_forest_t forest, sc_MPI_Comm comm,
     /* Set the new last local tree */
     forest->last_local_tree = tree_info->gtree_id;
     /* advance the element cursor */
-    element_cursor += element_size * tree_info->num_elements;
+    element_cursor += recv_element_size * tree_info->num_elements;
+    element_cursor += T8_ADD_PADDING (element_cursor);
     /* Advance to the next tree_info entry in the recv buffer */
     tree_cursor += sizeof (t8_forest_partition_tree_info_t);
     tree_info += 1;
@@ -40,6 +40,12 @@ T8_EXTERN_C_BEGIN ();
 /* For each tree in a forest compute its first and last descendant */
 void                t8_forest_compute_desc (t8_forest_t forest);
 
+/** For each local tree in a forest and each of its faces compute the
+ * connection to the neighbor tree and store it in forest->tree_face_info.
+ * \param [in,out] forest A forest whose trees and cmesh are set.
+ */
+void                t8_forest_compute_tree_face_info (t8_forest_t forest);
+
 /* Create the elements on this process given a uniform partition
  * of the coarse mesh. */
 void                t8_forest_populate (t8_forest_t forest);
@@ -153,6 +159,32 @@ t8_element_t       *t8_forest_get_tree_element (t8_tree_t tree,
 t8_element_array_t *t8_forest_get_tree_element_array (t8_forest_t forest,
                                                       t8_locidx_t ltreeid);
 
+/** Search for a linear element id (at forest->maxlevel) in a sorted array of
+ * elements. If the element does not exist, return the largest index i
+ * such that the element at position i has a smaller id than the given one.
+ * If no such i exists, return -1.
+ * \param [in]  elements   A sorted array of elements of a tree.
+ * \param [in]  element_id The linear id to look for.
+ * \param [in]  maxlevel   The level at which the linear ids are computed.
+ * \return                 The index of the element or of its predecessor.
+ */
+/* TODO: should return t8_locidx_t */
+t8_locidx_t         t8_forest_bin_search_lower (t8_element_array_t *
+                                                elements,
+                                                t8_linearidx_t element_id,
+                                                int maxlevel);
+
+/** Return the orientation of the face connection of a local tree at one of
+ * its faces, as stored in the coarse mesh.
+ * \param [in]  forest     A committed forest.
+ * \param [in]  ltreeid    The local id of a tree in \a forest.
+ * \param [in]  tree_face  A face of the tree that is not a domain boundary.
+ * \return                 The orientation of the connection at \a tree_face.
+ */
+int                 t8_forest_tree_face_orientation (t8_forest_t forest,
+                                                     t8_locidx_t ltreeid,
+                                                     int tree_face);
+
 /** Find the owner process of a given element, deprecated version.
  * Use t8_forest_element_find_owner instead.
  * \param [in]    forest  The forest.
@@ -380,6 +412,36 @@ void                t8_forest_element_owners_at_neigh_face_bounds (t8_forest_t
                                                                    int
                                                                    *upper);
 
+/** Construct the face neighbor of an element, possibly across tree boundaries,
+ * as \ref t8_forest_element_face_neighbor, without allocating memory.
+ * \param [in]    forest  The forest.
+ * \param [in]    ltreeid The local tree id of the tree in which \a elem is.
+ * \param [in]    elem    The element to be considered.
+ * \param [in,out] neigh  An allocated element of the scheme \a neigh_scheme.
+ *                        On output the face neighbor of \a elem across \a face.
+ * \param [in]    neigh_scheme The eclass scheme of \a neigh.
+ * \param [in]    face    The number of the face along which the neighbor
+ *                        should be constructed.
+ * \param [out]   neigh_face The number of the face viewed from \a neigh.
+ * \param [in,out] face_element If not NULL, an allocated element of the
+ *                        class of the tree face at which \a face lies.
+ *                        It is used as workspace if the neighbor is in
+ *                        another tree. If NULL, it is allocated as needed.
+ * \return                The global id of the tree in which \a neigh is.
+ *        -1 if there exists no neighbor across that face.
+ */
+t8_gloidx_t         t8_forest_element_face_neighbor_ext (t8_forest_t forest,
+                                                         t8_locidx_t ltreeid,
+                                                         const t8_element_t *
+                                                         elem,
+                                                         t8_element_t * neigh,
+                                                         t8_eclass_scheme_c *
+                                                         neigh_scheme,
+                                                         int face,
+                                                         int *neigh_face,
+                                                         t8_element_t *
+                                                         face_element);
+
 /** Construct all face neighbors of half size of a given element.
  * \param [in]    forest The forest.
  * \param [in]    ltreeid The local tree id of the tree in which the element is.
@@ -424,10 +486,10 @@ t8_gloidx_t         t8_forest_element_half_face_neighbors (t8_forest_t forest,
  *                        num_local_el , ... , num_local_el + num_ghosts - 1 for ghosts.
  * \param [out]   pneigh_scheme On output the eclass scheme of the neighbor elements.
  * \param [in]    forest_is_balanced True if we know that \a forest is balanced, false
- *                        otherwise.
+ *                        otherwise. If false, the neighbor leafs may have arbitrary
+ *                        levels and are computed with \ref t8_forest_leaf_face_neighbors_all.
  * \note If there are no face neighbors, then *neighbor_leafs = NULL, num_neighbors = 0,
  * and *pelement_indices = NULL on output.
- * \note Currently \a forest must be balanced.
  * \note \a forest must be committed before calling this function.
  */
 void                t8_forest_leaf_face_neighbors (t8_forest_t forest,
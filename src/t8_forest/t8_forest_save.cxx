@@ -0,0 +1,988 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_forest/t8_forest_save.h>
+#include <t8_forest/t8_forest_types.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh/t8_cmesh_types.h>
+#include <t8_cmesh/t8_cmesh_partition.h>
+#include <t8_element_cxx.hxx>
+#ifdef SC_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+/* We want to export the whole implementation to be callable from "C" */
+T8_EXTERN_C_BEGIN ();
+
+/* A forest checkpoint consists of the files fileprefix_RANK.cmesh written
+ * by t8_cmesh_save and the single file fileprefix.forest.
+ * The latter is written in native byte order and contains, in this order:
+ *  - the header t8_forest_save_header_t,
+ *  - the element class of each tree as int8_t, padded to a multiple of 8 bytes,
+ *  - the global index of the first element of each tree as int64_t,
+ *    followed by the global number of elements,
+ *  - the elements.
+ * With T8_FOREST_SAVE_ELEMENTS, the elements are stored as
+ *  - the linear id of each element at its level as uint64_t,
+ *  - the level of each element as int8_t,
+ * in their global order, independent of the partition of the forest that
+ * wrote the file.
+ * With T8_FOREST_SAVE_REFINEMENT, the elements are stored as
+ *  - one t8_forest_save_segment_t per writing process,
+ *  - the refinement bitstreams of all processes, one after the other.
+ * The bitstream of a process is the depth-first traversal of the
+ * refinement trees of its local trees. Each node is stored as one bit, 1 if
+ * it is refined and 0 if it is a leaf. If the first tree of a process is
+ * shared with the previous process, the nodes before the first local
+ * element and its ancestors are not stored.
+ */
+
+#define T8_FOREST_SAVE_MAGIC 0x7438666f72657374LL       /* "t8forest" */
+#define T8_FOREST_SAVE_VERSION 2
+
+typedef struct
+{
+  int64_t             magic;    /**< Must be T8_FOREST_SAVE_MAGIC. */
+  int64_t             version;  /**< The version of the file format. */
+  int64_t             dimension;        /**< The dimension of the forest. */
+  int64_t             num_cmesh_files;  /**< The number of cmesh files. */
+  int64_t             global_num_trees; /**< The number of trees. */
+  int64_t             global_num_elements;      /**< The number of elements. */
+  int64_t             encoding; /**< A \ref t8_forest_save_encoding_t. */
+  int64_t             compressed;       /**< True if the bitstreams are compressed with zlib. */
+  int64_t             num_segments;     /**< The number of refinement bitstreams. */
+} t8_forest_save_header_t;
+
+/* The description of the refinement bitstream of one writing process. */
+typedef struct
+{
+  int64_t             first_element;    /**< Global index of the first element. */
+  int64_t             num_elements;     /**< The number of elements. */
+  uint64_t            first_linear_id;  /**< Linear id of the first element. */
+  int64_t             first_level;      /**< Level of the first element. */
+  int64_t             data_offset;      /**< Start of the stored bitstream relative to
+                                             the first bitstream, in bytes. */
+  int64_t             data_size;        /**< Stored size of the bitstream in bytes. */
+  int64_t             num_bits; /**< The number of bits in the uncompressed bitstream. */
+} t8_forest_save_segment_t;
+
+/* A contiguous piece of the file that a process reads or writes. */
+typedef struct
+{
+  long long           file_offset;      /**< Position in the file in bytes. */
+  void               *data;     /**< The data in memory. */
+  size_t              num_bytes;        /**< The number of bytes. May be 0. */
+} t8_forest_save_block_t;
+
+/* The positions of the data sections in the file, in bytes. */
+typedef struct
+{
+  long long           eclasses;
+  long long           tree_first_elements;
+  long long           linear_ids;       /**< Only for T8_FOREST_SAVE_ELEMENTS. */
+  long long           levels;   /**< Only for T8_FOREST_SAVE_ELEMENTS. */
+  long long           segments; /**< Only for T8_FOREST_SAVE_REFINEMENT. */
+  long long           bitstreams;       /**< Only for T8_FOREST_SAVE_REFINEMENT. */
+} t8_forest_save_layout_t;
+
+/* A bitstream that is written or read bit by bit. */
+typedef struct
+{
+  uint8_t            *bytes;    /**< The bits, the first bit in the lowest bit of the first byte. */
+  size_t              num_bits; /**< The number of bits written. */
+  size_t              num_bytes_alloc;  /**< The allocated number of bytes when writing. */
+  size_t              read_pos; /**< The next bit to read when reading. */
+} t8_forest_save_bits_t;
+
+/* The state of the traversal of one refinement tree. */
+typedef struct
+{
+  t8_eclass_scheme_c *ts;       /**< The scheme of the tree. */
+  t8_element_t      **nodes;    /**< One element per level for the current path. */
+  t8_element_t       *nca;      /**< Scratch element for ancestor checks. */
+  int                 maxlevel; /**< The maximum level of the scheme. */
+  t8_forest_save_bits_t *bits;  /**< The refinement bits. */
+  t8_element_array_t *leaves;   /**< The leaves to encode, or the leaves to decode into. */
+  const t8_element_t *first;    /**< If not NULL, the tree starts at this element
+                                     on this process. Its ancestors and the nodes
+                                     before it are not stored. */
+  t8_locidx_t         num_leaves;       /**< The number of leaves to traverse. */
+  t8_locidx_t         count;    /**< The number of leaves traversed so far. */
+  t8_locidx_t         first_out;        /**< When decoding, the index of the first leaf
+                                             that is stored in \a leaves. */
+} t8_forest_save_tree_t;
+
+static void
+t8_forest_save_compute_layout (const t8_forest_save_header_t * header,
+                               t8_forest_save_layout_t * layout)
+{
+  long long           num_trees = header->global_num_trees;
+  long long           num_elements = header->global_num_elements;
+
+  layout->eclasses = sizeof (t8_forest_save_header_t);
+  layout->tree_first_elements = layout->eclasses + (num_trees + 7) / 8 * 8;
+  layout->linear_ids = layout->segments = layout->tree_first_elements
+    + (num_trees + 1) * (long long) sizeof (int64_t);
+  layout->levels = layout->linear_ids
+    + num_elements * (long long) sizeof (uint64_t);
+  layout->bitstreams = layout->segments
+    + header->num_segments * (long long) sizeof (t8_forest_save_segment_t);
+}
+
+/* Set the entries of a block. */
+static void
+t8_forest_save_block_set (t8_forest_save_block_t * block,
+                          long long file_offset, void *data,
+                          size_t num_bytes)
+{
+  block->file_offset = file_offset;
+  block->data = data;
+  block->num_bytes = num_bytes;
+}
+
+/* Append a bit to a bitstream. */
+static void
+t8_forest_save_bits_push (t8_forest_save_bits_t * bits, int bit)
+{
+  if (bits->num_bits == 8 * bits->num_bytes_alloc) {
+    bits->num_bytes_alloc = SC_MAX (64, 2 * bits->num_bytes_alloc);
+    bits->bytes = T8_REALLOC (bits->bytes, uint8_t, bits->num_bytes_alloc);
+  }
+  if (bits->num_bits % 8 == 0) {
+    bits->bytes[bits->num_bits / 8] = 0;
+  }
+  if (bit) {
+    bits->bytes[bits->num_bits / 8] |= (uint8_t) (1 << (bits->num_bits % 8));
+  }
+  bits->num_bits++;
+}
+
+/* Read the next bit of a bitstream. */
+static int
+t8_forest_save_bits_read (t8_forest_save_bits_t * bits)
+{
+  int                 bit;
+
+  SC_CHECK_ABORT (bits->read_pos < bits->num_bits,
+                  "Refinement bitstream in forest checkpoint too short.\n");
+  bit = (bits->bytes[bits->read_pos / 8] >> (bits->read_pos % 8)) & 1;
+  bits->read_pos++;
+  return bit;
+}
+
+/* Return true if an element is a descendant of or equal to the node of
+ * the given level in the current path of a tree. */
+static int
+t8_forest_save_is_ancestor (t8_forest_save_tree_t * tree, int level,
+                            const t8_element_t * element)
+{
+  if (tree->ts->t8_element_level (element) < level) {
+    return 0;
+  }
+  tree->ts->t8_element_nca (tree->nodes[level], element, tree->nca);
+  return tree->ts->t8_element_level (tree->nca) == level;
+}
+
+/* Append the refinement bits of the subtree of tree->nodes[level]
+ * until all leaves of tree->leaves are encoded. */
+static void
+t8_forest_save_encode_node (t8_forest_save_tree_t * tree, int level)
+{
+  const t8_element_t *node = tree->nodes[level];
+  const t8_element_t *leaf;
+  int                 ichild, num_children;
+  /* The ancestors of the first leaf of a shared tree are not stored */
+  int                 implicit = tree->first != NULL && tree->count == 0;
+
+  if (tree->count >= tree->num_leaves) {
+    return;
+  }
+  leaf = t8_element_array_index_locidx (tree->leaves, tree->count);
+  if (!t8_forest_save_is_ancestor (tree, level, leaf)) {
+    /* This node lies before the first leaf that this process owns */
+    T8_ASSERT (implicit);
+    return;
+  }
+  if (tree->ts->t8_element_level (leaf) == level) {
+    /* The node is a leaf */
+    if (!implicit) {
+      t8_forest_save_bits_push (tree->bits, 0);
+    }
+    tree->count++;
+    return;
+  }
+  if (!implicit) {
+    t8_forest_save_bits_push (tree->bits, 1);
+  }
+  num_children = tree->ts->t8_element_num_children (node);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    tree->ts->t8_element_child (node, ichild, tree->nodes[level + 1]);
+    t8_forest_save_encode_node (tree, level + 1);
+  }
+}
+
+/* Read the refinement bits of the subtree of tree->nodes[level] and
+ * store its leaves until tree->num_leaves leaves are decoded. */
+static void
+t8_forest_save_decode_node (t8_forest_save_tree_t * tree, int level)
+{
+  const t8_element_t *node = tree->nodes[level];
+  t8_element_t       *leaf;
+  int                 ichild, num_children, is_leaf;
+
+  if (tree->count >= tree->num_leaves) {
+    return;
+  }
+  if (tree->first != NULL && tree->count == 0) {
+    /* The ancestors of the first leaf of a shared tree are not stored */
+    if (!t8_forest_save_is_ancestor (tree, level, tree->first)) {
+      return;
+    }
+    is_leaf = tree->ts->t8_element_level (tree->first) == level;
+  }
+  else {
+    is_leaf = !t8_forest_save_bits_read (tree->bits);
+  }
+  if (is_leaf) {
+    if (tree->leaves != NULL && tree->count >= tree->first_out
+        && tree->count - tree->first_out <
+        (t8_locidx_t) t8_element_array_get_count (tree->leaves)) {
+      leaf = t8_element_array_index_locidx (tree->leaves,
+                                            tree->count - tree->first_out);
+      tree->ts->t8_element_copy (node, leaf);
+    }
+    tree->count++;
+    return;
+  }
+  SC_CHECK_ABORT (level < tree->maxlevel,
+                  "Invalid refinement bitstream in forest checkpoint.\n");
+  num_children = tree->ts->t8_element_num_children (node);
+  for (ichild = 0; ichild < num_children; ichild++) {
+    tree->ts->t8_element_child (node, ichild, tree->nodes[level + 1]);
+    t8_forest_save_decode_node (tree, level + 1);
+  }
+}
+
+/* Encode or decode the refinement tree of one coarse tree, starting at the
+ * root element. */
+static void
+t8_forest_save_traverse_tree (t8_forest_save_tree_t * tree, int decode)
+{
+  tree->maxlevel = tree->ts->t8_element_maxlevel ();
+  tree->nodes = T8_ALLOC (t8_element_t *, tree->maxlevel + 1);
+  tree->ts->t8_element_new (tree->maxlevel + 1, tree->nodes);
+  tree->ts->t8_element_new (1, &tree->nca);
+  tree->ts->t8_element_set_linear_id (tree->nodes[0], 0, 0);
+  tree->count = 0;
+  if (decode) {
+    t8_forest_save_decode_node (tree, 0);
+  }
+  else {
+    t8_forest_save_encode_node (tree, 0);
+  }
+  T8_ASSERT (tree->count == tree->num_leaves);
+  tree->ts->t8_element_destroy (tree->maxlevel + 1, tree->nodes);
+  tree->ts->t8_element_destroy (1, &tree->nca);
+  T8_FREE (tree->nodes);
+}
+
+/* Collectively read or write blocks of a file.
+ * If do_write is true, the file is created and the blocks are written.
+ * Otherwise, the blocks are read.
+ * All processes must pass the same number of blocks.
+ * Returns true on all processes if all processes were successful. */
+static int
+t8_forest_save_io (sc_MPI_Comm comm, const char *filename,
+                   t8_forest_save_block_t * blocks, int num_blocks,
+                   int do_write)
+{
+  int                 iblock;
+  int                 success = 1, global_success;
+  int                 mpiret;
+#ifdef T8_ENABLE_MPIIO
+  MPI_File            mpifile;
+  MPI_Status          status;
+  int                 count;
+
+  mpiret = MPI_File_open (comm, (char *) filename,
+                          do_write ? MPI_MODE_WRONLY | MPI_MODE_CREATE :
+                          MPI_MODE_RDONLY, MPI_INFO_NULL, &mpifile);
+  if (mpiret != MPI_SUCCESS) {
+    /* Opening is collective, thus all processes return here */
+    t8_errorf ("Error when opening file %s\n", filename);
+    return 0;
+  }
+  if (do_write) {
+    /* Truncate a possibly existing file */
+    mpiret = MPI_File_set_size (mpifile, 0);
+    SC_CHECK_MPI (mpiret);
+  }
+  for (iblock = 0; iblock < num_blocks; iblock++) {
+    SC_CHECK_ABORT (blocks[iblock].num_bytes <= (size_t) INT_MAX,
+                    "Local data too large for forest checkpoint.");
+    if (do_write) {
+      mpiret = MPI_File_write_at_all (mpifile,
+                                      (MPI_Offset) blocks[iblock].file_offset,
+                                      blocks[iblock].data,
+                                      (int) blocks[iblock].num_bytes,
+                                      MPI_BYTE, &status);
+    }
+    else {
+      mpiret = MPI_File_read_at_all (mpifile,
+                                     (MPI_Offset) blocks[iblock].file_offset,
+                                     blocks[iblock].data,
+                                     (int) blocks[iblock].num_bytes,
+                                     MPI_BYTE, &status);
+    }
+    SC_CHECK_MPI (mpiret);
+    mpiret = MPI_Get_count (&status, MPI_BYTE, &count);
+    SC_CHECK_MPI (mpiret);
+    if ((size_t) count != blocks[iblock].num_bytes) {
+      t8_errorf ("Error when %s file %s\n", do_write ? "writing" : "reading",
+                 filename);
+      success = 0;
+    }
+  }
+  mpiret = MPI_File_close (&mpifile);
+  SC_CHECK_MPI (mpiret);
+#else
+  FILE               *file = NULL;
+  int                 irank, mpirank, mpisize;
+
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  /* Without MPI I/O the processes write their parts one after the other.
+   * Reading can be done by all processes at the same time. */
+  for (irank = 0; irank < (do_write ? mpisize : 1); irank++) {
+    if (!do_write || irank == mpirank) {
+      file = fopen (filename, !do_write ? "rb" : irank == 0 ? "wb" : "r+b");
+      if (file == NULL) {
+        t8_errorf ("Error when opening file %s\n", filename);
+        success = 0;
+      }
+      for (iblock = 0; success && iblock < num_blocks; iblock++) {
+        if (blocks[iblock].num_bytes == 0) {
+          continue;
+        }
+        if (fseek (file, (long) blocks[iblock].file_offset, SEEK_SET)
+            || (do_write ? fwrite (blocks[iblock].data, 1,
+                                   blocks[iblock].num_bytes, file)
+                : fread (blocks[iblock].data, 1,
+                         blocks[iblock].num_bytes, file))
+            != blocks[iblock].num_bytes) {
+          t8_errorf ("Error when %s file %s\n",
+                     do_write ? "writing" : "reading", filename);
+          success = 0;
+        }
+      }
+      if (file != NULL && fclose (file)) {
+        t8_errorf ("Error when closing file %s\n", filename);
+        success = 0;
+      }
+    }
+    if (do_write) {
+      mpiret = sc_MPI_Barrier (comm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+#endif
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, comm);
+  SC_CHECK_MPI (mpiret);
+  return global_success;
+}
+
+/* Encode the local elements of a forest as refinement bitstream.
+ * If compress is true and zlib is available, the bitstream is compressed.
+ * On output, *data is allocated and contains the stored bitstream,
+ * segment->data_size and segment->num_bits are set.
+ * Returns true if the bitstream was compressed. */
+static int
+t8_forest_save_encode (t8_forest_t forest, int compress,
+                       t8_forest_save_segment_t * segment, uint8_t ** data)
+{
+  t8_forest_save_bits_t bits;
+  t8_forest_save_tree_t tree;
+  t8_locidx_t         itree, num_local_trees;
+  t8_tree_t           local_tree;
+  int                 first_shared;
+
+  memset (&bits, 0, sizeof (bits));
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  first_shared = forest->local_num_elements > 0
+    && t8_forest_first_tree_shared (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    local_tree = t8_forest_get_tree (forest, itree);
+    tree.ts = t8_forest_get_eclass_scheme (forest, local_tree->eclass);
+    tree.bits = &bits;
+    tree.leaves = &local_tree->elements;
+    tree.num_leaves = t8_forest_get_tree_num_elements (forest, itree);
+    tree.first = itree == 0 && first_shared ?
+      t8_element_array_index_locidx (&local_tree->elements, 0) : NULL;
+    tree.first_out = 0;
+    t8_forest_save_traverse_tree (&tree, 0);
+  }
+  segment->num_bits = bits.num_bits;
+  segment->data_size = (bits.num_bits + 7) / 8;
+  *data = bits.bytes;
+#ifdef SC_HAVE_ZLIB
+  if (compress) {
+    uLongf              compressed_size;
+    uint8_t            *compressed;
+    int                 zret;
+
+    if (segment->data_size > 0) {
+      compressed_size = compressBound ((uLong) segment->data_size);
+      compressed = T8_ALLOC (uint8_t, compressed_size);
+      zret = compress2 (compressed, &compressed_size, bits.bytes,
+                        (uLong) segment->data_size, Z_BEST_COMPRESSION);
+      SC_CHECK_ABORT (zret == Z_OK, "zlib compression failed.\n");
+      T8_FREE (bits.bytes);
+      segment->data_size = compressed_size;
+      *data = compressed;
+    }
+    return 1;
+  }
+#endif
+  return 0;
+}
+
+int
+t8_forest_save_ext (t8_forest_t forest, const char *fileprefix,
+                    t8_forest_save_encoding_t encoding, int compress)
+{
+  t8_forest_save_header_t header;
+  t8_forest_save_layout_t layout;
+  t8_forest_save_segment_t segment;
+  t8_forest_save_block_t blocks[7];
+  char                filename[BUFSIZ];
+  int8_t             *eclasses, *levels = NULL;
+  int64_t            *tree_first_elements;
+  int64_t             global_num_elements, data_end;
+  uint64_t           *linear_ids = NULL;
+  uint8_t            *data = NULL;
+  t8_locidx_t         num_local_trees, itree, first_owned_tree;
+  t8_locidx_t         ielement, num_elements, element_index;
+  t8_gloidx_t         first_element;
+  t8_tree_t           tree;
+  t8_element_t       *element;
+  t8_eclass_scheme_c *ts;
+  int                 success, cmesh_success, mpiret, num_blocks;
+
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (encoding == T8_FOREST_SAVE_ELEMENTS
+             || encoding == T8_FOREST_SAVE_REFINEMENT);
+
+  /* Save the coarse mesh */
+  cmesh_success = t8_cmesh_save (forest->cmesh, fileprefix);
+  mpiret = sc_MPI_Allreduce (&cmesh_success, &success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  if (!success) {
+    t8_global_errorf ("Error when saving the cmesh to %s\n", fileprefix);
+    return 0;
+  }
+
+  header.magic = T8_FOREST_SAVE_MAGIC;
+  header.version = T8_FOREST_SAVE_VERSION;
+  header.dimension = forest->dimension;
+  header.num_cmesh_files = forest->cmesh->set_partition ? forest->mpisize : 1;
+  header.global_num_trees = forest->global_num_trees;
+  header.global_num_elements = global_num_elements =
+    forest->global_num_elements;
+  header.encoding = encoding;
+  header.compressed = 0;
+  header.num_segments =
+    encoding == T8_FOREST_SAVE_REFINEMENT ? forest->mpisize : 0;
+  t8_forest_save_compute_layout (&header, &layout);
+
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  first_element = t8_forest_get_first_local_element_id (forest);
+  /* Each tree entry is written by the process that owns the
+   * first element of the tree. */
+  first_owned_tree = 0;
+  if (forest->local_num_elements > 0 && t8_forest_first_tree_shared (forest)) {
+    first_owned_tree = 1;
+  }
+  eclasses = T8_ALLOC (int8_t, SC_MAX (num_local_trees - first_owned_tree,
+                                       0));
+  tree_first_elements =
+    T8_ALLOC (int64_t, SC_MAX (num_local_trees - first_owned_tree, 0));
+  for (itree = first_owned_tree; itree < num_local_trees; itree++) {
+    tree = t8_forest_get_tree (forest, itree);
+    eclasses[itree - first_owned_tree] = (int8_t) tree->eclass;
+    tree_first_elements[itree - first_owned_tree] =
+      first_element + tree->elements_offset;
+  }
+
+  /* The header and the final tree entry are written by the first process */
+  t8_forest_save_block_set (blocks, 0, &header,
+                            forest->mpirank == 0 ? sizeof (header) : 0);
+  t8_forest_save_block_set (blocks + 1, layout.tree_first_elements
+                            + forest->global_num_trees
+                            * (long long) sizeof (int64_t),
+                            &global_num_elements, forest->mpirank == 0 ?
+                            sizeof (int64_t) : 0);
+  t8_forest_save_block_set (blocks + 2, layout.eclasses
+                            + forest->first_local_tree + first_owned_tree,
+                            eclasses, SC_MAX (num_local_trees
+                                              - first_owned_tree, 0));
+  t8_forest_save_block_set (blocks + 3, layout.tree_first_elements
+                            + (forest->first_local_tree + first_owned_tree)
+                            * (long long) sizeof (int64_t),
+                            tree_first_elements, SC_MAX (num_local_trees
+                                                         - first_owned_tree,
+                                                         0)
+                            * sizeof (int64_t));
+
+  if (encoding == T8_FOREST_SAVE_ELEMENTS) {
+    linear_ids = T8_ALLOC (uint64_t, forest->local_num_elements);
+    levels = T8_ALLOC (int8_t, forest->local_num_elements);
+    for (itree = 0, element_index = 0; itree < num_local_trees; itree++) {
+      tree = t8_forest_get_tree (forest, itree);
+      ts = t8_forest_get_eclass_scheme (forest, tree->eclass);
+      num_elements = t8_forest_get_tree_num_elements (forest, itree);
+      for (ielement = 0; ielement < num_elements;
+           ielement++, element_index++) {
+        element = t8_element_array_index_locidx (&tree->elements, ielement);
+        levels[element_index] = (int8_t) ts->t8_element_level (element);
+        linear_ids[element_index] =
+          ts->t8_element_get_linear_id (element, levels[element_index]);
+      }
+    }
+    T8_ASSERT (element_index == forest->local_num_elements);
+    t8_forest_save_block_set (blocks + 4, layout.linear_ids
+                              + first_element
+                              * (long long) sizeof (uint64_t), linear_ids,
+                              forest->local_num_elements
+                              * sizeof (uint64_t));
+    t8_forest_save_block_set (blocks + 5, layout.levels + first_element,
+                              levels, forest->local_num_elements);
+    num_blocks = 6;
+  }
+  else {
+    /* Encode the refinement trees and compute the position of our
+     * bitstream from the sizes of the bitstreams of smaller ranks */
+    memset (&segment, 0, sizeof (segment));
+    segment.first_element = first_element;
+    segment.num_elements = forest->local_num_elements;
+    if (forest->local_num_elements > 0) {
+      tree = t8_forest_get_tree (forest, 0);
+      ts = t8_forest_get_eclass_scheme (forest, tree->eclass);
+      element = t8_element_array_index_locidx (&tree->elements, 0);
+      segment.first_level = ts->t8_element_level (element);
+      segment.first_linear_id =
+        ts->t8_element_get_linear_id (element, segment.first_level);
+    }
+    header.compressed = t8_forest_save_encode (forest, compress, &segment,
+                                               &data);
+    mpiret = sc_MPI_Scan (&segment.data_size, &data_end, 1, T8_MPI_GLOIDX,
+                          sc_MPI_SUM, forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+    segment.data_offset = data_end - segment.data_size;
+    t8_forest_save_block_set (blocks + 4, layout.segments + forest->mpirank
+                              * (long long)
+                              sizeof (t8_forest_save_segment_t), &segment,
+                              sizeof (segment));
+    t8_forest_save_block_set (blocks + 5, layout.bitstreams
+                              + segment.data_offset, data,
+                              segment.data_size);
+    num_blocks = 6;
+  }
+
+  snprintf (filename, BUFSIZ, "%s.forest", fileprefix);
+  success = t8_forest_save_io (forest->mpicomm, filename, blocks, num_blocks,
+                               1);
+
+  T8_FREE (eclasses);
+  T8_FREE (tree_first_elements);
+  T8_FREE (linear_ids);
+  T8_FREE (levels);
+  T8_FREE (data);
+  return success;
+}
+
+int
+t8_forest_save (t8_forest_t forest, const char *fileprefix)
+{
+  return t8_forest_save_ext (forest, fileprefix, T8_FOREST_SAVE_ELEMENTS, 0);
+}
+
+/* Return the global index of the first element of a process in a
+ * uniform partition of num_elements elements. */
+static              t8_gloidx_t
+t8_forest_load_first_element (t8_gloidx_t num_elements, int rank,
+                              int mpisize)
+{
+  return (t8_gloidx_t) ((long double) rank * num_elements / mpisize);
+}
+
+/* Return the tree that contains a given element.
+ * tree_first_elements must be strictly increasing. */
+static              t8_gloidx_t
+t8_forest_load_find_tree (const int64_t * tree_first_elements,
+                          t8_gloidx_t num_trees, t8_gloidx_t element)
+{
+  t8_gloidx_t         low = 0, high = num_trees - 1, guess;
+
+  T8_ASSERT (tree_first_elements[0] <= element
+             && element < tree_first_elements[num_trees]);
+  while (low < high) {
+    guess = (low + high + 1) / 2;
+    if (tree_first_elements[guess] <= element) {
+      low = guess;
+    }
+    else {
+      high = guess - 1;
+    }
+  }
+  return low;
+}
+
+/* Read the elements with global indices first_element, ..., last_element - 1
+ * stored as linear ids and levels into the local trees of a forest. */
+static void
+t8_forest_load_elements (t8_forest_t forest, const char *filename,
+                         const t8_forest_save_layout_t * layout,
+                         t8_gloidx_t first_element, t8_gloidx_t last_element)
+{
+  t8_forest_save_block_t blocks[2];
+  t8_locidx_t         num_local_elements, itree, ielement, index;
+  t8_tree_t           tree;
+  t8_element_t       *element;
+  t8_eclass_scheme_c *ts;
+  int8_t             *levels;
+  uint64_t           *linear_ids;
+  int                 success;
+
+  num_local_elements = last_element - first_element;
+  linear_ids = T8_ALLOC (uint64_t, num_local_elements);
+  levels = T8_ALLOC (int8_t, num_local_elements);
+  t8_forest_save_block_set (blocks, layout->linear_ids + first_element
+                            * (long long) sizeof (uint64_t), linear_ids,
+                            num_local_elements * sizeof (uint64_t));
+  t8_forest_save_block_set (blocks + 1, layout->levels + first_element,
+                            levels, num_local_elements);
+  success = t8_forest_save_io (forest->mpicomm, filename, blocks, 2, 0);
+  SC_CHECK_ABORTF (success, "Could not read forest checkpoint %s\n",
+                   filename);
+
+  for (itree = 0; itree < (t8_locidx_t) forest->trees->elem_count; itree++) {
+    tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees, itree);
+    ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+    for (ielement = 0;
+         ielement < (t8_locidx_t) t8_element_array_get_count (&tree->elements);
+         ielement++) {
+      element = t8_element_array_index_locidx (&tree->elements, ielement);
+      index = tree->elements_offset + ielement;
+      SC_CHECK_ABORT (0 <= levels[index] && levels[index] <= forest->maxlevel,
+                      "Invalid element level in forest checkpoint.\n");
+      ts->t8_element_set_linear_id (element, levels[index],
+                                    linear_ids[index]);
+    }
+  }
+  T8_FREE (linear_ids);
+  T8_FREE (levels);
+}
+
+/* Decode the elements with global indices first_element, ...,
+ * last_element - 1 from the refinement bitstreams into the local trees of a
+ * forest. We read and decode the bitstreams of all writing processes whose
+ * elements overlap with this range. */
+static void
+t8_forest_load_refinement (t8_forest_t forest, const char *filename,
+                           const t8_forest_save_header_t * header,
+                           const t8_forest_save_layout_t * layout,
+                           const int8_t * eclasses,
+                           const int64_t * tree_first_elements,
+                           t8_gloidx_t first_element,
+                           t8_gloidx_t last_element)
+{
+  t8_forest_save_block_t block;
+  t8_forest_save_segment_t *segments, *segment;
+  t8_forest_save_bits_t bits;
+  t8_forest_save_tree_t tree;
+  t8_tree_t           local_tree;
+  t8_element_t       *first = NULL;
+  t8_eclass_scheme_c *first_ts = NULL;
+  t8_gloidx_t         num_trees = header->global_num_trees;
+  t8_gloidx_t         gtree, tree_begin, tree_end, seg_end;
+  int64_t             isegment, first_segment, last_segment;
+  uint8_t            *data;
+  long long           data_begin, data_size;
+  int                 success;
+
+  /* Read the description of all bitstreams */
+  segments = T8_ALLOC (t8_forest_save_segment_t, header->num_segments);
+  t8_forest_save_block_set (&block, layout->segments, segments,
+                            header->num_segments
+                            * sizeof (t8_forest_save_segment_t));
+  success = t8_forest_save_io (forest->mpicomm, filename, &block, 1, 0);
+  SC_CHECK_ABORTF (success, "Could not read forest checkpoint %s\n",
+                   filename);
+
+  /* Find the bitstreams that contain our elements and read them at once */
+  first_segment = header->num_segments;
+  last_segment = -1;
+  for (isegment = 0; isegment < header->num_segments; isegment++) {
+    segment = segments + isegment;
+    if (segment->num_elements > 0 && segment->first_element < last_element
+        && segment->first_element + segment->num_elements > first_element) {
+      first_segment = SC_MIN (first_segment, isegment);
+      last_segment = isegment;
+    }
+  }
+  data_begin = data_size = 0;
+  if (first_segment <= last_segment) {
+    data_begin = segments[first_segment].data_offset;
+    data_size = segments[last_segment].data_offset
+      + segments[last_segment].data_size - data_begin;
+  }
+  data = T8_ALLOC (uint8_t, data_size);
+  t8_forest_save_block_set (&block, layout->bitstreams + data_begin, data,
+                            data_size);
+  success = t8_forest_save_io (forest->mpicomm, filename, &block, 1, 0);
+  SC_CHECK_ABORTF (success, "Could not read forest checkpoint %s\n",
+                   filename);
+
+  for (isegment = first_segment; isegment <= last_segment; isegment++) {
+    segment = segments + isegment;
+    memset (&bits, 0, sizeof (bits));
+    bits.num_bits = segment->num_bits;
+    bits.bytes = data + segment->data_offset - data_begin;
+    if (header->compressed && bits.num_bits > 0) {
+#ifdef SC_HAVE_ZLIB
+      uLongf              raw_size = (bits.num_bits + 7) / 8;
+      int                 zret;
+
+      bits.bytes = T8_ALLOC (uint8_t, raw_size);
+      zret = uncompress (bits.bytes, &raw_size,
+                         data + segment->data_offset - data_begin,
+                         (uLong) segment->data_size);
+      SC_CHECK_ABORT (zret == Z_OK
+                      && raw_size == (uLongf) (bits.num_bits + 7) / 8,
+                      "zlib decompression failed.\n");
+#else
+      SC_ABORT ("Cannot read a compressed forest checkpoint without zlib.\n");
+#endif
+    }
+    /* Decode the trees of this segment. Trees outside our range are
+     * traversed as well to advance in the bitstream. */
+    seg_end = segment->first_element + segment->num_elements;
+    for (gtree = t8_forest_load_find_tree (tree_first_elements, num_trees,
+                                           segment->first_element);
+         gtree < num_trees && tree_first_elements[gtree] < seg_end; gtree++) {
+      tree_begin = SC_MAX (tree_first_elements[gtree],
+                           segment->first_element);
+      tree_end = SC_MIN (tree_first_elements[gtree + 1], seg_end);
+      tree.ts = forest->scheme_cxx->eclass_schemes[eclasses[gtree]];
+      SC_CHECK_ABORT (tree.ts != NULL, "The scheme does not support the "
+                      "element class of a tree in the checkpoint.\n");
+      tree.bits = &bits;
+      tree.num_leaves = tree_end - tree_begin;
+      tree.first = NULL;
+      if (tree_begin > tree_first_elements[gtree]) {
+        /* The segment starts inside this tree */
+        first_ts = tree.ts;
+        first_ts->t8_element_new (1, &first);
+        first_ts->t8_element_set_linear_id (first, segment->first_level,
+                                            segment->first_linear_id);
+        tree.first = first;
+      }
+      tree.leaves = NULL;
+      tree.first_out = 0;
+      if (forest->first_local_tree <= gtree
+          && gtree <= forest->last_local_tree) {
+        local_tree = (t8_tree_t)
+          t8_sc_array_index_locidx (forest->trees,
+                                    gtree - forest->first_local_tree);
+        tree.leaves = &local_tree->elements;
+        /* The index of our first element of this tree in this segment */
+        tree.first_out = SC_MAX (first_element, tree_first_elements[gtree])
+          - tree_begin;
+      }
+      t8_forest_save_traverse_tree (&tree, 1);
+      if (first != NULL) {
+        first_ts->t8_element_destroy (1, &first);
+        first = NULL;
+      }
+    }
+    if (header->compressed && bits.num_bits > 0) {
+      T8_FREE (bits.bytes);
+    }
+  }
+  T8_FREE (data);
+  T8_FREE (segments);
+}
+
+void
+t8_forest_load (t8_forest_t forest)
+{
+  t8_forest_save_header_t header;
+  t8_forest_save_layout_t layout;
+  t8_forest_save_block_t blocks[2];
+  char                filename[BUFSIZ];
+  int8_t             *eclasses;
+  int64_t            *tree_first_elements;
+  t8_gloidx_t         num_trees, num_elements, itree;
+  t8_gloidx_t         first_element, last_element, start, end;
+  t8_locidx_t         num_local_elements;
+  t8_tree_t           tree;
+  t8_eclass_scheme_c *ts;
+  int                 success;
+
+  T8_ASSERT (forest->set_load != NULL);
+  T8_ASSERT (forest->scheme_cxx != NULL);
+  T8_ASSERT (forest->mpisize > 0 && forest->mpirank >= 0);
+
+  /* Read the header and the tree information on all processes */
+  snprintf (filename, BUFSIZ, "%s.forest", forest->set_load);
+  t8_forest_save_block_set (blocks, 0, &header, sizeof (header));
+  success = t8_forest_save_io (forest->mpicomm, filename, blocks, 1, 0);
+  SC_CHECK_ABORTF (success, "Could not read forest checkpoint %s\n",
+                   filename);
+  SC_CHECK_ABORTF (header.magic == T8_FOREST_SAVE_MAGIC
+                   && header.version == T8_FOREST_SAVE_VERSION,
+                   "File %s is not a forest checkpoint of version %i\n",
+                   filename, T8_FOREST_SAVE_VERSION);
+  SC_CHECK_ABORTF (header.encoding == T8_FOREST_SAVE_ELEMENTS
+                   || header.encoding == T8_FOREST_SAVE_REFINEMENT,
+                   "Unknown encoding in forest checkpoint %s\n", filename);
+  num_trees = header.global_num_trees;
+  num_elements = header.global_num_elements;
+  t8_forest_save_compute_layout (&header, &layout);
+
+  eclasses = T8_ALLOC (int8_t, num_trees);
+  tree_first_elements = T8_ALLOC (int64_t, num_trees + 1);
+  t8_forest_save_block_set (blocks, layout.eclasses, eclasses, num_trees);
+  t8_forest_save_block_set (blocks + 1, layout.tree_first_elements,
+                            tree_first_elements,
+                            (num_trees + 1) * sizeof (int64_t));
+  success = t8_forest_save_io (forest->mpicomm, filename, blocks, 2, 0);
+  SC_CHECK_ABORTF (success, "Could not read forest checkpoint %s\n",
+                   filename);
+  SC_CHECK_ABORTF (num_trees > 0 && tree_first_elements[0] == 0
+                   && tree_first_elements[num_trees] == num_elements,
+                   "Invalid tree offsets in forest checkpoint %s\n",
+                   filename);
+  for (itree = 0; itree < num_trees; itree++) {
+    SC_CHECK_ABORTF (tree_first_elements[itree] <
+                     tree_first_elements[itree + 1]
+                     && 0 <= eclasses[itree]
+                     && eclasses[itree] < T8_ECLASS_COUNT,
+                     "Invalid tree %lli in forest checkpoint %s\n",
+                     (long long) itree, filename);
+  }
+
+  if (forest->cmesh == NULL) {
+    /* Load the coarse mesh from the checkpoint as well */
+    SC_CHECK_ABORTF (header.num_cmesh_files <= forest->mpisize,
+                     "Cannot load a cmesh saved on %lli processes on %i "
+                     "processes\n", (long long) header.num_cmesh_files,
+                     forest->mpisize);
+    forest->cmesh =
+      t8_cmesh_load_and_distribute (forest->set_load,
+                                    (int) header.num_cmesh_files,
+                                    forest->mpicomm, T8_LOAD_SIMPLE, 0);
+    SC_CHECK_ABORTF (forest->cmesh != NULL,
+                     "Could not load the cmesh of forest checkpoint %s\n",
+                     forest->set_load);
+    if (forest->cmesh->set_partition) {
+      /* These are not computed if every process loads its own file */
+      t8_cmesh_gather_trees_per_eclass (forest->cmesh, forest->mpicomm);
+      t8_cmesh_gather_treecount (forest->cmesh, forest->mpicomm);
+    }
+  }
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (forest->cmesh) == num_trees
+                  && forest->cmesh->dimension == header.dimension,
+                  "The cmesh does not match the forest checkpoint.\n");
+  forest->dimension = forest->cmesh->dimension;
+  t8_forest_compute_maxlevel (forest);
+
+  /* Create the local trees of a uniform partition of the elements */
+  first_element = t8_forest_load_first_element (num_elements,
+                                                forest->mpirank,
+                                                forest->mpisize);
+  last_element = t8_forest_load_first_element (num_elements,
+                                               forest->mpirank + 1,
+                                               forest->mpisize);
+  num_local_elements = last_element - first_element;
+  if (num_local_elements > 0) {
+    forest->first_local_tree =
+      t8_forest_load_find_tree (tree_first_elements, num_trees,
+                                first_element);
+    forest->last_local_tree =
+      t8_forest_load_find_tree (tree_first_elements, num_trees,
+                                last_element - 1);
+    forest->trees = sc_array_new_count (sizeof (t8_tree_struct_t),
+                                        forest->last_local_tree -
+                                        forest->first_local_tree + 1);
+    for (itree = forest->first_local_tree; itree <= forest->last_local_tree;
+         itree++) {
+      tree = (t8_tree_t) t8_sc_array_index_locidx (forest->trees,
+                                                   itree -
+                                                   forest->first_local_tree);
+      tree->eclass = (t8_eclass_t) eclasses[itree];
+      ts = forest->scheme_cxx->eclass_schemes[tree->eclass];
+      SC_CHECK_ABORT (ts != NULL, "The scheme does not support the element "
+                      "class of a tree in the checkpoint.\n");
+      /* The local range of elements of this tree */
+      start = SC_MAX (tree_first_elements[itree], first_element);
+      end = SC_MIN (tree_first_elements[itree + 1], last_element);
+      tree->elements_offset = start - first_element;
+      t8_element_array_init_size (&tree->elements, ts, end - start);
+    }
+  }
+  else {
+    /* This process is empty, set first and last local tree such
+     * that t8_forest_get_num_local_trees return 0 */
+    forest->trees = sc_array_new (sizeof (t8_tree_struct_t));
+    forest->first_local_tree = 0;
+    forest->last_local_tree = -1;
+  }
+
+  /* Fill the elements */
+  if (header.encoding == T8_FOREST_SAVE_ELEMENTS) {
+    t8_forest_load_elements (forest, filename, &layout, first_element,
+                             last_element);
+  }
+  else {
+    t8_forest_load_refinement (forest, filename, &header, &layout, eclasses,
+                               tree_first_elements, first_element,
+                               last_element);
+  }
+  forest->local_num_elements = num_local_elements;
+  forest->global_num_elements = num_elements;
+  forest->global_num_trees = num_trees;
+  t8_debugf ("Loaded %li of %lli elements from %s\n",
+             (long) num_local_elements, (long long) num_elements, filename);
+
+  T8_FREE (eclasses);
+  T8_FREE (tree_first_elements);
+}
+
+T8_EXTERN_C_END ();
@@ -0,0 +1,50 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/** \file t8_forest_save.h
+ * We define the routine that reads a forest checkpoint written by
+ * \ref t8_forest_save. It is called from \ref t8_forest_commit.
+ */
+
+#ifndef T8_FOREST_SAVE_H
+#define T8_FOREST_SAVE_H
+
+#include <t8.h>
+#include <t8_forest/t8_forest_types.h>
+
+T8_EXTERN_C_BEGIN ();
+
+/** Build the local trees and elements of a forest from the checkpoint
+ * given by forest->set_load.
+ * The elements are partitioned uniformly among the processes.
+ * If no cmesh was set, it is loaded from the checkpoint as well.
+ * On output, the dimension, maxlevel, trees, first and last local tree,
+ * and the local and global number of elements and trees are set.
+ * This function is collective.
+ * \param [in,out] forest   A forest with mpicomm, mpisize, mpirank, scheme
+ *                          and set_load set.
+ */
+void                t8_forest_load (t8_forest_t forest);
+
+T8_EXTERN_C_END ();
+
+#endif /* !T8_FOREST_SAVE_H! */
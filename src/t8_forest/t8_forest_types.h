@@ -60,6 +60,23 @@ typedef int8_t      t8_forest_from_t;
 #define T8_FOREST_BALANCE_REPART 1 /**< Value of forest->set_balance if balancing with repartitioning */
 #define T8_FOREST_BALANCE_NO_REPART 2 /**< Value of forest->set_balance if balancing without repartitioning */
 
+/** The connection of a local tree face to its neighbor tree.
+ * It is computed for all local trees in \ref t8_forest_commit, such that
+ * face neighbor computations across tree boundaries do not need to query
+ * the cmesh. */
+typedef struct t8_forest_tree_face_info
+{
+  t8_gloidx_t         neigh_tree;       /**< The global id of the neighbor tree, -1 if the face
+                                             is at the domain boundary. The other entries are
+                                             only valid if this is not -1. */
+  int8_t              neigh_eclass;     /**< The element class of the neighbor tree. */
+  int8_t              neigh_face;       /**< The face of the neighbor tree at which the connection is. */
+  int8_t              orientation;      /**< The orientation of the face connection. */
+  int8_t              sign;             /**< True if both faces have the same orientation. */
+  int8_t              is_smaller;       /**< True if the face of the local tree is the smaller one
+                                             in the face connection. */
+} t8_forest_tree_face_info_t;
+
 /** This structure is private to the implementation. */
 typedef struct t8_forest
 {
@@ -80,6 +97,8 @@ typedef struct t8_forest
 
   t8_forest_t         set_from;         /**< Temporarily store source forest. */
   t8_forest_from_t    from_method;      /**< Method to derive from \b set_from. */
+  char               *set_load;         /**< If not NULL, the prefix of a checkpoint to load the forest from.
+                                             \see t8_forest_set_load */
 #if 0
   /* TODO: Think about this. see t8_forest_iterate.{cxx,h} */
   t8_forest_replace_t set_replace_fn;   /**< Replace function. Called when \b from_method
@@ -94,6 +113,8 @@ typedef struct t8_forest
                                              If 0, no balance. If 1 balance with repartitioning, if 2 balance without
                                              repartitioning, \see t8_forest_balance */
   int                 do_ghost;         /**< If True, a ghost layer will be created when the forest is committed. */
+  int                 set_compact;      /**< If True, the local trees store compact keys after commit.
+                                             \see t8_forest_set_compact */
   t8_ghost_type_t     ghost_type;       /**< If a ghost layer will be created, the type of neighbors that count as ghost. */
   int                 ghost_algorithm;  /**< Controls the algorithm used for ghost. 1 = balanced only. 2 = also unbalanced
                                              3 = top-down search and unbalanced. */
@@ -108,6 +129,9 @@ typedef struct t8_forest
   t8_gloidx_t         global_num_trees; /**< The total number of global trees */
   sc_array_t         *trees;
   t8_forest_ghost_t   ghosts;           /**< If not NULL, the ghost elements. \see t8_forest_ghost.h */
+  t8_forest_tree_face_info_t *tree_face_info; /**< If not NULL, for each local tree T8_ECLASS_MAX_FACES
+                                             entries with the connections of its faces.
+                                             \see t8_forest_compute_tree_face_info */
   t8_shmem_array_t    element_offsets; /**< If partitioned, for each process the global index
                                             of its first element. Since it is memory consuming,
                                             it is usually only constructed when needed and otherwise unallocated. */
@@ -25,26 +25,37 @@
 #include <t8_cmesh.h>
 #include <t8_element_cxx.hxx>
 #include <t8_forest/t8_forest_ghost.h>
+#include <t8_forest/t8_forest_partition.h>
 #include <t8_vec.h>
+#include <sc_io.h>
 #include "t8_cmesh/t8_cmesh_trees.h"
 #include "t8_forest_types.h"
+/* With C++11 the background output runs in its own thread.  The writer
+ * allocates sc memory concurrently to the caller, which is only
+ * thread-safe if libsc is configured with --enable-pthread.
+ * Otherwise the output is written synchronously. */
+#if __cplusplus >= 201103L && defined (SC_ENABLE_PTHREAD)
+#define T8_FOREST_VTK_ASYNC_THREAD
+#include <atomic>
+#include <thread>
+#endif
 
 /* We want to export the whole implementation to be callable from "C" */
 T8_EXTERN_C_BEGIN ();
 
-/* TODO: Currently we only use ASCII mode and no data compression.
- *       We also do not use sc_io to buffer our output stream. */
-
 /* There are different cell data to write, e.g. connectivity, type, vertices, ...
  * The structure is always the same:
  * Iterate over the trees,
  *      iterate over the elements of that tree
- *          execute an element dependent part to write in the file.
+ *          execute an element dependent part to compute the data.
  * In order to simplify writing this code, we put all the parts that are
  * repetetive in the function
  *  t8_forest_vtk_write_cell_data.
  * This function accepts a callback function, which is then executed for
  * each element. The callback function is defined below.
+ * The callbacks append the values of the elements to a typed buffer.
+ * Once all elements are processed, the buffer is written to the file
+ * in the output format, see t8_forest_vtk_write_data_array.
  */
 /* TODO: As soon as we have element iterators we should restructure this concept
  * appropiately. */
@@ -59,7 +70,7 @@ typedef enum
  * The function is executed for each element.
  * The callback can run in three different modi:
  *  INIT    - Called once, to (possibly) initialize the data pointer
- *  EXECUTE - Called for each element, the actual writing happens here.
+ *  EXECUTE - Called for each element, the actual computation happens here.
  *  CLEANUP - Called once after all elements. Used to cleanup any memory
  *            allocated during INIT.
  * \param [in] forest The forest.
@@ -71,15 +82,14 @@ typedef enum
  * \param [in] is_ghost Non-zero if the current element is a ghost element.
  *                      In this cas \a tree is NULL.
  *                      All ghost element will be traversed after all elements are
- * \param [in,out] vtufile The open file stream to which we write the forest.
- * \param [in,out] columns An integer counting the number of written columns.
- *                         The callback should increase this value by the number
- *                         of values written to the file.
+ * \param [in,out] values  The buffer of the data array. The callback appends
+ *                         the values of the element with
+ *                         t8_forest_vtk_push_int or t8_forest_vtk_push_float.
  * \param [in,out] data    A pointer that the callback can modify at will.
  *                         Between modi INIT and CLEANUP, \a data will not be
  *                         modified outside of this callback.
  * \param [in]     modus   The modus in which the callback is called. See above.
- * \return                 True if successful, false if not (i.e. file i/o error).
+ * \return                 True if successful, false if not.
  */
 typedef int         (*t8_forest_vtk_cell_data_kernel) (t8_forest_t forest,
                                                        t8_locidx_t ltree_id,
@@ -89,12 +99,93 @@ typedef int         (*t8_forest_vtk_cell_data_kernel) (t8_forest_t forest,
                                                        t8_element_t * element,
                                                        t8_eclass_scheme_c *
                                                        ts, int is_ghost,
-                                                       FILE * vtufile,
-                                                       int *columns,
+                                                       sc_array_t * values,
                                                        void **data,
                                                        T8_VTK_KERNEL_MODUS
                                                        modus);
 
+/* The record of one element corner that is used to identify corners
+ * that belong to the same vertex. */
+typedef struct
+{
+  double              coords[3];        /* The physical coordinates. */
+  t8_gloidx_t         gtreeid;  /* The global id of the tree of the element. */
+  int                 ref_coords[3];    /* The integer coordinates of the
+                                           corner inside the tree. */
+  int                 on_tree_boundary; /* True if the corner lies on the
+                                           boundary of the tree. */
+  double              min_dist; /* The smallest distance between two
+                                   corners of the element, or 0 if the
+                                   element has only one corner. */
+} t8_forest_vtk_corner_t;
+
+/* The distinct vertices of the output elements.
+ * Each element corner is mapped to the vertex at its position, such that each
+ * vertex is written only once and the connectivity refers to the vertices. */
+typedef struct
+{
+  t8_locidx_t         num_points;       /* The number of distinct vertices. */
+  t8_locidx_t         num_corners;      /* The number of element corners. */
+  t8_locidx_t        *corner_points;    /* For each element corner in output
+                                           order the index of its vertex. */
+  double             *coordinates;      /* The coordinates of the vertices,
+                                           3 entries per vertex. */
+} t8_forest_vtk_points_t;
+
+/* The state of the output of one vtu file. */
+typedef struct
+{
+  FILE               *vtufile;  /* The open file stream. */
+  t8_vtk_format_t     format;   /* The output format of the data arrays. */
+  sc_array_t         *appended; /* In appended format, the buffers of all
+                                   data arrays written so far, in order. */
+  size_t              appended_offset;  /* In appended format, the offset of
+                                           the next data array in the
+                                           appended section. */
+  t8_forest_vtk_points_t *points;       /* If not NULL, the merged vertices
+                                           of the elements. Otherwise the
+                                           corners of each element are
+                                           written separately. */
+} t8_forest_vtk_writer_t;
+
+/* In appended format each data array is preceded by its size in bytes. */
+typedef uint64_t    t8_forest_vtk_header_t;
+
+/* Return the size in bytes of one value of a vtk data type. */
+static size_t
+t8_forest_vtk_type_size (const char *datatype)
+{
+  if (!strcmp (datatype, "Int32") || !strcmp (datatype, "Float32")) {
+    return 4;
+  }
+  if (!strcmp (datatype, "Int64") || !strcmp (datatype, "Float64")) {
+    return 8;
+  }
+  SC_ABORTF ("Unsupported vtk data type %s", datatype);
+  return 0;
+}
+
+/* Append an integer value to a buffer of Int32 or Int64 values. */
+static inline void
+t8_forest_vtk_push_int (sc_array_t * values, long long value)
+{
+  if (values->elem_size == sizeof (int32_t)) {
+    *(int32_t *) sc_array_push (values) = (int32_t) value;
+  }
+  else {
+    T8_ASSERT (values->elem_size == sizeof (int64_t));
+    *(int64_t *) sc_array_push (values) = (int64_t) value;
+  }
+}
+
+/* Append a floating point value to a buffer of T8_VTK_FLOAT_TYPE values. */
+static inline void
+t8_forest_vtk_push_float (sc_array_t * values, double value)
+{
+  T8_ASSERT (values->elem_size == sizeof (T8_VTK_FLOAT_TYPE));
+  *(T8_VTK_FLOAT_TYPE *) sc_array_push (values) = (T8_VTK_FLOAT_TYPE) value;
+}
+
 static              t8_locidx_t
 t8_forest_num_points (t8_forest_t forest, int count_ghosts)
 {
@@ -127,6 +218,48 @@ t8_forest_num_points (t8_forest_t forest, int count_ghosts)
   return num_points;
 }
 
+/* The vertex coordinates of the tree that the last element passed to
+ * a kernel belongs to. */
+typedef struct
+{
+  t8_locidx_t         ltreeid;  /* Store the last treeid with which the kernel was called.
+                                   This is either a local tree id or a local ghost tree id */
+  double              tree_vertices[T8_ECLASS_MAX_CORNERS * 3]; /* Stores the vertex coordinates of the tree */
+} t8_forest_vtk_tree_vertices_t;
+
+/* Update the stored tree vertices if \a ltree_id is not the tree
+ * that they were last stored for. */
+static void
+t8_forest_vtk_tree_vertices_update (t8_forest_t forest, t8_locidx_t ltree_id,
+                                    t8_eclass_t eclass,
+                                    t8_forest_vtk_tree_vertices_t *
+                                    vertex_data)
+{
+  t8_cmesh_t          cmesh;
+  t8_locidx_t         cmesh_local_id;
+  double             *temp_vertices;
+  int                 num_tree_vertices;
+
+  if (ltree_id == vertex_data->ltreeid) {
+    /* The vertices are already stored */
+    return;
+  }
+  vertex_data->ltreeid = ltree_id;
+  /* get the coarse mesh tree */
+  cmesh = t8_forest_get_cmesh (forest);
+  /* Comput the cmesh local id of the tree */
+  cmesh_local_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltree_id);
+  /* Get the vertex coordinates of this tree */
+  temp_vertices = ((double *) t8_cmesh_get_attribute (cmesh,
+                                                      t8_get_package_id (),
+                                                      0, cmesh_local_id));
+
+  /* Copy the tree's vertex coordinates into the struct of the data pointer */
+  num_tree_vertices = t8_eclass_num_vertices[eclass];
+  memcpy (vertex_data->tree_vertices, temp_vertices, sizeof (*temp_vertices)
+          * num_tree_vertices * 3);
+}
+
 static int
 t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                      t8_tree_t tree,
@@ -134,28 +267,21 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                      t8_element_t * element,
                                      t8_eclass_scheme_c * ts,
                                      int is_ghost,
-                                     FILE * vtufile, int *columns,
+                                     sc_array_t * values,
                                      void **data, T8_VTK_KERNEL_MODUS modus)
 {
-  struct t8_forest_vtk_vertices_t
-  {
-    t8_locidx_t         ltreeid;        /* Store the last treeid with which the lernel was called.
-                                           This is either a local tree id or a local ghost tree id */
-    double              tree_vertices[T8_ECLASS_MAX_CORNERS * 3];       /* Stores the vertex coordinates of the tree */
-  }                  *vertex_data;
-
+  t8_forest_vtk_tree_vertices_t *vertex_data;
 #if 0
   /* if we eventually implement scaling the elements, activate this line */
   double              midpoint[3];
 #endif
   double              element_coordinates[3];
-  int                 num_tree_vertices, ivertex;
-  int                 freturn;
+  int                 ivertex;
 
   if (modus == T8_VTK_KERNEL_INIT) {
     /* We initialize the user data to store NULL as the current tree */
-    *data = T8_ALLOC_ZERO (struct t8_forest_vtk_vertices_t, 1);
-    vertex_data = (struct t8_forest_vtk_vertices_t *) *data;
+    *data = T8_ALLOC_ZERO (t8_forest_vtk_tree_vertices_t, 1);
+    vertex_data = (t8_forest_vtk_tree_vertices_t *) * data;
     /* Set an invalid tree id as first tree id */
     vertex_data->ltreeid = -1;
     return 1;
@@ -166,29 +292,9 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   }
 
   T8_ASSERT (modus == T8_VTK_KERNEL_EXECUTE);
-  vertex_data = (struct t8_forest_vtk_vertices_t *) *data;
-  if (ltree_id != vertex_data->ltreeid) {
-    t8_cmesh_t          cmesh;
-    t8_locidx_t         cmesh_local_id;
-    double             *temp_vertices;
-
-    /* The current tree is not the tree that we stored from
-     * the last call to this function */
-    vertex_data->ltreeid = ltree_id;
-    /* get the coarse mesh tree */
-    cmesh = t8_forest_get_cmesh (forest);
-    /* Comput the cmesh local id of the tree */
-    cmesh_local_id = t8_forest_ltreeid_to_cmesh_ltreeid (forest, ltree_id);
-    /* Get the vertex coordinates of this tree */
-    temp_vertices = ((double *) t8_cmesh_get_attribute (cmesh,
-                                                        t8_get_package_id (),
-                                                        0, cmesh_local_id));
-
-    /* Copy the tree's vertex coordinates into the struct of the data pointer */
-    num_tree_vertices = t8_eclass_num_vertices[ts->eclass];
-    memcpy (vertex_data->tree_vertices, temp_vertices, sizeof (*temp_vertices)
-            * num_tree_vertices * 3);
-  }
+  vertex_data = (t8_forest_vtk_tree_vertices_t *) * data;
+  t8_forest_vtk_tree_vertices_update (forest, ltree_id, ts->eclass,
+                                      vertex_data);
 
   /* TODO: be careful with pyramid class here.
    *       does this work too over tree->class or do we need something else?
@@ -211,29 +317,377 @@ t8_forest_vtk_cells_vertices_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
     t8_vec_ax (element_coordinates, 0.9);
     t8_vec_axpy (midpoint, element_coordinates, 0.1);
 #endif
-    freturn = fprintf (vtufile, "         ");
-    if (freturn <= 0) {
-      return 0;
-    }
-#ifdef T8_VTK_DOUBLES
-    freturn = fprintf (vtufile, " %24.16e %24.16e %24.16e\n",
-                       element_coordinates[0], element_coordinates[1],
-                       element_coordinates[2]);
-#else
-    freturn = fprintf (vtufile, " %16.8e %16.8e %16.8e\n",
-                       element_coordinates[0], element_coordinates[1],
-                       element_coordinates[2]);
-#endif
-    if (freturn <= 0) {
-      return 0;
+    t8_forest_vtk_push_float (values, element_coordinates[0]);
+    t8_forest_vtk_push_float (values, element_coordinates[1]);
+    t8_forest_vtk_push_float (values, element_coordinates[2]);
+  }
+  return 1;
+}
+
+/* Return true if the corner of an element with integer coordinates
+ * \a coords lies on the boundary of its tree.
+ * Only these corners can be shared with elements of other trees. */
+static int
+t8_forest_vtk_corner_on_tree_boundary (t8_eclass_t eclass,
+                                       const int coords[3], int root_len)
+{
+  switch (eclass) {
+  case T8_ECLASS_VERTEX:
+    return 1;
+  case T8_ECLASS_LINE:
+    return coords[0] == 0 || coords[0] == root_len;
+  case T8_ECLASS_QUAD:
+    return coords[0] == 0 || coords[0] == root_len
+      || coords[1] == 0 || coords[1] == root_len;
+  case T8_ECLASS_HEX:
+    return coords[0] == 0 || coords[0] == root_len
+      || coords[1] == 0 || coords[1] == root_len
+      || coords[2] == 0 || coords[2] == root_len;
+  case T8_ECLASS_TRIANGLE:
+    /* The root triangle is 0 <= y <= x <= root_len */
+    return coords[1] == 0 || coords[0] == coords[1] || coords[0] == root_len;
+  case T8_ECLASS_TET:
+    /* The root tet is 0 <= y <= z <= x <= root_len */
+    return coords[1] == 0 || coords[1] == coords[2]
+      || coords[2] == coords[0] || coords[0] == root_len;
+  case T8_ECLASS_PRISM:
+    /* A triangle in x and y times a line in z */
+    return coords[1] == 0 || coords[0] == coords[1] || coords[0] == root_len
+      || coords[2] == 0 || coords[2] == root_len;
+  default:
+    SC_ABORT ("Pyramids are not supported in vtk output");
+  }
+  return 1;
+}
+
+/* Compute a t8_forest_vtk_corner_t for each corner of an element.
+ * The corners are stored in the order of the vtk connectivity. */
+static int
+t8_forest_vtk_cells_corners_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
+                                    t8_tree_t tree,
+                                    t8_locidx_t element_index,
+                                    t8_element_t * element,
+                                    t8_eclass_scheme_c * ts,
+                                    int is_ghost,
+                                    sc_array_t * values,
+                                    void **data, T8_VTK_KERNEL_MODUS modus)
+{
+  t8_forest_vtk_tree_vertices_t *vertex_data;
+  t8_forest_vtk_corner_t *corner, *first_corner;
+  t8_gloidx_t         gtreeid;
+  double              min_dist, dist;
+  int                 ivertex, jvertex, num_vertices, corner_number;
+  int                 root_len;
+
+  if (modus == T8_VTK_KERNEL_INIT) {
+    *data = T8_ALLOC_ZERO (t8_forest_vtk_tree_vertices_t, 1);
+    vertex_data = (t8_forest_vtk_tree_vertices_t *) * data;
+    /* Set an invalid tree id as first tree id */
+    vertex_data->ltreeid = -1;
+    return 1;
+  }
+  else if (modus == T8_VTK_KERNEL_CLEANUP) {
+    T8_FREE (*data);
+    return 1;
+  }
+
+  T8_ASSERT (modus == T8_VTK_KERNEL_EXECUTE);
+  T8_ASSERT (values->elem_size == sizeof (t8_forest_vtk_corner_t));
+  vertex_data = (t8_forest_vtk_tree_vertices_t *) * data;
+  t8_forest_vtk_tree_vertices_update (forest, ltree_id, ts->eclass,
+                                      vertex_data);
+  /* Elements of a tree that is local and ghost at the same time must be
+   * identified, thus we use the global tree id */
+  if (is_ghost) {
+    gtreeid = t8_forest_ghost_get_global_treeid (forest, ltree_id -
+                                                 t8_forest_get_num_local_trees
+                                                 (forest));
+  }
+  else {
+    gtreeid = t8_forest_global_tree_id (forest, ltree_id);
+  }
+  root_len = ts->t8_element_root_len (element);
+
+  num_vertices = t8_eclass_num_vertices[ts->eclass];
+  for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+    corner_number = t8_eclass_vtk_corner_number[ts->eclass][ivertex];
+    corner = (t8_forest_vtk_corner_t *) sc_array_push (values);
+    corner->gtreeid = gtreeid;
+    corner->ref_coords[0] = corner->ref_coords[1] = corner->ref_coords[2] = 0;
+    ts->t8_element_vertex_coords (element, corner_number, corner->ref_coords);
+    corner->on_tree_boundary =
+      t8_forest_vtk_corner_on_tree_boundary (ts->eclass, corner->ref_coords,
+                                             root_len);
+    t8_forest_element_coordinate (forest, ltree_id, element,
+                                  vertex_data->tree_vertices,
+                                  corner_number, corner->coords);
+  }
+  /* Compute the smallest distance between two corners of the element */
+  first_corner = (t8_forest_vtk_corner_t *)
+    sc_array_index (values, values->elem_count - num_vertices);
+  min_dist = 0;
+  for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+    for (jvertex = ivertex + 1; jvertex < num_vertices; jvertex++) {
+      dist = t8_vec_dist (first_corner[ivertex].coords,
+                          first_corner[jvertex].coords);
+      if (min_dist == 0 || dist < min_dist) {
+        min_dist = dist;
+      }
     }
-    /* We switch of the colum control of the surrounding function
-     * by keeping the columns value constant. */
-    *columns = 1;
+  }
+  for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+    first_corner[ivertex].min_dist = min_dist;
   }
   return 1;
 }
 
+/* Two corners of different trees are identified if their coordinates are
+ * equal up to this fraction of the smallest distance between two corners
+ * of an element. The coordinates are rounded to a grid of this spacing. */
+#define T8_FOREST_VTK_MERGE_RESOLUTION 1e-4
+/* If a coordinate is rounded to a grid point and it is closer than this
+ * fraction of the grid spacing to the middle between two grid points,
+ * we also look at the other grid point. */
+#define T8_FOREST_VTK_MERGE_TOLERANCE 1e-2
+
+/* An entry in the hash of the vertices of the trees */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;  /* The global id of the tree. */
+  int                 ref_coords[3];    /* The coordinates in the tree. */
+  t8_locidx_t         point;    /* The index of the vertex. */
+} t8_forest_vtk_tree_vertex_t;
+
+/* An entry in the hash of the vertices on tree boundaries */
+typedef struct
+{
+  int64_t             grid_coords[3];   /* The rounded coordinates. */
+  t8_locidx_t         point;    /* The index of the vertex. */
+} t8_forest_vtk_grid_vertex_t;
+
+static unsigned
+t8_forest_vtk_tree_vertex_hash (const void *v, const void *u)
+{
+  const t8_forest_vtk_tree_vertex_t *vertex =
+    (const t8_forest_vtk_tree_vertex_t *) v;
+  uint32_t            a, b, c;
+
+  a = (uint32_t) vertex->ref_coords[0] + (uint32_t) vertex->gtreeid;
+  b = (uint32_t) vertex->ref_coords[1];
+  c = (uint32_t) vertex->ref_coords[2];
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+  return (unsigned) c;
+}
+
+static int
+t8_forest_vtk_tree_vertex_equal (const void *v1, const void *v2,
+                                 const void *u)
+{
+  const t8_forest_vtk_tree_vertex_t *vertex1 =
+    (const t8_forest_vtk_tree_vertex_t *) v1;
+  const t8_forest_vtk_tree_vertex_t *vertex2 =
+    (const t8_forest_vtk_tree_vertex_t *) v2;
+
+  return vertex1->gtreeid == vertex2->gtreeid
+    && vertex1->ref_coords[0] == vertex2->ref_coords[0]
+    && vertex1->ref_coords[1] == vertex2->ref_coords[1]
+    && vertex1->ref_coords[2] == vertex2->ref_coords[2];
+}
+
+static unsigned
+t8_forest_vtk_grid_vertex_hash (const void *v, const void *u)
+{
+  const t8_forest_vtk_grid_vertex_t *vertex =
+    (const t8_forest_vtk_grid_vertex_t *) v;
+  uint32_t            a, b, c;
+
+  a = (uint32_t) vertex->grid_coords[0]
+    ^ (uint32_t) (vertex->grid_coords[0] >> 32);
+  b = (uint32_t) vertex->grid_coords[1]
+    ^ (uint32_t) (vertex->grid_coords[1] >> 32);
+  c = (uint32_t) vertex->grid_coords[2]
+    ^ (uint32_t) (vertex->grid_coords[2] >> 32);
+  sc_hash_mix (a, b, c);
+  sc_hash_final (a, b, c);
+  return (unsigned) c;
+}
+
+static int
+t8_forest_vtk_grid_vertex_equal (const void *v1, const void *v2,
+                                 const void *u)
+{
+  const t8_forest_vtk_grid_vertex_t *vertex1 =
+    (const t8_forest_vtk_grid_vertex_t *) v1;
+  const t8_forest_vtk_grid_vertex_t *vertex2 =
+    (const t8_forest_vtk_grid_vertex_t *) v2;
+
+  return vertex1->grid_coords[0] == vertex2->grid_coords[0]
+    && vertex1->grid_coords[1] == vertex2->grid_coords[1]
+    && vertex1->grid_coords[2] == vertex2->grid_coords[2];
+}
+
+/* Look up the vertex at the given coordinates in the hash of the vertices
+ * on tree boundaries. The coordinates are rounded to the grid with
+ * spacing \a resolution. If they are close to the middle between two grid
+ * points, the neighboring grid points are also considered.
+ * On output \a grid_coords are the rounded coordinates.
+ * Return the index of the vertex if found and -1 otherwise. */
+static              t8_locidx_t
+t8_forest_vtk_grid_vertex_lookup (sc_hash_array_t * grid_vertices,
+                                  const double coords[3], double resolution,
+                                  int64_t grid_coords[3])
+{
+  t8_forest_vtk_grid_vertex_t search, *found;
+  int64_t             other_coords[3];
+  double              scaled, fraction;
+  size_t              position;
+  int                 idim, iprobe;
+
+  for (idim = 0; idim < 3; idim++) {
+    scaled = coords[idim] / resolution + .5;
+    grid_coords[idim] = (int64_t) floor (scaled);
+    fraction = scaled - grid_coords[idim];
+    other_coords[idim] = grid_coords[idim];
+    if (fraction < T8_FOREST_VTK_MERGE_TOLERANCE) {
+      other_coords[idim] = grid_coords[idim] - 1;
+    }
+    else if (fraction > 1 - T8_FOREST_VTK_MERGE_TOLERANCE) {
+      other_coords[idim] = grid_coords[idim] + 1;
+    }
+  }
+  /* Bit idim of iprobe decides whether we use the rounded or the
+   * other grid coordinate in dimension idim */
+  for (iprobe = 0; iprobe < 8; iprobe++) {
+    for (idim = 0; idim < 3; idim++) {
+      if ((iprobe & (1 << idim))
+          && other_coords[idim] == grid_coords[idim]) {
+        /* This probe is the same as a previous one */
+        break;
+      }
+      search.grid_coords[idim] = iprobe & (1 << idim) ?
+        other_coords[idim] : grid_coords[idim];
+    }
+    if (idim < 3) {
+      continue;
+    }
+    if (sc_hash_array_lookup (grid_vertices, &search, &position)) {
+      found = (t8_forest_vtk_grid_vertex_t *)
+        sc_array_index (&grid_vertices->a, position);
+      return found->point;
+    }
+  }
+  return -1;
+}
+
+/* Given the corners of all output elements, compute the distinct vertices
+ * and the vertex of each corner.
+ * The corners of one tree are identified via their integer coordinates.
+ * Corners on the boundary of a tree may be shared with a face (or edge/vertex)
+ * neighbor tree, these are identified via their coordinates. */
+static void
+t8_forest_vtk_merge_corners (sc_array_t * corners,
+                             t8_forest_vtk_points_t * points)
+{
+  sc_hash_array_t    *tree_vertices, *grid_vertices;
+  t8_forest_vtk_corner_t *corner;
+  t8_forest_vtk_tree_vertex_t tree_search, *tree_vertex;
+  t8_forest_vtk_grid_vertex_t grid_search, *grid_vertex;
+  double              min_dist, magnitude, resolution;
+  t8_locidx_t         point;
+  size_t              icorner, position;
+  int                 idim;
+
+  points->num_corners = (t8_locidx_t) corners->elem_count;
+  points->num_points = 0;
+  points->corner_points = T8_ALLOC (t8_locidx_t, points->num_corners);
+  points->coordinates = T8_ALLOC (double, 3 * points->num_corners);
+
+  /* Compute the spacing of the grid that we round the coordinates of the
+   * tree boundary corners to. Distinct vertices are at least about the
+   * smallest distance between the corners of an element apart, thus we
+   * choose the spacing as a small fraction of this distance. It does not
+   * depend on the position of the mesh, such that meshes far from the
+   * origin are merged correctly. If no element has two corners, we use a
+   * fraction of the magnitude of the coordinates. */
+  min_dist = 0;
+  magnitude = 0;
+  for (icorner = 0; icorner < corners->elem_count; icorner++) {
+    corner = (t8_forest_vtk_corner_t *) sc_array_index (corners, icorner);
+    if (corner->min_dist > 0
+        && (min_dist == 0 || corner->min_dist < min_dist)) {
+      min_dist = corner->min_dist;
+    }
+    for (idim = 0; idim < 3; idim++) {
+      magnitude = SC_MAX (magnitude, fabs (corner->coords[idim]));
+    }
+  }
+  if (min_dist > 0) {
+    resolution = min_dist * T8_FOREST_VTK_MERGE_RESOLUTION;
+  }
+  else {
+    resolution = SC_MAX (magnitude, 1) * 1e-12;
+  }
+
+  tree_vertices =
+    sc_hash_array_new (sizeof (t8_forest_vtk_tree_vertex_t),
+                       t8_forest_vtk_tree_vertex_hash,
+                       t8_forest_vtk_tree_vertex_equal, NULL);
+  grid_vertices =
+    sc_hash_array_new (sizeof (t8_forest_vtk_grid_vertex_t),
+                       t8_forest_vtk_grid_vertex_hash,
+                       t8_forest_vtk_grid_vertex_equal, NULL);
+  for (icorner = 0; icorner < corners->elem_count; icorner++) {
+    corner = (t8_forest_vtk_corner_t *) sc_array_index (corners, icorner);
+    tree_search.gtreeid = corner->gtreeid;
+    for (idim = 0; idim < 3; idim++) {
+      tree_search.ref_coords[idim] = corner->ref_coords[idim];
+    }
+    tree_vertex = (t8_forest_vtk_tree_vertex_t *)
+      sc_hash_array_insert_unique (tree_vertices, &tree_search, &position);
+    if (tree_vertex == NULL) {
+      /* We already found this vertex in the tree */
+      tree_vertex = (t8_forest_vtk_tree_vertex_t *)
+        sc_array_index (&tree_vertices->a, position);
+      points->corner_points[icorner] = tree_vertex->point;
+      continue;
+    }
+    /* This is a new vertex of the tree */
+    *tree_vertex = tree_search;
+    point = -1;
+    if (corner->on_tree_boundary) {
+      /* The vertex may have been found in another tree */
+      point = t8_forest_vtk_grid_vertex_lookup (grid_vertices, corner->coords,
+                                                resolution,
+                                                grid_search.grid_coords);
+    }
+    if (point < 0) {
+      /* This is a new vertex */
+      point = points->num_points++;
+      for (idim = 0; idim < 3; idim++) {
+        points->coordinates[3 * point + idim] = corner->coords[idim];
+      }
+      if (corner->on_tree_boundary) {
+        grid_vertex = (t8_forest_vtk_grid_vertex_t *)
+          sc_hash_array_insert_unique (grid_vertices, &grid_search,
+                                       &position);
+        T8_ASSERT (grid_vertex != NULL);
+        grid_vertex->point = point;
+        for (idim = 0; idim < 3; idim++) {
+          grid_vertex->grid_coords[idim] = grid_search.grid_coords[idim];
+        }
+      }
+    }
+    tree_vertex->point = point;
+    points->corner_points[icorner] = point;
+  }
+  sc_hash_array_destroy (tree_vertices);
+  sc_hash_array_destroy (grid_vertices);
+  points->coordinates =
+    T8_REALLOC (points->coordinates, double,
+                3 * SC_MAX (points->num_points, 1));
+}
+
 #if 0
 /* Write vertex coordinates into the already opened file.
  * Returns true when successful, false otherwise.
@@ -350,12 +804,11 @@ t8_forest_vtk_cells_connectivity_kernel (t8_forest_t forest,
                                          t8_element_t * elements,
                                          t8_eclass_scheme_c * ts,
                                          int is_ghost,
-                                         FILE * vtufile, int *columns,
+                                         sc_array_t * values,
                                          void **data,
                                          T8_VTK_KERNEL_MODUS modus)
 {
   int                 ivertex;
-  int                 freturn;
   t8_locidx_t        *count_vertices;
 
   if (modus == T8_VTK_KERNEL_INIT) {
@@ -376,12 +829,8 @@ t8_forest_vtk_cells_connectivity_kernel (t8_forest_t forest,
                   "No vtk support for pyramids.");
   for (ivertex = 0; ivertex < t8_eclass_num_vertices[ts->eclass];
        ++ivertex, (*count_vertices)++) {
-    freturn = fprintf (vtufile, " %ld", (long) *count_vertices);
-    if (freturn <= 0) {
-      return 0;
-    }
+    t8_forest_vtk_push_int (values, *count_vertices);
   }
-  *columns += t8_eclass_num_vertices[ts->eclass];
   return 1;
 }
 
@@ -392,11 +841,10 @@ t8_forest_vtk_cells_offset_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   sc_array_t * values,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   long long          *offset;
-  int                 freturn;
 
   if (modus == T8_VTK_KERNEL_INIT) {
     *data = T8_ALLOC_ZERO (long long, 1);
@@ -414,11 +862,7 @@ t8_forest_vtk_cells_offset_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
   SC_CHECK_ABORT (ts->eclass != T8_ECLASS_PYRAMID,
                   "Pyramids not supported in vtk");
   *offset += t8_eclass_num_vertices[ts->eclass];
-  freturn = fprintf (vtufile, " %lld", *offset);
-  if (freturn <= 0) {
-    return 0;
-  }
-  *columns += 1;
+  t8_forest_vtk_push_int (values, *offset);
 
   return 1;
 }
@@ -430,17 +874,12 @@ t8_forest_vtk_cells_type_kernel (t8_forest_t forest, t8_locidx_t ltree_id,
                                  t8_element_t * element,
                                  t8_eclass_scheme_c * ts,
                                  int is_ghost,
-                                 FILE * vtufile, int *columns,
+                                 sc_array_t * values,
                                  void **data, T8_VTK_KERNEL_MODUS modus)
 {
-  int                 freturn;
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    /* print the vtk type of the element */
-    freturn = fprintf (vtufile, " %d", t8_eclass_vtk_type[ts->eclass]);
-    if (freturn <= 0) {
-      return 0;
-    }
-    *columns += 1;
+    /* store the vtk type of the element */
+    t8_forest_vtk_push_int (values, t8_eclass_vtk_type[ts->eclass]);
   }
   return 1;
 }
@@ -452,12 +891,11 @@ t8_forest_vtk_cells_level_kernel (t8_forest_t forest,
                                   t8_element_t * element,
                                   t8_eclass_scheme_c * ts,
                                   int is_ghost,
-                                  FILE * vtufile, int *columns,
+                                  sc_array_t * values,
                                   void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    fprintf (vtufile, "%i ", ts->t8_element_level (element));
-    *columns += 1;
+    t8_forest_vtk_push_int (values, ts->t8_element_level (element));
   }
   return 1;
 }
@@ -469,12 +907,11 @@ t8_forest_vtk_cells_rank_kernel (t8_forest_t forest,
                                  t8_element_t * element,
                                  t8_eclass_scheme_c * ts,
                                  int is_ghost,
-                                 FILE * vtufile, int *columns,
+                                 sc_array_t * values,
                                  void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
-    fprintf (vtufile, "%i ", forest->mpirank);
-    *columns += 1;
+    t8_forest_vtk_push_int (values, forest->mpirank);
   }
   return 1;
 }
@@ -486,7 +923,7 @@ t8_forest_vtk_cells_treeid_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   sc_array_t * values,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
@@ -499,8 +936,7 @@ t8_forest_vtk_cells_treeid_kernel (t8_forest_t forest,
       /* Otherwise the global tree id */
       tree_id = (long long) ltree_id + forest->first_local_tree;
     }
-    fprintf (vtufile, "%lli ", tree_id);
-    *columns += 1;
+    t8_forest_vtk_push_int (values, tree_id);
   }
   return 1;
 }
@@ -512,18 +948,18 @@ t8_forest_vtk_cells_elementid_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      sc_array_t * values,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   if (modus == T8_VTK_KERNEL_EXECUTE) {
     if (!is_ghost) {
-      fprintf (vtufile, "%lli ", element_index + tree->elements_offset +
-               (long long) t8_forest_get_first_local_element_id (forest));
+      t8_forest_vtk_push_int (values, element_index + tree->elements_offset +
+                              (long long)
+                              t8_forest_get_first_local_element_id (forest));
     }
     else {
-      fprintf (vtufile, "%lli ", (long long) -1);
+      t8_forest_vtk_push_int (values, -1);
     }
-    *columns += 1;
   }
   return 1;
 }
@@ -535,7 +971,7 @@ t8_forest_vtk_cells_scalar_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   sc_array_t * values,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double              element_value = 0;
@@ -551,8 +987,7 @@ t8_forest_vtk_cells_scalar_kernel (t8_forest_t forest,
     else {
       element_value = 0;
     }
-    fprintf (vtufile, "%g ", element_value);
-    *columns += 1;
+    t8_forest_vtk_push_float (values, element_value);
   }
   return 1;
 }
@@ -564,7 +999,7 @@ t8_forest_vtk_cells_vector_kernel (t8_forest_t forest,
                                    t8_element_t * element,
                                    t8_eclass_scheme_c * ts,
                                    int is_ghost,
-                                   FILE * vtufile, int *columns,
+                                   sc_array_t * values,
                                    void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double             *element_values, null_vec[3] = { 0, 0, 0 };
@@ -585,9 +1020,8 @@ t8_forest_vtk_cells_vector_kernel (t8_forest_t forest,
       element_values = null_vec;
     }
     for (idim = 0; idim < dim; idim++) {
-      fprintf (vtufile, "%g ", element_values[idim]);
+      t8_forest_vtk_push_float (values, element_values[idim]);
     }
-    *columns += dim;
   }
   return 1;
 }
@@ -600,7 +1034,7 @@ t8_forest_vtk_vertices_scalar_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      sc_array_t * values,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double              element_value = 0;
@@ -620,8 +1054,7 @@ t8_forest_vtk_vertices_scalar_kernel (t8_forest_t forest,
       else {
         element_value = 0;
       }
-      fprintf (vtufile, "%g ", element_value);
-      *columns += 1;
+      t8_forest_vtk_push_float (values, element_value);
     }
   }
   return 1;
@@ -635,7 +1068,7 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
                                       t8_element_t * element,
                                       t8_eclass_scheme_c * ts,
                                       int is_ghost,
-                                      FILE * vtufile, int *columns,
+                                      sc_array_t * values,
                                       void **data, T8_VTK_KERNEL_MODUS modus)
 {
   double             *element_values, null_vec[3] = { 0, 0, 0 };
@@ -659,27 +1092,158 @@ t8_forest_vtk_vertices_vector_kernel (t8_forest_t forest,
         element_values = null_vec;
       }
       for (idim = 0; idim < dim; idim++) {
-        fprintf (vtufile, "%g ", element_values[idim]);
+        t8_forest_vtk_push_float (values, element_values[idim]);
       }
-      *columns += dim;
     }
   }
   return 1;
 }
 
-/* Iterate over all cells and write cell data to the file using
- * the cell_data_kernel as callback */
+#ifdef T8_VTK_DOUBLES
+#define T8_FOREST_VTK_FLOAT_FORMAT " %24.16e"
+#else
+#define T8_FOREST_VTK_FLOAT_FORMAT " %16.8e"
+#endif
+
+/* Write the values of a data array to the file in the output format of
+ * the writer.
+ * In ascii format, we break the line after max_columns values.
+ * In appended format, only the DataArray tag is written and the writer
+ * takes ownership of \a values. The values are written at the end of the
+ * file in t8_forest_vtk_write_appended.
+ * Otherwise, \a values is destroyed.
+ * Returns true on success and zero otherwise. */
 static int
-t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
-                               const char *dataname,
-                               const char *datatype,
-                               const char *component_string,
-                               int max_columns,
-                               t8_forest_vtk_cell_data_kernel kernel,
-                               int write_ghosts, void *udata)
+t8_forest_vtk_write_data_array (t8_forest_vtk_writer_t * writer,
+                                const char *dataname,
+                                const char *datatype,
+                                const char *component_string,
+                                int max_columns, sc_array_t * values)
+{
+  FILE               *vtufile = writer->vtufile;
+  const size_t        num_bytes = values->elem_count * values->elem_size;
+  const int           is_float = datatype[0] == 'F';
+  size_t              ivalue;
+  const void         *value;
+  int                 freturn;
+
+  if (writer->format == T8_VTK_FORMAT_APPENDED) {
+    freturn = fprintf (vtufile, "        <DataArray type=\"%s\" "
+                       "Name=\"%s\" %s format=\"appended\" offset=\"%llu\"/>\n",
+                       datatype, dataname, component_string,
+                       (unsigned long long) writer->appended_offset);
+    if (freturn <= 0) {
+      sc_array_destroy (values);
+      return 0;
+    }
+    /* Store the values until we write the appended section */
+    *(sc_array_t **) sc_array_push (writer->appended) = values;
+    writer->appended_offset += sizeof (t8_forest_vtk_header_t) + num_bytes;
+    return 1;
+  }
+
+  freturn = fprintf (vtufile, "        <DataArray type=\"%s\" "
+                     "Name=\"%s\" %s format=\"%s\">\n         ",
+                     datatype, dataname, component_string,
+                     writer->format == T8_VTK_FORMAT_ASCII ? "ascii" :
+                     "binary");
+  if (freturn <= 0) {
+    goto t8_forest_vtk_data_array_failure;
+  }
+  if (writer->format == T8_VTK_FORMAT_ASCII) {
+    for (ivalue = 0; ivalue < values->elem_count; ivalue++) {
+      value = sc_array_index (values, ivalue);
+      if (is_float) {
+        freturn = fprintf (vtufile, T8_FOREST_VTK_FLOAT_FORMAT,
+                           (double) *(const T8_VTK_FLOAT_TYPE *) value);
+      }
+      else if (values->elem_size == sizeof (int32_t)) {
+        freturn = fprintf (vtufile, " %ld", (long) *(const int32_t *) value);
+      }
+      else {
+        freturn = fprintf (vtufile, " %lld",
+                           (long long) *(const int64_t *) value);
+      }
+      if (freturn <= 0) {
+        goto t8_forest_vtk_data_array_failure;
+      }
+      /* After max_columns we break the line */
+      if (!((ivalue + 1) % max_columns)) {
+        freturn = fprintf (vtufile, "\n         ");
+        if (freturn <= 0) {
+          goto t8_forest_vtk_data_array_failure;
+        }
+      }
+    }
+  }
+  else {
+    T8_ASSERT (writer->format == T8_VTK_FORMAT_BINARY);
+    /* Write all values at once base64 encoded */
+#ifdef SC_HAVE_ZLIB
+    freturn = sc_vtk_write_compressed (vtufile, values->array, num_bytes);
+#else
+    freturn = sc_vtk_write_binary (vtufile, values->array, num_bytes);
+#endif
+    if (freturn) {
+      goto t8_forest_vtk_data_array_failure;
+    }
+  }
+  freturn = fprintf (vtufile, "\n        </DataArray>\n");
+  if (freturn <= 0) {
+    goto t8_forest_vtk_data_array_failure;
+  }
+  sc_array_destroy (values);
+  return 1;
+t8_forest_vtk_data_array_failure:
+  sc_array_destroy (values);
+  return 0;
+}
+
+/* Write the appended section with the raw values of all data arrays
+ * stored in the writer. Each array is preceded by its size in bytes.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_write_appended (t8_forest_vtk_writer_t * writer)
 {
+  FILE               *vtufile = writer->vtufile;
+  t8_forest_vtk_header_t num_bytes;
+  sc_array_t         *values;
+  size_t              iarray;
   int                 freturn;
-  int                 countcols;
+
+  T8_ASSERT (writer->format == T8_VTK_FORMAT_APPENDED);
+  freturn = fprintf (vtufile, "  <AppendedData encoding=\"raw\">\n   _");
+  if (freturn <= 0) {
+    return 0;
+  }
+  for (iarray = 0; iarray < writer->appended->elem_count; iarray++) {
+    values = *(sc_array_t **) sc_array_index (writer->appended, iarray);
+    num_bytes = values->elem_count * values->elem_size;
+    if (fwrite (&num_bytes, sizeof (num_bytes), 1, vtufile) != 1) {
+      return 0;
+    }
+    if (num_bytes > 0
+        && fwrite (values->array, 1, num_bytes, vtufile) != num_bytes) {
+      return 0;
+    }
+  }
+  freturn = fprintf (vtufile, "\n  </AppendedData>\n");
+  if (freturn <= 0) {
+    return 0;
+  }
+  return 1;
+}
+
+/* Iterate over all cells and compute the values of a data array using
+ * the cell_data_kernel as callback. The values are appended to \a values.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_compute_cell_data (t8_forest_t forest,
+                                 t8_forest_vtk_cell_data_kernel kernel,
+                                 int write_ghosts, void *udata,
+                                 sc_array_t * values)
+{
+  int                 success = 1;
   t8_tree_t           tree;
   t8_locidx_t         itree, ighost;
   t8_locidx_t         element_index, elems_in_tree;
@@ -688,15 +1252,6 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
   t8_eclass_scheme_c *ts;
   void               *data = NULL;
 
-  /* Write the connectivity information.
-   * Thus for each tree we write the indices of its corner vertices. */
-  freturn = fprintf (vtufile, "        <DataArray type=\"%s\" "
-                     "Name=\"%s\" %s format=\"ascii\">\n         ",
-                     datatype, dataname, component_string);
-  if (freturn <= 0) {
-    return 0;
-  }
-
   /* if udata != NULL, use it as the data pointer, in this case, the kernel
    * should not modify it */
   if (udata != NULL) {
@@ -705,13 +1260,10 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
 
   /* Call the kernel in initilization modus to possibly initialize the
    * data pointer */
-  kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
-          T8_VTK_KERNEL_INIT);
-  /* We iterate over the trees and count each trees vertices,
-   * we add this to the already counted vertices and write it to the file */
+  kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, &data, T8_VTK_KERNEL_INIT);
   /* TODO: replace with an element iterator */
   num_local_trees = t8_forest_get_num_local_trees (forest);
-  for (itree = 0, countcols = 0; itree < num_local_trees; itree++) {
+  for (itree = 0; success && itree < num_local_trees; itree++) {
     /* Get the tree that stores the elements */
     tree = t8_forest_get_tree (forest, itree);
     /* Get the eclass scheme of the tree */
@@ -720,38 +1272,15 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
                                                                 itree));
     elems_in_tree =
       (t8_locidx_t) t8_element_array_get_count (&tree->elements);
-    for (element_index = 0; element_index < elems_in_tree; element_index++) {
+    for (element_index = 0; success && element_index < elems_in_tree;
+         element_index++) {
       /* Get a pointer to the element */
-      element =
-        t8_forest_get_element (forest, tree->elements_offset + element_index,
-                               NULL);
+      element = t8_forest_get_element_in_tree (forest, itree, element_index);
       T8_ASSERT (element != NULL);
       /* Execute the given callback on each element */
-      if (!kernel
-          (forest, itree, tree, element_index, element, ts, 0, vtufile,
-           &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
-        /* call the kernel in clean-up modus */
-        kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
-                T8_VTK_KERNEL_CLEANUP);
-        return 0;
-      }
-      /* After max_columns we break the line */
-      if (!(countcols % max_columns)) {
-        freturn = fprintf (vtufile, "\n         ");
-        if (freturn <= 0) {
-          /* call the kernel in clean-up modus */
-          kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
-                  T8_VTK_KERNEL_CLEANUP);
-          return 0;
-        }
-      }
+      success = kernel (forest, itree, tree, element_index, element, ts, 0,
+                        values, &data, T8_VTK_KERNEL_EXECUTE);
     }                           /* element loop ends here */
-    if (freturn <= 0) {
-      /* call the kernel in clean-up modus */
-      kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
-              T8_VTK_KERNEL_CLEANUP);
-      return 0;
-    }
   }                             /* tree loop ends here */
 
   if (write_ghosts) {
@@ -759,7 +1288,7 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
     /* Iterate over the ghost elements */
     /* TODO: replace with an element iterator */
     num_ghost_trees = t8_forest_ghost_num_trees (forest);
-    for (ighost = 0; ighost < num_ghost_trees; ighost++) {
+    for (ighost = 0; success && ighost < num_ghost_trees; ighost++) {
       /* Get the eclass scheme of the ghost tree */
       ts =
         t8_forest_get_eclass_scheme (forest,
@@ -768,46 +1297,140 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
       /* The number of ghosts in this tree */
       num_ghosts_in_tree = t8_forest_ghost_tree_num_elements (forest, ighost);
       for (element_index = 0;
-           element_index < num_ghosts_in_tree; element_index++) {
+           success && element_index < num_ghosts_in_tree; element_index++) {
         /* Get a pointer to the element */
         element = t8_forest_ghost_get_element (forest, ighost, element_index);
         /* Execute the given callback on each element */
-        if (!kernel
-            (forest, ighost + num_local_trees, NULL, element_index, element,
-             ts, 1, vtufile, &countcols, &data, T8_VTK_KERNEL_EXECUTE)) {
-          /* call the kernel in clean-up modus */
-          kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
-                  T8_VTK_KERNEL_CLEANUP);
-          return 0;
-        }
-        /* After max_columns we break the line */
-        if (!(countcols % max_columns)) {
-          freturn = fprintf (vtufile, "\n         ");
-          if (freturn <= 0) {
-            /* call the kernel in clean-up modus */
-            kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
-                    T8_VTK_KERNEL_CLEANUP);
-            return 0;
-          }
-        }
+        success = kernel (forest, ighost + num_local_trees, NULL,
+                          element_index, element, ts, 1, values, &data,
+                          T8_VTK_KERNEL_EXECUTE);
       }                         /* element loop ends here */
-      if (freturn <= 0) {
-        /* call the kernel in clean-up modus */
-        kernel (NULL, 0, NULL, 0, NULL, NULL, 1, NULL, NULL, &data,
-                T8_VTK_KERNEL_CLEANUP);
-        return 0;
-      }
     }                           /* ghost loop ends here */
   }                             /* write_ghosts ends here */
   /* call the kernel in clean-up modus */
-  kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, NULL, &data,
+  kernel (NULL, 0, NULL, 0, NULL, NULL, 0, NULL, &data,
           T8_VTK_KERNEL_CLEANUP);
-  freturn = fprintf (vtufile, "\n        </DataArray>\n");
-  if (freturn <= 0) {
+  return success;
+}
+
+/* Iterate over all cells and compute the values of a data array using
+ * the cell_data_kernel as callback. Then write the array to the file. */
+static int
+t8_forest_vtk_write_cell_data (t8_forest_t forest,
+                               t8_forest_vtk_writer_t * writer,
+                               const char *dataname,
+                               const char *datatype,
+                               const char *component_string,
+                               int max_columns,
+                               t8_forest_vtk_cell_data_kernel kernel,
+                               int write_ghosts, void *udata)
+{
+  sc_array_t         *values;
+
+  /* The buffer that the kernel fills with the values of all elements */
+  values = sc_array_new (t8_forest_vtk_type_size (datatype));
+  if (!t8_forest_vtk_compute_cell_data (forest, kernel, write_ghosts, udata,
+                                        values)) {
+    sc_array_destroy (values);
     return 0;
   }
+  /* Write the values of all elements */
+  return t8_forest_vtk_write_data_array (writer, dataname, datatype,
+                                         component_string, max_columns,
+                                         values);
+}
 
-  return 1;
+/* Compute the distinct vertices of the (local and possibly ghost) elements
+ * of a forest and the vertex of each element corner. */
+static t8_forest_vtk_points_t *
+t8_forest_vtk_points_new (t8_forest_t forest, int write_ghosts)
+{
+  t8_forest_vtk_points_t *points;
+  sc_array_t         *corners;
+  int                 success;
+
+  /* Collect all element corners in output order */
+  corners = sc_array_new (sizeof (t8_forest_vtk_corner_t));
+  success =
+    t8_forest_vtk_compute_cell_data (forest,
+                                     t8_forest_vtk_cells_corners_kernel,
+                                     write_ghosts, NULL, corners);
+  SC_CHECK_ABORT (success, "Error when computing the element corners.");
+  T8_ASSERT ((t8_locidx_t) corners->elem_count ==
+             t8_forest_num_points (forest, write_ghosts));
+  /* Identify the corners at the same vertex */
+  points = T8_ALLOC_ZERO (t8_forest_vtk_points_t, 1);
+  t8_forest_vtk_merge_corners (corners, points);
+  sc_array_destroy (corners);
+  return points;
+}
+
+static void
+t8_forest_vtk_points_destroy (t8_forest_vtk_points_t * points)
+{
+  T8_FREE (points->corner_points);
+  T8_FREE (points->coordinates);
+  T8_FREE (points);
+}
+
+/* Write a user defined data field as point data of the merged vertices.
+ * The value at a vertex is the average of the values of the local elements
+ * that share this vertex. Vertices of ghost elements only get the value 0.
+ * \a element_values has \a num_components entries per local element. */
+static int
+t8_forest_vtk_write_merged_point_data (t8_forest_t forest,
+                                       t8_forest_vtk_writer_t * writer,
+                                       const char *dataname,
+                                       const char *component_string,
+                                       int max_columns, int num_components,
+                                       const double *element_values)
+{
+  t8_forest_vtk_points_t *points = writer->points;
+  sc_array_t         *values;
+  double             *sums;
+  t8_locidx_t        *counts;
+  t8_locidx_t         itree, num_local_trees, ielement, num_elements;
+  t8_locidx_t         icorner, element_offset, point;
+  int                 num_vertices, ivertex, icomp;
+
+  T8_ASSERT (points != NULL);
+  sums = T8_ALLOC_ZERO (double, num_components * points->num_points);
+  counts = T8_ALLOC_ZERO (t8_locidx_t, points->num_points);
+  /* The corners of the local elements come first, in element order */
+  icorner = 0;
+  element_offset = 0;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    num_vertices =
+      t8_eclass_num_vertices[t8_forest_get_tree_class (forest, itree)];
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      for (ivertex = 0; ivertex < num_vertices; ivertex++, icorner++) {
+        point = points->corner_points[icorner];
+        counts[point]++;
+        for (icomp = 0; icomp < num_components; icomp++) {
+          sums[num_components * point + icomp] +=
+            element_values[num_components * (element_offset + ielement)
+                           + icomp];
+        }
+      }
+    }
+    element_offset += num_elements;
+  }
+
+  values = sc_array_new (sizeof (T8_VTK_FLOAT_TYPE));
+  for (point = 0; point < points->num_points; point++) {
+    for (icomp = 0; icomp < num_components; icomp++) {
+      t8_forest_vtk_push_float (values, counts[point] > 0 ?
+                                sums[num_components * point + icomp]
+                                / counts[point] : 0);
+    }
+  }
+  T8_FREE (sums);
+  T8_FREE (counts);
+  return t8_forest_vtk_write_data_array (writer, dataname, T8_VTK_FLOAT_NAME,
+                                         component_string, max_columns,
+                                         values);
 }
 
 /* Write the cell data to an open file stream.
@@ -815,7 +1438,8 @@ t8_forest_vtk_write_cell_data (t8_forest_t forest, FILE * vtufile,
  * After completion the file will remain open, whether writing
  * cells was successful or not. */
 static int
-t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
+t8_forest_vtk_write_cells (t8_forest_t forest,
+                           t8_forest_vtk_writer_t * writer,
                            int write_treeid,
                            int write_mpirank,
                            int write_level, int write_element_id,
@@ -826,19 +1450,33 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   int                 idata;
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (vtufile != NULL);
+  T8_ASSERT (writer->vtufile != NULL);
 
-  freturn = fprintf (vtufile, "      <Cells>\n");
+  freturn = fprintf (writer->vtufile, "      <Cells>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
 
   /* Write the connectivity information.
    * Thus for each tree we write the indices of its corner vertices. */
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "connectivity",
-                                           T8_VTK_LOCIDX, "", 8,
-                                           t8_forest_vtk_cells_connectivity_kernel,
-                                           write_ghosts, NULL);
+  if (writer->points != NULL) {
+    /* The corners refer to the merged vertices */
+    sc_array_t         *values;
+    t8_locidx_t         icorner;
+
+    values = sc_array_new (t8_forest_vtk_type_size (T8_VTK_LOCIDX));
+    for (icorner = 0; icorner < writer->points->num_corners; icorner++) {
+      t8_forest_vtk_push_int (values, writer->points->corner_points[icorner]);
+    }
+    freturn = t8_forest_vtk_write_data_array (writer, "connectivity",
+                                              T8_VTK_LOCIDX, "", 8, values);
+  }
+  else {
+    freturn = t8_forest_vtk_write_cell_data (forest, writer, "connectivity",
+                                             T8_VTK_LOCIDX, "", 8,
+                                             t8_forest_vtk_cells_connectivity_kernel,
+                                             write_ghosts, NULL);
+  }
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -850,7 +1488,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
    * For example if the trees are a square and a triangle, the offsets would
    * be 4 and 7, since indices 0,1,2,3 refer to the vertices of the square
    * and indices 4,5,6 to the indices of the triangle. */
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "offsets",
+  freturn = t8_forest_vtk_write_cell_data (forest, writer, "offsets",
                                            T8_VTK_LOCIDX, "", 8,
                                            t8_forest_vtk_cells_offset_kernel,
                                            write_ghosts, NULL);
@@ -862,7 +1500,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   /* Write the element types. The type specifies the element class, thus
    * square/triangle/tet etc. */
 
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "types",
+  freturn = t8_forest_vtk_write_cell_data (forest, writer, "types",
                                            "Int32", "", 8,
                                            t8_forest_vtk_cells_type_kernel,
                                            write_ghosts, NULL);
@@ -871,12 +1509,12 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     goto t8_forest_vtk_cell_failure;
   }
   /* Done with writing the types */
-  freturn = fprintf (vtufile, "      </Cells>\n");
+  freturn = fprintf (writer->vtufile, "      </Cells>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
 
-  freturn = fprintf (vtufile, "      <CellData Scalars =\"%s%s\">\n",
+  freturn = fprintf (writer->vtufile, "      <CellData Scalars =\"%s%s\">\n",
                      "treeid,mpirank,level", (write_element_id ? "id" : ""));
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
@@ -885,7 +1523,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   if (write_treeid) {
     /* Write the tree ids. */
 
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "treeid",
+    freturn = t8_forest_vtk_write_cell_data (forest, writer, "treeid",
                                              T8_VTK_GLOIDX, "", 8,
                                              t8_forest_vtk_cells_treeid_kernel,
                                              write_ghosts, NULL);
@@ -897,7 +1535,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   if (write_mpirank) {
     /* Write the mpiranks. */
 
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "mpirank",
+    freturn = t8_forest_vtk_write_cell_data (forest, writer, "mpirank",
                                              "Int32", "", 8,
                                              t8_forest_vtk_cells_rank_kernel,
                                              write_ghosts, NULL);
@@ -909,7 +1547,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   if (write_level) {
     /* Write the element refinement levels. */
 
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "level",
+    freturn = t8_forest_vtk_write_cell_data (forest, writer, "level",
                                              "Int32", "", 8,
                                              t8_forest_vtk_cells_level_kernel,
                                              write_ghosts, NULL);
@@ -926,7 +1564,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     /* Use 32 bit ints if the global element count fits, 64 bit otherwise. */
     datatype = forest->global_num_elements > T8_LOCIDX_MAX ? T8_VTK_GLOIDX :
       T8_VTK_LOCIDX;
-    freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "element_id",
+    freturn = t8_forest_vtk_write_cell_data (forest, writer, "element_id",
                                              datatype, "", 8,
                                              t8_forest_vtk_cells_elementid_kernel,
                                              write_ghosts, NULL);
@@ -940,7 +1578,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
   for (idata = 0; idata < num_data; idata++) {
     if (data[idata].type == T8_VTK_SCALAR) {
       freturn =
-        t8_forest_vtk_write_cell_data (forest, vtufile,
+        t8_forest_vtk_write_cell_data (forest, writer,
                                        data[idata].description,
                                        T8_VTK_FLOAT_NAME, "", 8,
                                        t8_forest_vtk_cells_scalar_kernel,
@@ -951,7 +1589,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
       T8_ASSERT (data[idata].type == T8_VTK_VECTOR);
       snprintf (component_string, BUFSIZ, "NumberOfComponents=\"3\"");
       freturn =
-        t8_forest_vtk_write_cell_data (forest, vtufile,
+        t8_forest_vtk_write_cell_data (forest, writer,
                                        data[idata].description,
                                        T8_VTK_FLOAT_NAME,
                                        component_string,
@@ -964,7 +1602,7 @@ t8_forest_vtk_write_cells (t8_forest_t forest, FILE * vtufile,
     }
   }
 
-  freturn = fprintf (vtufile, "      </CellData>\n");
+  freturn = fprintf (writer->vtufile, "      </CellData>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -982,7 +1620,8 @@ t8_forest_vtk_cell_failure:
  * After completion the file will remain open, whether writing
  * cells was successful or not. */
 static int
-t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
+t8_forest_vtk_write_points (t8_forest_t forest,
+                            t8_forest_vtk_writer_t * writer,
                             int write_ghosts,
                             int num_data, t8_vtk_data_field_t * data)
 {
@@ -991,24 +1630,40 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
   char                description[BUFSIZ];
 
   T8_ASSERT (t8_forest_is_committed (forest));
-  T8_ASSERT (vtufile != NULL);
+  T8_ASSERT (writer->vtufile != NULL);
 
   /* Write the vertex coordinates */
 
-  freturn = fprintf (vtufile, "      <Points>\n");
+  freturn = fprintf (writer->vtufile, "      <Points>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
-  freturn = t8_forest_vtk_write_cell_data (forest, vtufile, "Position",
-                                           T8_VTK_FLOAT_NAME,
-                                           "NumberOfComponents=\"3\"",
-                                           8,
-                                           t8_forest_vtk_cells_vertices_kernel,
-                                           write_ghosts, NULL);
+  if (writer->points != NULL) {
+    /* Write the coordinates of the merged vertices */
+    sc_array_t         *values;
+    t8_locidx_t         icoord;
+
+    values = sc_array_new (sizeof (T8_VTK_FLOAT_TYPE));
+    for (icoord = 0; icoord < 3 * writer->points->num_points; icoord++) {
+      t8_forest_vtk_push_float (values, writer->points->coordinates[icoord]);
+    }
+    freturn = t8_forest_vtk_write_data_array (writer, "Position",
+                                              T8_VTK_FLOAT_NAME,
+                                              "NumberOfComponents=\"3\"",
+                                              3, values);
+  }
+  else {
+    freturn = t8_forest_vtk_write_cell_data (forest, writer, "Position",
+                                             T8_VTK_FLOAT_NAME,
+                                             "NumberOfComponents=\"3\"",
+                                             3,
+                                             t8_forest_vtk_cells_vertices_kernel,
+                                             write_ghosts, NULL);
+  }
   if (!freturn) {
     goto t8_forest_vtk_cell_failure;
   }
-  freturn = fprintf (vtufile, "      </Points>\n");
+  freturn = fprintf (writer->vtufile, "      </Points>\n");
   if (freturn <= 0) {
     goto t8_forest_vtk_cell_failure;
   }
@@ -1016,16 +1671,24 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
 
   /* Write the user defined data fields per element */
   if (num_data > 0) {
-    freturn = fprintf (vtufile, "      <PointData>\n");
+    freturn = fprintf (writer->vtufile, "      <PointData>\n");
     for (idata = 0; idata < num_data; idata++) {
       if (data[idata].type == T8_VTK_SCALAR) {
         snprintf (description, BUFSIZ, "%s_%s", data[idata].description,
                   "points");
-        freturn =
-          t8_forest_vtk_write_cell_data (forest, vtufile, description,
-                                         T8_VTK_FLOAT_NAME, "", 8,
-                                         t8_forest_vtk_vertices_scalar_kernel,
-                                         write_ghosts, data[idata].data);
+        if (writer->points != NULL) {
+          freturn =
+            t8_forest_vtk_write_merged_point_data (forest, writer,
+                                                   description, "", 8, 1,
+                                                   data[idata].data);
+        }
+        else {
+          freturn =
+            t8_forest_vtk_write_cell_data (forest, writer, description,
+                                           T8_VTK_FLOAT_NAME, "", 8,
+                                           t8_forest_vtk_vertices_scalar_kernel,
+                                           write_ghosts, data[idata].data);
+        }
       }
       else {
         char                component_string[BUFSIZ];
@@ -1033,18 +1696,29 @@ t8_forest_vtk_write_points (t8_forest_t forest, FILE * vtufile,
         snprintf (component_string, BUFSIZ, "NumberOfComponents=\"3\"");
         snprintf (description, BUFSIZ, "%s_%s", data[idata].description,
                   "points");
-        freturn =
-          t8_forest_vtk_write_cell_data (forest, vtufile, description,
-                                         T8_VTK_FLOAT_NAME, component_string,
-                                         8 * forest->dimension,
-                                         t8_forest_vtk_vertices_vector_kernel,
-                                         write_ghosts, data[idata].data);
+        if (writer->points != NULL) {
+          freturn =
+            t8_forest_vtk_write_merged_point_data (forest, writer,
+                                                   description,
+                                                   component_string,
+                                                   8 * forest->dimension, 3,
+                                                   data[idata].data);
+        }
+        else {
+          freturn =
+            t8_forest_vtk_write_cell_data (forest, writer, description,
+                                           T8_VTK_FLOAT_NAME,
+                                           component_string,
+                                           8 * forest->dimension,
+                                           t8_forest_vtk_vertices_vector_kernel,
+                                           write_ghosts, data[idata].data);
+        }
       }
       if (!freturn) {
         goto t8_forest_vtk_cell_failure;
       }
     }
-    freturn = fprintf (vtufile, "      </PointData>\n");
+    freturn = fprintf (writer->vtufile, "      </PointData>\n");
   }
   /* Function completed successfully */
   return 1;
@@ -1054,30 +1728,186 @@ t8_forest_vtk_cell_failure:
   return 0;
 }
 
-int
-t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
-                          int write_treeid,
-                          int write_mpirank,
-                          int write_level, int write_element_id,
-                          int write_ghosts,
-                          int num_data, t8_vtk_data_field_t * data)
+/* Write the xml header of a vtu file up to the opening UnstructuredGrid
+ * tag. Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_write_header (t8_forest_vtk_writer_t * writer)
+{
+  int                 freturn;
+
+  freturn = fprintf (writer->vtufile, "<?xml version=\"1.0\"?>\n");
+  if (freturn <= 0) {
+    return 0;
+  }
+  if (writer->format == T8_VTK_FORMAT_APPENDED) {
+    /* The sizes of the raw data arrays are stored as 64 bit integers,
+     * which needs version 1.0 of the file format */
+    freturn = fprintf (writer->vtufile, "<VTKFile type=\"UnstructuredGrid\""
+                       " version=\"1.0\" header_type=\"UInt64\"");
+  }
+  else {
+    freturn = fprintf (writer->vtufile,
+                       "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
+  }
+  if (freturn <= 0) {
+    return 0;
+  }
+#ifdef SC_HAVE_ZLIB
+  if (writer->format == T8_VTK_FORMAT_BINARY) {
+    freturn = fprintf (writer->vtufile,
+                       " compressor=\"vtkZLibDataCompressor\"");
+    if (freturn <= 0) {
+      return 0;
+    }
+  }
+#endif
+#ifdef SC_IS_BIGENDIAN
+  freturn = fprintf (writer->vtufile, " byte_order=\"BigEndian\">\n");
+#else
+  freturn = fprintf (writer->vtufile, " byte_order=\"LittleEndian\">\n");
+#endif
+  if (freturn <= 0) {
+    return 0;
+  }
+  freturn = fprintf (writer->vtufile, "  <UnstructuredGrid>\n");
+  if (freturn <= 0) {
+    return 0;
+  }
+  return 1;
+}
+
+/* Write the local elements of the forest as one Piece of a vtu file.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_write_piece (t8_forest_t forest,
+                           t8_forest_vtk_writer_t * writer,
+                           int write_treeid, int write_mpirank,
+                           int write_level, int write_element_id,
+                           int write_ghosts, int num_data,
+                           t8_vtk_data_field_t * data)
 {
-  FILE               *vtufile = NULL;
   t8_locidx_t         num_elements, num_points;
+  int                 freturn;
+
+  /* The local number of elements */
+  num_elements = t8_forest_get_num_element (forest);
+  if (write_ghosts) {
+    num_elements += t8_forest_get_num_ghosts (forest);
+  }
+  if (writer->points != NULL) {
+    /* Each of the distinct vertices is written once */
+    num_points = writer->points->num_points;
+  }
+  else {
+    /* The local number of points, counted with multiplicity */
+    num_points = t8_forest_num_points (forest, write_ghosts);
+  }
+
+  freturn = fprintf (writer->vtufile,
+                     "    <Piece NumberOfPoints=\"%lld\" NumberOfCells=\"%lld\">\n",
+                     (long long) num_points, (long long) num_elements);
+  if (freturn <= 0) {
+    return 0;
+  }
+  /* write the point data */
+  if (!t8_forest_vtk_write_points
+      (forest, writer, write_ghosts, num_data, data)) {
+    /* writings points was not succesful */
+    return 0;
+  }
+  /* write the cell data */
+  if (!t8_forest_vtk_write_cells
+      (forest, writer, write_treeid, write_mpirank, write_level,
+       write_element_id, write_ghosts, num_data, data)) {
+    /* Writing cells was not successful */
+    return 0;
+  }
+  freturn = fprintf (writer->vtufile, "    </Piece>\n");
+  if (freturn <= 0) {
+    return 0;
+  }
+  return 1;
+}
+
+/* Write the end of a vtu file after the last Piece, including the
+ * appended data in appended format.
+ * Returns true on success and zero otherwise. */
+static int
+t8_forest_vtk_write_footer (t8_forest_vtk_writer_t * writer)
+{
+  int                 freturn;
+
+  freturn = fprintf (writer->vtufile, "  </UnstructuredGrid>\n");
+  if (freturn <= 0) {
+    return 0;
+  }
+  if (writer->format == T8_VTK_FORMAT_APPENDED) {
+    /* write the values of all data arrays */
+    if (!t8_forest_vtk_write_appended (writer)) {
+      return 0;
+    }
+  }
+  freturn = fprintf (writer->vtufile, "</VTKFile>\n");
+  if (freturn <= 0) {
+    return 0;
+  }
+  return 1;
+}
+
+/* Free the buffers of a writer. */
+static void
+t8_forest_vtk_writer_reset (t8_forest_vtk_writer_t * writer)
+{
+  size_t              iarray;
+
+  if (writer->appended != NULL) {
+    /* Free the values of the appended data arrays */
+    for (iarray = 0; iarray < writer->appended->elem_count; iarray++) {
+      sc_array_destroy (*(sc_array_t **)
+                        sc_array_index (writer->appended, iarray));
+    }
+    sc_array_destroy (writer->appended);
+    writer->appended = NULL;
+  }
+  if (writer->points != NULL) {
+    t8_forest_vtk_points_destroy (writer->points);
+    writer->points = NULL;
+  }
+}
+
+int
+t8_forest_vtk_write_file_format (t8_forest_t forest, const char *fileprefix,
+                                 t8_vtk_format_t format,
+                                 int merge_vertices,
+                                 int write_treeid,
+                                 int write_mpirank,
+                                 int write_level, int write_element_id,
+                                 int write_ghosts,
+                                 int num_data, t8_vtk_data_field_t * data)
+{
+  t8_forest_vtk_writer_t writer;
   char                vtufilename[BUFSIZ];
   int                 freturn;
 
   T8_ASSERT (forest != NULL);
   T8_ASSERT (t8_forest_is_committed (forest));
   T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (format == T8_VTK_FORMAT_ASCII || format == T8_VTK_FORMAT_BINARY
+             || format == T8_VTK_FORMAT_APPENDED);
   if (forest->ghosts == NULL || forest->ghosts->num_ghosts_elements == 0) {
     /* Never write ghost elements if there aren't any */
     write_ghosts = 0;
   }
   T8_ASSERT (forest->ghosts != NULL || !write_ghosts);
 
-  /* Currently we only support output in ascii format, not binary */
-  T8_ASSERT (T8_VTK_ASCII == 1);
+  writer.vtufile = NULL;
+  writer.format = format;
+  writer.appended = NULL;
+  writer.appended_offset = 0;
+  writer.points = NULL;
+  if (format == T8_VTK_FORMAT_APPENDED) {
+    writer.appended = sc_array_new (sizeof (sc_array_t *));
+  }
 
   /* process 0 creates the .pvtu file */
   if (forest->mpirank == 0) {
@@ -1089,13 +1919,10 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
     }
   }
 
-  /* The local number of elements */
-  num_elements = t8_forest_get_num_element (forest);
-  if (write_ghosts) {
-    num_elements += t8_forest_get_num_ghosts (forest);
+  if (merge_vertices) {
+    /* Compute the distinct vertices, each is written once */
+    writer.points = t8_forest_vtk_points_new (forest, write_ghosts);
   }
-  /* The local number of points, counted with multiplicity */
-  num_points = t8_forest_num_points (forest, write_ghosts);
 
   /* The filename for this processes file */
   freturn =
@@ -1107,79 +1934,828 @@ t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
   }
 
   /* Open the vtufile to write to */
-  vtufile = fopen (vtufilename, "w");
-  if (vtufile == NULL) {
+  writer.vtufile = fopen (vtufilename, "wb");
+  if (writer.vtufile == NULL) {
     t8_errorf ("Error when opening file %s\n", vtufilename);
     goto t8_forest_vtk_failure;
   }
   /* Write the header information in the .vtu file.
    * xml type, Unstructured grid and number of points and elements. */
-  freturn = fprintf (vtufile, "<?xml version=\"1.0\"?>\n");
-  if (freturn <= 0) {
-    goto t8_forest_vtk_failure;
-  }
-  freturn =
-    fprintf (vtufile, "<VTKFile type=\"UnstructuredGrid\" version=\"0.1\"");
-  if (freturn <= 0) {
-    goto t8_forest_vtk_failure;
-  }
-#ifdef SC_IS_BIGENDIAN
-  freturn = fprintf (vtufile, " byte_order=\"BigEndian\">\n");
-#else
-  freturn = fprintf (vtufile, " byte_order=\"LittleEndian\">\n");
-#endif
-  if (freturn <= 0) {
-    goto t8_forest_vtk_failure;
-  }
-  freturn = fprintf (vtufile, "  <UnstructuredGrid>\n");
-  if (freturn <= 0) {
-    goto t8_forest_vtk_failure;
-  }
-  freturn = fprintf (vtufile,
-                     "    <Piece NumberOfPoints=\"%lld\" NumberOfCells=\"%lld\">\n",
-                     (long long) num_points, (long long) num_elements);
-  if (freturn <= 0) {
+  if (!t8_forest_vtk_write_header (&writer)) {
     goto t8_forest_vtk_failure;
   }
-
-  /* write the point data */
-  if (!t8_forest_vtk_write_points
-      (forest, vtufile, write_ghosts, num_data, data)) {
-    /* writings points was not succesful */
-    goto t8_forest_vtk_failure;
-  }
-  /* write the cell data */
-  if (!t8_forest_vtk_write_cells
-      (forest, vtufile, write_treeid, write_mpirank, write_level,
+  if (!t8_forest_vtk_write_piece
+      (forest, &writer, write_treeid, write_mpirank, write_level,
        write_element_id, write_ghosts, num_data, data)) {
-    /* Writing cells was not successful */
     goto t8_forest_vtk_failure;
   }
-
-  freturn = fprintf (vtufile, "    </Piece>\n"
-                     "  </UnstructuredGrid>\n" "</VTKFile>\n");
-  if (freturn <= 0) {
+  if (!t8_forest_vtk_write_footer (&writer)) {
     goto t8_forest_vtk_failure;
   }
 
-  freturn = fclose (vtufile);
+  freturn = fclose (writer.vtufile);
   /* We set it not NULL, even if fclose was not successful, since then any
    * following call to fclose would result in undefined behaviour. */
-  vtufile = NULL;
+  writer.vtufile = NULL;
   if (freturn != 0) {
     /* Closing failed, this usually means that the final write operation could
      * not be completed. */
     t8_global_errorf ("Error when closing file %s\n", vtufilename);
     goto t8_forest_vtk_failure;
   }
-  /* Writing was successful */
-  return 1;
+  freturn = 1;
+  goto t8_forest_vtk_cleanup;
 t8_forest_vtk_failure:
-  if (vtufile != NULL) {
-    fclose (vtufile);
+  if (writer.vtufile != NULL) {
+    fclose (writer.vtufile);
   }
   t8_errorf ("Error when writing vtk file.\n");
+  freturn = 0;
+t8_forest_vtk_cleanup:
+  t8_forest_vtk_writer_reset (&writer);
+  return freturn;
+}
+
+int
+t8_forest_vtk_write_file (t8_forest_t forest, const char *fileprefix,
+                          int write_treeid,
+                          int write_mpirank,
+                          int write_level, int write_element_id,
+                          int write_ghosts,
+                          int num_data, t8_vtk_data_field_t * data)
+{
+  return t8_forest_vtk_write_file_format (forest, fileprefix,
+                                          T8_VTK_FORMAT_ASCII, 0, write_treeid,
+                                          write_mpirank, write_level,
+                                          write_element_id, write_ghosts,
+                                          num_data, data);
+}
+
+/* The maximum number of bytes of a message of the aggregated output */
+#define T8_FOREST_VTK_AGGREGATE_CHUNK (1 << 30)
+
+int
+t8_forest_vtk_write_file_aggregated (t8_forest_t forest,
+                                     const char *fileprefix,
+                                     t8_vtk_format_t format,
+                                     int merge_vertices, int group_size,
+                                     int write_treeid, int write_mpirank,
+                                     int write_level, int write_element_id,
+                                     int write_ghosts, int num_data,
+                                     t8_vtk_data_field_t * data)
+{
+  t8_forest_vtk_writer_t writer;
+  sc_MPI_Comm         groupcomm;
+  char                vtufilename[BUFSIZ];
+  char               *piece = NULL, *chunk;
+  size_t              piece_size = 0;
+  long long           local_size, *sizes = NULL, max_size, offset;
+  int                 group, num_groups, grouprank, groupsize;
+  int                 irank, mpiret, freturn, count;
+  int                 success = 1, global_success;
+#ifndef T8_HAVE_OPEN_MEMSTREAM
+  long                file_size;
+#endif
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (format == T8_VTK_FORMAT_ASCII || format == T8_VTK_FORMAT_BINARY
+             || format == T8_VTK_FORMAT_APPENDED);
+  T8_ASSERT (group_size > 0);
+  if (forest->ghosts == NULL || forest->ghosts->num_ghosts_elements == 0) {
+    /* Never write ghost elements if there aren't any */
+    write_ghosts = 0;
+  }
+  T8_ASSERT (forest->ghosts != NULL || !write_ghosts);
+  if (format == T8_VTK_FORMAT_APPENDED) {
+    /* The offsets into the appended data of a piece are only known after
+     * the previous pieces were written. We thus write the arrays inline. */
+    format = T8_VTK_FORMAT_BINARY;
+  }
+
+  /* The processes mpirank / group_size * group_size, ... ,
+   * mpirank / group_size * group_size + group_size - 1 write one file */
+  group = forest->mpirank / group_size;
+  num_groups = (forest->mpisize + group_size - 1) / group_size;
+
+  writer.vtufile = NULL;
+  writer.format = format;
+  writer.appended = NULL;
+  writer.appended_offset = 0;
+  writer.points = NULL;
+
+  /* process 0 creates the .pvtu file that lists the aggregated files */
+  if (forest->mpirank == 0) {
+    if (t8_write_pvtu
+        (fileprefix, num_groups, write_treeid, write_mpirank,
+         write_level, write_element_id, num_data, data)) {
+      t8_errorf ("Error when writing file %s.pvtu\n", fileprefix);
+      success = 0;
+    }
+  }
+
+  if (merge_vertices) {
+    /* Compute the distinct vertices, each is written once */
+    writer.points = t8_forest_vtk_points_new (forest, write_ghosts);
+  }
+  /* Write the piece of this process into memory */
+#ifdef T8_HAVE_OPEN_MEMSTREAM
+  writer.vtufile = open_memstream (&piece, &piece_size);
+#else
+  /* Without open_memstream, we write the piece to a temporary file and
+   * read it back */
+  writer.vtufile = tmpfile ();
+#endif
+  if (writer.vtufile == NULL) {
+    t8_errorf ("Error when opening memory stream for vtk output.\n");
+    success = 0;
+  }
+  else {
+    if (!t8_forest_vtk_write_piece
+        (forest, &writer, write_treeid, write_mpirank, write_level,
+         write_element_id, write_ghosts, num_data, data)) {
+      t8_errorf ("Error when writing vtk piece.\n");
+      success = 0;
+    }
+#ifndef T8_HAVE_OPEN_MEMSTREAM
+    if (success) {
+      if (fseek (writer.vtufile, 0, SEEK_END) != 0
+          || (file_size = ftell (writer.vtufile)) < 0) {
+        success = 0;
+      }
+      else {
+        /* We allocate with malloc, as open_memstream does */
+        piece_size = (size_t) file_size;
+        piece = (char *) malloc (piece_size + 1);
+        rewind (writer.vtufile);
+        if (piece == NULL
+            || fread (piece, 1, piece_size, writer.vtufile) != piece_size) {
+          t8_errorf ("Error when reading back vtk piece.\n");
+          success = 0;
+        }
+      }
+    }
+#endif
+    if (fclose (writer.vtufile) != 0) {
+      success = 0;
+    }
+    writer.vtufile = NULL;
+  }
+  t8_forest_vtk_writer_reset (&writer);
+  /* A negative size tells the first process of the group that this
+   * process failed */
+  local_size = success ? (long long) piece_size : -1;
+
+  /* Collect the piece sizes of the group on its first process */
+  mpiret = sc_MPI_Comm_split (forest->mpicomm, group, forest->mpirank,
+                              &groupcomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_rank (groupcomm, &grouprank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (groupcomm, &groupsize);
+  SC_CHECK_MPI (mpiret);
+  if (grouprank == 0) {
+    sizes = T8_ALLOC (long long, groupsize);
+  }
+  mpiret = sc_MPI_Gather (&local_size, 1, sc_MPI_LONG_LONG_INT, sizes, 1,
+                          sc_MPI_LONG_LONG_INT, 0, groupcomm);
+  SC_CHECK_MPI (mpiret);
+
+  if (grouprank == 0) {
+    /* The file is only written if all pieces of the group exist */
+    max_size = 0;
+    for (irank = 0; irank < groupsize; irank++) {
+      if (sizes[irank] < 0) {
+        t8_errorf ("Error when writing the vtk piece of group rank %i.\n",
+                   irank);
+        success = 0;
+      }
+      max_size = SC_MAX (max_size, sizes[irank]);
+    }
+    if (success) {
+      freturn = snprintf (vtufilename, BUFSIZ, "%s_%04d.vtu", fileprefix,
+                          group);
+      if (freturn >= BUFSIZ) {
+        t8_errorf ("Error when writing vtu file. Filename too long.\n");
+        success = 0;
+      }
+      else if ((writer.vtufile = fopen (vtufilename, "wb")) == NULL) {
+        t8_errorf ("Error when opening file %s\n", vtufilename);
+        success = 0;
+      }
+      else if (!t8_forest_vtk_write_header (&writer)) {
+        success = 0;
+      }
+    }
+    if (success && sizes[0] > 0
+        && fwrite (piece, 1, piece_size, writer.vtufile) != piece_size) {
+      success = 0;
+    }
+    /* Receive the pieces of the other processes in order and append them
+     * to the file.  A piece may exceed the int count of MPI, we thus
+     * receive it in chunks. */
+    chunk = T8_ALLOC (char, SC_MIN (max_size,
+                                    T8_FOREST_VTK_AGGREGATE_CHUNK) + 1);
+    for (irank = 1; irank < groupsize; irank++) {
+      for (offset = 0; offset < sizes[irank]; offset += count) {
+        count = (int) SC_MIN (sizes[irank] - offset,
+                              T8_FOREST_VTK_AGGREGATE_CHUNK);
+        mpiret = sc_MPI_Recv (chunk, count, sc_MPI_BYTE, irank,
+                              T8_MPI_VTK_AGGREGATE, groupcomm,
+                              sc_MPI_STATUS_IGNORE);
+        SC_CHECK_MPI (mpiret);
+        if (success
+            && fwrite (chunk, 1, count, writer.vtufile) != (size_t) count) {
+          success = 0;
+        }
+      }
+    }
+    T8_FREE (chunk);
+    if (writer.vtufile != NULL) {
+      if (success && !t8_forest_vtk_write_footer (&writer)) {
+        success = 0;
+      }
+      if (fclose (writer.vtufile) != 0) {
+        t8_global_errorf ("Error when closing file %s\n", vtufilename);
+        success = 0;
+      }
+      writer.vtufile = NULL;
+      if (!success) {
+        t8_errorf ("Error when writing file %s\n", vtufilename);
+      }
+    }
+    T8_FREE (sizes);
+  }
+  else {
+    /* Send the piece of this process in chunks */
+    for (offset = 0; offset < local_size; offset += count) {
+      count = (int) SC_MIN (local_size - offset,
+                            T8_FOREST_VTK_AGGREGATE_CHUNK);
+      mpiret = sc_MPI_Send (piece + offset, count, sc_MPI_BYTE, 0,
+                            T8_MPI_VTK_AGGREGATE, groupcomm);
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  /* The piece was allocated by open_memstream */
+  free (piece);
+  mpiret = sc_MPI_Comm_free (&groupcomm);
+  SC_CHECK_MPI (mpiret);
+
+  /* The output is only complete if all processes succeeded */
+  mpiret = sc_MPI_Allreduce (&success, &global_success, 1, sc_MPI_INT,
+                             sc_MPI_MIN, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  return global_success;
+}
+
+/* A vtk output that is written in the background */
+struct t8_forest_vtk_async
+{
+  t8_forest_t         forest;   /* The forest, referenced by this output */
+  char               *fileprefix;
+  t8_vtk_format_t     format;
+  int                 merge_vertices;
+  int                 write_treeid;
+  int                 write_mpirank;
+  int                 write_level;
+  int                 write_element_id;
+  int                 write_ghosts;
+  int                 num_data;
+  t8_vtk_data_field_t *data;    /* Copies of the user data fields */
+  int                 result;   /* The return value of the output */
+#ifdef T8_FOREST_VTK_ASYNC_THREAD
+  std::thread         thread;   /* The thread that writes the files */
+  std::atomic < int > done;     /* True once result is set */
+#endif
+};
+
+/* Write the files of a background output.  This is executed by the
+ * writer thread and only reads the referenced forest. */
+static void
+t8_forest_vtk_async_run (t8_forest_vtk_async * async)
+{
+  /* The partition tables must have been built by the calling thread */
+  T8_ASSERT (async->forest->element_offsets != NULL);
+  T8_ASSERT (async->forest->tree_offsets != NULL);
+  T8_ASSERT (async->forest->global_first_desc != NULL);
+  async->result =
+    t8_forest_vtk_write_file_format (async->forest, async->fileprefix,
+                                     async->format, async->merge_vertices,
+                                     async->write_treeid,
+                                     async->write_mpirank,
+                                     async->write_level,
+                                     async->write_element_id,
+                                     async->write_ghosts, async->num_data,
+                                     async->data);
+#ifdef T8_FOREST_VTK_ASYNC_THREAD
+  async->done.store (1, std::memory_order_release);
+#endif
+}
+
+int
+t8_forest_vtk_write_file_async (t8_forest_vtk_async_t * handle,
+                                t8_forest_t forest, const char *fileprefix,
+                                t8_vtk_format_t format, int merge_vertices,
+                                int write_treeid, int write_mpirank,
+                                int write_level, int write_element_id,
+                                int write_ghosts, int num_data,
+                                t8_vtk_data_field_t * data)
+{
+  t8_forest_vtk_async *async;
+  t8_locidx_t         num_elements;
+  size_t              num_values;
+  int                 idata;
+  int                 previous;
+
+  T8_ASSERT (handle != NULL);
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+  T8_ASSERT (num_data == 0 || data != NULL);
+
+  /* Throttle: at most one output per handle is in flight */
+  previous = t8_forest_vtk_async_wait (handle);
+
+  async = new t8_forest_vtk_async;
+  async->fileprefix = T8_ALLOC (char, strlen (fileprefix) + 1);
+  strcpy (async->fileprefix, fileprefix);
+  async->format = format;
+  async->merge_vertices = merge_vertices;
+  async->write_treeid = write_treeid;
+  async->write_mpirank = write_mpirank;
+  async->write_level = write_level;
+  async->write_element_id = write_element_id;
+  async->write_ghosts = write_ghosts;
+  async->num_data = num_data;
+  async->result = 0;
+
+  /* Stage the user data, the caller may reuse its arrays */
+  async->data = T8_ALLOC (t8_vtk_data_field_t, num_data);
+  num_elements = t8_forest_get_num_element (forest);
+  for (idata = 0; idata < num_data; idata++) {
+    async->data[idata] = data[idata];
+    num_values = (size_t) num_elements
+      * (data[idata].type == T8_VTK_SCALAR ? 1 : 3);
+    async->data[idata].data = T8_ALLOC (double, num_values);
+    memcpy (async->data[idata].data, data[idata].data,
+            num_values * sizeof (double));
+  }
+
+  /* The writer reads the partition tables of the forest.  Partition, ghost
+   * and iterate build these tables on demand and destroy them afterwards.
+   * We build them here, such that these functions leave them untouched
+   * while the thread is running.  The tables are only destroyed together
+   * with the forest, which we keep alive by a reference.  The reference
+   * count is only changed by the calling thread. */
+  if (forest->element_offsets == NULL) {
+    t8_forest_partition_create_offsets (forest);
+  }
+  if (forest->tree_offsets == NULL) {
+    t8_forest_partition_create_tree_offsets (forest);
+  }
+  if (forest->global_first_desc == NULL) {
+    t8_forest_partition_create_first_desc (forest);
+  }
+  t8_forest_ref (forest);
+  async->forest = forest;
+
+#ifdef T8_FOREST_VTK_ASYNC_THREAD
+  async->done.store (0, std::memory_order_relaxed);
+  async->thread = std::thread (t8_forest_vtk_async_run, async);
+#else
+  t8_forest_vtk_async_run (async);
+#endif
+  *handle = async;
+  return previous;
+}
+
+int
+t8_forest_vtk_async_test (t8_forest_vtk_async_t handle)
+{
+  T8_ASSERT (handle != NULL);
+#ifdef T8_FOREST_VTK_ASYNC_THREAD
+  return handle->done.load (std::memory_order_acquire);
+#else
+  return 1;
+#endif
+}
+
+int
+t8_forest_vtk_async_wait (t8_forest_vtk_async_t * handle)
+{
+  t8_forest_vtk_async *async;
+  int                 idata;
+  int                 result;
+
+  T8_ASSERT (handle != NULL);
+  async = *handle;
+  if (async == NULL) {
+    /* There is no output to wait for */
+    return 1;
+  }
+#ifdef T8_FOREST_VTK_ASYNC_THREAD
+  async->thread.join ();
+#endif
+  result = async->result;
+
+  t8_forest_unref (&async->forest);
+  for (idata = 0; idata < async->num_data; idata++) {
+    T8_FREE (async->data[idata].data);
+  }
+  T8_FREE (async->data);
+  T8_FREE (async->fileprefix);
+  delete              async;
+  *handle = NULL;
+  return result;
+}
+
+/* The XDMF type of the cells of each element class in a mixed topology.
+ * Pyramids are not supported. */
+static const int    t8_forest_xdmf_type[T8_ECLASS_COUNT] =
+  { 1, 2, 5, 4, 9, 6, 8, 7 };
+
+/* One data array of the heavy data file of the XDMF output. */
+typedef struct
+{
+  char                name[BUFSIZ];     /* The name of the array. */
+  sc_array_t         *values;   /* The local values of the array. */
+  int                 num_components;   /* The number of values per entry. */
+  int                 is_float; /* True for floating point values. */
+  t8_gloidx_t         offset;   /* The global index of the first local
+                                   value. */
+  t8_gloidx_t         global_count;     /* The global number of values. */
+  long long           file_offset;      /* The offset of the array in
+                                           the heavy data file in bytes. */
+} t8_forest_xdmf_array_t;
+
+/* Add a new array to the arrays of the heavy data file and
+ * return a pointer to it. */
+static t8_forest_xdmf_array_t *
+t8_forest_xdmf_add_array (sc_array_t * arrays, const char *name,
+                          size_t value_size, int num_components,
+                          int is_float)
+{
+  t8_forest_xdmf_array_t *array;
+
+  array = (t8_forest_xdmf_array_t *) sc_array_push (arrays);
+  snprintf (array->name, BUFSIZ, "%s", name);
+  array->values = sc_array_new (value_size);
+  array->num_components = num_components;
+  array->is_float = is_float;
+  array->offset = 0;
+  array->global_count = 0;
+  array->file_offset = 0;
+  return array;
+}
+
+/* Write the local values of all arrays to the heavy data file.
+ * This function is collective. */
+static int
+t8_forest_xdmf_write_heavy (t8_forest_t forest, const char *filename,
+                            sc_array_t * arrays, long long file_size)
+{
+  t8_forest_xdmf_array_t *array;
+  long long           file_offset;
+  size_t              iarray;
+  int                 success = 1;
+#ifdef T8_ENABLE_MPIIO
+  MPI_File            mpifile;
+  MPI_Offset          mpi_offset;
+  size_t              num_bytes;
+  int                 mpiret;
+
+  /* All processes write their part of each array collectively */
+  mpiret = MPI_File_open (forest->mpicomm, (char *) filename,
+                          MPI_MODE_WRONLY | MPI_MODE_CREATE, MPI_INFO_NULL,
+                          &mpifile);
+  SC_CHECK_MPI (mpiret);
+  /* Truncate a possibly existing file */
+  mpiret = MPI_File_set_size (mpifile, (MPI_Offset) file_size);
+  SC_CHECK_MPI (mpiret);
+  for (iarray = 0; iarray < arrays->elem_count; iarray++) {
+    array = (t8_forest_xdmf_array_t *) sc_array_index (arrays, iarray);
+    file_offset = array->file_offset
+      + array->offset * (long long) array->values->elem_size;
+    mpi_offset = (MPI_Offset) file_offset;
+    num_bytes = array->values->elem_count * array->values->elem_size;
+    SC_CHECK_ABORT (num_bytes <= (size_t) INT_MAX,
+                    "Local data array too large for xdmf output.");
+    mpiret = MPI_File_write_at_all (mpifile, mpi_offset,
+                                    array->values->array, (int) num_bytes,
+                                    MPI_BYTE, MPI_STATUS_IGNORE);
+    SC_CHECK_MPI (mpiret);
+  }
+  mpiret = MPI_File_close (&mpifile);
+  SC_CHECK_MPI (mpiret);
+#else
+  FILE               *file;
+  int                 irank, mpiret;
+
+  /* Without MPI I/O the processes write their parts one after the other */
+  for (irank = 0; irank < forest->mpisize; irank++) {
+    if (irank == forest->mpirank) {
+      file = fopen (filename, irank == 0 ? "wb" : "r+b");
+      if (file == NULL) {
+        t8_errorf ("Error when opening file %s\n", filename);
+        success = 0;
+      }
+      for (iarray = 0; success && iarray < arrays->elem_count; iarray++) {
+        array = (t8_forest_xdmf_array_t *) sc_array_index (arrays, iarray);
+        file_offset = array->file_offset
+          + array->offset * (long long) array->values->elem_size;
+        if (fseek (file, (long) file_offset, SEEK_SET)
+            || fwrite (array->values->array, array->values->elem_size,
+                       array->values->elem_count, file)
+            != array->values->elem_count) {
+          t8_errorf ("Error when writing file %s\n", filename);
+          success = 0;
+        }
+      }
+      if (file != NULL && fclose (file)) {
+        t8_errorf ("Error when closing file %s\n", filename);
+        success = 0;
+      }
+    }
+    mpiret = sc_MPI_Barrier (forest->mpicomm);
+    SC_CHECK_MPI (mpiret);
+  }
+#endif
+  return success;
+}
+
+/* Write the xml description of one data array. */
+static int
+t8_forest_xdmf_write_data_item (FILE * xmffile,
+                                const t8_forest_xdmf_array_t * array,
+                                const char *heavy_filename)
+{
+  int                 freturn;
+
+  if (array->num_components > 1) {
+    freturn = fprintf (xmffile, "        <DataItem Dimensions=\"%lld %i\"",
+                       (long long) array->global_count
+                       / array->num_components, array->num_components);
+  }
+  else {
+    freturn = fprintf (xmffile, "        <DataItem Dimensions=\"%lld\"",
+                       (long long) array->global_count);
+  }
+  if (freturn <= 0) {
+    return 0;
+  }
+  freturn = fprintf (xmffile, " NumberType=\"%s\" Precision=\"%i\""
+                     " Format=\"Binary\" Endian=\"%s\" Seek=\"%lld\">\n"
+                     "          %s\n        </DataItem>\n",
+                     array->is_float ? "Float" : "Int",
+                     (int) array->values->elem_size,
+#ifdef SC_IS_BIGENDIAN
+                     "Big",
+#else
+                     "Little",
+#endif
+                     array->file_offset, heavy_filename);
+  return freturn > 0;
+}
+
+/* Write the light data file describing the forest and the arrays
+ * in the heavy data file. */
+static int
+t8_forest_xdmf_write_light (t8_forest_t forest, const char *filename,
+                            const char *heavy_filename, sc_array_t * arrays)
+{
+  FILE               *xmffile;
+  t8_forest_xdmf_array_t *array;
+  size_t              iarray;
+  int                 freturn;
+
+  xmffile = fopen (filename, "w");
+  if (xmffile == NULL) {
+    t8_errorf ("Error when opening file %s\n", filename);
+    return 0;
+  }
+  freturn = fprintf (xmffile, "<?xml version=\"1.0\" ?>\n"
+                     "<!DOCTYPE Xdmf SYSTEM \"Xdmf.dtd\" []>\n"
+                     "<Xdmf Version=\"2.0\">\n"
+                     "  <Domain>\n"
+                     "    <Grid Name=\"t8_forest\" GridType=\"Uniform\">\n");
+  if (freturn <= 0) {
+    goto t8_forest_xdmf_failure;
+  }
+  /* The first array is the geometry and the second the topology,
+   * all other arrays are cell data */
+  for (iarray = 0; iarray < arrays->elem_count; iarray++) {
+    array = (t8_forest_xdmf_array_t *) sc_array_index (arrays, iarray);
+    if (iarray == 0) {
+      freturn = fprintf (xmffile, "      <Geometry GeometryType=\"XYZ\">\n");
+    }
+    else if (iarray == 1) {
+      freturn = fprintf (xmffile, "      <Topology TopologyType=\"Mixed\""
+                         " NumberOfElements=\"%lld\">\n",
+                         (long long) forest->global_num_elements);
+    }
+    else {
+      freturn = fprintf (xmffile, "      <Attribute Name=\"%s\""
+                         " AttributeType=\"%s\" Center=\"Cell\">\n",
+                         array->name,
+                         array->num_components > 1 ? "Vector" : "Scalar");
+    }
+    if (freturn <= 0) {
+      goto t8_forest_xdmf_failure;
+    }
+    if (!t8_forest_xdmf_write_data_item (xmffile, array, heavy_filename)) {
+      goto t8_forest_xdmf_failure;
+    }
+    freturn = fprintf (xmffile, "      </%s>\n", iarray == 0 ? "Geometry" :
+                       iarray == 1 ? "Topology" : "Attribute");
+    if (freturn <= 0) {
+      goto t8_forest_xdmf_failure;
+    }
+  }
+  freturn = fprintf (xmffile, "    </Grid>\n  </Domain>\n</Xdmf>\n");
+  if (freturn <= 0) {
+    goto t8_forest_xdmf_failure;
+  }
+  if (fclose (xmffile)) {
+    t8_errorf ("Error when closing file %s\n", filename);
+    return 0;
+  }
+  return 1;
+t8_forest_xdmf_failure:
+  t8_errorf ("Error when writing file %s\n", filename);
+  fclose (xmffile);
   return 0;
 }
 
+int
+t8_forest_vtk_write_xdmf (t8_forest_t forest, const char *fileprefix,
+                          int write_treeid, int write_mpirank,
+                          int write_level, int write_element_id,
+                          int num_data, t8_vtk_data_field_t * data)
+{
+  t8_forest_vtk_points_t *points;
+  t8_forest_xdmf_array_t *array;
+  sc_array_t         *arrays;
+  t8_gloidx_t         local_counts[2], global_counts[2], offsets[2];
+  t8_gloidx_t         first_element;
+  t8_locidx_t         itree, num_local_trees, ielement, num_elements;
+  t8_locidx_t         icorner;
+  t8_eclass_t         eclass;
+  char                xmffilename[BUFSIZ], heavyfilename[BUFSIZ];
+  const char         *heavy_basename;
+  long long           file_offset;
+  size_t              iarray;
+  int                 idata, ivertex, success, mpiret;
+
+  T8_ASSERT (forest != NULL);
+  T8_ASSERT (t8_forest_is_committed (forest));
+  T8_ASSERT (fileprefix != NULL);
+
+  if (snprintf (xmffilename, BUFSIZ, "%s.xmf", fileprefix) >= BUFSIZ
+      || snprintf (heavyfilename, BUFSIZ, "%s.bin", fileprefix) >= BUFSIZ) {
+    t8_global_errorf ("Error when writing xdmf file. Filename too long.\n");
+    return 0;
+  }
+  /* The light data file refers to the heavy data file relative to its
+   * own directory */
+  heavy_basename = strrchr (heavyfilename, '/');
+  heavy_basename = heavy_basename == NULL ? heavyfilename :
+    heavy_basename + 1;
+
+  arrays = sc_array_new (sizeof (t8_forest_xdmf_array_t));
+  /* The vertices of the local elements, each written once */
+  points = t8_forest_vtk_points_new (forest, 0);
+  array = t8_forest_xdmf_add_array (arrays, "geometry", sizeof (double), 3, 1);
+  sc_array_resize (array->values, 3 * points->num_points);
+  memcpy (array->values->array, points->coordinates,
+          3 * points->num_points * sizeof (double));
+
+  /* Compute the global offsets of the vertices and of the topology */
+  local_counts[0] = points->num_points;
+  local_counts[1] = 0;
+  num_local_trees = t8_forest_get_num_local_trees (forest);
+  for (itree = 0; itree < num_local_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    SC_CHECK_ABORT (eclass != T8_ECLASS_PYRAMID,
+                    "Pyramids are not supported in xdmf output");
+    /* Each cell is given by its type, the number of vertices for
+     * vertices and lines, and its vertices */
+    local_counts[1] += t8_forest_get_tree_num_elements (forest, itree)
+      * (1 + (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_LINE)
+         + t8_eclass_num_vertices[eclass]);
+  }
+  mpiret = sc_MPI_Scan (local_counts, offsets, 2, T8_MPI_GLOIDX,
+                        sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Allreduce (local_counts, global_counts, 2, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, forest->mpicomm);
+  SC_CHECK_MPI (mpiret);
+  offsets[0] -= local_counts[0];
+  offsets[1] -= local_counts[1];
+  array->offset = 3 * offsets[0];
+  array->global_count = 3 * global_counts[0];
+
+  /* The topology refers to the global indices of the vertices */
+  array = t8_forest_xdmf_add_array (arrays, "topology", sizeof (int64_t), 1,
+                                    0);
+  icorner = 0;
+  for (itree = 0; itree < num_local_trees; itree++) {
+    eclass = t8_forest_get_tree_class (forest, itree);
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      t8_forest_vtk_push_int (array->values, t8_forest_xdmf_type[eclass]);
+      if (eclass == T8_ECLASS_VERTEX || eclass == T8_ECLASS_LINE) {
+        t8_forest_vtk_push_int (array->values,
+                                t8_eclass_num_vertices[eclass]);
+      }
+      for (ivertex = 0; ivertex < t8_eclass_num_vertices[eclass];
+           ivertex++, icorner++) {
+        t8_forest_vtk_push_int (array->values, offsets[0]
+                                + points->corner_points[icorner]);
+      }
+    }
+  }
+  T8_ASSERT (icorner == points->num_corners);
+  T8_ASSERT ((t8_gloidx_t) array->values->elem_count == local_counts[1]);
+  array->offset = offsets[1];
+  array->global_count = global_counts[1];
+  t8_forest_vtk_points_destroy (points);
+
+  /* The cell data */
+  if (write_treeid) {
+    array = t8_forest_xdmf_add_array (arrays, "treeid", sizeof (int64_t),
+                                      1, 0);
+    t8_forest_vtk_compute_cell_data (forest,
+                                     t8_forest_vtk_cells_treeid_kernel, 0,
+                                     NULL, array->values);
+  }
+  if (write_mpirank) {
+    array = t8_forest_xdmf_add_array (arrays, "mpirank", sizeof (int32_t),
+                                      1, 0);
+    t8_forest_vtk_compute_cell_data (forest, t8_forest_vtk_cells_rank_kernel,
+                                     0, NULL, array->values);
+  }
+  if (write_level) {
+    array = t8_forest_xdmf_add_array (arrays, "level", sizeof (int32_t),
+                                      1, 0);
+    t8_forest_vtk_compute_cell_data (forest,
+                                     t8_forest_vtk_cells_level_kernel, 0,
+                                     NULL, array->values);
+  }
+  if (write_element_id) {
+    array = t8_forest_xdmf_add_array (arrays, "element_id",
+                                      sizeof (int64_t), 1, 0);
+    t8_forest_vtk_compute_cell_data (forest,
+                                     t8_forest_vtk_cells_elementid_kernel, 0,
+                                     NULL, array->values);
+  }
+  for (idata = 0; idata < num_data; idata++) {
+    if (data[idata].type == T8_VTK_SCALAR) {
+      array = t8_forest_xdmf_add_array (arrays, data[idata].description,
+                                        sizeof (T8_VTK_FLOAT_TYPE), 1, 1);
+      t8_forest_vtk_compute_cell_data (forest,
+                                       t8_forest_vtk_cells_scalar_kernel, 0,
+                                       data[idata].data, array->values);
+    }
+    else {
+      T8_ASSERT (data[idata].type == T8_VTK_VECTOR);
+      array = t8_forest_xdmf_add_array (arrays, data[idata].description,
+                                        sizeof (T8_VTK_FLOAT_TYPE), 3, 1);
+      t8_forest_vtk_compute_cell_data (forest,
+                                       t8_forest_vtk_cells_vector_kernel, 0,
+                                       data[idata].data, array->values);
+    }
+  }
+  /* The cell data arrays are placed according to the global element ids */
+  first_element = t8_forest_get_first_local_element_id (forest);
+  file_offset = 0;
+  for (iarray = 0; iarray < arrays->elem_count; iarray++) {
+    array = (t8_forest_xdmf_array_t *) sc_array_index (arrays, iarray);
+    if (iarray >= 2) {
+      array->offset = first_element * array->num_components;
+      array->global_count =
+        forest->global_num_elements * array->num_components;
+      T8_ASSERT ((t8_gloidx_t) array->values->elem_count ==
+                 t8_forest_get_num_element (forest) * array->num_components);
+    }
+    array->file_offset = file_offset;
+    file_offset += array->global_count * (long long) array->values->elem_size;
+  }
+
+  /* Write the heavy data collectively and the light data on rank 0 */
+  success = t8_forest_xdmf_write_heavy (forest, heavyfilename, arrays,
+                                        file_offset);
+  if (success && forest->mpirank == 0) {
+    success = t8_forest_xdmf_write_light (forest, xmffilename,
+                                          heavy_basename, arrays);
+  }
+
+  for (iarray = 0; iarray < arrays->elem_count; iarray++) {
+    array = (t8_forest_xdmf_array_t *) sc_array_index (arrays, iarray);
+    sc_array_destroy (array->values);
+  }
+  sc_array_destroy (arrays);
+  return success;
+}
+
 T8_EXTERN_C_END ();
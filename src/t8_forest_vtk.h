@@ -35,7 +35,7 @@ T8_EXTERN_C_BEGIN ();
 /* function declarations */
 
 /** Write the forest in .pvtu file format. Writes one .vtu file per
- * process and a meta .pvtu file.
+ * process and a meta .pvtu file. The data arrays are written in ascii format.
  * \param [in]  forest    The forest.
  * \param [in]  fileprefix  The prefix of the output files.
  * \param [in]  write_treeid If true, the global tree id is written for each element.
@@ -61,6 +61,212 @@ int                 t8_forest_vtk_write_file (t8_forest_t forest,
                                               int num_data,
                                               t8_vtk_data_field_t * data);
 
+/** Write the forest in .pvtu file format with a given format of the data
+ * arrays. Writes one .vtu file per process and a meta .pvtu file.
+ * The values of each data array are collected in a buffer and written
+ * at once. The binary formats produce considerably smaller files and are
+ * faster to write and read than ascii.
+ * \param [in]  forest    The forest.
+ * \param [in]  fileprefix  The prefix of the output files.
+ * \param [in]  format    The format of the data arrays, see \ref t8_vtk_format_t.
+ * \param [in]  merge_vertices If true, the element corners at the same
+ *                        position are identified and each vertex is written
+ *                        only once. This gives considerably smaller files.
+ *                        Corners are identified within a tree via their
+ *                        integer coordinates and across trees via their
+ *                        coordinates.
+ *                        User defined data fields are written as point data
+ *                        by averaging the values of the elements at a vertex.
+ *                        If false, the corners of each element are written
+ *                        separately.
+ * \param [in]  write_treeid If true, the global tree id is written for each element.
+ * \param [in]  write_mpirank If true, the mpirank is written for each element .
+ * \param [in]  write_level If true, the refinement level is written for each element.
+ * \param [in]  write_element_id If true, the global element id is written for each element.
+ * \param [in]  write_ghosts If true, each process additionally writes its ghost elements.
+ *                           For ghost element the treeid is -1.
+ * \param [in]  num_data  Number of user defined double valued data fields to write.
+ * \param [in]  data      Array of t8_vtk_data_field_t of length \a num_data
+ *                        providing the used defined per element data.
+ *                        If scalar and vector fields are used, all scalar fields
+ *                        must come first in the array.
+ * \return  True if succesful, false if not (process local).
+ * \see t8_forest_vtk_write_file
+ */
+int                 t8_forest_vtk_write_file_format (t8_forest_t forest,
+                                                     const char *fileprefix,
+                                                     t8_vtk_format_t format,
+                                                     int merge_vertices,
+                                                     int write_treeid,
+                                                     int write_mpirank,
+                                                     int write_level,
+                                                     int write_element_id,
+                                                     int write_ghosts,
+                                                     int num_data,
+                                                     t8_vtk_data_field_t *
+                                                     data);
+
+/** Write the forest in .pvtu file format into fewer files than processes.
+ * The processes are split into groups of \a group_size consecutive ranks.
+ * Each process writes its elements into a buffer in memory, and the first
+ * process of each group receives these buffers one after the other and
+ * appends them as the pieces of one .vtu file.  If a process of a group
+ * fails to write its piece, the file of the group is not written.
+ * Process 0 writes the meta .pvtu file that
+ * lists these files.  By choosing the group size, the number of files can
+ * be matched to the file system, for example to its stripe count.
+ * With a group size of 1 the output is that of
+ * \ref t8_forest_vtk_write_file_format, with a group size of at least the
+ * number of processes one .vtu file is written.
+ * This function is collective.
+ * \param [in]  forest    The forest.
+ * \param [in]  fileprefix  The prefix of the output files.
+ * \param [in]  format    The format of the data arrays, see \ref t8_vtk_format_t.
+ *                        \ref T8_VTK_FORMAT_APPENDED is written as
+ *                        \ref T8_VTK_FORMAT_BINARY, since the pieces of a
+ *                        file are written independently.
+ * \param [in]  merge_vertices If true, each vertex of a process is written
+ *                        only once, see \ref t8_forest_vtk_write_file_format.
+ * \param [in]  group_size The number of processes that write into one file.
+ *                        Must be positive.
+ * \param [in]  write_treeid If true, the global tree id is written for each element.
+ * \param [in]  write_mpirank If true, the mpirank is written for each element .
+ * \param [in]  write_level If true, the refinement level is written for each element.
+ * \param [in]  write_element_id If true, the global element id is written for each element.
+ * \param [in]  write_ghosts If true, each process additionally writes its ghost elements.
+ * \param [in]  num_data  Number of user defined double valued data fields to write.
+ * \param [in]  data      Array of t8_vtk_data_field_t of length \a num_data
+ *                        providing the used defined per element data.
+ * \return  True if succesful on all processes, false if not.
+ */
+int                 t8_forest_vtk_write_file_aggregated (t8_forest_t forest,
+                                                         const char
+                                                         *fileprefix,
+                                                         t8_vtk_format_t
+                                                         format,
+                                                         int merge_vertices,
+                                                         int group_size,
+                                                         int write_treeid,
+                                                         int write_mpirank,
+                                                         int write_level,
+                                                         int
+                                                         write_element_id,
+                                                         int write_ghosts,
+                                                         int num_data,
+                                                         t8_vtk_data_field_t
+                                                         * data);
+
+/** The handle of a vtk output that is written in the background.
+ * \see t8_forest_vtk_write_file_async */
+typedef struct t8_forest_vtk_async *t8_forest_vtk_async_t;
+
+/** Write the forest in .pvtu file format in the background.
+ * The output is the same as that of \ref t8_forest_vtk_write_file_format.
+ * The user defined data fields are copied and the forest is referenced,
+ * such that the caller may change \a data and unref \a forest directly
+ * after this function returns.  The files are then written by a
+ * separate thread while the caller continues its computation.
+ * If \a handle points to the handle of a previous write that is still
+ * running, this function first waits for it to finish.  Thus at most one
+ * output per handle is in flight and the calling loop is throttled to
+ * the speed of the file system.
+ * This function is collective.  The writer thread does not communicate.
+ * It only reads the forest, so the forest must not be changed while it is
+ * written, except by referencing it or by using it as the source of a new
+ * forest.  The partition tables of the forest, which partition, ghost and
+ * iterate would otherwise create and destroy on demand, are built before
+ * the thread starts.  The thread creates and destroys
+ * elements, which is only safe if the eclass schemes of the forest can be
+ * used concurrently, as the default schemes can.
+ * If t8code is compiled without C++11 support or libsc is configured
+ * without pthread support, the files are written before this function
+ * returns.
+ * \param [in,out] handle On input a handle returned by a previous call
+ *                        or NULL.  On output the handle of this write.
+ *                        It must be passed to \ref t8_forest_vtk_async_wait
+ *                        or to the next call of this function.
+ * \param [in]  forest    The committed forest.  It is referenced until
+ *                        the write has finished.
+ * \param [in]  fileprefix  The prefix of the output files.
+ * \param [in]  format    The format of the data arrays, see \ref t8_vtk_format_t.
+ * \param [in]  merge_vertices If true, each vertex is written only once,
+ *                        see \ref t8_forest_vtk_write_file_format.
+ * \param [in]  write_treeid If true, the global tree id is written for each element.
+ * \param [in]  write_mpirank If true, the mpirank is written for each element .
+ * \param [in]  write_level If true, the refinement level is written for each element.
+ * \param [in]  write_element_id If true, the global element id is written for each element.
+ * \param [in]  write_ghosts If true, each process additionally writes its ghost elements.
+ * \param [in]  num_data  Number of user defined double valued data fields to write.
+ * \param [in]  data      Array of t8_vtk_data_field_t of length \a num_data
+ *                        providing the used defined per element data.
+ * \return  True if the previous write that \a handle referred to was
+ *          succesful or if there was none, false if not (process local).
+ */
+int                 t8_forest_vtk_write_file_async (t8_forest_vtk_async_t *
+                                                    handle,
+                                                    t8_forest_t forest,
+                                                    const char *fileprefix,
+                                                    t8_vtk_format_t format,
+                                                    int merge_vertices,
+                                                    int write_treeid,
+                                                    int write_mpirank,
+                                                    int write_level,
+                                                    int write_element_id,
+                                                    int write_ghosts,
+                                                    int num_data,
+                                                    t8_vtk_data_field_t *
+                                                    data);
+
+/** Query whether a background vtk output has finished.
+ * \param [in]  handle    A handle returned by
+ *                        \ref t8_forest_vtk_write_file_async.
+ * \return  True if the files are completely written, false if the
+ *          writer thread is still running.
+ */
+int                 t8_forest_vtk_async_test (t8_forest_vtk_async_t handle);
+
+/** Wait for a background vtk output to finish and free its handle.
+ * The reference of the forest that was written is released.
+ * \param [in,out] handle The handle of the write or NULL.  It is set to
+ *                        NULL on output.
+ * \return  True if the write was succesful or if \a handle was NULL,
+ *          false if not (process local).
+ */
+int                 t8_forest_vtk_async_wait (t8_forest_vtk_async_t *
+                                              handle);
+
+/** Write the forest into one XDMF file and one raw binary data file.
+ * Other than \ref t8_forest_vtk_write_file, this does not create a file
+ * per process. The light data file fileprefix.xmf is written by process 0
+ * and describes the arrays in the heavy data file fileprefix.bin, which all
+ * processes write collectively with MPI I/O. Each process writes its part
+ * of the arrays at the offset given by its first global element id.
+ * The vertices of the local elements are merged, see
+ * \ref t8_forest_vtk_write_file_format.
+ * If t8code is configured without MPI I/O, the processes write their
+ * parts one after the other.
+ * This function is collective and the output can be read with ParaView
+ * or VisIt.
+ * \param [in]  forest    The forest.
+ * \param [in]  fileprefix  The prefix of the output files.
+ * \param [in]  write_treeid If true, the global tree id is written for each element.
+ * \param [in]  write_mpirank If true, the mpirank is written for each element .
+ * \param [in]  write_level If true, the refinement level is written for each element.
+ * \param [in]  write_element_id If true, the global element id is written for each element.
+ * \param [in]  num_data  Number of user defined double valued data fields to write.
+ * \param [in]  data      Array of t8_vtk_data_field_t of length \a num_data
+ *                        providing the used defined per element data.
+ * \return  True if succesful, false if not (process local).
+ */
+int                 t8_forest_vtk_write_xdmf (t8_forest_t forest,
+                                              const char *fileprefix,
+                                              int write_treeid,
+                                              int write_mpirank,
+                                              int write_level,
+                                              int write_element_id,
+                                              int num_data,
+                                              t8_vtk_data_field_t * data);
+
 T8_EXTERN_C_END ();
 
 #endif /* !T8_FOREST_VTK_H */
@@ -71,6 +71,16 @@ typedef struct
                       n = 1 if type = T8_VTK_SCALAR, n = 3 if type = T8_VTK_VECTOR */
 } t8_vtk_data_field_t;
 
+/** The formats in which the data arrays of a vtu file can be written. */
+typedef enum
+{
+  T8_VTK_FORMAT_ASCII,          /**< Human readable ascii values. */
+  T8_VTK_FORMAT_BINARY,         /**< Base64 encoded binary values, zlib compressed
+                                     if sc is configured with zlib. */
+  T8_VTK_FORMAT_APPENDED        /**< Raw binary values in an appended section
+                                     at the end of the file. */
+} t8_vtk_format_t;
+
 T8_EXTERN_C_BEGIN ();
 
 /* function declarations */
@@ -0,0 +1,316 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_readmshfile.h>
+#include "t8_cmesh/t8_cmesh_types.h"
+#include "t8_cmesh/t8_cmesh_trees.h"
+#include "t8_cmesh/t8_cmesh_msh_file.h"
+
+/* In this test, we write a hybrid mesh of triangles and quadrilaterals
+ * to a .msh file and read it once on every process and once in parallel
+ * with all processes.  We check that both cmeshes have the same trees,
+ * vertices and face connections.
+ * We also read the same mesh stored in the ascii format of version 2 and
+ * in the ascii and binary formats of version 4.1 and check that the
+ * cmeshes are equal.  Finally, we compare the number parser of the reader
+ * with strtod. */
+
+/* The directory of the test mesh files */
+#ifndef T8_TEST_MSH_FILE_DIR
+#define T8_TEST_MSH_FILE_DIR "test/testfiles"
+#endif
+
+/* The number of grid cells in x and y direction */
+#define T8_TEST_READMSH_NX 7
+#define T8_TEST_READMSH_NY 5
+
+/* The index of the node at grid position (x, y) in the .msh file.
+ * The nodes are numbered in a permuted order with gaps. */
+static long
+t8_test_readmsh_node (int x, int y)
+{
+  const long          num_nodes =
+    (T8_TEST_READMSH_NX + 1) * (T8_TEST_READMSH_NY + 1);
+
+  /* 11 and the number of nodes are coprime */
+  return 3 * ((11 * (x + (T8_TEST_READMSH_NX + 1) * y)) % num_nodes) + 7;
+}
+
+/* Write a grid in which every third cell is split into two triangles
+ * and the other cells are quadrilaterals.  The lines at the bottom are
+ * written as well and must be ignored when reading dimension 2. */
+static void
+t8_test_readmsh_write (const char *filename)
+{
+  FILE               *file;
+  int                 x, y, num_elements, id;
+
+  file = fopen (filename, "w");
+  SC_CHECK_ABORTF (file != NULL, "Could not open file %s", filename);
+  fprintf (file, "$MeshFormat\n2.2 0 8\n$EndMeshFormat\n");
+  fprintf (file, "$Nodes\n%i\n",
+           (T8_TEST_READMSH_NX + 1) * (T8_TEST_READMSH_NY + 1));
+  /* Write the nodes in reverse order */
+  for (y = T8_TEST_READMSH_NY; y >= 0; y--) {
+    for (x = T8_TEST_READMSH_NX; x >= 0; x--) {
+      fprintf (file, "%li %.17g %.17g 0\n", t8_test_readmsh_node (x, y),
+               0.25 * x, 0.37 * y - 12.5);
+    }
+  }
+  fprintf (file, "$EndNodes\n$Elements\n");
+  num_elements = T8_TEST_READMSH_NX;
+  for (y = 0; y < T8_TEST_READMSH_NY; y++) {
+    for (x = 0; x < T8_TEST_READMSH_NX; x++) {
+      num_elements += (x + y) % 3 == 0 ? 2 : 1;
+    }
+  }
+  fprintf (file, "%i\n", num_elements);
+  id = 1;
+  for (x = 0; x < T8_TEST_READMSH_NX; x++) {
+    fprintf (file, "%i 1 2 0 1 %li %li\n", id++, t8_test_readmsh_node (x, 0),
+             t8_test_readmsh_node (x + 1, 0));
+  }
+  for (y = 0; y < T8_TEST_READMSH_NY; y++) {
+    for (x = 0; x < T8_TEST_READMSH_NX; x++) {
+      if ((x + y) % 3 == 0) {
+        fprintf (file, "%i 2 2 0 1 %li %li %li\n", id++,
+                 t8_test_readmsh_node (x, y),
+                 t8_test_readmsh_node (x + 1, y),
+                 t8_test_readmsh_node (x + 1, y + 1));
+        fprintf (file, "%i 2 2 0 1 %li %li %li\n", id++,
+                 t8_test_readmsh_node (x, y),
+                 t8_test_readmsh_node (x + 1, y + 1),
+                 t8_test_readmsh_node (x, y + 1));
+      }
+      else {
+        fprintf (file, "%i 3 2 0 1 %li %li %li %li\n", id++,
+                 t8_test_readmsh_node (x, y),
+                 t8_test_readmsh_node (x + 1, y),
+                 t8_test_readmsh_node (x + 1, y + 1),
+                 t8_test_readmsh_node (x, y + 1));
+      }
+    }
+  }
+  fprintf (file, "$EndElements\n");
+  SC_CHECK_ABORT (fclose (file) == 0, "Could not write the mesh file");
+}
+
+/* Check that the local trees of a cmesh equal those of a replicated
+ * cmesh: their eclass, vertices, face neighbors and orientations. */
+static void
+t8_test_readmsh_compare (t8_cmesh_t cmesh, t8_cmesh_t cmesh_replicated)
+{
+  t8_locidx_t         ltree, *face_neigh, *face_neigh_replicated;
+  t8_gloidx_t         gtree;
+  int8_t             *ttf, *ttf_replicated;
+  t8_eclass_t         eclass;
+  double             *vertices, *vertices_replicated;
+  int                 iface;
+
+  for (ltree = 0; ltree < t8_cmesh_get_num_local_trees (cmesh); ltree++) {
+    gtree = t8_cmesh_get_global_id (cmesh, ltree);
+    eclass = t8_cmesh_get_tree_class (cmesh, ltree);
+    SC_CHECK_ABORT (eclass == t8_cmesh_get_tree_class (cmesh_replicated,
+                                                       gtree),
+                    "The trees have different eclasses");
+    vertices = t8_cmesh_get_tree_vertices (cmesh, ltree);
+    vertices_replicated = t8_cmesh_get_tree_vertices (cmesh_replicated,
+                                                      gtree);
+    SC_CHECK_ABORT (vertices != NULL && vertices_replicated != NULL
+                    && !memcmp (vertices, vertices_replicated,
+                                3 * t8_eclass_num_vertices[eclass]
+                                * sizeof (double)),
+                    "The trees have different vertices");
+    (void) t8_cmesh_trees_get_tree_ext (cmesh->trees, ltree, &face_neigh,
+                                        &ttf);
+    (void) t8_cmesh_trees_get_tree_ext (cmesh_replicated->trees, gtree,
+                                        &face_neigh_replicated,
+                                        &ttf_replicated);
+    for (iface = 0; iface < t8_eclass_num_faces[eclass]; iface++) {
+      SC_CHECK_ABORT (t8_cmesh_get_global_id (cmesh, face_neigh[iface])
+                      == face_neigh_replicated[iface],
+                      "The trees have different face neighbors");
+      SC_CHECK_ABORT (ttf[iface] == ttf_replicated[iface],
+                      "The trees have different face connections");
+      SC_CHECK_ABORT (t8_cmesh_tree_face_is_boundary (cmesh, ltree, iface)
+                      == t8_cmesh_tree_face_is_boundary (cmesh_replicated,
+                                                         gtree, iface),
+                      "The trees have different boundary faces");
+    }
+  }
+}
+
+static void
+t8_test_cmesh_readmsh (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_replicated, cmesh_master, cmesh_distributed;
+  int                 mpirank, mpiret;
+  const char         *fileprefix = "test_cmesh_readmsh";
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  if (mpirank == 0) {
+    t8_test_readmsh_write ("test_cmesh_readmsh.msh");
+  }
+  mpiret = sc_MPI_Barrier (comm);
+  SC_CHECK_MPI (mpiret);
+
+  /* Every process reads the whole file */
+  cmesh_replicated = t8_cmesh_from_msh_file (fileprefix, 0, comm, 2, 0);
+  SC_CHECK_ABORT (cmesh_replicated != NULL, "Could not read the mesh file");
+  /* Process 0 reads the file and holds all trees */
+  cmesh_master = t8_cmesh_from_msh_file (fileprefix, 1, comm, 2, 0);
+  SC_CHECK_ABORT (cmesh_master != NULL, "Could not read the mesh file");
+  /* All processes read a part of the file */
+  cmesh_distributed = t8_cmesh_from_msh_file (fileprefix, 1, comm, 2, -1);
+  SC_CHECK_ABORT (cmesh_distributed != NULL, "Could not read the mesh file");
+
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh_master)
+                  == t8_cmesh_get_num_trees (cmesh_replicated)
+                  && t8_cmesh_get_num_trees (cmesh_distributed)
+                  == t8_cmesh_get_num_trees (cmesh_replicated),
+                  "The cmeshes have different numbers of trees");
+  t8_test_readmsh_compare (cmesh_master, cmesh_replicated);
+  t8_test_readmsh_compare (cmesh_distributed, cmesh_replicated);
+
+  t8_cmesh_destroy (&cmesh_distributed);
+  t8_cmesh_destroy (&cmesh_master);
+  t8_cmesh_destroy (&cmesh_replicated);
+}
+
+/* Read the same mesh from each supported file format and check that the
+ * cmeshes are equal. */
+static void
+t8_test_cmesh_readmsh_formats (sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_reference, cmesh, cmesh_distributed;
+  int                 iformat;
+  const char         *formats[3] = { "vers2_ascii", "vers4_ascii",
+    "vers4_bin"
+  };
+  char                fileprefix[BUFSIZ];
+
+  snprintf (fileprefix, BUFSIZ, "%s/test_msh_file_%s",
+            T8_TEST_MSH_FILE_DIR, formats[0]);
+  cmesh_reference = t8_cmesh_from_msh_file (fileprefix, 0, comm, 2, 0);
+  SC_CHECK_ABORTF (cmesh_reference != NULL, "Could not read file %s.msh",
+                   fileprefix);
+  /* The mesh has 4 triangles and 4 quadrilaterals */
+  SC_CHECK_ABORT (t8_cmesh_get_num_trees (cmesh_reference) == 8,
+                  "Wrong number of trees");
+  for (iformat = 0; iformat < 3; iformat++) {
+    snprintf (fileprefix, BUFSIZ, "%s/test_msh_file_%s",
+              T8_TEST_MSH_FILE_DIR, formats[iformat]);
+    t8_global_productionf ("Reading file %s.msh\n", fileprefix);
+    cmesh = t8_cmesh_from_msh_file (fileprefix, 0, comm, 2, 0);
+    SC_CHECK_ABORTF (cmesh != NULL, "Could not read file %s.msh",
+                     fileprefix);
+    SC_CHECK_ABORTF (t8_cmesh_is_equal (cmesh, cmesh_reference),
+                     "The mesh of file %s.msh differs", fileprefix);
+    t8_cmesh_destroy (&cmesh);
+    cmesh_distributed = t8_cmesh_from_msh_file (fileprefix, 1, comm, 2, -1);
+    SC_CHECK_ABORTF (cmesh_distributed != NULL,
+                     "Could not read file %s.msh", fileprefix);
+    t8_test_readmsh_compare (cmesh_distributed, cmesh_reference);
+    t8_cmesh_destroy (&cmesh_distributed);
+  }
+  t8_cmesh_destroy (&cmesh_reference);
+}
+
+/* Check that the number parser of the reader yields the same value and
+ * the same end of the number as strtod. */
+static void
+t8_test_cmesh_readmsh_parse_double ()
+{
+  const char         *numbers[] = {
+    "0", "-0", "+0", "+1.5", "-.25e+2", ".5", "5.", "1.e3",
+    /* Incomplete exponents are not part of the number */
+    "1e", "1E+", "1e-", "2.5e", "1e 5", "1e5x", "12.5abc",
+    /* The fast path ends at 1e22 and 2^53 */
+    "1e22", "1e23", "1e-22", "3e-23", "9007199254740992",
+    "9007199254740993", "0.30000000000000004",
+    /* Mantissas with more than 19 digits */
+    "9999999999999999999", "99999999999999999999", "18446744073709551616",
+    "1234567890123456789012345", "0.1234567890123456789012",
+    "123456789012345678e5", "00000000000000000000000001.5",
+    "0.000000000000000000000000000000001",
+    "123456789012345678901234567890123456789012345678901234567890"
+      "123456789e-50",
+    /* Huge exponents, subnormal numbers and overflow */
+    "1.7976931348623157e308", "2.2250738585072014e-308", "4.9e-324",
+    "1e400", "-1e400", "1e99999999999999999999", "1e-99999999999999999999",
+    /* No numbers at all */
+    ".", "-", "+", "e5", "+.e1"
+  };
+  const char         *pos;
+  char               *strtod_end;
+  double              value, strtod_value;
+  size_t              inumber;
+  int                 success;
+
+  for (inumber = 0; inumber < sizeof (numbers) / sizeof (*numbers);
+       inumber++) {
+    pos = numbers[inumber];
+    success = t8_cmesh_msh_file_parse_double (&pos, numbers[inumber] +
+                                              strlen (numbers[inumber]),
+                                              &value);
+    strtod_value = strtod (numbers[inumber], &strtod_end);
+    SC_CHECK_ABORTF (success == (strtod_end != numbers[inumber]),
+                     "Parsing %s does not match strtod", numbers[inumber]);
+    if (success) {
+      /* Compare the bits to distinguish -0 and 0 */
+      SC_CHECK_ABORTF (!memcmp (&value, &strtod_value, sizeof (double))
+                       && pos == strtod_end,
+                       "Parsing %s does not match strtod", numbers[inumber]);
+    }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         comm;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  comm = sc_MPI_COMM_WORLD;
+  sc_init (comm, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_global_productionf ("Testing the .msh file reader.\n");
+  t8_test_cmesh_readmsh (comm);
+  t8_test_cmesh_readmsh_formats (comm);
+  t8_test_cmesh_readmsh_parse_double ();
+  t8_global_productionf ("Done testing the .msh file reader.\n");
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,244 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+/* In this test we fill an element array with all elements of a uniform
+ * refinement of the root element and check
+ *  - that the array versions of the scheme functions give the same results
+ *    as the single element versions,
+ *  - that generating a range of linear ids gives the same elements,
+ *  - that the families are found, for full and compact storage,
+ *  - that switching the array to compact storage and back restores the
+ *    elements and that single elements can be decoded from the compact array,
+ *  - that the keys of a range of elements are decoded into another array.
+ */
+
+#include <t8_eclass.h>
+#include <t8_element_cxx.hxx>
+#include <t8_default_cxx.hxx>
+#include <t8_data/t8_containers.h>
+
+static void
+t8_test_element_array_class (t8_eclass_scheme_c * ts, int level)
+{
+  t8_element_array_t  elements, copy, parents, children;
+  t8_element_t       *element, *decoded;
+  t8_linearidx_t      num_elements, id, *ids, *keys;
+  int                *levels, *child_ids;
+  int8_t             *family_start;
+  int                 dim, num_children, ichild;
+  size_t              num_new;
+
+  dim = t8_eclass_to_dimension[ts->eclass];
+  num_elements = (t8_linearidx_t) 1 << (dim * level);
+
+  /* Fill the array with the uniform level elements */
+  t8_element_array_init_size (&elements, ts, num_elements);
+  for (id = 0; id < num_elements; id++) {
+    element = t8_element_array_index_locidx (&elements, id);
+    ts->t8_element_set_linear_id (element, level, id);
+  }
+
+  /* Generate the second half of the elements in one call */
+  t8_element_array_init_size (&copy, ts, num_elements - num_elements / 2);
+  ts->t8_element_array_set_linear_ids (&copy, 0, level, num_elements / 2,
+                                       num_elements);
+  for (id = num_elements / 2; id < num_elements; id++) {
+    SC_CHECK_ABORT (!ts->t8_element_compare (t8_element_array_index_locidx
+                                             (&copy, id - num_elements / 2),
+                                             t8_element_array_index_locidx
+                                             (&elements, id)),
+                    "Wrong element in generated range");
+  }
+  t8_element_array_reset (&copy);
+
+  /* Check the array versions of the scheme functions */
+  ids = T8_ALLOC (t8_linearidx_t, num_elements);
+  levels = T8_ALLOC (int, num_elements);
+  child_ids = T8_ALLOC (int, num_elements);
+  ts->t8_element_array_linear_ids (&elements, 0, num_elements, level, ids);
+  ts->t8_element_array_levels (&elements, 0, num_elements, levels);
+  ts->t8_element_array_child_ids (&elements, 0, num_elements, child_ids);
+  for (id = 0; id < num_elements; id++) {
+    element = t8_element_array_index_locidx (&elements, id);
+    SC_CHECK_ABORT (ids[id] == id, "Wrong linear id in array version");
+    SC_CHECK_ABORT (levels[id] == level, "Wrong level in array version");
+    SC_CHECK_ABORT (child_ids[id] == ts->t8_element_child_id (element),
+                    "Wrong child id in array version");
+  }
+  if (level > 0) {
+    t8_element_array_init_size (&parents, ts, num_elements);
+    ts->t8_element_array_parents (&elements, 0, num_elements, &parents, 0);
+    for (id = 0; id < num_elements; id++) {
+      element = t8_element_array_index_locidx (&parents, id);
+      SC_CHECK_ABORT (ts->t8_element_level (element) == level - 1,
+                      "Wrong parent level in array version");
+      SC_CHECK_ABORT (ts->t8_element_get_linear_id (element, level - 1)
+                      == id >> dim, "Wrong parent in array version");
+    }
+    t8_element_array_reset (&parents);
+  }
+  num_children = 1 << dim;
+  t8_element_array_init_size (&children, ts, num_elements * num_children);
+  num_new = ts->t8_element_array_children (&elements, 0, num_elements,
+                                           &children, 0);
+  SC_CHECK_ABORT (num_new == num_elements * num_children,
+                  "Wrong number of children in array version");
+  for (id = 0; id < num_elements; id++) {
+    for (ichild = 0; ichild < num_children; ichild++) {
+      element = t8_element_array_index_locidx (&children,
+                                               id * num_children + ichild);
+      SC_CHECK_ABORT (ts->t8_element_get_linear_id (element, level + 1)
+                      == id * num_children + ichild,
+                      "Wrong child in array version");
+    }
+  }
+  t8_element_array_reset (&children);
+  T8_FREE (ids);
+  T8_FREE (levels);
+  T8_FREE (child_ids);
+
+  /* Check the compact storage */
+  t8_element_array_init (&copy, ts);
+  t8_element_array_copy (&copy, &elements);
+  SC_CHECK_ABORT (t8_element_array_compact (&copy),
+                  "Could not compact element array");
+  SC_CHECK_ABORT (t8_element_array_is_compact (&copy),
+                  "Element array is not compact");
+  SC_CHECK_ABORT (t8_element_array_get_count (&copy) == num_elements,
+                  "Wrong element count of compact array");
+  ts->t8_element_new (1, &decoded);
+  for (id = 0; id < num_elements; id++) {
+    t8_element_array_decode (&copy, id, decoded);
+    SC_CHECK_ABORT (!ts->t8_element_compare (decoded,
+                                             t8_element_array_index_locidx
+                                             (&elements, id)),
+                    "Wrong element decoded from compact array");
+  }
+  t8_element_array_expand (&copy);
+  SC_CHECK_ABORT (!t8_element_array_is_compact (&copy),
+                  "Element array is still compact");
+  for (id = 0; id < num_elements; id++) {
+    SC_CHECK_ABORT (!ts->t8_element_compare (t8_element_array_index_locidx
+                                             (&copy, id),
+                                             t8_element_array_index_locidx
+                                             (&elements, id)),
+                    "Wrong element after expanding compact array");
+  }
+  ts->t8_element_destroy (1, &decoded);
+
+  /* Encode the second half of the elements and decode their keys into
+   * the first half of another array */
+  keys = T8_ALLOC (t8_linearidx_t, num_elements - num_elements / 2);
+  SC_CHECK_ABORT (t8_element_array_can_encode (&elements, num_elements / 2,
+                                               num_elements -
+                                               num_elements / 2),
+                  "Cannot encode element range");
+  SC_CHECK_ABORT (t8_element_array_encode (&elements, num_elements / 2,
+                                           num_elements - num_elements / 2,
+                                           keys),
+                  "Could not encode element range");
+  t8_element_array_init_size (&children, ts, num_elements);
+  t8_element_array_decode_keys (&children, 0,
+                                num_elements - num_elements / 2, keys);
+  for (id = num_elements / 2; id < num_elements; id++) {
+    SC_CHECK_ABORT (!ts->t8_element_compare (t8_element_array_index_locidx
+                                             (&children,
+                                              id - num_elements / 2),
+                                             t8_element_array_index_locidx
+                                             (&elements, id)),
+                    "Wrong element decoded from keys");
+  }
+  t8_element_array_reset (&children);
+  T8_FREE (keys);
+
+  /* Check the family detection. In a uniform refinement every element
+   * with child id 0 starts a family. */
+  num_children = 1 << dim;
+  family_start = T8_ALLOC (int8_t, num_elements);
+  t8_element_array_family_starts (&elements, 0, num_elements, family_start);
+  for (id = 0; id < num_elements; id++) {
+    SC_CHECK_ABORT (family_start[id] == (level > 0 && id % num_children == 0),
+                    "Wrong family start");
+  }
+  SC_CHECK_ABORT (t8_element_array_compact (&copy),
+                  "Could not compact element array");
+  t8_element_array_family_starts (&copy, 0, num_elements, family_start);
+  for (id = 0; id < num_elements; id++) {
+    SC_CHECK_ABORT (family_start[id] == (level > 0 && id % num_children == 0),
+                    "Wrong family start in compact array");
+  }
+  if (num_elements > 1) {
+    /* A range that ends within a family does not contain that family */
+    t8_element_array_family_starts (&elements, 0, num_elements - 1,
+                                    family_start);
+    SC_CHECK_ABORT (!family_start[num_elements - num_children],
+                    "Family start of incomplete family");
+  }
+  T8_FREE (family_start);
+  t8_element_array_reset (&copy);
+  t8_element_array_reset (&elements);
+}
+
+static void
+t8_test_element_array ()
+{
+  t8_scheme_cxx_t    *scheme;
+  int                 eclassi, level;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclassi = T8_ECLASS_ZERO; eclassi < T8_ECLASS_COUNT; eclassi++) {
+    if (scheme->eclass_schemes[eclassi] == NULL
+        || eclassi == T8_ECLASS_PYRAMID) {
+      continue;
+    }
+    t8_global_productionf ("Testing eclass %s\n",
+                           t8_eclass_to_string[eclassi]);
+    for (level = 0; level < 4; level++) {
+      t8_test_element_array_class (scheme->eclass_schemes[eclassi], level);
+    }
+  }
+  t8_scheme_cxx_unref (&scheme);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_element_array ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
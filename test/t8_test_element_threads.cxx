@@ -0,0 +1,176 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+/* In this test several threads allocate and destroy elements of the same
+ * default scheme concurrently. Each thread allocates elements, sets them
+ * to distinct linear ids and checks them. Half of the elements are
+ * destroyed by the thread that allocated them, the other half by another
+ * thread.
+ */
+
+#include <t8_eclass.h>
+#include <t8_element_cxx.hxx>
+#include <t8_default_cxx.hxx>
+#include <t8_default/t8_default_common_cxx.hxx>
+#ifdef T8_DEFAULT_MEMPOOL_THREADS
+#include <thread>
+#include <vector>
+
+#define T8_TEST_THREADS_NUM_THREADS 4
+#define T8_TEST_THREADS_NUM_ELEMENTS 1000
+#define T8_TEST_THREADS_NUM_ROUNDS 10
+
+/* Allocate the elements of one thread and check that they do not overlap
+ * with the elements of other threads. */
+static void
+t8_test_threads_new (t8_eclass_scheme_c * ts, int level,
+                     t8_element_t ** elements, int ithread)
+{
+  t8_element_t       *keep[T8_TEST_THREADS_NUM_ELEMENTS / 2];
+  t8_linearidx_t      id;
+  int                 ielem, iround, num_elements;
+
+  num_elements = T8_TEST_THREADS_NUM_ELEMENTS;
+  for (iround = 0; iround < T8_TEST_THREADS_NUM_ROUNDS; iround++) {
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      ts->t8_element_new (1, elements + ielem);
+      id = (t8_linearidx_t) ithread * num_elements + ielem;
+      ts->t8_element_set_linear_id (elements[ielem], level, id);
+    }
+    for (ielem = 0; ielem < num_elements; ielem++) {
+      id = (t8_linearidx_t) ithread * num_elements + ielem;
+      SC_CHECK_ABORT (ts->t8_element_get_linear_id (elements[ielem], level)
+                      == id, "Element was changed by another thread");
+    }
+    if (iround < T8_TEST_THREADS_NUM_ROUNDS - 1) {
+      /* Destroy the elements in a different order than they were allocated */
+      for (ielem = 0; ielem < num_elements / 2; ielem++) {
+        keep[ielem] = elements[2 * ielem];
+        ts->t8_element_destroy (1, elements + 2 * ielem + 1);
+      }
+      ts->t8_element_destroy (num_elements / 2, keep);
+    }
+  }
+  /* Destroy every second element, the other ones are destroyed by
+   * another thread */
+  for (ielem = 0; ielem < num_elements; ielem += 2) {
+    ts->t8_element_destroy (1, elements + ielem);
+  }
+}
+
+/* Destroy the elements that another thread allocated. */
+static void
+t8_test_threads_destroy (t8_eclass_scheme_c * ts, t8_element_t ** elements)
+{
+  int                 ielem;
+
+  for (ielem = 1; ielem < T8_TEST_THREADS_NUM_ELEMENTS; ielem += 2) {
+    ts->t8_element_destroy (1, elements + ielem);
+  }
+}
+
+static void
+t8_test_element_threads_class (t8_eclass_scheme_c * ts)
+{
+  std::vector < std::thread > threads;
+  t8_element_t      **elements;
+  int                 ithread, level, dim;
+
+  /* Choose a level with enough elements for distinct ids */
+  dim = t8_eclass_to_dimension[ts->eclass];
+  level = dim == 0 ? 0 : 16 / dim;
+  elements = T8_ALLOC (t8_element_t *, T8_TEST_THREADS_NUM_THREADS *
+                       T8_TEST_THREADS_NUM_ELEMENTS);
+  for (ithread = 0; ithread < T8_TEST_THREADS_NUM_THREADS; ithread++) {
+    threads.push_back (std::thread (t8_test_threads_new, ts, level,
+                                    elements +
+                                    ithread * T8_TEST_THREADS_NUM_ELEMENTS,
+                                    ithread));
+  }
+  for (ithread = 0; ithread < T8_TEST_THREADS_NUM_THREADS; ithread++) {
+    threads[ithread].join ();
+  }
+  threads.clear ();
+  /* Each thread destroys the remaining elements of the next thread */
+  for (ithread = 0; ithread < T8_TEST_THREADS_NUM_THREADS; ithread++) {
+    threads.push_back (std::thread (t8_test_threads_destroy, ts,
+                                    elements +
+                                    ((ithread + 1) %
+                                     T8_TEST_THREADS_NUM_THREADS) *
+                                    T8_TEST_THREADS_NUM_ELEMENTS));
+  }
+  for (ithread = 0; ithread < T8_TEST_THREADS_NUM_THREADS; ithread++) {
+    threads[ithread].join ();
+  }
+  T8_FREE (elements);
+}
+
+static void
+t8_test_element_threads ()
+{
+  t8_scheme_cxx_t    *scheme;
+  int                 eclassi;
+
+  scheme = t8_scheme_new_default_cxx ();
+  for (eclassi = T8_ECLASS_ZERO; eclassi < T8_ECLASS_COUNT; eclassi++) {
+    if (scheme->eclass_schemes[eclassi] == NULL
+        || eclassi == T8_ECLASS_PYRAMID) {
+      continue;
+    }
+    t8_global_productionf ("Testing eclass %s\n",
+                           t8_eclass_to_string[eclassi]);
+    t8_test_element_threads_class (scheme->eclass_schemes[eclassi]);
+  }
+  /* Destroying the scheme destroys the per-thread pools */
+  t8_scheme_cxx_unref (&scheme);
+}
+#endif
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+#ifdef T8_DEFAULT_MEMPOOL_THREADS
+  t8_test_element_threads ();
+#else
+  t8_global_productionf ("The default schemes do not use per-thread memory"
+                         " pools. Skipping the test.\n");
+#endif
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
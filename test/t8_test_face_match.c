@@ -0,0 +1,307 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+#include <t8_eclass.h>
+#include <t8_cmesh/t8_cmesh_face_match.h>
+
+/* The number of hexahedra in each coordinate direction */
+#define T8_TEST_FACE_MATCH_N 4
+
+/* The index of a vertex in the grid. We use a large stride to test
+ * indices that need more than one radix sort pass. */
+static long
+t8_test_face_match_vertex (int x, int y, int z)
+{
+  const int           n = T8_TEST_FACE_MATCH_N + 1;
+
+  return 100003L * (x + n * (y + n * z)) + 7;
+}
+
+/* The global tree id of the hexahedron at grid position (x, y, z).
+ * The trees are numbered in reverse order to the grid. */
+static              t8_gloidx_t
+t8_test_face_match_tree (int x, int y, int z)
+{
+  const int           n = T8_TEST_FACE_MATCH_N;
+
+  return n * n * n - 1 - (x + n * (y + n * z));
+}
+
+/* Build the faces of a uniform hexahedral grid, match them and check
+ * the face connections. */
+static void
+test_face_match_hex (int boundary)
+{
+  sc_array_t         *faces, *joins;
+  t8_cmesh_face_key_t *face, *next;
+  t8_cmesh_face_join_t *join;
+  t8_gloidx_t         trees[2];
+  long                vertices[8];
+  size_t              iz;
+  int                 x, y, z, iv, dir;
+  int                 num_boundary = 0, num_inner = 0;
+  const int           n = T8_TEST_FACE_MATCH_N;
+
+  faces = sc_array_new (sizeof (t8_cmesh_face_key_t));
+  for (z = 0; z < n; z++) {
+    for (y = 0; y < n; y++) {
+      for (x = 0; x < n; x++) {
+        for (iv = 0; iv < 8; iv++) {
+          vertices[iv] = t8_test_face_match_vertex (x + (iv & 1),
+                                                    y + ((iv & 2) >> 1),
+                                                    z + ((iv & 4) >> 2));
+        }
+        t8_cmesh_face_keys_add_tree (faces, t8_test_face_match_tree (x, y,
+                                                                     z),
+                                     T8_ECLASS_HEX, vertices);
+      }
+    }
+  }
+  SC_CHECK_ABORT (faces->elem_count == (size_t) 6 * n * n * n,
+                  "Wrong number of faces");
+
+  t8_cmesh_face_keys_sort (faces);
+  for (iz = 0; iz + 1 < faces->elem_count; iz++) {
+    face = (t8_cmesh_face_key_t *) sc_array_index (faces, iz);
+    next = (t8_cmesh_face_key_t *) sc_array_index (faces, iz + 1);
+    for (iv = 0; iv < 4 && face->key[iv] == next->key[iv]; iv++) {
+    }
+    SC_CHECK_ABORT (iv == 4 || face->key[iv] < next->key[iv],
+                    "Faces are not sorted");
+  }
+
+  joins = sc_array_new (sizeof (t8_cmesh_face_join_t));
+  t8_cmesh_face_keys_match (faces, joins, boundary);
+  for (iz = 0; iz < joins->elem_count; iz++) {
+    join = (t8_cmesh_face_join_t *) sc_array_index (joins, iz);
+    if (join->gtree_id == join->neighbor) {
+      SC_CHECK_ABORT (join->face_number == join->neighbor_face,
+                      "Wrong boundary face");
+      num_boundary++;
+      continue;
+    }
+    num_inner++;
+    /* The faces of a connection lie in the same direction and
+     * all hexahedra are oriented equally */
+    dir = join->face_number / 2;
+    SC_CHECK_ABORT (join->neighbor_face / 2 == dir
+                    && join->face_number != join->neighbor_face,
+                    "Wrong face numbers");
+    SC_CHECK_ABORT (join->orientation == 0, "Wrong orientation");
+    /* Check that the trees are neighbors in direction dir */
+    trees[0] = join->face_number % 2 ? join->gtree_id : join->neighbor;
+    trees[1] = join->face_number % 2 ? join->neighbor : join->gtree_id;
+    for (z = 0; z < n; z++) {
+      for (y = 0; y < n; y++) {
+        for (x = 0; x < n; x++) {
+          if (t8_test_face_match_tree (x, y, z) == trees[0]) {
+            SC_CHECK_ABORT (t8_test_face_match_tree
+                            (x + (dir == 0), y + (dir == 1),
+                             z + (dir == 2)) == trees[1],
+                            "Trees are not neighbors");
+          }
+        }
+      }
+    }
+  }
+  SC_CHECK_ABORT (num_inner == 3 * n * n * (n - 1),
+                  "Wrong number of face connections");
+  SC_CHECK_ABORT (num_boundary == (boundary ? 6 * n * n : 0),
+                  "Wrong number of boundary faces");
+  sc_array_destroy (joins);
+  sc_array_destroy (faces);
+}
+
+/* An expected face connection between two trees */
+typedef struct
+{
+  t8_gloidx_t         tree;
+  int                 face;
+  t8_gloidx_t         neighbor;
+  int                 neighbor_face;
+  int                 orientation;
+} t8_test_face_match_join_t;
+
+/* Match the faces of a few trees and check that exactly the expected
+ * face connections are found and that all other faces are boundaries. */
+static void
+test_face_match_trees (int num_trees, const t8_gloidx_t * tree_ids,
+                       const t8_eclass_t * eclasses,
+                       const long vertices[][8], int num_expected,
+                       const t8_test_face_match_join_t * expected)
+{
+  sc_array_t         *faces, *joins;
+  t8_cmesh_face_join_t *join;
+  const t8_test_face_match_join_t *exp;
+  size_t              iz;
+  int                 itree, iexp, found;
+  int                 num_faces = 0, num_boundary = 0, num_inner = 0;
+
+  faces = sc_array_new (sizeof (t8_cmesh_face_key_t));
+  for (itree = 0; itree < num_trees; itree++) {
+    t8_cmesh_face_keys_add_tree (faces, tree_ids[itree], eclasses[itree],
+                                 vertices[itree]);
+    num_faces += t8_eclass_num_faces[eclasses[itree]];
+  }
+  t8_cmesh_face_keys_sort (faces);
+  joins = sc_array_new (sizeof (t8_cmesh_face_join_t));
+  t8_cmesh_face_keys_match (faces, joins, 1);
+  for (iz = 0; iz < joins->elem_count; iz++) {
+    join = (t8_cmesh_face_join_t *) sc_array_index (joins, iz);
+    if (join->gtree_id == join->neighbor
+        && join->face_number == join->neighbor_face) {
+      num_boundary++;
+      continue;
+    }
+    num_inner++;
+    /* The connection may be stored from either side */
+    found = 0;
+    for (iexp = 0; iexp < num_expected; iexp++) {
+      exp = expected + iexp;
+      if ((join->gtree_id == exp->tree && join->face_number == exp->face
+           && join->neighbor == exp->neighbor
+           && join->neighbor_face == exp->neighbor_face)
+          || (join->gtree_id == exp->neighbor
+              && join->face_number == exp->neighbor_face
+              && join->neighbor == exp->tree
+              && join->neighbor_face == exp->face)) {
+        SC_CHECK_ABORTF (join->orientation == exp->orientation,
+                         "Wrong orientation %i of the connection of tree"
+                         " %lli and %lli, expected %i", join->orientation,
+                         (long long) exp->tree, (long long) exp->neighbor,
+                         exp->orientation);
+        found++;
+      }
+    }
+    SC_CHECK_ABORT (found == 1, "Unexpected face connection");
+  }
+  SC_CHECK_ABORT (num_inner == num_expected,
+                  "Wrong number of face connections");
+  SC_CHECK_ABORT (num_boundary == num_faces - 2 * num_expected,
+                  "Wrong number of boundary faces");
+  sc_array_destroy (joins);
+  sc_array_destroy (faces);
+}
+
+/* Two hexahedra, where the second one is rotated by 90 degrees about
+ * the x-axis.  Face 1 of the first hexahedron with the vertices
+ * 11, 13, 15, 17 is face 0 of the second with the vertices 13, 17, 11, 15.
+ * The orientation is the position of the first vertex of the face of the
+ * smaller tree id in the face of the bigger tree id. */
+static void
+test_face_match_rotated_hex ()
+{
+  const t8_eclass_t   eclasses[2] = { T8_ECLASS_HEX, T8_ECLASS_HEX };
+  const long          vertices[2][8] = {
+    {10, 11, 12, 13, 14, 15, 16, 17},
+    {13, 20, 17, 21, 11, 22, 15, 23}
+  };
+  const t8_gloidx_t   tree_ids[2] = { 0, 1 };
+  const t8_gloidx_t   swapped_ids[2] = { 5, 2 };
+  /* 11 is at position 2 of 13, 17, 11, 15 */
+  const t8_test_face_match_join_t expected = { 0, 1, 1, 0, 2 };
+  /* 13 is at position 1 of 11, 13, 15, 17 */
+  const t8_test_face_match_join_t swapped = { 5, 1, 2, 0, 1 };
+
+  test_face_match_trees (2, tree_ids, eclasses, vertices, 1, &expected);
+  test_face_match_trees (2, swapped_ids, eclasses, vertices, 1, &swapped);
+}
+
+/* Three tetrahedra, the second and the third one share a face with the
+ * first one.  Face i of a tetrahedron is opposite to its vertex i. */
+static void
+test_face_match_tets ()
+{
+  const t8_eclass_t   eclasses[3] =
+    { T8_ECLASS_TET, T8_ECLASS_TET, T8_ECLASS_TET };
+  const long          vertices[3][8] = {
+    {100, 101, 102, 103},
+    {102, 104, 103, 101},
+    {105, 102, 100, 101}
+  };
+  const t8_gloidx_t   tree_ids[3] = { 0, 1, 2 };
+  const t8_test_face_match_join_t expected[2] = {
+    /* Face 0 of tree 0 is 101, 102, 103 and face 1 of tree 1 is
+     * 102, 103, 101, thus 101 is at position 2 */
+    {0, 0, 1, 1, 2},
+    /* Face 3 of tree 0 is 100, 101, 102 and face 0 of tree 2 is
+     * 102, 100, 101, thus 100 is at position 1 */
+    {0, 3, 2, 0, 1}
+  };
+
+  test_face_match_trees (3, tree_ids, eclasses, vertices, 2, expected);
+}
+
+/* A prism with two tetrahedra at its triangular faces.  The tetrahedra
+ * have the bigger tree ids, but the smaller eclass, thus their faces
+ * determine the orientation. */
+static void
+test_face_match_prism_tets ()
+{
+  const t8_eclass_t   eclasses[3] =
+    { T8_ECLASS_PRISM, T8_ECLASS_TET, T8_ECLASS_TET };
+  const long          vertices[3][8] = {
+    {200, 201, 202, 203, 204, 205},
+    {206, 205, 203, 204},
+    {201, 200, 207, 202}
+  };
+  const t8_gloidx_t   tree_ids[3] = { 0, 1, 2 };
+  const t8_test_face_match_join_t expected[2] = {
+    /* Face 4 of the prism is 203, 204, 205 and face 0 of tree 1 is
+     * 205, 203, 204, thus 205 is at position 2 */
+    {0, 4, 1, 0, 2},
+    /* Face 3 of the prism is 200, 201, 202 and face 2 of tree 2 is
+     * 201, 200, 202, thus 201 is at position 1 */
+    {0, 3, 2, 2, 1}
+  };
+
+  test_face_match_trees (3, tree_ids, eclasses, vertices, 2, expected);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  test_face_match_hex (0);
+  test_face_match_hex (1);
+  test_face_match_rotated_hex ();
+  test_face_match_tets ();
+  test_face_match_prism_tets ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,436 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_forest/t8_forest_private.h>
+#include <t8_forest/t8_forest_face_connectivity.h>
+#include <t8_default_cxx.hxx>
+
+/* Refine every second element up to level 3. The forest is not balanced
+ * afterwards. */
+static int
+t8_test_iterate_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                       t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                       t8_eclass_scheme_c * ts, int num_elements,
+                       t8_element_t * elements[])
+{
+  return lelement_id % 2 == 0 && ts->t8_element_level (elements[0]) < 3;
+}
+
+/* Refine the first element of each tree up to level 4, such that its
+ * neighbors at level 1 have faces that are hanging by several levels. */
+static int
+t8_test_iterate_unbalanced_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                                  t8_locidx_t which_tree,
+                                  t8_locidx_t lelement_id,
+                                  t8_eclass_scheme_c * ts, int num_elements,
+                                  t8_element_t * elements[])
+{
+  return ts->t8_element_level (elements[0]) < 4
+    && ts->t8_element_get_linear_id (elements[0],
+                                     ts->t8_element_level (elements[0])) ==
+    0;
+}
+
+/* The reference neighbors of a face of a local leaf computed with
+ * t8_forest_leaf_face_neighbors for balanced forests */
+typedef struct
+{
+  t8_element_t      **leafs;
+  int                *dual_faces;
+  t8_locidx_t        *element_indices;
+  int                 num_neighbors;
+  t8_eclass_scheme_c *neigh_scheme;
+} t8_test_iterate_reference_t;
+
+static void
+t8_test_iterate_reference_new (t8_forest_t forest, t8_locidx_t ltreeid,
+                               const t8_element_t * element, int face,
+                               t8_test_iterate_reference_t * ref)
+{
+  t8_forest_leaf_face_neighbors (forest, ltreeid, element, &ref->leafs, face,
+                                 &ref->dual_faces, &ref->num_neighbors,
+                                 &ref->element_indices, &ref->neigh_scheme,
+                                 1);
+}
+
+static void
+t8_test_iterate_reference_destroy (t8_test_iterate_reference_t * ref)
+{
+  if (ref->num_neighbors > 0) {
+    ref->neigh_scheme->t8_element_destroy (ref->num_neighbors, ref->leafs);
+    T8_FREE (ref->leafs);
+    T8_FREE (ref->dual_faces);
+    T8_FREE (ref->element_indices);
+  }
+}
+
+/* Return the position of a neighbor in the reference or -1 */
+static int
+t8_test_iterate_reference_find (const t8_test_iterate_reference_t * ref,
+                                t8_locidx_t element_index)
+{
+  int                 ineigh;
+
+  for (ineigh = 0; ineigh < ref->num_neighbors; ineigh++) {
+    if (ref->element_indices[ineigh] == element_index) {
+      return ineigh;
+    }
+  }
+  return -1;
+}
+
+/* The data passed to the face callback */
+typedef struct
+{
+  int                *face_visits;      /* For each local element and face the number of visits */
+  int                 max_faces;        /* The maximum number of faces of an element */
+} t8_test_iterate_data_t;
+
+/* Check that the neighbor side of a visited face is one of the reference
+ * neighbors with the same dual face, and count the visits. */
+static void
+t8_test_iterate_face_fn (t8_forest_t forest,
+                         const t8_forest_iter_face_side_t * side,
+                         const t8_forest_iter_face_side_t * neighbor_side,
+                         void *user_data)
+{
+  t8_test_iterate_data_t *data = (t8_test_iterate_data_t *) user_data;
+  t8_test_iterate_reference_t ref;
+  int                 ineigh;
+
+  SC_CHECK_ABORT (!side->is_ghost, "The first side must be local.\n");
+  t8_test_iterate_reference_new (forest, side->treeid, side->element,
+                                 side->face, &ref);
+  if (neighbor_side == NULL) {
+    SC_CHECK_ABORT (ref.num_neighbors == 0,
+                    "Face with neighbors visited as boundary face.\n");
+  }
+  else {
+    ineigh = t8_test_iterate_reference_find (&ref,
+                                             neighbor_side->element_index);
+    SC_CHECK_ABORTF (ineigh >= 0, "Element %i is no neighbor of element "
+                     "%i at face %i.\n", neighbor_side->element_index,
+                     side->element_index, side->face);
+    SC_CHECK_ABORT (neighbor_side->face == ref.dual_faces[ineigh],
+                    "Wrong dual face in face iteration.\n");
+    SC_CHECK_ABORT (neighbor_side->is_ghost ==
+                    (neighbor_side->element_index >=
+                     t8_forest_get_num_element (forest)),
+                    "Wrong ghost flag in face iteration.\n");
+    SC_CHECK_ABORT (!ref.neigh_scheme->t8_element_compare
+                    (neighbor_side->element, ref.leafs[ineigh]),
+                    "Wrong neighbor element in face iteration.\n");
+  }
+  t8_test_iterate_reference_destroy (&ref);
+
+  data->face_visits[side->element_index * data->max_faces + side->face]++;
+  if (neighbor_side != NULL && !neighbor_side->is_ghost) {
+    data->face_visits[neighbor_side->element_index * data->max_faces +
+                      neighbor_side->face]++;
+  }
+}
+
+/* Adapt and balance a forest and check the face iteration and the face
+ * connectivity against t8_forest_leaf_face_neighbors.
+ * Each face of a local element must be visited once for each of its leaf
+ * neighbors, or once if it is a boundary face. The face connectivity must
+ * store the same neighbors and dual faces. If twisted_face is not negative,
+ * the faces at the tree face twisted_face of tree 0 and at face 0 of tree 1
+ * must have the orientation twisted_orientation, all other faces
+ * orientation 0. */
+static void
+t8_test_forest_iterate (t8_cmesh_t cmesh, sc_MPI_Comm comm,
+                        int twisted_face, int twisted_orientation)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  t8_test_iterate_data_t data;
+  t8_test_iterate_reference_t ref;
+  t8_forest_face_connectivity_t conn;
+  const t8_forest_face_neighbor_t *conn_neighbors;
+  t8_locidx_t         itree, ielement, element_index;
+  t8_gloidx_t         gtreeid;
+  int                 iface, num_faces, expected, num_conn_neighbors;
+  int                 ineigh, iref, orientation, tree_face;
+
+  forest =
+    t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), 1, 0, comm);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest, t8_test_iterate_adapt, 1);
+  t8_forest_set_balance (forest_adapt, NULL, 0);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  forest = forest_adapt;
+
+  data.max_faces = T8_ECLASS_MAX_FACES;
+  data.face_visits =
+    T8_ALLOC_ZERO (int, t8_forest_get_num_element (forest) * data.max_faces);
+  t8_forest_iterate (forest, t8_test_iterate_face_fn, &data);
+  conn = t8_forest_face_connectivity_new (forest);
+
+  element_index = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    gtreeid = t8_forest_global_tree_id (forest, itree);
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, element_index++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      num_faces = ts->t8_element_num_faces (element);
+      for (iface = 0; iface < num_faces; iface++) {
+        t8_test_iterate_reference_new (forest, itree, element, iface, &ref);
+        expected = SC_MAX (1, ref.num_neighbors);
+        SC_CHECK_ABORTF (data.face_visits[element_index * data.max_faces +
+                                          iface] == expected,
+                         "Face %i of element %i visited %i times, "
+                         "expected %i.\n", iface, element_index,
+                         data.face_visits[element_index * data.max_faces +
+                                          iface], expected);
+        /* The expected orientation of the face */
+        orientation = 0;
+        if (ts->t8_element_is_root_boundary (element, iface)) {
+          tree_face = ts->t8_element_tree_face (element, iface);
+          if ((gtreeid == 0 && tree_face == twisted_face)
+              || (gtreeid == 1 && tree_face == 0)) {
+            orientation = twisted_orientation;
+          }
+        }
+        /* Check that the connectivity table stores the same neighbors */
+        num_conn_neighbors =
+          t8_forest_face_connectivity_get_neighbors (conn, element_index,
+                                                     iface, &conn_neighbors);
+        SC_CHECK_ABORT (num_conn_neighbors == ref.num_neighbors,
+                        "Wrong number of neighbors in face connectivity.\n");
+        for (ineigh = 0; ineigh < num_conn_neighbors; ineigh++) {
+          iref = t8_test_iterate_reference_find (&ref,
+                                                 conn_neighbors
+                                                 [ineigh].neighbor);
+          SC_CHECK_ABORT (iref >= 0,
+                          "Wrong neighbor in face connectivity.\n");
+          SC_CHECK_ABORT (conn_neighbors[ineigh].dual_face ==
+                          ref.dual_faces[iref],
+                          "Wrong dual face in face connectivity.\n");
+          SC_CHECK_ABORTF (twisted_face < 0
+                           || conn_neighbors[ineigh].orientation ==
+                           orientation, "Wrong orientation %i in face "
+                           "connectivity, expected %i.\n",
+                           conn_neighbors[ineigh].orientation, orientation);
+        }
+        t8_test_iterate_reference_destroy (&ref);
+      }
+    }
+  }
+  t8_forest_face_connectivity_destroy (&conn);
+  T8_FREE (data.face_visits);
+  t8_forest_unref (&forest);
+}
+
+/* Return the position of the side with a given element index in an array
+ * of t8_forest_iter_face_side_t or -1 */
+static int
+t8_test_iterate_find_side (sc_array_t * sides, t8_locidx_t element_index)
+{
+  size_t              iside;
+
+  for (iside = 0; iside < sides->elem_count; iside++) {
+    if (((t8_forest_iter_face_side_t *) sc_array_index (sides, iside))
+        ->element_index == element_index) {
+      return (int) iside;
+    }
+  }
+  return -1;
+}
+
+/* The face callback for unbalanced forests. The reference neighbors are
+ * computed with t8_forest_leaf_face_neighbors_all. */
+static void
+t8_test_iterate_unbalanced_face_fn (t8_forest_t forest,
+                                    const t8_forest_iter_face_side_t * side,
+                                    const t8_forest_iter_face_side_t *
+                                    neighbor_side, void *user_data)
+{
+  t8_test_iterate_data_t *data = (t8_test_iterate_data_t *) user_data;
+  t8_forest_iter_face_side_t *ref_side;
+  sc_array_t          ref;
+  int                 ineigh;
+
+  SC_CHECK_ABORT (!side->is_ghost, "The first side must be local.\n");
+  sc_array_init (&ref, sizeof (t8_forest_iter_face_side_t));
+  t8_forest_leaf_face_neighbors_all (forest, side->treeid, side->element,
+                                     side->face, &ref);
+  if (neighbor_side == NULL) {
+    SC_CHECK_ABORT (ref.elem_count == 0,
+                    "Face with neighbors visited as boundary face.\n");
+  }
+  else {
+    ineigh = t8_test_iterate_find_side (&ref, neighbor_side->element_index);
+    SC_CHECK_ABORTF (ineigh >= 0, "Element %i is no neighbor of element "
+                     "%i at face %i.\n", neighbor_side->element_index,
+                     side->element_index, side->face);
+    ref_side = (t8_forest_iter_face_side_t *) sc_array_index_int (&ref,
+                                                                  ineigh);
+    SC_CHECK_ABORT (neighbor_side->face == ref_side->face,
+                    "Wrong dual face in face iteration.\n");
+    SC_CHECK_ABORT (neighbor_side->is_ghost == ref_side->is_ghost,
+                    "Wrong ghost flag in face iteration.\n");
+  }
+  sc_array_reset (&ref);
+
+  data->face_visits[side->element_index * data->max_faces + side->face]++;
+  if (neighbor_side != NULL && !neighbor_side->is_ghost) {
+    data->face_visits[neighbor_side->element_index * data->max_faces +
+                      neighbor_side->face]++;
+  }
+}
+
+/* Refine the first element of each tree up to level 4 without balancing
+ * and check that the face iteration visits each face once for each of its
+ * leaf neighbors, including faces that are hanging by several levels. */
+static void
+t8_test_forest_iterate_unbalanced (t8_cmesh_t cmesh, sc_MPI_Comm comm)
+{
+  t8_forest_t         forest, forest_adapt;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *element;
+  t8_test_iterate_data_t data;
+  sc_array_t          ref;
+  t8_locidx_t         itree, ielement, element_index;
+  int                 iface, num_faces, expected;
+
+  forest =
+    t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), 1, 0, comm);
+  t8_forest_init (&forest_adapt);
+  t8_forest_set_adapt (forest_adapt, forest,
+                       t8_test_iterate_unbalanced_adapt, 1);
+  t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+  t8_forest_commit (forest_adapt);
+  forest = forest_adapt;
+
+  data.max_faces = T8_ECLASS_MAX_FACES;
+  data.face_visits =
+    T8_ALLOC_ZERO (int, t8_forest_get_num_element (forest) * data.max_faces);
+  t8_forest_iterate (forest, t8_test_iterate_unbalanced_face_fn, &data);
+
+  sc_array_init (&ref, sizeof (t8_forest_iter_face_side_t));
+  element_index = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, element_index++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      num_faces = ts->t8_element_num_faces (element);
+      for (iface = 0; iface < num_faces; iface++) {
+        sc_array_resize (&ref, 0);
+        t8_forest_leaf_face_neighbors_all (forest, itree, element, iface,
+                                           &ref);
+        expected = SC_MAX (1, (int) ref.elem_count);
+        SC_CHECK_ABORTF (data.face_visits[element_index * data.max_faces +
+                                          iface] == expected,
+                         "Face %i of element %i visited %i times, "
+                         "expected %i.\n", iface, element_index,
+                         data.face_visits[element_index * data.max_faces +
+                                          iface], expected);
+      }
+    }
+  }
+  sc_array_reset (&ref);
+  T8_FREE (data.face_visits);
+  t8_forest_unref (&forest);
+}
+
+/* Two trees of class eclass whose faces twisted_face and 0 are connected
+ * with a given orientation */
+static t8_cmesh_t
+t8_test_iterate_twisted_cmesh (t8_eclass_t eclass, int twisted_face,
+                               int orientation, sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh;
+
+  t8_cmesh_init (&cmesh);
+  t8_cmesh_set_tree_class (cmesh, 0, eclass);
+  t8_cmesh_set_tree_class (cmesh, 1, eclass);
+  t8_cmesh_set_join (cmesh, 0, 1, twisted_face, 0, orientation);
+  t8_cmesh_commit (cmesh, comm);
+  return cmesh;
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    if (ieclass != T8_ECLASS_PYRAMID) {
+      /* TODO: does not work with pyramids yet */
+      t8_debugf ("Testing face iteration with eclass %s.\n",
+                 t8_eclass_to_string[ieclass]);
+      t8_test_forest_iterate (t8_cmesh_new_hypercube
+                              ((t8_eclass_t) ieclass, mpic, 0, 0, 0), mpic,
+                              -1, 0);
+    }
+  }
+  /* Tree boundaries with nonzero orientation */
+  t8_debugf ("Testing face iteration on twisted tree connections.\n");
+  t8_test_forest_iterate (t8_test_iterate_twisted_cmesh
+                          (T8_ECLASS_QUAD, 1, 1, mpic), mpic, 1, 1);
+  t8_test_forest_iterate (t8_test_iterate_twisted_cmesh
+                          (T8_ECLASS_HEX, 1, 3, mpic), mpic, 1, 3);
+  t8_test_forest_iterate (t8_test_iterate_twisted_cmesh
+                          (T8_ECLASS_TRIANGLE, 0, 1, mpic), mpic, 0, 1);
+  /* Faces that are hanging by several levels */
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    if (ieclass != T8_ECLASS_PYRAMID) {
+      t8_debugf ("Testing face iteration on unbalanced forests with "
+                 "eclass %s.\n", t8_eclass_to_string[ieclass]);
+      t8_test_forest_iterate_unbalanced (t8_cmesh_new_hypercube
+                                         ((t8_eclass_t) ieclass, mpic, 0, 0,
+                                          0), mpic);
+    }
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
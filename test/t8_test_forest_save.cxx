@@ -0,0 +1,217 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we adapt and partition a uniform forest and save it to a
+ * checkpoint with each encoding. We then load the checkpoint twice, once with
+ * the original cmesh and once loading the cmesh from the checkpoint as well,
+ * and check that the loaded forests are equal to the saved one.
+ * Additionally, we load the checkpoint on a subcommunicator with half of the
+ * processes, such that the elements are repartitioned while loading. */
+
+/* Refine every element with child id 1 up to a maximum level. */
+static int
+t8_test_save_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                    t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                    t8_eclass_scheme_c * ts, int num_elements,
+                    t8_element_t * elements[])
+{
+  int                 maxlevel;
+
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  if (ts->t8_element_level (elements[0]) < maxlevel
+      && ts->t8_element_child_id (elements[0]) == 1) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Load a forest from a checkpoint. If cmesh is NULL, the cmesh
+ * is loaded from the checkpoint as well. */
+static              t8_forest_t
+t8_test_save_load (const char *fileprefix, t8_cmesh_t cmesh,
+                   sc_MPI_Comm comm)
+{
+  t8_forest_t         forest;
+
+  t8_forest_init (&forest);
+  if (cmesh != NULL) {
+    t8_forest_set_cmesh (forest, cmesh, comm);
+  }
+  t8_forest_set_scheme (forest, t8_scheme_new_default_cxx ());
+  t8_forest_set_load (forest, fileprefix, comm);
+  t8_forest_commit (forest);
+  return forest;
+}
+
+/* Compute a checksum of a forest's elements that depends on the global
+ * order of the elements, but not on their partition. */
+static              t8_gloidx_t
+t8_test_save_checksum (t8_forest_t forest, sc_MPI_Comm comm)
+{
+  t8_locidx_t         itree, ielement, num_elements;
+  t8_gloidx_t         gelement, gtree, local_sum, global_sum;
+  t8_linearidx_t      hash;
+  t8_element_t       *element;
+  t8_eclass_scheme_c *ts;
+  int                 mpiret, elevel;
+
+  local_sum = 0;
+  gelement = t8_forest_get_first_local_element_id (forest);
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    gtree = t8_forest_global_tree_id (forest, itree);
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    num_elements = t8_forest_get_tree_num_elements (forest, itree);
+    for (ielement = 0; ielement < num_elements; ielement++, gelement++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      elevel = ts->t8_element_level (element);
+      hash = ts->t8_element_get_linear_id (element, elevel);
+      hash = (hash * 31 + gtree * 7919 + elevel) % 1000003;
+      local_sum += (gelement + 1) * (t8_gloidx_t) hash;
+    }
+  }
+  mpiret = sc_MPI_Allreduce (&local_sum, &global_sum, 1, T8_MPI_GLOIDX,
+                             sc_MPI_SUM, comm);
+  SC_CHECK_MPI (mpiret);
+  return global_sum;
+}
+
+static void
+t8_test_forest_save (sc_MPI_Comm comm)
+{
+  int                 eclass, level, maxlevel, encoding;
+  int                 mpiret, mpirank, mpisize, subsize;
+  t8_gloidx_t         checksum;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt, forest_load;
+  sc_MPI_Comm         subcomm;
+
+  /* Build a communicator of the first half of the processes */
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  subsize = SC_MAX (mpisize / 2, 1);
+  mpiret = sc_MPI_Comm_split (comm, mpirank < subsize ? 0 : sc_MPI_UNDEFINED,
+                              mpirank, &subcomm);
+  SC_CHECK_MPI (mpiret);
+
+  for (eclass = T8_ECLASS_VERTEX; eclass < T8_ECLASS_COUNT; eclass++) {
+    if (eclass == T8_ECLASS_PYRAMID) {
+      /* TODO: does not work with pyramids yet */
+      continue;
+    }
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing forest save with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclass], level);
+      maxlevel = level + 2;
+      cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+      t8_cmesh_ref (cmesh);
+      forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      level, 0, comm);
+      /* Adapt and partition the forest */
+      t8_forest_init (&forest_adapt);
+      t8_forest_set_user_data (forest_adapt, &maxlevel);
+      t8_forest_set_adapt (forest_adapt, forest, t8_test_save_adapt, 1);
+      t8_forest_set_partition (forest_adapt, NULL, 0);
+      t8_forest_commit (forest_adapt);
+
+      /* Save with the element encoding and with the uncompressed and
+       * compressed refinement encoding */
+      for (encoding = 0; encoding < 3; encoding++) {
+        SC_CHECK_ABORT (t8_forest_save_ext
+                        (forest_adapt, "test_forest_save",
+                         encoding == 0 ? T8_FOREST_SAVE_ELEMENTS :
+                         T8_FOREST_SAVE_REFINEMENT, encoding == 2),
+                        "Saving the forest failed");
+
+        /* Load the forest with the original cmesh */
+        t8_cmesh_ref (cmesh);
+        forest_load = t8_test_save_load ("test_forest_save", cmesh, comm);
+        SC_CHECK_ABORT (t8_forest_is_equal (forest_adapt, forest_load),
+                        "The loaded forest is not equal to the saved one");
+        t8_forest_unref (&forest_load);
+
+        /* Load the forest together with its cmesh */
+        forest_load = t8_test_save_load ("test_forest_save", NULL, comm);
+        SC_CHECK_ABORT (t8_forest_is_equal (forest_adapt, forest_load),
+                        "The loaded forest is not equal to the saved one");
+        t8_forest_unref (&forest_load);
+
+        /* Load the forest on fewer processes and check that it has the
+         * same elements in the same order */
+        checksum = t8_test_save_checksum (forest_adapt, comm);
+        if (mpirank < subsize) {
+          forest_load =
+            t8_test_save_load ("test_forest_save", NULL, subcomm);
+          SC_CHECK_ABORT (t8_forest_get_global_num_elements (forest_load)
+                          == t8_forest_get_global_num_elements
+                          (forest_adapt),
+                          "The loaded forest has a wrong number of elements");
+          SC_CHECK_ABORT (t8_test_save_checksum (forest_load, subcomm)
+                          == checksum,
+                          "The loaded forest is not equal to the saved one");
+          t8_forest_unref (&forest_load);
+        }
+        /* Do not overwrite the checkpoint while it is being loaded */
+        mpiret = sc_MPI_Barrier (comm);
+        SC_CHECK_MPI (mpiret);
+      }
+      t8_forest_unref (&forest_adapt);
+      t8_cmesh_unref (&cmesh);
+    }
+  }
+  if (subcomm != sc_MPI_COMM_NULL) {
+    mpiret = sc_MPI_Comm_free (&subcomm);
+    SC_CHECK_MPI (mpiret);
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_save (mpic);
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,670 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_cmesh_vtk.h>
+#include <t8_forest.h>
+#include <t8_forest_vtk.h>
+#include <t8_default_cxx.hxx>
+
+/* In this test, we adapt and partition a uniform forest and write it
+ * in each vtu format, with and without merged vertices and ghosts.
+ * Each process reads back its .vtu file and checks the number of points
+ * and cells of its piece and the format of the data arrays.
+ * We also write the forest in xdmf format and each process checks the
+ * cell data of its elements in the heavy data file.
+ * We write the forest into fewer files than processes and check that each
+ * process finds its piece in the file of its group.
+ * Finally, we write the forest several times in the background and compare
+ * the files with those of the synchronous writer. */
+
+/* Refine every element with child id 1 up to a maximum level. */
+static int
+t8_test_vtk_adapt (t8_forest_t forest, t8_forest_t forest_from,
+                   t8_locidx_t which_tree, t8_locidx_t lelement_id,
+                   t8_eclass_scheme_c * ts, int num_elements,
+                   t8_element_t * elements[])
+{
+  int                 maxlevel;
+
+  maxlevel = *(int *) t8_forest_get_user_data (forest);
+  if (ts->t8_element_level (elements[0]) < maxlevel
+      && ts->t8_element_child_id (elements[0]) == 1) {
+    return 1;
+  }
+  return 0;
+}
+
+/* Read a whole file into a nul-terminated string.
+ * The string must be freed with T8_FREE. */
+static char        *
+t8_test_vtk_read_file (const char *filename, size_t * num_bytes)
+{
+  FILE               *file;
+  char               *content;
+  long                size;
+
+  file = fopen (filename, "rb");
+  SC_CHECK_ABORTF (file != NULL, "Could not open file %s", filename);
+  SC_CHECK_ABORT (fseek (file, 0, SEEK_END) == 0, "Could not seek file");
+  size = ftell (file);
+  SC_CHECK_ABORT (size >= 0, "Could not get file size");
+  rewind (file);
+  content = T8_ALLOC (char, size + 1);
+  SC_CHECK_ABORT (fread (content, 1, size, file) == (size_t) size,
+                  "Could not read file");
+  content[size] = '\0';
+  fclose (file);
+  if (num_bytes != NULL) {
+    *num_bytes = size;
+  }
+  return content;
+}
+
+/* Return the sum of the number of corners of all local elements. */
+static              t8_locidx_t
+t8_test_vtk_num_corners (t8_forest_t forest)
+{
+  t8_locidx_t         itree, ielement, num_corners;
+  t8_eclass_scheme_c *ts;
+
+  num_corners = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++) {
+      num_corners += ts->t8_element_num_corners
+        (t8_forest_get_element_in_tree (forest, itree, ielement));
+    }
+  }
+  return num_corners;
+}
+
+/* Check the .vtu file of this process. Return the number of points of
+ * its piece. */
+static long long
+t8_test_vtk_check_vtu (t8_forest_t forest, const char *fileprefix,
+                       t8_vtk_format_t format, int write_ghosts)
+{
+  char                filename[BUFSIZ];
+  char               *content, *piece;
+  const char         *format_string;
+  long long           num_points, num_cells, num_elements;
+  int                 mpirank, mpiret;
+  size_t              num_bytes;
+
+  mpiret = sc_MPI_Comm_rank (t8_forest_get_mpicomm (forest), &mpirank);
+  SC_CHECK_MPI (mpiret);
+  snprintf (filename, BUFSIZ, "%s_%04d.vtu", fileprefix, mpirank);
+  content = t8_test_vtk_read_file (filename, &num_bytes);
+  SC_CHECK_ABORT (!strncmp (content, "<?xml", 5), "Wrong vtu file header");
+  SC_CHECK_ABORT (num_bytes >= 12
+                  && !strcmp (content + num_bytes - 12, "</VTKFile>\n"),
+                  "Wrong vtu file end");
+  piece = strstr (content, "<Piece ");
+  SC_CHECK_ABORT (piece != NULL, "No piece in vtu file");
+  SC_CHECK_ABORT (sscanf (piece, "<Piece NumberOfPoints=\"%lld\" "
+                          "NumberOfCells=\"%lld\"", &num_points,
+                          &num_cells) == 2, "Could not read piece sizes");
+  num_elements = t8_forest_get_num_element (forest);
+  if (write_ghosts) {
+    num_elements += t8_forest_get_num_ghosts (forest);
+  }
+  SC_CHECK_ABORT (num_cells == num_elements, "Wrong number of cells");
+  /* All data arrays are written in the requested format */
+  format_string = format == T8_VTK_FORMAT_ASCII ? "format=\"ascii\"" :
+    format == T8_VTK_FORMAT_BINARY ? "format=\"binary\"" :
+    "format=\"appended\"";
+  SC_CHECK_ABORT (strstr (content, format_string) != NULL,
+                  "Data arrays are not written in the requested format");
+  SC_CHECK_ABORT ((strstr (content, "<AppendedData") != NULL)
+                  == (format == T8_VTK_FORMAT_APPENDED),
+                  "Wrong appended data section");
+  T8_FREE (content);
+  return num_points;
+}
+
+/* Write a forest in all vtu formats and check the output. */
+static void
+t8_test_vtk_write_formats (t8_forest_t forest)
+{
+  t8_vtk_data_field_t data[2];
+  t8_locidx_t         num_elements, ielement;
+  long long           num_points;
+  int                 format, merge, ghosts, mpirank, mpiret;
+  char               *pvtu;
+  const char         *fileprefix = "test_forest_vtk";
+
+  mpiret = sc_MPI_Comm_rank (t8_forest_get_mpicomm (forest), &mpirank);
+  SC_CHECK_MPI (mpiret);
+  num_elements = t8_forest_get_num_element (forest);
+  /* A scalar and a vector field */
+  data[0].type = T8_VTK_SCALAR;
+  snprintf (data[0].description, BUFSIZ, "scalar");
+  data[0].data = T8_ALLOC (double, num_elements);
+  data[1].type = T8_VTK_VECTOR;
+  snprintf (data[1].description, BUFSIZ, "vector");
+  data[1].data = T8_ALLOC (double, 3 * num_elements);
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    data[0].data[ielement] = ielement;
+    data[1].data[3 * ielement] = mpirank;
+    data[1].data[3 * ielement + 1] = ielement;
+    data[1].data[3 * ielement + 2] = -ielement;
+  }
+
+  for (format = T8_VTK_FORMAT_ASCII; format <= T8_VTK_FORMAT_APPENDED;
+       format++) {
+    for (merge = 0; merge < 2; merge++) {
+      for (ghosts = 0; ghosts < 2; ghosts++) {
+        SC_CHECK_ABORT (t8_forest_vtk_write_file_format
+                        (forest, fileprefix, (t8_vtk_format_t) format,
+                         merge, 1, 1, 1, 1, ghosts, 2, data),
+                        "Writing the vtu files failed");
+        num_points =
+          t8_test_vtk_check_vtu (forest, fileprefix,
+                                 (t8_vtk_format_t) format, ghosts);
+        if (!ghosts) {
+          if (merge) {
+            /* Merging identifies corners of neighboring elements */
+            SC_CHECK_ABORT (num_elements == 0 || (0 < num_points
+                                                  && num_points <=
+                                                  t8_test_vtk_num_corners
+                                                  (forest)),
+                            "Wrong number of merged points");
+          }
+          else {
+            SC_CHECK_ABORT (num_points == t8_test_vtk_num_corners (forest),
+                            "Wrong number of points");
+          }
+        }
+        if (mpirank == 0) {
+          pvtu = t8_test_vtk_read_file ("test_forest_vtk.pvtu", NULL);
+          SC_CHECK_ABORT (strstr (pvtu, "test_forest_vtk_0000.vtu") != NULL,
+                          "The pvtu file does not list the vtu files");
+          T8_FREE (pvtu);
+        }
+      }
+    }
+  }
+  T8_FREE (data[0].data);
+  T8_FREE (data[1].data);
+}
+
+/* Find the data item of an array in the content of an .xmf file.
+ * The geometry and topology are found with the names "Geometry" and
+ * "Topology", the cell data arrays with their names. */
+static void
+t8_test_xdmf_find_item (const char *content, const char *name,
+                        long long *count, int *precision, long long *seek)
+{
+  char                tag[BUFSIZ];
+  const char         *item;
+
+  if (!strcmp (name, "Geometry") || !strcmp (name, "Topology")) {
+    snprintf (tag, BUFSIZ, "<%s ", name);
+  }
+  else {
+    snprintf (tag, BUFSIZ, "<Attribute Name=\"%s\"", name);
+  }
+  item = strstr (content, tag);
+  SC_CHECK_ABORTF (item != NULL, "No array %s in xmf file", name);
+  item = strstr (item, "<DataItem Dimensions=\"");
+  SC_CHECK_ABORT (item != NULL, "No data item in xmf file");
+  SC_CHECK_ABORT (sscanf (item, "<DataItem Dimensions=\"%lld", count) == 1,
+                  "Could not read data item dimensions");
+  item = strstr (item, "Precision=\"");
+  SC_CHECK_ABORT (item != NULL
+                  && sscanf (item, "Precision=\"%i", precision) == 1,
+                  "Could not read data item precision");
+  item = strstr (item, "Seek=\"");
+  SC_CHECK_ABORT (item != NULL && sscanf (item, "Seek=\"%lld", seek) == 1,
+                  "Could not read data item offset");
+}
+
+/* Read the values of the local elements of an integer cell data array
+ * from the heavy data file of the xdmf output. */
+static void
+t8_test_xdmf_read_local (t8_forest_t forest, const char *xmf,
+                         const char *bin, size_t bin_size, const char *name,
+                         long long *values)
+{
+  long long           count, seek, offset;
+  t8_locidx_t         ielement;
+  int32_t             value32;
+  int64_t             value64;
+  int                 precision;
+
+  t8_test_xdmf_find_item (xmf, name, &count, &precision, &seek);
+  SC_CHECK_ABORT (count == t8_forest_get_global_num_elements (forest),
+                  "Wrong number of values of cell data array");
+  SC_CHECK_ABORT (precision == 4 || precision == 8,
+                  "Wrong precision of integer cell data array");
+  SC_CHECK_ABORT (seek + count * precision <= (long long) bin_size,
+                  "Cell data array exceeds the heavy data file");
+  offset = seek + t8_forest_get_first_local_element_id (forest) * precision;
+  for (ielement = 0; ielement < t8_forest_get_num_element (forest);
+       ielement++) {
+    if (precision == 4) {
+      memcpy (&value32, bin + offset + ielement * precision, precision);
+      values[ielement] = value32;
+    }
+    else {
+      memcpy (&value64, bin + offset + ielement * precision, precision);
+      values[ielement] = value64;
+    }
+  }
+}
+
+/* Count the occurrences of a string in a string. */
+static int
+t8_test_vtk_count (const char *content, const char *pattern)
+{
+  int                 count = 0;
+
+  while ((content = strstr (content, pattern)) != NULL) {
+    count++;
+    content++;
+  }
+  return count;
+}
+
+/* Write a forest into fewer files than processes with different group
+ * sizes and check that each process finds its piece in the file of its
+ * group. */
+static void
+t8_test_vtk_write_aggregated (t8_forest_t forest)
+{
+  t8_vtk_data_field_t data;
+  t8_locidx_t         num_elements, ielement;
+  long long           num_points, num_cells;
+  char                filename[BUFSIZ];
+  char               *content, *piece;
+  int                 group_sizes[3], igroup_size, group_size, num_groups;
+  int                 merge, ipiece, num_pieces, mpirank, mpisize, mpiret;
+  const char         *fileprefix = "test_forest_vtk_aggregated";
+
+  mpiret = sc_MPI_Comm_rank (t8_forest_get_mpicomm (forest), &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (t8_forest_get_mpicomm (forest), &mpisize);
+  SC_CHECK_MPI (mpiret);
+  num_elements = t8_forest_get_num_element (forest);
+  data.type = T8_VTK_SCALAR;
+  snprintf (data.description, BUFSIZ, "scalar");
+  data.data = T8_ALLOC (double, num_elements);
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    data.data[ielement] = ielement;
+  }
+  /* One file per process, two processes per file and a single file */
+  group_sizes[0] = 1;
+  group_sizes[1] = 2;
+  group_sizes[2] = mpisize;
+
+  for (igroup_size = 0; igroup_size < 3; igroup_size++) {
+    group_size = group_sizes[igroup_size];
+    num_groups = (mpisize + group_size - 1) / group_size;
+    for (merge = 0; merge < 2; merge++) {
+      SC_CHECK_ABORT (t8_forest_vtk_write_file_aggregated
+                      (forest, fileprefix, T8_VTK_FORMAT_BINARY, merge,
+                       group_size, 1, 1, 1, 1, 0, 1, &data),
+                      "Writing the aggregated vtu files failed");
+      /* The files are complete once all processes returned */
+      mpiret = sc_MPI_Barrier (t8_forest_get_mpicomm (forest));
+      SC_CHECK_MPI (mpiret);
+
+      snprintf (filename, BUFSIZ, "%s_%04d.vtu", fileprefix,
+                mpirank / group_size);
+      content = t8_test_vtk_read_file (filename, NULL);
+      num_pieces = SC_MIN (group_size,
+                           mpisize - mpirank / group_size * group_size);
+      SC_CHECK_ABORT (t8_test_vtk_count (content, "<Piece ") == num_pieces,
+                      "Wrong number of pieces in aggregated vtu file");
+      SC_CHECK_ABORT (t8_test_vtk_count (content, "<VTKFile ") == 1
+                      && t8_test_vtk_count (content, "</VTKFile>") == 1,
+                      "Wrong header or footer of aggregated vtu file");
+      /* The pieces are ordered by rank */
+      piece = content;
+      for (ipiece = 0; ipiece <= mpirank % group_size; ipiece++) {
+        piece = strstr (piece + 1, "<Piece ");
+      }
+      SC_CHECK_ABORT (sscanf (piece, "<Piece NumberOfPoints=\"%lld\" "
+                              "NumberOfCells=\"%lld\"", &num_points,
+                              &num_cells) == 2,
+                      "Could not read piece sizes");
+      SC_CHECK_ABORT (num_cells == num_elements, "Wrong number of cells");
+      if (!merge) {
+        SC_CHECK_ABORT (num_points == t8_test_vtk_num_corners (forest),
+                        "Wrong number of points");
+      }
+      T8_FREE (content);
+      if (mpirank == 0) {
+        snprintf (filename, BUFSIZ, "%s.pvtu", fileprefix);
+        content = t8_test_vtk_read_file (filename, NULL);
+        SC_CHECK_ABORT (t8_test_vtk_count (content, "<Piece Source")
+                        == num_groups,
+                        "The pvtu file does not list the aggregated files");
+        T8_FREE (content);
+      }
+      /* Do not overwrite the files while they are being read */
+      mpiret = sc_MPI_Barrier (t8_forest_get_mpicomm (forest));
+      SC_CHECK_MPI (mpiret);
+    }
+  }
+  T8_FREE (data.data);
+}
+
+#define T8_TEST_VTK_NUM_ASYNC 3
+
+/* Write a forest several times in the background with the same handle
+ * while partitioning it, and check that each output equals the output
+ * of the synchronous writer. */
+static void
+t8_test_vtk_write_async (t8_forest_t forest)
+{
+  t8_vtk_data_field_t data;
+  t8_forest_vtk_async_t handle = NULL;
+  t8_forest_t         forest_partition;
+  t8_locidx_t         num_elements, ielement;
+  char                fileprefix[BUFSIZ], filename[BUFSIZ];
+  char               *async_content, *sync_content;
+  size_t              async_bytes, sync_bytes;
+  int                 iwrite, mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (t8_forest_get_mpicomm (forest), &mpirank);
+  SC_CHECK_MPI (mpiret);
+  num_elements = t8_forest_get_num_element (forest);
+  data.type = T8_VTK_SCALAR;
+  snprintf (data.description, BUFSIZ, "scalar");
+  data.data = T8_ALLOC (double, num_elements);
+
+  for (iwrite = 0; iwrite < T8_TEST_VTK_NUM_ASYNC; iwrite++) {
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      data.data[ielement] = iwrite + ielement;
+    }
+    snprintf (fileprefix, BUFSIZ, "test_forest_vtk_async_%i", iwrite);
+    /* This waits for the previous write of the handle */
+    SC_CHECK_ABORT (t8_forest_vtk_write_file_async
+                    (&handle, forest, fileprefix, T8_VTK_FORMAT_ASCII, 1,
+                     1, 1, 1, 1, 0, 1, &data),
+                    "Writing the vtu files in the background failed");
+    SC_CHECK_ABORT (handle != NULL, "No handle for the background write");
+    /* The data was copied and may be overwritten */
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      data.data[ielement] = -1;
+    }
+    /* Partition and ghost read the forest while it is being written */
+    t8_forest_ref (forest);
+    t8_forest_init (&forest_partition);
+    t8_forest_set_partition (forest_partition, forest, 0);
+    t8_forest_set_ghost (forest_partition, 1, T8_GHOST_FACES);
+    t8_forest_commit (forest_partition);
+    t8_forest_unref (&forest_partition);
+  }
+  while (!t8_forest_vtk_async_test (handle)) {
+    /* Wait for the writer thread */
+  }
+  SC_CHECK_ABORT (t8_forest_vtk_async_wait (&handle),
+                  "Writing the vtu files in the background failed");
+  SC_CHECK_ABORT (handle == NULL, "The handle was not freed");
+
+  /* Compare each output with the synchronous output */
+  for (iwrite = 0; iwrite < T8_TEST_VTK_NUM_ASYNC; iwrite++) {
+    for (ielement = 0; ielement < num_elements; ielement++) {
+      data.data[ielement] = iwrite + ielement;
+    }
+    SC_CHECK_ABORT (t8_forest_vtk_write_file_format
+                    (forest, "test_forest_vtk_sync", T8_VTK_FORMAT_ASCII, 1,
+                     1, 1, 1, 1, 0, 1, &data),
+                    "Writing the vtu files failed");
+    snprintf (fileprefix, BUFSIZ, "test_forest_vtk_async_%i", iwrite);
+    t8_test_vtk_check_vtu (forest, fileprefix, T8_VTK_FORMAT_ASCII, 0);
+    snprintf (filename, BUFSIZ, "%s_%04d.vtu", fileprefix, mpirank);
+    async_content = t8_test_vtk_read_file (filename, &async_bytes);
+    snprintf (filename, BUFSIZ, "test_forest_vtk_sync_%04d.vtu", mpirank);
+    sync_content = t8_test_vtk_read_file (filename, &sync_bytes);
+    SC_CHECK_ABORT (async_bytes == sync_bytes
+                    && !memcmp (async_content, sync_content, sync_bytes),
+                    "The background output differs from the synchronous one");
+    T8_FREE (async_content);
+    T8_FREE (sync_content);
+  }
+  /* Waiting on an empty handle succeeds */
+  SC_CHECK_ABORT (t8_forest_vtk_async_wait (&handle),
+                  "Waiting on an empty handle failed");
+  T8_FREE (data.data);
+}
+
+/* Write a forest in xdmf format and check the output. Each process
+ * reads back the values of its elements from the heavy data file. */
+static void
+t8_test_vtk_write_xdmf (t8_forest_t forest)
+{
+  t8_vtk_data_field_t data;
+  t8_locidx_t         num_elements, ielement, itree, itree_element;
+  t8_eclass_scheme_c *ts;
+  long long          *values, count, seek;
+  char               *xmf, *bin;
+  size_t              bin_size;
+  int                 precision, mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (t8_forest_get_mpicomm (forest), &mpirank);
+  SC_CHECK_MPI (mpiret);
+  num_elements = t8_forest_get_num_element (forest);
+  data.type = T8_VTK_SCALAR;
+  snprintf (data.description, BUFSIZ, "scalar");
+  data.data = T8_ALLOC (double, num_elements);
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    data.data[ielement] = ielement;
+  }
+  SC_CHECK_ABORT (t8_forest_vtk_write_xdmf (forest, "test_forest_xdmf",
+                                            1, 1, 1, 1, 1, &data),
+                  "Writing the xdmf files failed");
+  T8_FREE (data.data);
+  /* Wait for process 0 to finish the light data file */
+  mpiret = sc_MPI_Barrier (t8_forest_get_mpicomm (forest));
+  SC_CHECK_MPI (mpiret);
+
+  xmf = t8_test_vtk_read_file ("test_forest_xdmf.xmf", NULL);
+  bin = t8_test_vtk_read_file ("test_forest_xdmf.bin", &bin_size);
+  SC_CHECK_ABORT (strstr (xmf, "test_forest_xdmf.bin") != NULL,
+                  "The xmf file does not refer to the heavy data file");
+  t8_test_xdmf_find_item (xmf, "Topology", &count, &precision, &seek);
+  SC_CHECK_ABORT (seek + count * precision <= (long long) bin_size,
+                  "Topology exceeds the heavy data file");
+  t8_test_xdmf_find_item (xmf, "scalar", &count, &precision, &seek);
+  SC_CHECK_ABORT (seek + count * precision == (long long) bin_size,
+                  "The last array does not end with the heavy data file");
+
+  /* Compare the cell data of the local elements */
+  values = T8_ALLOC (long long, SC_MAX (num_elements, 1));
+  t8_test_xdmf_read_local (forest, xmf, bin, bin_size, "element_id",
+                           values);
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    SC_CHECK_ABORT (values[ielement] ==
+                    t8_forest_get_first_local_element_id (forest) + ielement,
+                    "Wrong element id in xdmf output");
+  }
+  t8_test_xdmf_read_local (forest, xmf, bin, bin_size, "mpirank", values);
+  for (ielement = 0; ielement < num_elements; ielement++) {
+    SC_CHECK_ABORT (values[ielement] == mpirank,
+                    "Wrong mpirank in xdmf output");
+  }
+  t8_test_xdmf_read_local (forest, xmf, bin, bin_size, "level", values);
+  ielement = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    ts = t8_forest_get_eclass_scheme (forest,
+                                      t8_forest_get_tree_class (forest,
+                                                                itree));
+    for (itree_element = 0;
+         itree_element < t8_forest_get_tree_num_elements (forest, itree);
+         itree_element++, ielement++) {
+      SC_CHECK_ABORT (values[ielement] ==
+                      ts->t8_element_level (t8_forest_get_element_in_tree
+                                            (forest, itree, itree_element)),
+                      "Wrong level in xdmf output");
+    }
+  }
+  T8_FREE (values);
+  T8_FREE (xmf);
+  T8_FREE (bin);
+  /* Do not overwrite the files while other processes read them */
+  mpiret = sc_MPI_Barrier (t8_forest_get_mpicomm (forest));
+  SC_CHECK_MPI (mpiret);
+}
+
+/* Create a copy of a replicated cmesh with translated vertices. */
+static              t8_cmesh_t
+t8_test_vtk_translate_cmesh (t8_cmesh_t cmesh, const double offset[3],
+                             sc_MPI_Comm comm)
+{
+  t8_cmesh_t          cmesh_translated;
+  t8_eclass_t         eclass;
+  t8_locidx_t         itree;
+  double              vertices[3 * T8_ECLASS_MAX_CORNERS], *tree_vertices;
+  int                 ivertex, idim, num_vertices;
+
+  t8_cmesh_init (&cmesh_translated);
+  for (itree = 0; itree < t8_cmesh_get_num_local_trees (cmesh); itree++) {
+    eclass = t8_cmesh_get_tree_class (cmesh, itree);
+    num_vertices = t8_eclass_num_vertices[eclass];
+    tree_vertices = t8_cmesh_get_tree_vertices (cmesh, itree);
+    for (ivertex = 0; ivertex < num_vertices; ivertex++) {
+      for (idim = 0; idim < 3; idim++) {
+        vertices[3 * ivertex + idim] =
+          tree_vertices[3 * ivertex + idim] + offset[idim];
+      }
+    }
+    t8_cmesh_set_tree_class (cmesh_translated, itree, eclass);
+    t8_cmesh_set_tree_vertices (cmesh_translated, itree, t8_get_package_id (),
+                                0, vertices, num_vertices);
+  }
+  t8_cmesh_commit (cmesh_translated, comm);
+  return cmesh_translated;
+}
+
+/* Write a uniform forest of the hybrid unit cube with merged vertices on
+ * each process and check the number of distinct points.
+ * The unit cube consists of 8 subcubes of tetrahedra, prisms and hexahedra.
+ * In a uniform refinement of level l the vertices thus form a grid of
+ * (2^(l+1) + 1)^3 points. We translate the cube away from the origin to
+ * check that the identification of corners does not depend on the
+ * position of the mesh. */
+static void
+t8_test_vtk_merged_points ()
+{
+  t8_cmesh_t          cmesh, cmesh_hybrid;
+  t8_forest_t         forest;
+  const double        offsets[3][3] = { {0, 0, 0},
+  {1234.5678, -987.654321, 4321.0123},
+  {-3.3e6, 1.7e6, 2.1e6}
+  };
+  long long           num_points, num_grid;
+  int                 level, ioffset, mpirank, mpiret;
+  char                fileprefix[BUFSIZ];
+
+  mpiret = sc_MPI_Comm_rank (sc_MPI_COMM_WORLD, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  snprintf (fileprefix, BUFSIZ, "test_forest_vtk_merged_%i", mpirank);
+  cmesh_hybrid = t8_cmesh_new_hypercube_hybrid (3, sc_MPI_COMM_SELF, 0, 0);
+  for (ioffset = 0; ioffset < 3; ioffset++) {
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing merged vtk points with offset %i, "
+                             "level %i\n", ioffset, level);
+      cmesh = t8_test_vtk_translate_cmesh (cmesh_hybrid, offsets[ioffset],
+                                           sc_MPI_COMM_SELF);
+      forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      level, 0, sc_MPI_COMM_SELF);
+      SC_CHECK_ABORT (t8_forest_vtk_write_file_format
+                      (forest, fileprefix, T8_VTK_FORMAT_BINARY, 1, 1, 0, 0,
+                       0, 0, 0, NULL), "Writing the vtu files failed");
+      num_points = t8_test_vtk_check_vtu (forest, fileprefix,
+                                          T8_VTK_FORMAT_BINARY, 0);
+      num_grid = (1 << (level + 1)) + 1;
+      SC_CHECK_ABORTF (num_points == num_grid * num_grid * num_grid,
+                       "Wrong number of merged points %lli, expected %lli",
+                       num_points, num_grid * num_grid * num_grid);
+      t8_forest_unref (&forest);
+    }
+  }
+  t8_cmesh_destroy (&cmesh_hybrid);
+}
+
+static void
+t8_test_forest_vtk (sc_MPI_Comm comm)
+{
+  int                 eclass, level, maxlevel;
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest, forest_adapt;
+
+  for (eclass = T8_ECLASS_LINE; eclass <= T8_ECLASS_PRISM; eclass++) {
+    /* TODO: Activate the other eclass as soon as they support ghosts */
+    for (level = 0; level < 3; level++) {
+      t8_global_productionf ("Testing forest vtk with eclass %s, level %i\n",
+                             t8_eclass_to_string[eclass], level);
+      maxlevel = level + 2;
+      cmesh = t8_cmesh_new_hypercube ((t8_eclass_t) eclass, comm, 0, 0, 0);
+      forest = t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (),
+                                      level, 0, comm);
+      /* Adapt and partition the forest and create a ghost layer */
+      t8_forest_init (&forest_adapt);
+      t8_forest_set_user_data (forest_adapt, &maxlevel);
+      t8_forest_set_adapt (forest_adapt, forest, t8_test_vtk_adapt, 1);
+      t8_forest_set_partition (forest_adapt, NULL, 0);
+      t8_forest_set_ghost (forest_adapt, 1, T8_GHOST_FACES);
+      t8_forest_commit (forest_adapt);
+
+      t8_test_vtk_write_formats (forest_adapt);
+      t8_test_vtk_write_xdmf (forest_adapt);
+      t8_test_vtk_write_async (forest_adapt);
+      t8_test_vtk_write_aggregated (forest_adapt);
+      t8_forest_unref (&forest_adapt);
+    }
+  }
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  t8_test_forest_vtk (mpic);
+  t8_test_vtk_merged_points ();
+
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}
@@ -0,0 +1,297 @@
+/*
+  This file is part of t8code.
+  t8code is a C library to manage a collection (a forest) of multiple
+  connected adaptive space-trees of general element classes in parallel.
+
+  Copyright (C) 2015 the developers
+
+  t8code is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  t8code is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with t8code; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+*/
+
+
+#include <t8_eclass.h>
+#include <t8_cmesh.h>
+#include <t8_forest.h>
+#include <t8_forest/t8_forest_iterate.h>
+#include <t8_default_cxx.hxx>
+
+/* Build a uniform forest on the hypercube and locate the centroids of all
+ * local elements. Each centroid must be found in its element.
+ * Furthermore, a point outside of the domain must not be found. */
+static void
+t8_test_search_locate_points (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  t8_element_t       *element;
+  t8_locidx_t         itree, ielement, num_elements, ipoint;
+  t8_locidx_t        *element_indices;
+  double             *points, *tree_vertices;
+  int                 level = 2;
+
+  t8_debugf ("Testing point location with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  forest =
+    t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), level, 0,
+                           comm);
+  num_elements = t8_forest_get_num_element (forest);
+  /* One point per element and one outside point */
+  points = T8_ALLOC (double, 3 * (num_elements + 1));
+  element_indices = T8_ALLOC (t8_locidx_t, num_elements + 1);
+  ipoint = 0;
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    tree_vertices = t8_forest_get_tree_vertices (forest, itree);
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++, ipoint++) {
+      element = t8_forest_get_element_in_tree (forest, itree, ielement);
+      t8_forest_element_centroid (forest, itree, element, tree_vertices,
+                                  points + 3 * ipoint);
+    }
+  }
+  T8_ASSERT (ipoint == num_elements);
+  /* The hypercube is the unit cube, thus this point is outside */
+  points[3 * num_elements] = 2;
+  points[3 * num_elements + 1] = 2;
+  points[3 * num_elements + 2] = 2;
+
+  t8_forest_locate_points (forest, points, num_elements + 1, 1e-10,
+                           element_indices);
+  for (ipoint = 0; ipoint < num_elements; ipoint++) {
+    SC_CHECK_ABORTF (element_indices[ipoint] == ipoint,
+                     "Centroid of element %i located in element %i.\n",
+                     ipoint, element_indices[ipoint]);
+  }
+  SC_CHECK_ABORT (element_indices[num_elements] == -1,
+                  "Point outside of the domain was located.\n");
+
+  T8_FREE (points);
+  T8_FREE (element_indices);
+  t8_forest_unref (&forest);
+}
+
+/* A query of the partition search test, a local element and its tree */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  t8_element_t       *element;
+  int                 owner;
+} t8_test_partition_query_t;
+
+/* Keep a query active if its element is a descendant of the current element
+ * and store the owner once the element is owned by a single process. */
+static int
+t8_test_search_partition_query_fn (t8_forest_t forest, t8_gloidx_t gtreeid,
+                                   const t8_element_t * element,
+                                   t8_eclass_t eclass, int pfirst, int plast,
+                                   void *user_data, void *query,
+                                   size_t query_index)
+{
+  t8_test_partition_query_t *test_query = (t8_test_partition_query_t *) query;
+  t8_eclass_scheme_c *ts;
+  t8_element_t       *ancestor;
+  int                 is_ancestor;
+
+  if (test_query->gtreeid != gtreeid) {
+    return 0;
+  }
+  ts = t8_forest_get_eclass_scheme (forest, eclass);
+  if (ts->t8_element_level (element) >
+      ts->t8_element_level (test_query->element)) {
+    return 0;
+  }
+  /* element is an ancestor of the query element if and only if it is their
+   * nearest common ancestor */
+  ts->t8_element_new (1, &ancestor);
+  ts->t8_element_nca (element, test_query->element, ancestor);
+  is_ancestor = !ts->t8_element_compare (element, ancestor);
+  ts->t8_element_destroy (1, &ancestor);
+  if (is_ancestor && pfirst == plast) {
+    SC_CHECK_ABORT (test_query->owner == -1,
+                    "Element found on two owner processes.\n");
+    test_query->owner = pfirst;
+  }
+  return is_ancestor;
+}
+
+/* Search the partition for all local elements of a uniform forest and
+ * check that we find this process as their owner. */
+static void
+t8_test_search_partition (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_cmesh_t          cmesh;
+  t8_forest_t         forest;
+  sc_array_t          queries;
+  t8_test_partition_query_t *query;
+  t8_locidx_t         itree, ielement;
+  size_t              iquery;
+  int                 level = 2;
+  int                 mpirank, mpiret;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  t8_debugf ("Testing partition search with eclass %s.\n",
+             t8_eclass_to_string[eclass]);
+  cmesh = t8_cmesh_new_hypercube (eclass, comm, 0, 0, 0);
+  forest =
+    t8_forest_new_uniform (cmesh, t8_scheme_new_default_cxx (), level, 0,
+                           comm);
+  sc_array_init (&queries, sizeof (t8_test_partition_query_t));
+  for (itree = 0; itree < t8_forest_get_num_local_trees (forest); itree++) {
+    for (ielement = 0;
+         ielement < t8_forest_get_tree_num_elements (forest, itree);
+         ielement++) {
+      query = (t8_test_partition_query_t *) sc_array_push (&queries);
+      query->gtreeid = t8_forest_global_tree_id (forest, itree);
+      query->element =
+        t8_forest_get_element_in_tree (forest, itree, ielement);
+      query->owner = -1;
+    }
+  }
+  t8_forest_search_partition (forest, NULL,
+                              t8_test_search_partition_query_fn, &queries,
+                              NULL);
+  for (iquery = 0; iquery < queries.elem_count; iquery++) {
+    query = (t8_test_partition_query_t *) sc_array_index (&queries, iquery);
+    SC_CHECK_ABORTF (query->owner == mpirank,
+                     "Wrong owner %i for local element %zd.\n",
+                     query->owner, iquery);
+  }
+  sc_array_reset (&queries);
+  t8_forest_unref (&forest);
+}
+
+/* The query for the owners of a whole tree */
+typedef struct
+{
+  t8_gloidx_t         gtreeid;
+  int                 pfirst, plast;
+  int                 num_calls;
+} t8_test_tree_query_t;
+
+/* Store the owners of the query's tree at its root, which is NULL if the
+ * class of the tree is not known. */
+static int
+t8_test_search_trees_query_fn (t8_forest_t forest, t8_gloidx_t gtreeid,
+                               const t8_element_t * element,
+                               t8_eclass_t eclass, int pfirst, int plast,
+                               void *user_data, void *query,
+                               size_t query_index)
+{
+  t8_test_tree_query_t *tree_query = (t8_test_tree_query_t *) query;
+
+  if (tree_query->gtreeid != gtreeid) {
+    return 0;
+  }
+  SC_CHECK_ABORT ((element == NULL) == (eclass == T8_ECLASS_COUNT),
+                  "Unknown tree class without NULL element.\n");
+  if (element == NULL
+      || t8_forest_get_eclass_scheme (forest, eclass)->t8_element_level
+      (element) == 0) {
+    tree_query->pfirst = pfirst;
+    tree_query->plast = plast;
+    tree_query->num_calls++;
+  }
+  return 0;
+}
+
+/* Search the owners of all trees of a forest on a partitioned coarse mesh,
+ * such that most trees are neither local nor ghost trees of the cmesh.
+ * Each tree must be found once and a nonempty process must be in the range
+ * of owners of a tree if and only if the tree is a local tree. */
+static void
+t8_test_search_partition_trees (sc_MPI_Comm comm, t8_eclass_t eclass)
+{
+  t8_cmesh_t          cmesh, cmesh_partition;
+  t8_forest_t         forest;
+  sc_array_t          queries;
+  t8_test_tree_query_t *query;
+  t8_gloidx_t         gtreeid, first_tree, last_tree;
+  int                 mpirank, mpisize, mpiret, is_local;
+
+  mpiret = sc_MPI_Comm_rank (comm, &mpirank);
+  SC_CHECK_MPI (mpiret);
+  mpiret = sc_MPI_Comm_size (comm, &mpisize);
+  SC_CHECK_MPI (mpiret);
+  t8_debugf ("Testing partition search on a partitioned cmesh with "
+             "eclass %s.\n", t8_eclass_to_string[eclass]);
+  cmesh = t8_cmesh_new_bigmesh (eclass, 3 * mpisize + 1, comm);
+  t8_cmesh_init (&cmesh_partition);
+  t8_cmesh_set_derive (cmesh_partition, cmesh);
+  t8_cmesh_set_partition_uniform (cmesh_partition, 0);
+  t8_cmesh_commit (cmesh_partition, comm);
+  forest =
+    t8_forest_new_uniform (cmesh_partition, t8_scheme_new_default_cxx (), 1,
+                           0, comm);
+
+  sc_array_init_size (&queries, sizeof (t8_test_tree_query_t),
+                      t8_forest_get_num_global_trees (forest));
+  for (gtreeid = 0; gtreeid < (t8_gloidx_t) queries.elem_count; gtreeid++) {
+    query = (t8_test_tree_query_t *) sc_array_index (&queries, gtreeid);
+    query->gtreeid = gtreeid;
+    query->num_calls = 0;
+  }
+  t8_forest_search_partition (forest, NULL, t8_test_search_trees_query_fn,
+                              &queries, NULL);
+  first_tree = t8_forest_get_first_local_tree_id (forest);
+  last_tree = first_tree + t8_forest_get_num_local_trees (forest) - 1;
+  for (gtreeid = 0; gtreeid < (t8_gloidx_t) queries.elem_count; gtreeid++) {
+    query = (t8_test_tree_query_t *) sc_array_index (&queries, gtreeid);
+    SC_CHECK_ABORTF (query->num_calls == 1,
+                     "Tree %lli found %i times.\n", (long long) gtreeid,
+                     query->num_calls);
+    if (t8_forest_get_num_element (forest) > 0) {
+      is_local = first_tree <= gtreeid && gtreeid <= last_tree;
+      SC_CHECK_ABORTF (is_local == (query->pfirst <= mpirank
+                                    && mpirank <= query->plast),
+                       "Wrong owners %i to %i of tree %lli.\n",
+                       query->pfirst, query->plast, (long long) gtreeid);
+    }
+  }
+  sc_array_reset (&queries);
+  t8_forest_unref (&forest);
+}
+
+int
+main (int argc, char **argv)
+{
+  int                 mpiret;
+  sc_MPI_Comm         mpic;
+  int                 ieclass;
+
+  mpiret = sc_MPI_Init (&argc, &argv);
+  SC_CHECK_MPI (mpiret);
+
+  mpic = sc_MPI_COMM_WORLD;
+  sc_init (mpic, 1, 1, NULL, SC_LP_PRODUCTION);
+  p4est_init (NULL, SC_LP_ESSENTIAL);
+  t8_init (SC_LP_DEFAULT);
+
+  for (ieclass = T8_ECLASS_LINE; ieclass < T8_ECLASS_COUNT; ieclass++) {
+    if (ieclass != T8_ECLASS_PYRAMID) {
+      /* TODO: does not work with pyramids yet */
+      t8_test_search_locate_points (mpic, (t8_eclass_t) ieclass);
+      t8_test_search_partition (mpic, (t8_eclass_t) ieclass);
+      t8_test_search_partition_trees (mpic, (t8_eclass_t) ieclass);
+    }
+  }
+  sc_finalize ();
+
+  mpiret = sc_MPI_Finalize ();
+  SC_CHECK_MPI (mpiret);
+
+  return 0;
+}